@@ -7,17 +7,19 @@
 
 /* splits a leaf node */
 /* ADDED int return type */
-int AM_SplitLeaf(fileDesc,pageBuf,pageNum,attrLength,recId,value,status,index,key)
-int fileDesc; /* file descriptor */
+int AM_SplitLeaf(ih,pageBuf,pageNum,recId,value,status,index,key,inserted)
+AM_INDEXHANDLE *ih; /* open index */
 char *pageBuf; /* pointer to buffer */
 int *pageNum; /* pagenumber of new leaf created */
-int attrLength; 
 int recId;
 char *value; /* attribute value for insert */
 
 int status; /* Whether key was found or not in the tree */
 int index; /* place where key is to be inserted */
 char *key; /* returns the key to be filled in the parent */
+int *inserted; /* returns whether the pair went into its half - a half
+		  whose keys are longer in full than the leaf's may not
+		  take it, and is then split in turn */
 {
 
 	AM_LEAFHEADER head,temphead; /* local header */
@@ -26,8 +28,16 @@ char *key; /* returns the key to be filled in the parent */
 								         page */
 	char *tempPageBuf,*tempPageBuf1;/* buffers for new pages to be
 								    allocated */
+	char last[AM_MAXATTRLENGTH],first[AM_MAXATTRLENGTH]; /* keys either
+						side of the split */
 	int errVal; 
+	int fileDesc = ih->fileDesc;
+	int attrLength = ih->attrLength;
 	int tempPageNum,tempPageNum1;/* pagenumbers for pages to be allocated */
+	int splitRoot; /* whether the leaf split is the root */
+	int prefixLength,keySize; /* how a half is stored */
+	int newPrefixLength,newKeySize; /* how a leaf of the new pair alone
+					   is stored */
 
 	/* initialise pointers to headers */
 	header = &head;
@@ -36,30 +46,81 @@ char *key; /* returns the key to be filled in the parent */
 	/* copy header from buffer */
 	bcopy(pageBuf,header,AM_sl);
 
-	/* compact half the keys into temporary page */
-	AM_Compact(1,(header->numKeys)/2,pageBuf,tempPage,header);
-
-	/* Allocate a new page for the other half of the leaf*/
-	errVal = PF_AllocPage(fileDesc,&tempPageNum,&tempPageBuf);
-	AM_Check;
-
-	/* compact the other half keys */
-	AM_Compact((header->numKeys)/2 + 1,header->numKeys
-			      ,pageBuf,tempPageBuf,header);
-
-	/*check where key has to be inserted */
-	if (index <= ((header->numKeys)/2))
+	if (header->numKeys < 2)
 	{
-		/*value to be inserted is in first half */
-		errVal = AM_InsertintoLeaf(tempPage,attrLength,value,recId,
-					   index,status);
+		/* a single key fills the page with its recIds, and cannot be
+		split between keys.  The new pair goes into a leaf of its own:
+		on the right if it is above the key, or else on the left, the
+		leaf a search for the key goes to first.  The full leaf moves
+		over whole - a key with more recIds than a leaf holds so goes on
+		into the leaves after it, each of them full */
+		AM_LeafEncoding(pageBuf,header,1,header->numKeys,NULL,
+				ih->compressKeys,&prefixLength,&keySize);
+		AM_LeafEncoding(pageBuf,header,1,0,value,ih->compressKeys,
+				&newPrefixLength,&newKeySize);
+		errVal = PF_AllocPage(fileDesc,&tempPageNum,&tempPageBuf);
+		AM_Check;
+		AM_LockNode(ih,tempPageNum);
+		if (index > header->numKeys)
+		{
+			AM_Compact(1,header->numKeys,pageBuf,tempPage,header,
+				   prefixLength,keySize);
+			AM_Compact(1,0,pageBuf,tempPageBuf,header,
+				   newPrefixLength,newKeySize);
+			*inserted = AM_InsertintoLeaf(tempPageBuf,
+						      ih->compressKeys,
+						      attrLength,value,recId,1,
+						      AM_NOT_FOUND);
+		}
+		else
+		{
+			AM_Compact(1,0,pageBuf,tempPage,header,
+				   newPrefixLength,newKeySize);
+			AM_Compact(1,header->numKeys,pageBuf,tempPageBuf,header,
+				   prefixLength,keySize);
+			*inserted = AM_InsertintoLeaf(tempPage,ih->compressKeys,
+						      attrLength,value,recId,1,
+						      AM_NOT_FOUND);
+		}
 	}
 	else
 	{
-		/* value to be inserted in second half */
-		index = index - ((header->numKeys)/2);
-		errVal = AM_InsertintoLeaf(tempPageBuf,attrLength,value,
-					   recId,index,status);
+		/* compact half the keys into temporary page, each half stored as
+		tightly as its own keys allow */
+		AM_LeafEncoding(pageBuf,header,1,(header->numKeys)/2,NULL,
+				ih->compressKeys,&prefixLength,&keySize);
+		AM_Compact(1,(header->numKeys)/2,pageBuf,tempPage,header,
+			   prefixLength,keySize);
+
+		/* Allocate a new page for the other half of the leaf*/
+		errVal = PF_AllocPage(fileDesc,&tempPageNum,&tempPageBuf);
+		AM_Check;
+		AM_LockNode(ih,tempPageNum);
+
+		/* compact the other half keys */
+		AM_LeafEncoding(pageBuf,header,(header->numKeys)/2 + 1,
+				header->numKeys,NULL,ih->compressKeys,
+				&prefixLength,&keySize);
+		AM_Compact((header->numKeys)/2 + 1,header->numKeys
+				      ,pageBuf,tempPageBuf,header,prefixLength,keySize);
+
+		/*check where key has to be inserted */
+		if (index <= ((header->numKeys)/2))
+		{
+			/*value to be inserted is in first half */
+			*inserted = AM_InsertintoLeaf(tempPage,ih->compressKeys,
+						      attrLength,value,recId,index,
+						      status);
+		}
+		else
+		{
+			/* value to be inserted in second half */
+			index = index - ((header->numKeys)/2);
+			*inserted = AM_InsertintoLeaf(tempPageBuf,
+						      ih->compressKeys,
+						      attrLength,value,recId,index,
+						      status);
+		}
 	}
 
 	/* change the next leafpage of first half of leaf to second half */
@@ -68,31 +129,36 @@ char *key; /* returns the key to be filled in the parent */
 	bcopy(tempheader,tempPage,AM_sl);
 	bcopy(tempPage,pageBuf,PF_PAGE_SIZE);
 
-	/* copy the value of key to be written onto the parent */
-
-	bcopy(tempPageBuf + AM_sl,key,attrLength);
+	/* the key to be written onto the parent is the shortest that is
+	above the last key of the first half - or the same, if the key goes
+	on into the second - and not above the first key of the second */
+	AM_GetLeafKey(tempPage,tempheader,tempheader->numKeys,last);
+	bcopy(tempPageBuf,tempheader,AM_sl);
+	AM_GetLeafKey(tempPageBuf,tempheader,1,first);
+	AM_Separator(ih->compressKeys,attrLength,last,first,key);
 
 
 	/*check if the split page is root */
-	if ((*pageNum) == AM_RootPageNum)
+	splitRoot = ((*pageNum) == ih->rootPageNum);
+	if (splitRoot)
 	{
-		/* the page being split is the root*/
-		/* Allocate a new page for another leaf as a new root has 
-		to be created*/
+		/* the page being split is the root - a new root is created
+		above the two halves, and the meta data in the handle points
+		to it.  The first half stays where it was, so it is still the
+		leftmost leaf */
 		errVal = PF_AllocPage(fileDesc,&tempPageNum1,&tempPageBuf1);
 		AM_Check;
+		AM_LockNode(ih,tempPageNum1);
+		AM_LockNode(ih,AM_HEADERPAGE);
 
-		AM_LeftPageNum = tempPageNum1; /* this will remain the 
-							   leftmost page hence*/
-
-		/* copy the old first half(actually the root) into a new page */ 
-		bcopy(pageBuf,tempPageBuf1,PF_PAGE_SIZE);
-		/* Initialise the new root page */ 
-
-		AM_FillRootPage(pageBuf,tempPageNum1,tempPageNum,key,
-		header->attrLength ,header->maxKeys);
+		AM_FillRootPage(tempPageBuf1,*pageNum,tempPageNum,key,
+		header->attrLength,
+		AM_IntKeySize(ih->compressKeys,attrLength,key));
 		errVal = PF_UnfixPage(fileDesc,tempPageNum1,TRUE);
 		AM_Check;
+		ih->rootPageNum = tempPageNum1;
+		ih->height++;
+		ih->headerChanged = TRUE;
 	}
 
 	errVal = PF_UnfixPage(fileDesc,*pageNum,TRUE);
@@ -101,7 +167,7 @@ char *key; /* returns the key to be filled in the parent */
 	errVal = PF_UnfixPage(fileDesc,tempPageNum,TRUE);
 	AM_Check;
 
-	if ((*pageNum) == AM_RootPageNum)
+	if (splitRoot)
 		return(FALSE);
 	else
 	{
@@ -112,12 +178,11 @@ char *key; /* returns the key to be filled in the parent */
 
 /* Adds to the parent(on top of the path stack) attribute value and page Number*/
 /* ADDED int return type */
-int AM_AddtoParent(fileDesc,pageNum,value,attrLength)
-int fileDesc;
+int AM_AddtoParent(ih,pageNum,value)
+AM_INDEXHANDLE *ih; /* open index */
 int pageNum; /* page Number to be added to parent */
 char *value; /* pointer to attribute value to be added - 
                  gives back the attribute value to be added to it's parent*/
-int attrLength;
 
 {
 	char tempPage[PF_PAGE_SIZE];/* temporary page for manipulating page */
@@ -126,30 +191,39 @@ int attrLength;
 	int offset; /* Place in parent where key is to be added - 
 								got from stack*/
 	int errVal; 
+	int fileDesc = ih->fileDesc;
 	int pageNum1,pageNum2; /* pagenumber of new pages to be allocated */
 
 	char *pageBuf,*pageBuf1,*pageBuf2;
 	AM_INTHEADER head,*header;
+	int keySize; /* key size the node needs to take value */
 
 
 	/* initialise header */
 	header = &head;
 	/* Get the top of stack values for the page number of the parent 
 						 and offset of the key */
-	AM_topofStack(&pageNumber,&offset);
-	AM_PopStack();
+	AM_topofStack(ih,&pageNumber,&offset);
+	AM_PopStack(ih);
 
 	/* Get the parent node */
 	errVal = PF_GetThisPage(fileDesc,pageNumber,&pageBuf);
 	AM_Check;
+	AM_LockNode(ih,pageNumber);
 
 	/* copy the header from buffer */
 	bcopy(pageBuf,header,AM_sint);
 
-	/* check if there is room in this node for another key */
-	if ((header->numKeys) < (header->maxKeys))
+	/* check if there is room in this node for another key, at the
+	width the node would need to take it */
+	keySize = AM_IntKeySize(ih->compressKeys,ih->attrLength,value);
+	if (keySize < header->keySize)
+		keySize = header->keySize;
+	if ((header->numKeys) < AM_INTMAXKEYS(keySize))
 	{
 		/* add the attribute value to the node */ 
+		if (keySize > header->keySize)
+			AM_WidenIntNode(pageBuf,header,keySize);
 		AM_AddtoIntPage(pageBuf,value,pageNum,header,offset);
 
 		/* copy the updated header into buffer*/
@@ -164,25 +238,29 @@ int attrLength;
 		/* not enough room for another key */ 
 		errVal = PF_AllocPage(fileDesc,&pageNum1,&pageBuf1);
 		AM_Check;
+		AM_LockNode(ih,pageNum1);
 
 		/* split the internal node */
 		AM_SplitIntNode(pageBuf,tempPage,pageBuf1,header,
-					 value,pageNum,offset);
+					 value,pageNum,offset,ih->compressKeys);
 
 		/* check if page being split is root */
-		if (pageNumber == AM_RootPageNum)
+		if (pageNumber == ih->rootPageNum)
 		{
 			/* allocate a new page for a new root */
 			errVal = PF_AllocPage(fileDesc,&pageNum2,&pageBuf2);
 			AM_Check;
+			AM_LockNode(ih,pageNum2);
+			AM_LockNode(ih,AM_HEADERPAGE);
 
-			/* copy the first half into another buffer */
-			bcopy(tempPage,pageBuf2,PF_PAGE_SIZE);
+			/* the first half stays on the old root's page */
+			bcopy(tempPage,pageBuf,PF_PAGE_SIZE);
 
 			/* fill the header of new root page and the 
 			attribute value */
-			AM_FillRootPage(pageBuf,pageNum2,pageNum1,value,
-			header->attrLength, header->maxKeys);
+			AM_FillRootPage(pageBuf2,pageNumber,pageNum1,value,
+			header->attrLength,
+			AM_IntKeySize(ih->compressKeys,ih->attrLength,value));
 
 			errVal = PF_UnfixPage(fileDesc,pageNumber,TRUE);
 			AM_Check;
@@ -193,6 +271,10 @@ int attrLength;
 			errVal = PF_UnfixPage(fileDesc,pageNum2,TRUE);
 			AM_Check;
 
+			/* one level more */
+			ih->rootPageNum = pageNum2;
+			ih->height++;
+			ih->headerChanged = TRUE;
 			return(AME_OK);
 		}
 		else
@@ -207,9 +289,9 @@ int attrLength;
 
 			/* recursive call to add to the parent of this 
 			internal node*/
-			errVal =  AM_AddtoParent(fileDesc,pageNum1,value,
-						 attrLength);
-			AM_Check;
+			errVal =  AM_AddtoParent(ih,pageNum1,value);
+			if (errVal < 0)
+				return(errVal);
 		}
 	}
 	return(AME_OK);
@@ -217,7 +299,7 @@ int attrLength;
 
 
 
-/* adds a key to an internal node */
+/* adds a key to an internal node - it must fit the node's key size */
 /* ADDED void return type */
 void AM_AddtoIntPage(pageBuf,value,pageNum,header,offset)
 char *pageBuf;
@@ -230,7 +312,7 @@ AM_INTHEADER *header;
 	int recSize;
 	int i;
 
-	recSize = header->attrLength + AM_si;
+	recSize = header->keySize + AM_si;
 
 	/* shift all the keys greater than the one to be added to the right to
 	make way for new key */
@@ -239,8 +321,8 @@ AM_INTHEADER *header;
 		      AM_sint +i*recSize + AM_si,recSize);
 
 	/* copy the attribute value into the appropriate place */
-	bcopy(value,pageBuf + AM_sint + offset*recSize + 
-	      AM_si,header->attrLength);
+	AM_PutIntKey(pageBuf + AM_sint + offset*recSize + AM_si,
+		     header->keySize,value,header->attrLength);
 
 	/* copy the pagenumber of the child */
 	bcopy((char *)&pageNum,pageBuf + AM_sint + (offset+1)*recSize,AM_si);
@@ -253,11 +335,12 @@ AM_INTHEADER *header;
 
 /* Fills the header and inserts a key into a new root */
 /* ADDED void return type */
-void AM_FillRootPage(pageBuf,pageNum1,pageNum2,value,attrLength,maxKeys)
+void AM_FillRootPage(pageBuf,pageNum1,pageNum2,value,attrLength,keySize)
 char *pageBuf;/* buffer to new root */
 int pageNum1,pageNum2;/* pagenumbers of it;s two children*/
 char *value; /* attr value to be inserted */
-short attrLength,maxKeys; /* some info about the header */
+short attrLength,keySize; /* some info about the header - keySize as
+			     AM_IntKeySize gives it for value */
 
 {
 	AM_INTHEADER temphead,*tempheader;
@@ -267,74 +350,221 @@ short attrLength,maxKeys; /* some info about the header */
 	/* fill the header */
 	tempheader->pageType = 'i';
 	tempheader->attrLength = attrLength;
-	tempheader->maxKeys = maxKeys;
+	tempheader->keySize = keySize;
 	tempheader->numKeys = 1;
 	bcopy((char *)&pageNum1,pageBuf + AM_sint ,AM_si);
-	bcopy(value,pageBuf + AM_sint + AM_si ,attrLength);
-	bcopy((char *)&pageNum2,pageBuf + AM_sint + AM_si + attrLength,AM_si);
+	AM_PutIntKey(pageBuf + AM_sint + AM_si,keySize,value,attrLength);
+	bcopy((char *)&pageNum2,pageBuf + AM_sint + AM_si + keySize,AM_si);
 	bcopy(tempheader,pageBuf,AM_sint);
 
 }
 
 
-/* Split an internal node */
+/* Split an internal node.  The keys, the new one among them, are cut
+in two about a middle key that goes up to the parent.  Each half gets
+the key size its longest key needs; should a long new key make the even
+split too wide for a page, the cut moves towards it until both halves
+fit */
 /* ADDED void return type */
-void AM_SplitIntNode(pageBuf,pbuf1,pbuf2,header,value,pageNum,offset)
+void AM_SplitIntNode(pageBuf,pbuf1,pbuf2,header,value,pageNum,offset,
+		     compress)
 char *pageBuf;/* internal node to be split */
 char *pbuf1,*pbuf2; /* the buffers for the two halves */
 char *value; /* pointer to key to be added and to be returned to parent*/
 AM_INTHEADER *header;
 int pageNum,offset;
+int compress; /* as the compressKeys of the index */
 
 {
 	AM_INTHEADER temphead,*tempheader;
-	int recSize;
-	char tempPage[PF_PAGE_SIZE + AM_MAXATTRLENGTH];/* temp page for 
-	                                               manipulating pageBuf */
-	int length1,length2;
+	char *keys[AM_MAXINTKEYS + 1]; /* the keys in order, new one and all */
+	int lengths[AM_MAXINTKEYS + 1]; /* bytes of each that can be read */
+	int children[AM_MAXINTKEYS + 2]; /* the child left of key t is t */
+	int sizes[AM_MAXINTKEYS + 1]; /* key size each key needs */
+	int leftSize[AM_MAXINTKEYS + 1]; /* key size of keys 0 to t-1 */
+	int rightSize[AM_MAXINTKEYS + 1]; /* key size of keys t+1 to n */
+	char key[AM_MAXATTRLENGTH]; /* a key in full */
+	int attrLength = header->attrLength;
+	int storedLength; /* bytes of a stored key that can be read */
+	int n = header->numKeys; /* keys are numbered 0 to n */
+	int middle,tries,t,i;
+
+	storedLength = (header->keySize < attrLength) ? header->keySize :
+			attrLength;
+	bcopy(AM_INTCHILD(pageBuf,header,0),(char *)&children[0],AM_si);
+	for (t = 0, i = 1; t <= n; t++)
+	{
+		if (t == offset)
+		{
+			keys[t] = value;
+			lengths[t] = attrLength;
+			children[t + 1] = pageNum;
+			continue;
+		}
+		keys[t] = AM_INTKEY(pageBuf,header,i);
+		lengths[t] = storedLength;
+		bcopy(AM_INTCHILD(pageBuf,header,i),(char *)&children[t + 1],
+		      AM_si);
+		i++;
+	}
+	for (t = 0; t <= n; t++)
+	{
+		memset(key,0,attrLength);
+		bcopy(keys[t],key,lengths[t]);
+		sizes[t] = AM_IntKeySize(compress,attrLength,key);
+	}
+	leftSize[0] = 0;
+	for (t = 1; t <= n; t++)
+		leftSize[t] = (sizes[t - 1] > leftSize[t - 1]) ? sizes[t - 1] :
+			      leftSize[t - 1];
+	rightSize[n] = 0;
+	for (t = n - 1; t >= 0; t--)
+		rightSize[t] = (sizes[t + 1] > rightSize[t + 1]) ? sizes[t + 1] :
+			       rightSize[t + 1];
+
+	/* the middle key, from the centre out - each half keeps a key */
+	middle = n/2;
+	for (tries = 0; tries <= 2*n; tries++)
+	{
+		t = (tries % 2) ? n/2 - (tries + 1)/2 : n/2 + tries/2;
+		if ((t < 1) || (t > n - 1))
+			continue;
+		if ((t <= AM_INTMAXKEYS(leftSize[t])) &&
+		    (n - t <= AM_INTMAXKEYS(rightSize[t])))
+		{
+			middle = t;
+			break;
+		}
+	}
 
+	/* the first half into pbuf1 */
 	tempheader = &temphead;
-	recSize = header->attrLength + AM_si;
-
 	tempheader->pageType = header->pageType;
-	tempheader->attrLength = header->attrLength;
-	tempheader->maxKeys = header->maxKeys;
+	tempheader->attrLength = attrLength;
+	tempheader->numKeys = middle;
+	tempheader->keySize = leftSize[middle];
+	bcopy((char *)&children[0],AM_INTCHILD(pbuf1,tempheader,0),AM_si);
+	for (t = 0; t < middle; t++)
+	{
+		AM_PutIntKey(AM_INTKEY(pbuf1,tempheader,t + 1),
+			     tempheader->keySize,keys[t],lengths[t]);
+		bcopy((char *)&children[t + 1],
+		      AM_INTCHILD(pbuf1,tempheader,t + 1),AM_si);
+	}
+	bcopy(tempheader,pbuf1,AM_sint);
 
-	length1 = AM_si + (offset*recSize);
-	/* copy the keys to the left of the key to be added */
-	bcopy(pageBuf + AM_sint,tempPage,length1);
+	/* the second half into pbuf2 */
+	tempheader->numKeys = n - middle;
+	tempheader->keySize = rightSize[middle];
+	bcopy((char *)&children[middle + 1],AM_INTCHILD(pbuf2,tempheader,0),
+	      AM_si);
+	for (t = middle + 1; t <= n; t++)
+	{
+		AM_PutIntKey(AM_INTKEY(pbuf2,tempheader,t - middle),
+			     tempheader->keySize,keys[t],lengths[t]);
+		bcopy((char *)&children[t + 1],
+		      AM_INTCHILD(pbuf2,tempheader,t - middle),AM_si);
+	}
+	bcopy(tempheader,pbuf2,AM_sint);
 
-	/* copy the key itself */
-	bcopy(value,tempPage + length1,header->attrLength);
+	/* copy the middle key into value to be passed back to parent */
+	memset(key,0,attrLength);
+	bcopy(keys[middle],key,lengths[middle]);
+	bcopy(key,value,attrLength);
 
-	/* copy the pagenumber of the child node */
-	bcopy((char *)&pageNum,tempPage + length1 + header->attrLength ,AM_si);
+}
 
-	length2 = (header->maxKeys - offset)*recSize;
 
-	/* copy the rest of the keys */
-	bcopy(pageBuf + AM_sint + length1,tempPage + length1 + header->attrLength 
-	    + AM_si,length2);
+/* Copies a key of length bytes, zero past its end, into a key of keySize
+bytes of an internal node */
+/* ADDED void return type */
+void AM_PutIntKey(keyPtr,keySize,value,length)
+char *keyPtr;
+int keySize;
+char *value;
+int length;
 
-	/* number of keys in each half */
-	length1 = (header->maxKeys)/2;
+{
+	memset(keyPtr,0,keySize);
+	bcopy(value,keyPtr,(length < keySize) ? length : keySize);
+}
 
-	length2 = AM_si + length1*recSize;
-	/* copy the first half into pbuf1 */
-	bcopy(tempPage,pbuf1 + AM_sint,length2);
-	tempheader->numKeys = length1;
 
-	/* copy header into pbuf1 */
-	bcopy(tempheader,pbuf1,AM_sint);
+/* Returns the key size an internal node needs to hold value, a key in
+canonical form: a string needs no more than its length */
+/* ADDED int return type */
+int AM_IntKeySize(compress,attrLength,value)
+int compress; /* as the compressKeys of the index */
+int attrLength;
+char *value;
 
-	/* copy the middle key into value to be passed back to parent */
-	bcopy(tempPage + AM_si + length1 * recSize,value,header->attrLength);
+{
+	int length;
 
-	/* copy the second half into pbuf2*/
-	bcopy(tempPage + AM_si + length1 * recSize + header->attrLength,
-	      pbuf2 + AM_sint,length2); 
-	bcopy(tempheader,pbuf2,AM_sint);
+	if (!compress)
+		return(AM_KEYSIZE(attrLength));
+	length = strnlen(value,attrLength);
+	return(AM_KEYSIZE((length > 0) ? length : 1));
+}
+
+
+/* Moves the keys and children of an internal node apart so that each
+key has keySize bytes, more than it has now */
+/* ADDED void return type */
+void AM_WidenIntNode(pageBuf,header,keySize)
+char *pageBuf;
+AM_INTHEADER *header;
+int keySize;
+
+{
+	AM_INTHEADER wide;
+	int i;
+
+	bcopy(header,&wide,AM_sint);
+	wide.keySize = keySize;
 
+	/* from the last key down, as each goes at or past where it was */
+	for (i = header->numKeys; i >= 1; i--)
+	{
+		memmove(AM_INTCHILD(pageBuf,&wide,i),
+			AM_INTCHILD(pageBuf,header,i),AM_si);
+		memmove(AM_INTKEY(pageBuf,&wide,i),AM_INTKEY(pageBuf,header,i),
+			header->keySize);
+		memset(AM_INTKEY(pageBuf,&wide,i) + header->keySize,0,
+		       keySize - header->keySize);
+	}
+	header->keySize = keySize;
+}
+
+
+/* Puts into sep the key a parent is given to tell apart a child whose
+largest key is left from the next child, whose smallest key is right.
+Strings are cut to the shortest start of right that is above left; as
+every key added later between the two goes to whichever side the
+separator sends it, any such string does */
+/* ADDED void return type */
+void AM_Separator(compress,attrLength,left,right,sep)
+int compress; /* as the compressKeys of the index */
+int attrLength;
+char *left,*right; /* in canonical form */
+char *sep; /* attrLength bytes */
+
+{
+	int length;
+
+	if (!compress)
+	{
+		bcopy(right,sep,attrLength);
+		return;
+	}
+	for (length = 0; (length < attrLength) && (right[length] != '\0') &&
+	     (left[length] == right[length]); length++)
+		;
+	/* right is above left from that byte on */
+	if (length < attrLength)
+		length++;
+	memset(sep,0,attrLength);
+	bcopy(right,sep,length);
 }
 
 /* * DELETED redundant bcopy function. 
@@ -1,31 +1,157 @@
 /* am.h: MODIFIED FOR MODERN COMPILER */
 #include <stdlib.h> /* For malloc/calloc */
 #include <string.h> /* For bcopy/memcpy */
+#include <pthread.h>
 
 typedef struct am_leafheader
 	{
 		char pageType;
+		short attrLength;
+		short keySize; /* bytes of a key in the key array */
+		short numKeys;
 		int nextLeafPage;
 		short recIdPtr;
 		short keyPtr;
 		short freeListPtr;
 		short numinfreeList;
-		short attrLength;
-		short numKeys;
-		short maxKeys;
+		short prefixLength; /* bytes every key of the leaf begins with */
 	}  AM_LEAFHEADER; /* Header for a leaf page */
 
+/* A leaf is laid out as
+	header | prefix | keys | heads | free space | recId lists
+The key array holds numKeys keys of keySize bytes, a multiple of an int,
+so the keys are aligned and nothing else lies between them.  The head
+array after it holds, for each key, the offset of the first entry of its
+recId list.  The lists are made of (recId,next) entries that grow down
+from the end of the page, and deleted entries go on a free list.  keyPtr
+is the end of the head array and recIdPtr the lowest list entry.  Key i,
+and its head, are numbered from 1.
+
+Int and float keys are kept whole: prefixLength is 0 and keySize is
+attrLength.  A string key is kept as what follows the prefix of its leaf
+- the first prefixLength bytes, which all its keys have in common, stored
+once before the key array.  As the bytes past the end of a string are
+zero, keySize need only hold the longest of those rests.  The key itself
+is the prefix, its rest, then zeros up to attrLength.  String keys are
+made zero past their end before they go in */
+# define AM_KEYSIZE(attrLength) ((((attrLength) + AM_si - 1)/AM_si)*AM_si)
+# define AM_LEAFPREFIX(pageBuf) ((pageBuf) + AM_sl)
+# define AM_LEAFKEY(pageBuf,header,i) ((pageBuf) + AM_sl + \
+	AM_KEYSIZE((header)->prefixLength) + ((i) - 1)*(header)->keySize)
+# define AM_LEAFHEAD(pageBuf,header,i) ((pageBuf) + AM_sl + \
+	AM_KEYSIZE((header)->prefixLength) + \
+	(header)->numKeys*(header)->keySize + ((i) - 1)*AM_ss)
+/* bytes past the header taken by the prefix and numKeys keys of a leaf
+stored that way, and by numRecs list entries */
+# define AM_LEAFBYTES(prefixLength,keySize,numKeys,numRecs) \
+	(AM_KEYSIZE(prefixLength) + (numKeys)*((keySize) + AM_ss) + \
+	 (numRecs)*(AM_si + AM_ss))
+
 typedef struct am_intheader 
 	{
 		char pageType;
 		short numKeys;
-		short maxKeys;
+		short keySize; /* bytes of a key in the node */
 		short attrLength;
 	}	AM_INTHEADER ; /* Header for an internal node */
 
-extern int AM_RootPageNum; /* The page number of the root */
-extern int AM_LeftPageNum; /* The page Number of the leftmost leaf */
-extern int AM_Errno; /* last error in AM layer */
+/* An internal node is laid out as
+	header | child 0 | key 1 | child 1 | ... | key numKeys | child numKeys
+with keys of keySize bytes.  For ints and floats that is attrLength.  A
+string node need only be as wide as its longest key, padded with zeros:
+the separators put into it are cut to the shortest string that still
+tells the two children apart.  A node is widened when a longer key comes
+in, and holds AM_INTMAXKEYS keys of its width */
+# define AM_INTKEY(pageBuf,header,i) \
+	((pageBuf) + AM_sint + AM_si + ((i) - 1)*((header)->keySize + AM_si))
+# define AM_INTCHILD(pageBuf,header,i) \
+	((pageBuf) + AM_sint + (i)*((header)->keySize + AM_si))
+# define AM_INTMAXKEYS(keySize) \
+	((int)((PF_PAGE_SIZE - AM_sint - AM_si)/((keySize) + AM_si)))
+# define AM_MAXINTKEYS AM_INTMAXKEYS(AM_si) /* most keys a node can hold */
+
+typedef struct am_indexheader
+	{
+		char pageType; /* 'h' */
+		char attrType;
+		short attrLength;
+		int rootPageNum;
+		int leftPageNum;
+		int height;
+		int numEntries;
+		int format; /* AM_FORMAT */
+		int compressKeys; /* TRUE: string keys are stored after the
+				     prefix of their leaf, and separators cut
+				     short - fixed when the index is made */
+	}	AM_INDEXHEADER; /* Header page of an index - page 0 of the file */
+
+/* "AM" and the version of the page layout.  Index files made before the
+field was added hold anything there, and have keys and recId heads
+interleaved in their leaves; the first of them have no header page at all
+and keep their root on page 0.  Version 2 kept every key whole, at
+attrLength.  AM_RebuildIndex brings any of these up to date */
+# define AM_FORMAT 0x414d0003
+# define AM_FORMAT2 0x414d0002
+
+# define AM_HEADERPAGE 0 /* page of the index header */
+# define AM_MAXSTACK 50 /* deepest path AM_Search can stack */
+# define AM_NUMVERSIONS 1024 /* version counters of an index - page p has
+				counter p % AM_NUMVERSIONS */
+# define AM_MAXLOCKED (2*AM_MAXSTACK + 4) /* counters one insert can lock */
+
+/* Search of an internal node (as AM_BinSearch) and of a leaf (as
+AM_SearchLeaf) */
+typedef int (*AM_IntSearchFcn)(char *, char, int, char *, int *, AM_INTHEADER *);
+typedef int (*AM_LeafSearchFcn)(char *, char, int, char *, int *, AM_LEAFHEADER *);
+
+typedef struct am_keyops
+	{
+		int (*compare)(char *, char, int, char *); /* as AM_Compare */
+		AM_IntSearchFcn intSearch;
+		AM_LeafSearchFcn leafSearch;
+	}	AM_KEYOPS; /* key routines made for one key type */
+
+typedef struct am_stackentry
+	{
+		int pageNumber;
+		int offset;
+	}	AM_STACKENTRY; /* internal node on the path to a leaf */
+
+typedef struct am_indexhandle
+	{
+		int fileDesc; /* PF file of the index, -1 when closed */
+		char attrType; /* 'c', 'i' or 'f' */
+		int attrLength;
+		int rootPageNum; /* The page number of the root */
+		int leftPageNum; /* The page Number of the leftmost leaf */
+		int height; /* levels of the tree, 1 while the root is a leaf */
+		int numEntries; /* (key,recId) pairs in the index */
+		int headerChanged; /* the fields above differ from the header
+				      page, which AM_CloseIndex rewrites */
+		AM_KEYOPS *keyOps; /* key routines for attrType */
+		int compressKeys; /* TRUE for a 'c' index whose header says so -
+				     the encoding the AM routines write */
+		AM_STACKENTRY stack[AM_MAXSTACK]; /* path of the last search */
+		int topofStack;
+		/* optimistic lock coupling: a counter is odd while the writer
+		changes a page it covers, and grows each time it does.  The
+		counter of AM_HEADERPAGE also covers the root and height above */
+		unsigned long versions[AM_NUMVERSIONS];
+		int lockedSlots[AM_MAXLOCKED]; /* counters the writer holds */
+		int numLocked;
+		long restarts; /* optimistic reads that had to start again */
+		pthread_mutex_t writeMutex; /* one writer at a time */
+	}	AM_INDEXHANDLE; /* An open index, filled in by AM_OpenIndex */
+
+extern _Thread_local int AM_Errno; /* last error in AM layer, per thread */
+
+/* Hands AM_BulkLoad the next (value,recId) pair in key order: returns TRUE
+with *value and *recId filled in, FALSE at the end or an AM error code */
+typedef int (*AM_NextEntryFcn)(void *, char *, int *);
+
+/* Gives AM_BuildIndex the key of a record: fills in the key and returns
+TRUE, or returns FALSE if the record is not to be indexed */
+typedef int (*AM_KeyFcn)(void *, char *, int, char *);
 
 /* * REMOVED conflicting extern char *calloc();
  * REMOVED conflicting extern char *malloc();
@@ -73,52 +199,89 @@ extern int AM_Errno; /* last error in AM layer */
 # define AME_INVALIDATTRTYPE -9
 # define AME_FD -10
 # define AME_INVALIDVALUE -11
+# define AME_NOTEMPTY -12
+# define AME_NOTINDEX -13
+# define AME_OLDFORMAT -14
 
 
 /* --- ADDED FUNCTION PROTOTYPES --- */
 
 /* From am.c */
-int AM_SplitLeaf(int, char *, int *, int, int, char *, int, int, char *);
-int AM_AddtoParent(int, int, char *, int);
+int AM_SplitLeaf(AM_INDEXHANDLE *, char *, int *, int, char *, int, int, char *, int *);
+int AM_AddtoParent(AM_INDEXHANDLE *, int, char *);
 void AM_AddtoIntPage(char *, char *, int, AM_INTHEADER *, int);
 void AM_FillRootPage(char *, int, int, char *, short, short);
-void AM_SplitIntNode(char *, char *, char *, AM_INTHEADER *, char *, int, int);
+void AM_SplitIntNode(char *, char *, char *, AM_INTHEADER *, char *, int, int, int);
+void AM_PutIntKey(char *, int, char *, int);
+int AM_IntKeySize(int, int, char *);
+void AM_WidenIntNode(char *, AM_INTHEADER *, int);
+void AM_Separator(int, int, char *, char *, char *);
+
+/* From ambulk.c */
+int AM_BulkLoad(AM_INDEXHANDLE *, AM_NextEntryFcn, void *, int);
+
+/* From ambuild.c (needs rm.h included before this file) */
+#ifdef RM_H
+int AM_BuildIndex(AM_INDEXHANDLE *, RM_FileHandle *, int, AM_KeyFcn, void *, int);
+#endif
 
 /* From amfns.c */
 int AM_CreateIndex(char *, int, char, int);
+int AM_CreateIndexEncoding(char *, int, char, int, int);
 int AM_DestroyIndex(char *, int);
-int AM_DeleteEntry(int, char, int, char *, int);
-int AM_InsertEntry(int, char, int, char *, int);
+int AM_OpenIndex(char *, int, AM_INDEXHANDLE *);
+int AM_CloseIndex(AM_INDEXHANDLE *);
+int AM_WriteHeader(AM_INDEXHANDLE *);
+int AM_DeleteEntry(AM_INDEXHANDLE *, char *, int);
+int AM_InsertEntry(AM_INDEXHANDLE *, char *, int);
 void AM_PrintError(char *);
 
 /* From aminsert.c */
-int AM_InsertintoLeaf(char *, int, char *, int, int, int);
+int AM_InsertintoLeaf(char *, int, int, char *, int, int, int);
+void AM_AddLeafKey(char *, AM_LEAFHEADER *, char *, int);
+void AM_RemoveLeafKey(char *, AM_LEAFHEADER *, int);
 void AM_InsertToLeafFound(char *, int, int, AM_LEAFHEADER *);
 void AM_InsertToLeafNotFound(char *, char *, int, int, AM_LEAFHEADER *);
-void AM_Compact(int, int, char *, char *, AM_LEAFHEADER *);
+void AM_Compact(int, int, char *, char *, AM_LEAFHEADER *, int, int);
+void AM_GetLeafKey(char *, AM_LEAFHEADER *, int, char *);
+int AM_LeafKeyFits(AM_LEAFHEADER *, char *, int, char *);
+void AM_LeafEncoding(char *, AM_LEAFHEADER *, int, int, char *, int, int *, int *);
+
+/* From amolc.c */
+void AM_LockNode(AM_INDEXHANDLE *, int);
+void AM_UnlockNodes(AM_INDEXHANDLE *);
+unsigned long AM_ReadVersion(AM_INDEXHANDLE *, int);
+int AM_CheckVersion(AM_INDEXHANDLE *, int, unsigned long);
+int AM_ReadNode(AM_INDEXHANDLE *, int, char *, unsigned long *);
+int AM_OptSearch(AM_INDEXHANDLE *, char *, int *, char *, int *);
 
+/* From amprint.c */
 void AM_PrintIntNode(char *, char);
 void AM_PrintLeafNode(char *, char);
 /* --- MODIFIED --- Changed return type to int */
-int AM_DumpLeafPages(int, int, char, int);
+int AM_DumpLeafPages(AM_INDEXHANDLE *, int);
 void AM_PrintLeafKeys(char *, char);
 void AM_PrintAttr(char *, char, int);
-void AM_PrintTree(int, int, char);
+void AM_PrintTree(AM_INDEXHANDLE *, int);
+
+/* From amrebuild.c */
+int AM_RebuildIndex(char *, int, char, int);
 
 /* From amscan.c */
-int AM_OpenIndexScan(int, char, int, int, char *);
+int AM_OpenIndexScan(AM_INDEXHANDLE *, int, char *);
 int AM_FindNextEntry(int);
 int AM_CloseIndexScan(int);
-int GetLeftPageNum(int);
 
 /* From amsearch.c */
-int AM_Search(int, char, int, char *, int *, char **, int *);
+int AM_Search(AM_INDEXHANDLE *, char *, int *, char **, int *);
 int AM_BinSearch(char *, char, int, char *, int *, AM_INTHEADER *);
 int AM_SearchLeaf(char *, char, int, char *, int *, AM_LEAFHEADER *);
 int AM_Compare(char *, char, int, char *);
+void AM_BindKeyOps(AM_INDEXHANDLE *);
+extern AM_KEYOPS AM_intOps, AM_floatOps, AM_charOps, AM_generalOps;
 
 /* From amstack.c */
-void AM_PushStack(int, int);
-void AM_PopStack(void);
-void AM_topofStack(int *, int *);
-void AM_EmptyStack(void);
\ No newline at end of file
+void AM_PushStack(AM_INDEXHANDLE *, int, int);
+void AM_PopStack(AM_INDEXHANDLE *);
+void AM_topofStack(AM_INDEXHANDLE *, int *, int *);
+void AM_EmptyStack(AM_INDEXHANDLE *);
\ No newline at end of file
@@ -0,0 +1,306 @@
+# include <stdio.h>
+# include <string.h>
+# include <pthread.h>
+# include "pf.h"
+# include "rm.h"
+# include "am.h"
+
+/* Builds an index over an RM file with several threads.  The file's pages
+are cut into one contiguous range per thread by RM_ParallelScan; each
+worker extracts the keys of the records in its range into a run of its
+own, in memory, and then sorts that run.  The sorted runs are merged
+through a heap on the calling thread, straight into AM_BulkLoad, so the
+tree itself is still built by one thread, bottom up.  Equal keys keep
+the order of their records in the file: the sort within a run is
+stable, ranges are in page order, and the merge breaks ties by run. */
+
+typedef struct am_buildrun
+	{
+		char *entries; /* numEntries entries of entrySize bytes: recId,
+				then the key */
+		int numEntries;
+		int capacity;
+		int next; /* next entry to merge */
+		int entrySize;
+		char attrType;
+		int attrLength;
+		int (*compare)(char *, char, int, char *); /* of the index */
+		AM_KeyFcn keyFcn;
+		void *keyArg;
+		int result;
+	} AM_BUILDRUN;
+
+typedef struct am_buildmerge
+	{
+		AM_BUILDRUN *runs;
+		int heap[RM_MAXTHREADS]; /* runs with entries left, smallest
+					first */
+		int heapSize;
+	} AM_BUILDMERGE;
+
+# define AM_BUILDKEY(run,i) ((run)->entries + (long)(i)*(run)->entrySize + AM_si)
+
+
+/* RM_ParallelScan callback: adds the record's key, if it has one, to the
+worker's run */
+static int AM_BuildAddRecord(arg,rid,rec,recLength)
+void *arg;
+RID rid;
+char *rec;
+int recLength;
+
+{
+	AM_BUILDRUN *run = (AM_BUILDRUN *)arg;
+	char *entries;
+	char *entry;
+
+	if (run->numEntries == run->capacity)
+		{
+		 run->capacity = (run->capacity == 0) ? 1024 : 2*run->capacity;
+		 entries = realloc(run->entries,(long)run->capacity*run->entrySize);
+		 if (entries == NULL)
+			return(RME_NOMEM);
+		 run->entries = entries;
+		}
+	entry = run->entries + (long)run->numEntries*run->entrySize;
+	if ((*run->keyFcn)(run->keyArg,rec,recLength,entry + AM_si) == TRUE)
+		{
+		 bcopy((char *)&rid,entry,AM_si);
+		 run->numEntries++;
+		}
+	return(RME_OK);
+}
+
+
+/* Stable merge sort of a run on its keys */
+static void AM_BuildSortRun(run)
+AM_BUILDRUN *run;
+
+{
+	char *from,*to,*tmp;
+	char *a,*b,*out;
+	int width,lo,mid,hi,i,j;
+	long size = run->entrySize;
+
+	if (run->numEntries < 2)
+		return;
+	to = malloc((long)run->numEntries*size);
+	if (to == NULL)
+		{
+		 run->result = RME_NOMEM;
+		 return;
+		}
+	from = run->entries;
+
+	for (width = 1; width < run->numEntries; width *= 2)
+		{
+		 for (lo = 0; lo < run->numEntries; lo += 2*width)
+			{
+			 mid = (lo + width < run->numEntries) ? lo + width : run->numEntries;
+			 hi = (lo + 2*width < run->numEntries) ? lo + 2*width : run->numEntries;
+			 out = to + lo*size;
+			 for (i = lo, j = mid; i < mid || j < hi; out += size)
+				{
+				 a = from + i*size;
+				 b = from + j*size;
+				 /* take from the right only if its key is smaller */
+				 if ((j < hi) && ((i == mid) ||
+				     ((*run->compare)(a + AM_si,run->attrType,
+						      run->attrLength,b + AM_si) < 0)))
+					{
+					 bcopy(b,out,size);
+					 j++;
+					}
+				 else
+					{
+					 bcopy(a,out,size);
+					 i++;
+					}
+				}
+			}
+		 tmp = from;
+		 from = to;
+		 to = tmp;
+		}
+
+	/* the sorted entries end up in from */
+	free(to);
+	run->entries = from;
+}
+
+
+/* Worker of the sort phase */
+static void *AM_BuildSortMain(arg)
+void *arg;
+
+{
+	AM_BuildSortRun((AM_BUILDRUN *)arg);
+	return(NULL);
+}
+
+
+/* TRUE if the next entry of run a comes before that of run b */
+static int AM_BuildLess(merge,a,b)
+AM_BUILDMERGE *merge;
+int a,b;
+
+{
+	AM_BUILDRUN *ra = &merge->runs[a];
+	AM_BUILDRUN *rb = &merge->runs[b];
+	int compareVal;
+
+	compareVal = (*ra->compare)(AM_BUILDKEY(rb,rb->next),ra->attrType,
+				    ra->attrLength,AM_BUILDKEY(ra,ra->next));
+	return((compareVal < 0) || ((compareVal == 0) && (a < b)));
+}
+
+
+/* Moves the run at heap[i] down to its place */
+static void AM_BuildSiftDown(merge,i)
+AM_BUILDMERGE *merge;
+int i;
+
+{
+	int child;
+	int top = merge->heap[i];
+
+	while ((child = 2*i + 1) < merge->heapSize)
+		{
+		 if ((child + 1 < merge->heapSize) &&
+		     AM_BuildLess(merge,merge->heap[child + 1],merge->heap[child]))
+			child++;
+		 if (!AM_BuildLess(merge,merge->heap[child],top))
+			break;
+		 merge->heap[i] = merge->heap[child];
+		 i = child;
+		}
+	merge->heap[i] = top;
+}
+
+
+/* AM_BulkLoad iterator: the smallest entry left in any run */
+static int AM_BuildNextEntry(arg,value,recId)
+void *arg;
+char *value;
+int *recId;
+
+{
+	AM_BUILDMERGE *merge = (AM_BUILDMERGE *)arg;
+	AM_BUILDRUN *run;
+	char *entry;
+
+	if (merge->heapSize == 0)
+		return(FALSE);
+	run = &merge->runs[merge->heap[0]];
+	entry = run->entries + (long)run->next*run->entrySize;
+	bcopy(entry,(char *)recId,AM_si);
+	bcopy(entry + AM_si,value,run->attrLength);
+
+	if (++run->next == run->numEntries)
+		merge->heap[0] = merge->heap[--merge->heapSize];
+	if (merge->heapSize > 0)
+		AM_BuildSiftDown(merge,0);
+	return(TRUE);
+}
+
+
+/* Builds an empty index over the records of an open RM file, with
+numThreads threads scanning and sorting.  keyFcn is called from the
+worker threads; it fills in all attrLength bytes of the record's key,
+or returns FALSE if the record is not to be indexed */
+int AM_BuildIndex(ih,rmFile,numThreads,keyFcn,keyArg,fillPercent)
+AM_INDEXHANDLE *ih; /* open index */
+RM_FileHandle *rmFile; /* records to index */
+int numThreads; /* 1 to RM_MAXTHREADS */
+AM_KeyFcn keyFcn; /* extracts the key of a record */
+void *keyArg; /* passed to keyFcn */
+int fillPercent; /* as for AM_BulkLoad */
+
+{
+	AM_BUILDRUN runs[RM_MAXTHREADS];
+	AM_BUILDMERGE merge;
+	pthread_t threads[RM_MAXTHREADS];
+	void *args[RM_MAXTHREADS];
+	int started;
+	int errVal;
+	int i;
+	char attrType; /* 'i' or 'c' or 'f' */
+	int attrLength; /* 4 for 'i' or 'f', 1-255 for 'c' */
+
+	if ((ih == NULL) || (ih->fileDesc < 0))
+		{
+		 AM_Errno = AME_FD;
+		 return(AME_FD);
+		}
+	attrType = ih->attrType;
+	attrLength = ih->attrLength;
+	if ((numThreads < 1) || (numThreads > RM_MAXTHREADS) || (keyFcn == NULL))
+		{
+		 AM_Errno = AME_INVALIDVALUE;
+		 return(AME_INVALIDVALUE);
+		}
+	if ((attrLength < 1) || (attrLength > AM_MAXATTRLENGTH))
+		{
+		 AM_Errno = AME_INVALIDATTRLENGTH;
+		 return(AME_INVALIDATTRLENGTH);
+		}
+
+	for (i = 0; i < numThreads; i++)
+		{
+		 runs[i].entries = NULL;
+		 runs[i].numEntries = runs[i].capacity = runs[i].next = 0;
+		 /* keep the recIds aligned */
+		 runs[i].entrySize = AM_si + ((attrLength + AM_si - 1)/AM_si)*AM_si;
+		 runs[i].attrType = attrType;
+		 runs[i].attrLength = attrLength;
+		 runs[i].compare = ih->keyOps->compare;
+		 runs[i].keyFcn = keyFcn;
+		 runs[i].keyArg = keyArg;
+		 runs[i].result = RME_OK;
+		 args[i] = &runs[i];
+		}
+
+	/* scan: every worker fills its own run */
+	errVal = RM_ParallelScan(rmFile,numThreads,NULL,AM_BuildAddRecord,args);
+	if (errVal != RME_OK)
+		{
+		 for (i = 0; i < numThreads; i++)
+			free(runs[i].entries);
+		 AM_Errno = AME_INTERROR;
+		 return(AME_INTERROR);
+		}
+
+	/* sort: run 0 on this thread, the rest on new ones */
+	for (started = 1; started < numThreads; started++)
+		if (pthread_create(&threads[started],NULL,AM_BuildSortMain,
+				   &runs[started]) != 0)
+			break;
+	AM_BuildSortRun(&runs[0]);
+	for (i = 1; i < started; i++)
+		pthread_join(threads[i],NULL);
+	for (i = started; i < numThreads; i++)
+		AM_BuildSortRun(&runs[i]);
+
+	/* merge into the bulk load */
+	errVal = AME_OK;
+	merge.runs = runs;
+	merge.heapSize = 0;
+	for (i = 0; i < numThreads; i++)
+		{
+		 if (runs[i].result != RME_OK)
+			errVal = AME_INTERROR;
+		 if (runs[i].numEntries > 0)
+			merge.heap[merge.heapSize++] = i;
+		}
+	for (i = merge.heapSize/2 - 1; i >= 0; i--)
+		AM_BuildSiftDown(&merge,i);
+
+	if (errVal == AME_OK)
+		errVal = AM_BulkLoad(ih,AM_BuildNextEntry,&merge,fillPercent);
+	else
+		AM_Errno = errVal;
+
+	for (i = 0; i < numThreads; i++)
+		free(runs[i].entries);
+	return(errVal);
+}
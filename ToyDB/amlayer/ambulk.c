@@ -0,0 +1,701 @@
+# include <stdio.h>
+# include <string.h>
+# include "am.h"
+# include "pf.h"
+# include "pftypes.h"
+
+/* Builds a B+ tree bottom up from entries that arrive in key order.
+Leaves are filled left to right up to the fill factor, and a leaf is
+written out as soon as the next one is begun.  Each finished leaf
+hands a separator - its first key, or for strings the shortest key
+above the last one of the leaf before - and its page number to the
+level above, whose nodes are filled the same way, and so on up.  No page is read back or written
+twice.  The single node left at the top is copied to the root page of
+the index, where AM_Search looks for it. */
+
+# define AM_MAXLEVELS 32 /* internal levels a bulk load can build */
+
+typedef struct am_bulklevel
+	{
+		char cur[PF_PAGE_SIZE]; /* node being filled */
+		char prev[PF_PAGE_SIZE]; /* last full node - kept back so that
+					  the last node can borrow from it */
+		char curKey[AM_MAXATTRLENGTH]; /* separator of cur */
+		char prevKey[AM_MAXATTRLENGTH]; /* separator of prev */
+		int hasCur;
+		int hasPrev;
+		int numWritten; /* nodes of this level already written */
+	} AM_BULKLEVEL;
+
+typedef struct am_bulkload
+	{
+		AM_INDEXHANDLE *ih; /* index being loaded */
+		int fileDesc;
+		char attrType;
+		int attrLength;
+		int rootPageNum; /* page of the empty root left by AM_CreateIndex */
+		int fillPercent; /* of the keys an internal node can hold */
+		int fillBytes; /* bytes of keys and recIds put into a leaf */
+		char firstLeaf[PF_PAGE_SIZE]; /* the first leaf stays here in
+					 case it turns out to be the root */
+		char *leafBuf; /* leaf being filled */
+		int leafPageNum; /* its page - AM_NULL_PAGE while in firstLeaf */
+		int firstLeafPageNum; /* page the first leaf went to */
+		char leafKey[AM_MAXATTRLENGTH]; /* first key in the leaf */
+		int leafLongest; /* length of the longest key in the leaf */
+		char prevLast[AM_MAXATTRLENGTH]; /* last key of the leaf before */
+		int hasPrevLeaf;
+		short lastNext; /* offset of the next field that ends the
+				      recId list of the last key */
+		int numLevels; /* internal levels begun */
+		AM_BULKLEVEL *levels;
+	} AM_BULKLOAD;
+
+
+/* initialises an empty leaf */
+static void AM_BulkInitLeaf(bl,pageBuf)
+AM_BULKLOAD *bl;
+char *pageBuf;
+
+{
+	AM_LEAFHEADER head;
+
+	head.pageType = 'l';
+	head.nextLeafPage = AM_NULL_PAGE;
+	head.recIdPtr = PF_PAGE_SIZE;
+	head.keyPtr = AM_sl;
+	head.freeListPtr = AM_NULL;
+	head.numinfreeList = 0;
+	head.attrLength = bl->attrLength;
+	head.keySize = AM_KEYSIZE(bl->attrLength);
+	head.numKeys = 0;
+	head.prefixLength = 0;
+	bcopy(&head,pageBuf,AM_sl);
+}
+
+
+/* works out how the leaf is to be stored with value appended - as keys
+come in order, the prefix they share is the one the first key shares
+with value */
+static void AM_BulkEncoding(bl,header,value,prefixLength,keySize)
+AM_BULKLOAD *bl;
+AM_LEAFHEADER *header; /* of the leaf */
+char *value; /* in canonical form */
+int *prefixLength;
+int *keySize;
+
+{
+	int longest;
+
+	if (!bl->ih->compressKeys)
+	{
+		*prefixLength = 0;
+		*keySize = AM_KEYSIZE(bl->attrLength);
+		return;
+	}
+	longest = strnlen(value,bl->attrLength);
+	*prefixLength = 0;
+	if (header->numKeys > 0)
+	{
+		if (bl->leafLongest > longest)
+			longest = bl->leafLongest;
+		while ((*prefixLength < bl->attrLength) &&
+		       (value[*prefixLength] != '\0') &&
+		       (value[*prefixLength] == bl->leafKey[*prefixLength]))
+			(*prefixLength)++;
+	}
+	*keySize = AM_KEYSIZE((longest > *prefixLength) ?
+			      longest - *prefixLength : 1);
+}
+
+
+/* appends a new key with a list of one recId to the leaf */
+static void AM_BulkAddKey(bl,pageBuf,value,recId)
+AM_BULKLOAD *bl;
+char *pageBuf;
+char *value;
+int recId;
+
+{
+	AM_LEAFHEADER head;
+	char tempPage[PF_PAGE_SIZE];
+	short recPtr;
+	short null = AM_NULL;
+	int prefixLength,keySize;
+	int length;
+
+	/* the leaf is stored again if the key changes the prefix or needs
+	a longer key - the caller has made sure there is room */
+	bcopy(pageBuf,&head,AM_sl);
+	AM_BulkEncoding(bl,&head,value,&prefixLength,&keySize);
+	if ((prefixLength != head.prefixLength) || (keySize != head.keySize))
+	{
+		AM_Compact(1,head.numKeys,pageBuf,tempPage,&head,prefixLength,
+			   keySize);
+		bcopy(tempPage,pageBuf,PF_PAGE_SIZE);
+		bcopy(pageBuf,&head,AM_sl);
+	}
+	length = strnlen(value,bl->attrLength);
+	if (head.numKeys == 0)
+	{
+		bcopy(value,bl->leafKey,bl->attrLength);
+		bl->leafLongest = length;
+	}
+	else if (length > bl->leafLongest)
+		bl->leafLongest = length;
+
+	/* the recId goes at the bottom of the page */
+	head.recIdPtr = head.recIdPtr - AM_si - AM_ss;
+	recPtr = head.recIdPtr;
+	bcopy((char *)&recId,pageBuf + recPtr,AM_si);
+	bcopy((char *)&null,pageBuf + recPtr + AM_si,AM_ss);
+
+	/* and the key after the last one */
+	AM_AddLeafKey(pageBuf,&head,value,head.numKeys + 1);
+	bcopy((char *)&recPtr,AM_LEAFHEAD(pageBuf,&head,head.numKeys),AM_ss);
+
+	bl->lastNext = recPtr + AM_si;
+	bcopy(&head,pageBuf,AM_sl);
+}
+
+
+/* appends a recId to the list of the last key in the leaf - recIds come
+out of a scan in the order they went in */
+static void AM_BulkAddRecId(bl,pageBuf,recId)
+AM_BULKLOAD *bl;
+char *pageBuf;
+int recId;
+
+{
+	AM_LEAFHEADER head;
+	short recPtr;
+	short null = AM_NULL;
+
+	bcopy(pageBuf,&head,AM_sl);
+	head.recIdPtr = head.recIdPtr - AM_si - AM_ss;
+	recPtr = head.recIdPtr;
+	bcopy((char *)&recId,pageBuf + recPtr,AM_si);
+	bcopy((char *)&null,pageBuf + recPtr + AM_si,AM_ss);
+	bcopy((char *)&recPtr,pageBuf + bl->lastNext,AM_ss);
+	bl->lastNext = recPtr + AM_si;
+	bcopy(&head,pageBuf,AM_sl);
+}
+
+
+/* moves the last key of a leaf, with all its recIds, into an empty leaf */
+static void AM_BulkMoveLastKey(bl,fromBuf,toBuf)
+AM_BULKLOAD *bl;
+char *fromBuf;
+char *toBuf;
+
+{
+	AM_LEAFHEADER head;
+	char key[AM_MAXATTRLENGTH]; /* the key being moved */
+	short nextRec;
+	int recId;
+	int numRecs = 0;
+
+	bcopy(fromBuf,&head,AM_sl);
+	AM_GetLeafKey(fromBuf,&head,head.numKeys,key);
+	bcopy(AM_LEAFHEAD(fromBuf,&head,head.numKeys),(char *)&nextRec,AM_ss);
+	while (nextRec != AM_NULL)
+	{
+		bcopy(fromBuf + nextRec,(char *)&recId,AM_si);
+		if (numRecs++ == 0)
+			AM_BulkAddKey(bl,toBuf,key,recId);
+		else
+			AM_BulkAddRecId(bl,toBuf,recId);
+		bcopy(fromBuf + nextRec + AM_si,(char *)&nextRec,AM_ss);
+	}
+
+	/* its recIds were the last ones put at the bottom of the page */
+	head.recIdPtr = head.recIdPtr + numRecs*(AM_si + AM_ss);
+	AM_RemoveLeafKey(fromBuf,&head,head.numKeys);
+	bcopy(&head,fromBuf,AM_sl);
+}
+
+
+/* initialises an internal node with its first child */
+static void AM_BulkInitNode(bl,pageBuf,pageNum)
+AM_BULKLOAD *bl;
+char *pageBuf;
+int pageNum;
+
+{
+	AM_INTHEADER head;
+
+	head.pageType = 'i';
+	head.numKeys = 0;
+	head.keySize = AM_IntKeySize(bl->ih->compressKeys,bl->attrLength,"");
+	head.attrLength = bl->attrLength;
+	bcopy(&head,pageBuf,AM_sint);
+	bcopy((char *)&pageNum,pageBuf + AM_sint,AM_si);
+}
+
+
+/* appends a key and the child to its right to an internal node */
+static void AM_BulkAppendToNode(bl,pageBuf,value,pageNum)
+AM_BULKLOAD *bl;
+char *pageBuf;
+char *value;
+int pageNum;
+
+{
+	AM_INTHEADER head;
+	int keySize;
+
+	bcopy(pageBuf,&head,AM_sint);
+	keySize = AM_IntKeySize(bl->ih->compressKeys,bl->attrLength,value);
+	if (keySize > head.keySize)
+		AM_WidenIntNode(pageBuf,&head,keySize);
+	AM_PutIntKey(AM_INTKEY(pageBuf,&head,head.numKeys + 1),head.keySize,
+		     value,bl->attrLength);
+	bcopy((char *)&pageNum,AM_INTCHILD(pageBuf,&head,head.numKeys + 1),
+	      AM_si);
+	head.numKeys++;
+	bcopy(&head,pageBuf,AM_sint);
+}
+
+
+/* keys an internal node can take with value added, at fillPercent
+percent of a page or at most a full one */
+static int AM_BulkNodeKeys(bl,header,value,fillPercent)
+AM_BULKLOAD *bl;
+AM_INTHEADER *header;
+char *value;
+int fillPercent;
+
+{
+	int keySize;
+	int numKeys;
+
+	keySize = AM_IntKeySize(bl->ih->compressKeys,bl->attrLength,value);
+	if (keySize < header->keySize)
+		keySize = header->keySize;
+	numKeys = (AM_INTMAXKEYS(keySize) * fillPercent) / 100;
+	return((numKeys < 1) ? 1 : numKeys);
+}
+
+
+static int AM_BulkAddChild();
+
+/* writes a finished internal node to a new page and passes it up */
+static int AM_BulkWriteNode(bl,level,pageBuf,key)
+AM_BULKLOAD *bl;
+int level;
+char *pageBuf;
+char *key; /* smallest key under the node */
+
+{
+	char *newBuf;
+	int pageNum;
+	int errVal;
+
+	errVal = PF_AllocPage(bl->fileDesc,&pageNum,&newBuf);
+	AM_Check;
+	bcopy(pageBuf,newBuf,PF_PAGE_SIZE);
+	errVal = PF_UnfixPage(bl->fileDesc,pageNum,TRUE);
+	AM_Check;
+	bl->levels[level].numWritten++;
+	return(AM_BulkAddChild(bl,level + 1,key,pageNum));
+}
+
+
+/* adds a child to the internal level 'level' (0 is just above the leaves) */
+static int AM_BulkAddChild(bl,level,key,pageNum)
+AM_BULKLOAD *bl;
+int level;
+char *key; /* smallest key under the child */
+int pageNum; /* page of the child */
+
+{
+	AM_BULKLEVEL *lev;
+	AM_INTHEADER head;
+	int errVal;
+
+	if (level == bl->numLevels)
+	{
+		if (level == AM_MAXLEVELS)
+			return(AME_INTERROR);
+		bl->numLevels++;
+	}
+	lev = &bl->levels[level];
+
+	/* the first child of a new node */
+	if (!lev->hasCur)
+	{
+		AM_BulkInitNode(bl,lev->cur,pageNum);
+		bcopy(key,lev->curKey,bl->attrLength);
+		lev->hasCur = TRUE;
+		return(AME_OK);
+	}
+
+	bcopy(lev->cur,&head,AM_sint);
+	if (head.numKeys < AM_BulkNodeKeys(bl,&head,key,bl->fillPercent))
+	{
+		AM_BulkAppendToNode(bl,lev->cur,key,pageNum);
+		return(AME_OK);
+	}
+
+	/* the node is full - write out the one before it and keep this one */
+	if (lev->hasPrev)
+	{
+		errVal = AM_BulkWriteNode(bl,level,lev->prev,lev->prevKey);
+		if (errVal < 0)
+			return(errVal);
+	}
+	bcopy(lev->cur,lev->prev,PF_PAGE_SIZE);
+	bcopy(lev->curKey,lev->prevKey,bl->attrLength);
+	lev->hasPrev = TRUE;
+
+	AM_BulkInitNode(bl,lev->cur,pageNum);
+	bcopy(key,lev->curKey,bl->attrLength);
+	return(AME_OK);
+}
+
+
+/* the separator of the current leaf, for the level above */
+static void AM_BulkSeparator(bl,sep)
+AM_BULKLOAD *bl;
+char *sep;
+
+{
+	if (bl->hasPrevLeaf)
+		AM_Separator(bl->ih->compressKeys,bl->attrLength,bl->prevLast,
+			     bl->leafKey,sep);
+	else
+		bcopy(bl->leafKey,sep,bl->attrLength);
+}
+
+
+/* starts the next leaf and writes out the current one - if moveLast, the
+last key of the current leaf is moved into the new one */
+static int AM_BulkNextLeaf(bl,moveLast)
+AM_BULKLOAD *bl;
+int moveLast;
+
+{
+	AM_LEAFHEADER head;
+	char *pageBuf;
+	char sep[AM_MAXATTRLENGTH]; /* separator of the full leaf */
+	int pageNum;
+	int errVal;
+
+	/* the first leaf is not the root after all */
+	if (bl->leafPageNum == AM_NULL_PAGE)
+	{
+		errVal = PF_AllocPage(bl->fileDesc,&bl->leafPageNum,&pageBuf);
+		AM_Check;
+		bcopy(bl->firstLeaf,pageBuf,PF_PAGE_SIZE);
+		bl->leafBuf = pageBuf;
+		bl->firstLeafPageNum = bl->leafPageNum;
+	}
+
+	errVal = PF_AllocPage(bl->fileDesc,&pageNum,&pageBuf);
+	AM_Check;
+	AM_BulkInitLeaf(bl,pageBuf);
+
+	/* link the full leaf to the new one and write it */
+	bcopy(bl->leafBuf,&head,AM_sl);
+	head.nextLeafPage = pageNum;
+	bcopy(&head,bl->leafBuf,AM_sl);
+	AM_BulkSeparator(bl,sep);
+	errVal = AM_BulkAddChild(bl,0,sep,bl->leafPageNum);
+	if (errVal < 0)
+	{
+		PF_UnfixPage(bl->fileDesc,pageNum,TRUE);
+		return(errVal);
+	}
+	if (moveLast)
+		AM_BulkMoveLastKey(bl,bl->leafBuf,pageBuf);
+	bcopy(bl->leafBuf,&head,AM_sl);
+	AM_GetLeafKey(bl->leafBuf,&head,head.numKeys,bl->prevLast);
+	bl->hasPrevLeaf = TRUE;
+	errVal = PF_UnfixPage(bl->fileDesc,bl->leafPageNum,TRUE);
+	bl->leafBuf = pageBuf;
+	bl->leafPageNum = pageNum;
+	AM_Check;
+	return(AME_OK);
+}
+
+
+/* copies the top node over the empty root and records the shape of the
+tree in the index handle */
+static int AM_BulkWriteRoot(bl,nodeBuf,height)
+AM_BULKLOAD *bl;
+char *nodeBuf;
+int height; /* levels of the tree, the leaves included */
+
+{
+	char *pageBuf;
+	int errVal;
+
+	errVal = PF_GetThisPage(bl->fileDesc,bl->rootPageNum,&pageBuf);
+	AM_Check;
+	AM_LockNode(bl->ih,bl->rootPageNum);
+	AM_LockNode(bl->ih,AM_HEADERPAGE);
+	bcopy(nodeBuf,pageBuf,PF_PAGE_SIZE);
+	errVal = PF_UnfixPage(bl->fileDesc,bl->rootPageNum,TRUE);
+	AM_Check;
+	bl->ih->leftPageNum = (height == 1) ? bl->rootPageNum : bl->firstLeafPageNum;
+	bl->ih->height = height;
+	bl->ih->headerChanged = TRUE;
+	return(AME_OK);
+}
+
+
+/* writes out the last leaf and closes the internal levels bottom up */
+static int AM_BulkFinish(bl)
+AM_BULKLOAD *bl;
+
+{
+	AM_BULKLEVEL *lev;
+	AM_INTHEADER head,prevhead;
+	char sep[AM_MAXATTRLENGTH]; /* separator of the last leaf */
+	int level;
+	int pageNum;
+	int errVal;
+
+	/* a single leaf is the root */
+	if (bl->leafPageNum == AM_NULL_PAGE)
+		return(AM_BulkWriteRoot(bl,bl->firstLeaf,1));
+
+	pageNum = bl->leafPageNum;
+	bl->leafPageNum = AM_NULL_PAGE;
+	errVal = PF_UnfixPage(bl->fileDesc,pageNum,TRUE);
+	AM_Check;
+	AM_BulkSeparator(bl,sep);
+	errVal = AM_BulkAddChild(bl,0,sep,pageNum);
+	if (errVal < 0)
+		return(errVal);
+
+	for (level = 0; level < bl->numLevels; level++)
+	{
+		lev = &bl->levels[level];
+
+		/* the only node of the level is the root */
+		if (!lev->hasPrev)
+			return(AM_BulkWriteRoot(bl,lev->cur,level + 2));
+
+		/* a node needs a key - if the last one got a single child
+		it goes to the node before, or takes that node's last child */
+		bcopy(lev->cur,&head,AM_sint);
+		if (head.numKeys == 0)
+		{
+			bcopy(lev->prev,&prevhead,AM_sint);
+			bcopy(lev->cur + AM_sint,(char *)&pageNum,AM_si);
+			if (prevhead.numKeys <
+			    AM_BulkNodeKeys(bl,&prevhead,lev->curKey,100))
+			{
+				AM_BulkAppendToNode(bl,lev->prev,lev->curKey,pageNum);
+				lev->hasCur = FALSE;
+				if (lev->numWritten == 0)
+					return(AM_BulkWriteRoot(bl,lev->prev,level + 2));
+			}
+			else
+			{
+				AM_BulkInitNode(bl,lev->cur,0);
+				bcopy(AM_INTCHILD(lev->prev,&prevhead,
+						  prevhead.numKeys),
+				      lev->cur + AM_sint,AM_si);
+				AM_BulkAppendToNode(bl,lev->cur,lev->curKey,pageNum);
+				memset(lev->curKey,0,bl->attrLength);
+				bcopy(AM_INTKEY(lev->prev,&prevhead,prevhead.numKeys),
+				      lev->curKey,
+				      (prevhead.keySize < bl->attrLength) ?
+				      prevhead.keySize : bl->attrLength);
+				prevhead.numKeys--;
+				bcopy(&prevhead,lev->prev,AM_sint);
+			}
+		}
+
+		errVal = AM_BulkWriteNode(bl,level,lev->prev,lev->prevKey);
+		if (errVal < 0)
+			return(errVal);
+		if (lev->hasCur)
+		{
+			errVal = AM_BulkWriteNode(bl,level,lev->cur,lev->curKey);
+			if (errVal < 0)
+				return(errVal);
+		}
+	}
+	return(AME_INTERROR);
+}
+
+
+/* Builds the index from (value,recId) pairs in ascending order of value, as
+handed out by nextEntry - called by AM_BulkLoad as the writer */
+static int AM_DoBulkLoad(ih,nextEntry,arg,fillPercent)
+AM_INDEXHANDLE *ih; /* open index */
+AM_NextEntryFcn nextEntry; /* gives the next pair in key order */
+void *arg; /* passed to nextEntry */
+int fillPercent; /* 1-100 */
+
+{
+	AM_BULKLOAD *bl;
+	AM_LEAFHEADER head;
+	char *pageBuf;
+	char value[AM_MAXATTRLENGTH]; /* key of the pair being added */
+	char lastKey[AM_MAXATTRLENGTH]; /* key of the pair before */
+	int recId;
+	int status; /* return value of nextEntry */
+	int compareVal;
+	int numEntries = 0;
+	int prefixLength,keySize; /* how the leaf is stored with a new key */
+	int length;
+	int errVal;
+	int fileDesc; /* file Descriptor */
+	char attrType; /* 'i' or 'c' or 'f' */
+	int attrLength; /* 4 for 'i' or 'f', 1-255 for 'c' */
+
+	fileDesc = ih->fileDesc;
+	attrType = ih->attrType;
+	attrLength = ih->attrLength;
+
+	if ((nextEntry == NULL) || (fillPercent < 1) || (fillPercent > 100))
+		{
+		 AM_Errno = AME_INVALIDVALUE;
+		 return(AME_INVALIDVALUE);
+		}
+
+	bl = (AM_BULKLOAD *) calloc(1,sizeof(AM_BULKLOAD));
+	if (bl == NULL)
+		{
+		 AM_Errno = AME_INTERROR;
+		 return(AME_INTERROR);
+		}
+
+	/* the index must hold only the empty root */
+	bl->rootPageNum = ih->rootPageNum;
+	errVal = PF_GetThisPage(fileDesc,bl->rootPageNum,&pageBuf);
+	if (errVal != PFE_OK)
+	{
+		free(bl);
+		AM_Errno = AME_PF;
+		return(AME_PF);
+	}
+	bcopy(pageBuf,&head,AM_sl);
+	PF_UnfixPage(fileDesc,bl->rootPageNum,FALSE);
+	if ((head.pageType != 'l') || (head.numKeys != 0) ||
+	    (PF_GetNumPages(fileDesc) != bl->rootPageNum + 1))
+		errVal = AME_NOTEMPTY;
+	else if (head.attrLength != attrLength)
+		errVal = AME_INVALIDATTRLENGTH;
+	else if ((bl->levels = (AM_BULKLEVEL *)
+		  calloc(AM_MAXLEVELS,sizeof(AM_BULKLEVEL))) == NULL)
+		errVal = AME_INTERROR;
+	else
+		errVal = AME_OK;
+	if (errVal != AME_OK)
+	{
+		free(bl);
+		AM_Errno = errVal;
+		return(errVal);
+	}
+
+	bl->ih = ih;
+	bl->fileDesc = fileDesc;
+	bl->attrType = attrType;
+	bl->attrLength = attrLength;
+	bl->fillPercent = fillPercent;
+	bl->fillBytes = ((PF_PAGE_SIZE - AM_sl) * fillPercent) / 100;
+	bl->leafBuf = bl->firstLeaf;
+	bl->leafPageNum = AM_NULL_PAGE;
+	AM_BulkInitLeaf(bl,bl->firstLeaf);
+
+	while ((status = (*nextEntry)(arg,value,&recId)) == TRUE)
+	{
+		if (attrType == 'c')
+		{
+			length = strnlen(value,attrLength);
+			memset(value + length,0,attrLength - length);
+		}
+		compareVal = 1;
+		if (numEntries > 0)
+		{
+			compareVal = (*ih->keyOps->compare)(lastKey,attrType,
+							    attrLength,value);
+			if (compareVal < 0)
+			{
+				/* the input is not sorted */
+				errVal = AME_INVALIDVALUE;
+				break;
+			}
+		}
+		bcopy(bl->leafBuf,&head,AM_sl);
+
+		if (compareVal == 0)
+		{
+			/* one more recId for the last key - if the page is
+			full the key moves to the next one, or goes on in it if
+			it is all the page holds */
+			if ((head.recIdPtr - head.keyPtr) < (AM_si + AM_ss))
+			{
+				if ((errVal = AM_BulkNextLeaf(bl,head.numKeys > 1))
+				    != AME_OK)
+					break;
+				if (head.numKeys == 1)
+					AM_BulkAddKey(bl,bl->leafBuf,value,recId);
+				else
+					AM_BulkAddRecId(bl,bl->leafBuf,recId);
+			}
+			else
+				AM_BulkAddRecId(bl,bl->leafBuf,recId);
+		}
+		else
+		{
+			/* the leaf as it would be stored with the key */
+			AM_BulkEncoding(bl,&head,value,&prefixLength,&keySize);
+			if ((head.numKeys > 0) &&
+			    (AM_LEAFBYTES(prefixLength,keySize,head.numKeys + 1,
+					  (PF_PAGE_SIZE - head.recIdPtr)/
+					  (AM_si + AM_ss) + 1) > bl->fillBytes))
+				if ((errVal = AM_BulkNextLeaf(bl,FALSE)) != AME_OK)
+					break;
+			AM_BulkAddKey(bl,bl->leafBuf,value,recId);
+		}
+		bcopy(value,lastKey,attrLength);
+		numEntries++;
+	}
+	if (status < 0)
+		errVal = status;
+
+	if (errVal == AME_OK)
+		errVal = AM_BulkFinish(bl);
+	if (errVal == AME_OK)
+		ih->numEntries = numEntries;
+	else if (bl->leafPageNum != AM_NULL_PAGE)
+		PF_UnfixPage(fileDesc,bl->leafPageNum,TRUE);
+
+	free(bl->levels);
+	free(bl);
+	AM_Errno = errVal;
+	return(errVal);
+}
+
+
+/* Builds the index from (value,recId) pairs in ascending order of value, as
+handed out by nextEntry.  The index must be empty, as AM_CreateIndex leaves
+it.  Leaves and internal nodes are filled to fillPercent percent.  Readers
+of the index see the empty root until the new tree is in place */
+int AM_BulkLoad(ih,nextEntry,arg,fillPercent)
+AM_INDEXHANDLE *ih; /* open index */
+AM_NextEntryFcn nextEntry; /* gives the next pair in key order */
+void *arg; /* passed to nextEntry */
+int fillPercent; /* 1-100 */
+
+{
+	int errVal;
+
+	/* check the parameters */
+	if ((ih == NULL) || (ih->fileDesc < 0))
+		{
+		 AM_Errno = AME_FD;
+		 return(AME_FD);
+		}
+	pthread_mutex_lock(&ih->writeMutex);
+	errVal = AM_DoBulkLoad(ih,nextEntry,arg,fillPercent);
+	AM_UnlockNodes(ih);
+	pthread_mutex_unlock(&ih->writeMutex);
+	return(errVal);
+}
@@ -9,7 +9,9 @@
 
 
 
-/* Creates a secondary idex file called fileName.indexNo */
+/* Creates a secondary idex file called fileName.indexNo - page 0 holds the
+index header, page 1 the root until the root splits.  String keys are
+compressed */
 /* ADDED int return type */
 int AM_CreateIndex(fileName,indexNo,attrType,attrLength)
 char *fileName;/* Name of indexed file */
@@ -17,16 +19,35 @@ int indexNo;/*number of this index for file */
 char attrType;/* 'c' for char ,'i' for int ,'f' for float */
 int attrLength; /* 4 for 'i' or 'f', 1-255 for 'c' */
 
+{
+	return(AM_CreateIndexEncoding(fileName,indexNo,attrType,attrLength,
+				      TRUE));
+}
+
+
+/* As AM_CreateIndex, but the caller picks whether string keys are stored
+after the prefix of their leaf and separators cut short, or every key
+whole as they used to be.  The choice is kept in the index header */
+/* ADDED int return type */
+int AM_CreateIndexEncoding(fileName,indexNo,attrType,attrLength,compressKeys)
+char *fileName;/* Name of indexed file */
+int indexNo;/*number of this index for file */
+char attrType;/* 'c' for char ,'i' for int ,'f' for float */
+int attrLength; /* 4 for 'i' or 'f', 1-255 for 'c' */
+int compressKeys; /* TRUE to compress string keys */
+
 
 {
 	char *pageBuf; /* buffer for holding a page */
 	char indexfName[AM_MAX_FNAME_LENGTH]; /* String to store the indexed
 					 files name with extension           */
-	int pageNum; /* page number of the root page(also the first page) */
+	int pageNum; /* page number of the root page */
+	int headerPageNum; /* page number of the index header */
+	char *headerBuf; /* buffer for the index header */
 	int fileDesc; /* file Descriptor */
 	int errVal;
-	int maxKeys;/* Maximum keys that can be held on one internal page */
 	AM_LEAFHEADER head,*header;
+	AM_INDEXHEADER indexHead;
 
 	/* Check the parameters */
 	if ((attrType != 'c') && (attrType != 'f') && (attrType != 'i'))
@@ -64,7 +85,9 @@ int attrLength; /* 4 for 'i' or 'f', 1-255 for 'c' */
 	   return(AME_PF);
           }
 
-	/* allocate a new page for the root */
+	/* allocate the header page, then a new page for the root */
+	errVal = PF_AllocPage(fileDesc,&headerPageNum,&headerBuf);
+	AM_Check;
 	errVal = PF_AllocPage(fileDesc,&pageNum,&pageBuf);
 	AM_Check;
 	
@@ -76,25 +99,32 @@ int attrLength; /* 4 for 'i' or 'f', 1-255 for 'c' */
 	header->freeListPtr = AM_NULL;
 	header->numinfreeList = 0;
 	header->attrLength = attrLength;
+	header->keySize = AM_KEYSIZE(attrLength);
 	header->numKeys = 0;
-	/* the maximum keys in an internal node- has to be even always*/
-	maxKeys = (PF_PAGE_SIZE - AM_sint - AM_si)/(AM_si + attrLength);
-	if (( maxKeys % 2) != 0) 
-		header->maxKeys = maxKeys - 1;
-	else 
-		header->maxKeys = maxKeys;
+	header->prefixLength = 0;
 	/* copy the header onto the page */
 	bcopy(header,pageBuf,AM_sl);
 	
 	errVal = PF_UnfixPage(fileDesc,pageNum,TRUE);
 	AM_Check;
+
+	/* the root is the only leaf, so also the leftmost one */
+	indexHead.pageType = 'h';
+	indexHead.attrType = attrType;
+	indexHead.attrLength = attrLength;
+	indexHead.rootPageNum = pageNum;
+	indexHead.leftPageNum = pageNum;
+	indexHead.height = 1;
+	indexHead.numEntries = 0;
+	indexHead.format = AM_FORMAT;
+	indexHead.compressKeys = compressKeys;
+	bcopy(&indexHead,headerBuf,sizeof(AM_INDEXHEADER));
+	errVal = PF_UnfixPage(fileDesc,headerPageNum,TRUE);
+	AM_Check;
 	
 	/* Close the file */
 	errVal = PF_CloseFile(fileDesc);
 	AM_Check;
-	
-	/* initialise the root page and the leftmost page numbers */
-	AM_RootPageNum = pageNum;
 	return(AME_OK);
 }
 
@@ -116,13 +146,149 @@ int indexNo; /* number of this index for file */
 }
 
 
-/* Deletes the recId from the list for value and deletes value if list
-becomes empty */
+/* Opens the index fileName.indexNo and fills in the handle from its header;
+every other call on the index goes through the handle */
+/* ADDED int return type */
+int AM_OpenIndex(fileName,indexNo,ih)
+char *fileName;/* name of indexed file */
+int indexNo; /* number of this index for file */
+AM_INDEXHANDLE *ih; /* handle to fill in */
+
+{
+	char indexfName[AM_MAX_FNAME_LENGTH];
+	char *pageBuf;
+	int fileDesc;
+	int errVal;
+	AM_INDEXHEADER indexHead;
+
+	if (ih == NULL)
+		{
+		 AM_Errno = AME_INVALIDVALUE;
+		 return(AME_INVALIDVALUE);
+		}
+	ih->fileDesc = -1;
+
+	sprintf(indexfName,"%s.%d",fileName,indexNo);
+	fileDesc = PF_OpenFile(indexfName,PF_LRU);
+	if (fileDesc < 0)
+		{
+		 AM_Errno = AME_PF;
+		 return(AME_PF);
+		}
+
+	errVal = PF_GetThisPage(fileDesc,AM_HEADERPAGE,&pageBuf);
+	if (errVal != PFE_OK)
+		{
+		 PF_CloseFile(fileDesc);
+		 AM_Errno = AME_PF;
+		 return(AME_PF);
+		}
+	bcopy(pageBuf,&indexHead,sizeof(AM_INDEXHEADER));
+	PF_UnfixPage(fileDesc,AM_HEADERPAGE,FALSE);
+	if ((indexHead.pageType != 'h') && (indexHead.pageType != 'l') &&
+	    (indexHead.pageType != 'i'))
+		{
+		 PF_CloseFile(fileDesc);
+		 AM_Errno = AME_NOTINDEX;
+		 return(AME_NOTINDEX);
+		}
+	/* the first indexes had their root on page 0 instead of a header */
+	if ((indexHead.pageType != 'h') || (indexHead.format != AM_FORMAT))
+		{
+		 PF_CloseFile(fileDesc);
+		 AM_Errno = AME_OLDFORMAT;
+		 return(AME_OLDFORMAT);
+		}
+
+	ih->fileDesc = fileDesc;
+	ih->attrType = indexHead.attrType;
+	ih->attrLength = indexHead.attrLength;
+	ih->rootPageNum = indexHead.rootPageNum;
+	ih->leftPageNum = indexHead.leftPageNum;
+	ih->height = indexHead.height;
+	ih->numEntries = indexHead.numEntries;
+	ih->compressKeys = (indexHead.attrType == 'c') &&
+			   indexHead.compressKeys;
+	ih->headerChanged = FALSE;
+	AM_BindKeyOps(ih);
+	ih->topofStack = -1;
+	memset(ih->versions,0,sizeof(ih->versions));
+	ih->numLocked = 0;
+	ih->restarts = 0;
+	pthread_mutex_init(&ih->writeMutex,NULL);
+	return(AME_OK);
+}
+
+
+/* Closes an index opened by AM_OpenIndex - its scans must be closed first.
+The header page is brought up to date with the handle */
 /* ADDED int return type */
-int AM_DeleteEntry(fileDesc,attrType,attrLength,value,recId)
-int fileDesc; /* file Descriptor */
-char attrType; /* 'c' , 'i' or 'f' */
-int attrLength; /* 4 for 'i' or 'f' , 1-255 for 'c' */
+int AM_CloseIndex(ih)
+AM_INDEXHANDLE *ih;
+
+{
+	int errVal;
+
+	if ((ih == NULL) || (ih->fileDesc < 0))
+		{
+		 AM_Errno = AME_FD;
+		 return(AME_FD);
+		}
+	if (ih->headerChanged)
+		{
+		 errVal = AM_WriteHeader(ih);
+		 if (errVal != AME_OK)
+			{
+			 PF_CloseFile(ih->fileDesc);
+			 ih->fileDesc = -1;
+			 pthread_mutex_destroy(&ih->writeMutex);
+			 return(errVal);
+			}
+		}
+	errVal = PF_CloseFile(ih->fileDesc);
+	ih->fileDesc = -1;
+	pthread_mutex_destroy(&ih->writeMutex);
+	AM_Check;
+	return(AME_OK);
+}
+
+
+/* Writes the root, leftmost leaf, height and entry count of the handle
+back to the index header.  While the index is open they change in the
+handle only, so a split or an insert costs no header page write */
+/* ADDED int return type */
+int AM_WriteHeader(ih)
+AM_INDEXHANDLE *ih;
+
+{
+	char *pageBuf;
+	int errVal;
+	AM_INDEXHEADER indexHead;
+
+	indexHead.pageType = 'h';
+	indexHead.attrType = ih->attrType;
+	indexHead.attrLength = ih->attrLength;
+	indexHead.rootPageNum = ih->rootPageNum;
+	indexHead.leftPageNum = ih->leftPageNum;
+	indexHead.height = ih->height;
+	indexHead.numEntries = ih->numEntries;
+	indexHead.format = AM_FORMAT;
+	indexHead.compressKeys = ih->compressKeys;
+
+	errVal = PF_GetThisPage(ih->fileDesc,AM_HEADERPAGE,&pageBuf);
+	AM_Check;
+	bcopy(&indexHead,pageBuf,sizeof(AM_INDEXHEADER));
+	errVal = PF_UnfixPage(ih->fileDesc,AM_HEADERPAGE,TRUE);
+	AM_Check;
+	ih->headerChanged = FALSE;
+	return(AME_OK);
+}
+
+
+/* Deletes the recId from the list for value and deletes value if list
+becomes empty - called by AM_DeleteEntry as the writer */
+static int AM_DoDeleteEntry(ih,value,recId)
+AM_INDEXHANDLE *ih; /* open index */
 char *value;/* Value of key whose corr recId is to be deleted */
 int recId; /* id of the record to delete */
 
@@ -136,38 +302,25 @@ int recId; /* id of the record to delete */
 	short temp; 
 	char *currRecPtr;/* pointer to the current record in the list */
 	AM_LEAFHEADER head,*header;/* header of the page */
-	int recSize; /* length of key,ptr pair for a leaf */
 	int tempRec; /* holds the recId of the current record */
-	/* int errVal; */ /* holds the return value of functions called within - REMOVED, was unused */
-	int i; /* loop index */
+	int errVal;
 
 
 	/* check the parameters */
-	if ((attrType != 'c') && (attrType != 'f') && (attrType != 'i'))
-		{
-		 AM_Errno = AME_INVALIDATTRTYPE;
-		 return(AME_INVALIDATTRTYPE);
-                }
-
 	if (value == NULL) 
 		{
 		 AM_Errno = AME_INVALIDVALUE;
 		 return(AME_INVALIDVALUE);
                 }
 
-	if (fileDesc < 0) 
-		{
-		 AM_Errno = AME_FD;
-		 return(AME_FD);
-                }
-
 	/* initialise the header */
 	header = &head;
 	
 	/* find the pagenumber and the index of the key to be deleted if it is
 	there */
-	status = AM_Search(fileDesc,attrType,attrLength,value,&pageNum,
-			   &pageBuf,&index);
+	status = AM_Search(ih,value,&pageNum,&pageBuf,&index);
+	/* only splits need the path */
+	AM_EmptyStack(ih);
 	
 	/* check if return value is an error */
 	if (status < 0) 
@@ -176,68 +329,76 @@ int recId; /* id of the record to delete */
 		 return(status);
                 }
 	
-	/* The key is not in the tree */
-	if (status == AM_NOT_FOUND) 
-		{
-		 AM_Errno = AME_NOTFOUND;
-		 return(AME_NOTFOUND);
-                }
-	
+	/* the leftmost leaf that can hold the key may not have recId in its
+	list - a key with more recIds than a leaf holds goes on into the next
+	leaves, so look on while it is the last key of the leaf.  Deletes
+	may have taken the key out of some of those leaves, or left them
+	empty, so look on past a leaf whose keys are all below it too */
 	bcopy(pageBuf,header,AM_sl);
-	recSize = attrLength + AM_ss;
-	currRecPtr = pageBuf + AM_sl + (index - 1)*recSize + attrLength;
-	bcopy(currRecPtr,&nextRec,AM_ss);
-	
-	/* search the list for recId */
-	while(nextRec != 0)
+	nextRec = AM_NULL;
+	for (;;)
 	{
-		bcopy(pageBuf + nextRec,&tempRec,AM_si);
-		
-		/* found the recId to be deleted */
-		if (recId == tempRec)
+		if (status == AM_FOUND)
 		{
-			/* Delete recId */
-			bcopy(pageBuf + nextRec + AM_si,currRecPtr,AM_ss);
-			header->numinfreeList++;
-			oldhead = header->freeListPtr;
-			header->freeListPtr = nextRec;
-			bcopy(&oldhead,pageBuf + nextRec + AM_si,AM_ss);
-			break;
-		}
-		else 
-	        {
-			/* go over to the next item on the list */
-			currRecPtr = pageBuf + nextRec + AM_si;
+			currRecPtr = AM_LEAFHEAD(pageBuf,header,index);
 			bcopy(currRecPtr,&nextRec,AM_ss);
+
+			/* search the list for recId */
+			while (nextRec != AM_NULL)
+			{
+				bcopy(pageBuf + nextRec,&tempRec,AM_si);
+				if (recId == tempRec)
+					break;
+				/* go over to the next item on the list */
+				currRecPtr = pageBuf + nextRec + AM_si;
+				bcopy(currRecPtr,&nextRec,AM_ss);
+			}
+			if (nextRec != AM_NULL)
+				break;
 		}
+		if ((index < header->numKeys) ||
+		    ((status == AM_NOT_FOUND) && (index == header->numKeys)) ||
+		    (header->nextLeafPage == AM_NULL_PAGE))
+			break;
+
+		/* on to the next leaf */
+		PF_UnfixPage(ih->fileDesc,pageNum,FALSE);
+		pageNum = header->nextLeafPage;
+		errVal = PF_GetThisPage(ih->fileDesc,pageNum,&pageBuf);
+		AM_Check;
+		bcopy(pageBuf,header,AM_sl);
+		status = (*ih->keyOps->leafSearch)(pageBuf,ih->attrType,
+				ih->attrLength,value,&index,header);
 	}
-	
+
 	/* if end of list reached then key not in tree */
 	if (nextRec == AM_NULL)
 		{
+		 PF_UnfixPage(ih->fileDesc,pageNum,FALSE);
 		 AM_Errno = AME_NOTFOUND;
 		 return(AME_NOTFOUND);
                 }
+
+	/* Delete recId - readers must not copy the leaf while it changes */
+	AM_LockNode(ih,pageNum);
+	bcopy(pageBuf + nextRec + AM_si,currRecPtr,AM_ss);
+	header->numinfreeList++;
+	oldhead = header->freeListPtr;
+	header->freeListPtr = nextRec;
+	bcopy(&oldhead,pageBuf + nextRec + AM_si,AM_ss);
 	
 	/* check if list is empty */
-	bcopy(pageBuf + AM_sl + (index - 1)*recSize + attrLength,&temp,AM_ss);
+	bcopy(AM_LEAFHEAD(pageBuf,header,index),&temp,AM_ss);
 	if (temp == 0)
-	{
 		/* list is empty , so delete key from the list */
-		for(i = index; i < (header->numKeys);i++)
-			bcopy(pageBuf + AM_sl + i*recSize,pageBuf + AM_sl + 
-				(i-1)*recSize,recSize);
-		header->numKeys--;
-		header->keyPtr = header->keyPtr - recSize;
-	}
+		AM_RemoveLeafKey(pageBuf,header,index);
 	
 	/* copy the header onto the buffer */
 	bcopy(header,pageBuf,AM_sl);
 	
-	/* errVal = */ PF_UnfixPage(fileDesc,pageNum,TRUE); /* Removed errVal */
-	
-	/* empty the stack so that it is set for next amlayer call */
-	AM_EmptyStack();
+	/* errVal = */ PF_UnfixPage(ih->fileDesc,pageNum,TRUE); /* Removed errVal */
+	ih->numEntries--;
+	ih->headerChanged = TRUE;
 	  {
 	   AM_Errno = AME_OK;
 	   return(AME_OK);
@@ -251,12 +412,10 @@ int recId; /* id of the record to delete */
 
 
 
-/* Inserts a value,recId pair into the tree */
-/* ADDED int return type */
-int AM_InsertEntry(fileDesc,attrType,attrLength,value,recId)
-int fileDesc; /* file Descriptor */
-char attrType; /* 'i' or 'c' or 'f' */
-int attrLength; /* 4 for 'i' or 'f', 1-255 for 'c' */
+/* Inserts a value,recId pair into the tree - called by AM_InsertEntry as
+the writer */
+static int AM_DoInsertEntry(ih,value,recId)
+AM_INDEXHANDLE *ih; /* open index */
 char *value; /* value to be inserted */ 
 int recId; /* recId to be inserted */
 
@@ -271,97 +430,151 @@ int recId; /* recId to be inserted */
 	int errVal; /* return value of functions within this function */
 	char key[AM_MAXATTRLENGTH]; /* holds the attribute to be passed 
 						  back to the parent */
+	char canonical[AM_MAXATTRLENGTH]; /* a string value, zero past its
+					     end */
+	int fileDesc; /* file Descriptor */
+	int attrLength; /* 4 for 'i' or 'f', 1-255 for 'c' */
 
 	
 	/* check the parameters */
-	if ((attrType != 'c') && (attrType != 'f') && (attrType != 'i'))
-		{
-		 AM_Errno = AME_INVALIDATTRTYPE;
-		 return(AME_INVALIDATTRTYPE);
-                }
-
 	if (value == NULL) 
 		{
 		 AM_Errno = AME_INVALIDVALUE;
 		 return(AME_INVALIDVALUE);
                 }
-
-	if (fileDesc < 0) 
-		{
-		 AM_Errno = AME_FD;
-		 return(AME_FD);
-                }
-	
-	
-	/* Search the leaf for the key */
-	status = AM_Search(fileDesc,attrType,attrLength,value,&pageNum,
-			   &pageBuf,&index);
-
-
-	
-	/* check if there is an error */
-	if (status < 0) 
-	{ 
-		AM_EmptyStack();
-		AM_Errno = status;
-		return(status);
-	}
-	
-	/* Insert into leaf the key,recId pair */
-	inserted = AM_InsertintoLeaf(pageBuf,attrLength,value,recId,index,
-				     status);
-
-	/* if key has been inserted then done */
-	if (inserted == TRUE) 
-	{
-		errVal = PF_UnfixPage(fileDesc,pageNum,TRUE);
-		AM_Check;
-		AM_EmptyStack();
-		return(AME_OK);
-	}
-	
-	/* check if there is any error */
-	if (inserted < 0) 
+	fileDesc = ih->fileDesc;
+	attrLength = ih->attrLength;
+	if (ih->attrType == 'c')
 	{
-		AM_EmptyStack();
-		AM_Errno = inserted;
-		return(inserted);
+		strncpy(canonical,value,attrLength);
+		value = canonical;
 	}
 	
-	/* if not inserted then have to split */
-	if (inserted == FALSE)
+	/* a split need not leave room for the pair in its half, if the keys
+	there are longer in full - the search is then made again, and the
+	leaf it leads to split in turn */
+	do
 	{
-		/* Split the leaf page */
-		addtoparent = AM_SplitLeaf(fileDesc,pageBuf,&pageNum,
-			     attrLength,recId,value, status,index,key);
-		
-		/* check for errors */
-		if (addtoparent < 0) 
+		/* Search the leaf for the key */
+		status = AM_Search(ih,value,&pageNum,&pageBuf,&index);
+
+		/* check if there is an error */
+		if (status < 0) 
+		{ 
+			AM_EmptyStack(ih);
+			AM_Errno = status;
+			return(status);
+		}
+
+		/* Insert into leaf the key,recId pair */
+		AM_LockNode(ih,pageNum);
+		inserted = AM_InsertintoLeaf(pageBuf,ih->compressKeys,
+					     attrLength,value,recId,index,
+					     status);
+
+		/* if key has been inserted then done */
+		if (inserted == TRUE) 
 		{
-			AM_EmptyStack();
-			{
-			 AM_Errno = addtoparent;
-			 return(addtoparent);
-                        }
+			errVal = PF_UnfixPage(fileDesc,pageNum,TRUE);
+			AM_Check;
+			AM_EmptyStack(ih);
+			ih->numEntries++;
+			ih->headerChanged = TRUE;
+			return(AME_OK);
 		}
-		
-		/* if key has to be added to the parent */
-		if (addtoparent == TRUE)
+
+		/* check if there is any error */
+		if (inserted < 0) 
+		{
+			AM_EmptyStack(ih);
+			AM_Errno = inserted;
+			return(inserted);
+		}
+
+		/* if not inserted then have to split */
+		if (inserted == FALSE)
 		{
-			errVal = AM_AddtoParent(fileDesc,pageNum,key,attrLength);
-			if (errVal < 0)
+			/* Split the leaf page */
+			addtoparent = AM_SplitLeaf(ih,pageBuf,&pageNum,
+				     recId,value, status,index,key,&inserted);
+
+			/* check for errors */
+			if (addtoparent < 0) 
+			{
+				AM_EmptyStack(ih);
+				{
+				 AM_Errno = addtoparent;
+				 return(addtoparent);
+				}
+			}
+
+			/* if key has to be added to the parent */
+			if (addtoparent == TRUE)
 			{
-				AM_EmptyStack();
-				AM_Errno = errVal;
-				return(errVal);
+				errVal = AM_AddtoParent(ih,pageNum,key);
+				if (errVal < 0)
+				{
+					AM_EmptyStack(ih);
+					AM_Errno = errVal;
+					return(errVal);
+				}
 			}
 		}
-	}
-	AM_EmptyStack();
+		AM_EmptyStack(ih);
+	} while (inserted != TRUE);
+	ih->numEntries++;
+	ih->headerChanged = TRUE;
 	return(AME_OK);
 }
 
 
+/* Deletes the recId from the list for value.  Deletes and inserts on an
+index are made one at a time; scans may go on while they are */
+/* ADDED int return type */
+int AM_DeleteEntry(ih,value,recId)
+AM_INDEXHANDLE *ih; /* open index */
+char *value;/* Value of key whose corr recId is to be deleted */
+int recId; /* id of the record to delete */
+
+{
+	int errVal;
+
+	if ((ih == NULL) || (ih->fileDesc < 0))
+		{
+		 AM_Errno = AME_FD;
+		 return(AME_FD);
+		}
+	pthread_mutex_lock(&ih->writeMutex);
+	errVal = AM_DoDeleteEntry(ih,value,recId);
+	AM_UnlockNodes(ih);
+	pthread_mutex_unlock(&ih->writeMutex);
+	return(errVal);
+}
+
+
+/* Inserts a value,recId pair into the tree, as AM_DeleteEntry deletes */
+/* ADDED int return type */
+int AM_InsertEntry(ih,value,recId)
+AM_INDEXHANDLE *ih; /* open index */
+char *value; /* value to be inserted */
+int recId; /* recId to be inserted */
+
+{
+	int errVal;
+
+	if ((ih == NULL) || (ih->fileDesc < 0))
+		{
+		 AM_Errno = AME_FD;
+		 return(AME_FD);
+		}
+	pthread_mutex_lock(&ih->writeMutex);
+	errVal = AM_DoInsertEntry(ih,value,recId);
+	AM_UnlockNodes(ih);
+	pthread_mutex_unlock(&ih->writeMutex);
+	return(errVal);
+}
+
+
 /* error messages */
 static char *AMerrormsg[] = {
 "No error",
@@ -375,7 +588,10 @@ static char *AMerrormsg[] = {
 "Scan Table is full",
 "Invalid Attribute Type",
 "Invalid file Descriptor",
-"Invalid value to Delete or Insert Entry"
+"Invalid value to Delete or Insert Entry",
+"Index is not empty",
+"Not an index file",
+"Index has an old page layout - rebuild it with AM_RebuildIndex"
 };
 
 
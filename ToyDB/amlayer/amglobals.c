@@ -1,6 +1,5 @@
 # include "am.h"
+# include "pf.h"
 
-int AM_RootPageNum = 0;
-int AM_LeftPageNum = 0;
-int AM_Errno;
-
+/* the root and leftmost leaf are kept per index, in AM_INDEXHANDLE */
+_Thread_local int AM_Errno = AME_OK;
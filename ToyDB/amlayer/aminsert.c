@@ -5,8 +5,9 @@
 
 /* Inserts a key into a leaf node */
 /* ADDED int return type */
-int AM_InsertintoLeaf(pageBuf,attrLength,value,recId,index,status)
+int AM_InsertintoLeaf(pageBuf,compress,attrLength,value,recId,index,status)
 char *pageBuf;/* buffer where the leaf page resides */
+int compress; /* as the compressKeys of the index */
 int attrLength;
 char *value;/* attribute value to be inserted*/
 int recId;/* recid of the attribute to be inserted */
@@ -17,6 +18,8 @@ int status;/* Whether key is a new key or an old key */
 	int recSize;
 	char tempPage[PF_PAGE_SIZE];
 	AM_LEAFHEADER head,*header;
+	int prefixLength,keySize; /* how the leaf must be stored to take value */
+	int numRecs; /* list entries in use */
 	/* int errVal; */ /* REMOVED - Unused variable */
 
 
@@ -24,7 +27,7 @@ int status;/* Whether key is a new key or an old key */
 	header = &head;
 	bcopy(pageBuf,header,AM_sl);
 
-	recSize = attrLength + AM_ss;
+	recSize = header->keySize + AM_ss;
 	if (status == AM_FOUND)
 		/* key is already present */ 
 	{
@@ -41,6 +44,26 @@ int status;/* Whether key is a new key or an old key */
 	}
 
 	/* status == AM_NOTFOUND and so key is a new key */
+	if (!AM_LeafKeyFits(header,AM_LEAFPREFIX(pageBuf),compress,value))
+	{
+		/* the new key does not begin with the prefix of the leaf, or
+		has a longer rest - the leaf is stored again to take it, if it
+		can be */
+		AM_LeafEncoding(pageBuf,header,1,header->numKeys,value,compress,
+				&prefixLength,&keySize);
+		numRecs = (PF_PAGE_SIZE - header->recIdPtr)/(AM_si + AM_ss) -
+			  header->numinfreeList;
+		if (AM_LEAFBYTES(prefixLength,keySize,header->numKeys + 1,
+				 numRecs + 1) > PF_PAGE_SIZE - AM_sl)
+			return(FALSE);
+		AM_Compact(1,header->numKeys,pageBuf,tempPage,header,
+			   prefixLength,keySize);
+		bcopy(tempPage,pageBuf,PF_PAGE_SIZE);
+		bcopy(pageBuf,header,AM_sl);
+		AM_InsertToLeafNotFound(pageBuf,value,recId,index,header);
+		bcopy(header,pageBuf,AM_sl);
+		return(TRUE);
+	}
 	if ((header->freeListPtr) == 0)
 		/* freelist empty */
 		if ((header->recIdPtr - header->keyPtr) < (AM_si + AM_ss 
@@ -50,7 +73,6 @@ int status;/* Whether key is a new key or an old key */
 		{    
 			AM_InsertToLeafNotFound(pageBuf,value,recId,index,
 						header);
-			header->numKeys++;
 			bcopy(header,pageBuf,AM_sl);
 			return(TRUE);
 		}
@@ -58,7 +80,6 @@ int status;/* Whether key is a new key or an old key */
 	if ((header->recIdPtr - header->keyPtr) > recSize)
 	{
 		AM_InsertToLeafNotFound(pageBuf,value,recId,index,header);
-		header->numKeys++;
 		bcopy(header,pageBuf,AM_sl);
 		return(TRUE);
 	}
@@ -68,13 +89,13 @@ int status;/* Whether key is a new key or an old key */
 	/*there is enough space in the freelist and in the middle put together */
 	{
 		/* Compact the freelist so that we get enough space in the middle                   so that the new key can be inserted */
-		AM_Compact(1,header->numKeys,pageBuf,tempPage,header);
+		AM_Compact(1,header->numKeys,pageBuf,tempPage,header,
+			   header->prefixLength,header->keySize);
 		
 		bcopy(tempPage,pageBuf,PF_PAGE_SIZE);
 		bcopy(pageBuf,header,AM_sl);
 		/* Insert into leaf a new key - no need to split */
 		AM_InsertToLeafNotFound(pageBuf,value,recId,index,header);
-		header->numKeys++;
 		bcopy(header,pageBuf,AM_sl);
 		return(TRUE);
 	}
@@ -92,11 +113,9 @@ int index;
 AM_LEAFHEADER *header;
 
 {
-	int recSize;
 	short tempPtr;
 	short oldhead;
 
-	recSize = header->attrLength + AM_ss;
 	if ((header->freeListPtr) == 0)
 	{
 		header->recIdPtr = header->recIdPtr - AM_si - AM_ss;
@@ -111,12 +130,10 @@ AM_LEAFHEADER *header;
 	}
 	
 	/* save  the old head of recId list */
-	bcopy(pageBuf+AM_sl+(index-1)*recSize + header->attrLength,
-	      (char *)&oldhead, AM_ss);
+	bcopy(AM_LEAFHEAD(pageBuf,header,index),(char *)&oldhead,AM_ss);
 
         /* Update the head of recId list to the new recid to be added */
-	bcopy((char *)  &tempPtr,pageBuf+AM_sl + (index-1)*recSize + 
-	       header->attrLength,AM_ss);
+	bcopy((char *)&tempPtr,AM_LEAFHEAD(pageBuf,header,index),AM_ss);
 
         /* Copy the recId*/
 	bcopy((char *)&recId,pageBuf + tempPtr,AM_si);
@@ -136,92 +153,238 @@ int index;
 AM_LEAFHEADER *header;
 
 {
-	int recSize;
-	short null = AM_NULL;
-	int i;
-
-	recSize = header->attrLength + AM_ss;
-	/* create space for the new key by pushing keys greater than that to 
-								    the right */
-	for(i = header->numKeys;i >= index; i--)
-		{bcopy(pageBuf+AM_sl+(i-1)*recSize,pageBuf+AM_sl+i*recSize,recSize);
-	 } 
-	/* Update the header */
-	header->keyPtr = header->keyPtr + recSize;
-	
-	/* copy the new key */
-	bcopy(value,pageBuf+AM_sl+(index-1)*recSize,header->attrLength);
-	
-	/* make the head of list NULL*/
-	bcopy((char *)&null,pageBuf+AM_sl+(index-1)*recSize+
-	       header->attrLength,AM_ss);
+	/* make a place for the new key, with an empty list */
+	AM_AddLeafKey(pageBuf,header,value,index);
 	
 	/* Now insert as if key were old key */
 	AM_InsertToLeafFound(pageBuf,recId,index,header);
 }
 
 
+/* Puts value in as key number index, with an empty recId list, and
+counts it in the header.  The caller has made sure there is room, and
+that value fits the way the leaf is stored */
+/* ADDED void return type */
+void AM_AddLeafKey(pageBuf,header,value,index)
+char *pageBuf;
+AM_LEAFHEADER *header;
+char *value;
+int index;
+
+{
+	char *keys = AM_LEAFKEY(pageBuf,header,1);
+	int restLength = header->attrLength - header->prefixLength;
+	char *heads = keys + header->numKeys*header->keySize;
+	int keySize = header->keySize;
+	int numKeys = header->numKeys;
+	short null = AM_NULL;
+
+	/* the heads move up past the new key, and those from index on one
+	more to make a place for its head - the last ones go first, as the
+	others may be moved onto them */
+	memmove(heads + keySize + index*AM_ss,heads + (index - 1)*AM_ss,
+		(numKeys - index + 1)*AM_ss);
+	memmove(heads + keySize,heads,(index - 1)*AM_ss);
+	memmove(keys + index*keySize,keys + (index - 1)*keySize,
+		(numKeys - index + 1)*keySize);
+
+	/* copy what follows the prefix, padding and all */
+	memset(keys + (index - 1)*keySize,0,keySize);
+	bcopy(value + header->prefixLength,keys + (index - 1)*keySize,
+	      (restLength < keySize) ? restLength : keySize);
+	header->numKeys++;
+	header->keyPtr = header->keyPtr + keySize + AM_ss;
+
+	/* make the head of list NULL*/
+	bcopy((char *)&null,AM_LEAFHEAD(pageBuf,header,index),AM_ss);
+}
+
+
+/* Takes key number index, whose recId list must be empty or have been
+dealt with by the caller, out of the key and head arrays */
+/* ADDED void return type */
+void AM_RemoveLeafKey(pageBuf,header,index)
+char *pageBuf;
+AM_LEAFHEADER *header;
+int index;
+
+{
+	char *keys = AM_LEAFKEY(pageBuf,header,1);
+	char *heads = keys + header->numKeys*header->keySize;
+	int keySize = header->keySize;
+	int numKeys = header->numKeys;
+
+	/* the reverse of AM_AddLeafKey, in the reverse order */
+	memmove(keys + (index - 1)*keySize,keys + index*keySize,
+		(numKeys - index)*keySize);
+	memmove(heads - keySize,heads,(index - 1)*AM_ss);
+	memmove(heads - keySize + (index - 1)*AM_ss,heads + index*AM_ss,
+		(numKeys - index)*AM_ss);
+	header->numKeys--;
+	header->keyPtr = header->keyPtr - keySize - AM_ss;
+}
+
+
 /* There may be quite a few entries in the freelist but there may not 
 be space in the middle for a new key. This compacts all the recid's to the right
-so that there is enough space in the middle */
+so that there is enough space in the middle.  Keys low to high go into
+tempPage stored with the prefix and key size given, which they must fit */
 /* ADDED void return type */
-void AM_Compact(low,high,pageBuf,tempPage,header)
+void AM_Compact(low,high,pageBuf,tempPage,header,prefixLength,keySize)
 int low;
 int high;
 char *pageBuf;
 char *tempPage;
 AM_LEAFHEADER *header;
+int prefixLength; /* as AM_LeafEncoding gives them */
+int keySize;
 
 {
 
 	short nextRec;
 	AM_LEAFHEADER temphead,*tempheader;
 	short recIdPtr;
-	int recSize;
+	short null = AM_NULL;
+	char *link; /* where the offset of the next list entry goes */
+	char key[AM_MAXATTRLENGTH]; /* a key in full */
+	int restLength = header->attrLength - prefixLength;
 	int i,j;
-	int offset1,offset2;
 
 	tempheader = &temphead;
 	bcopy(header,tempheader,AM_sl);
-	
-	recSize = header->attrLength + AM_ss;
-	recIdPtr = PF_PAGE_SIZE - AM_si - AM_ss ;
 
-    /* Initialize offset2 to avoid potential uninitialized use */
-    offset2 = (0 - 1) * recSize + AM_sl; 
+	/* the head array starts after the keys that are kept */
+	tempheader->numKeys = high - low + 1;
+	tempheader->prefixLength = prefixLength;
+	tempheader->keySize = keySize;
+	recIdPtr = PF_PAGE_SIZE;
+	if (restLength > keySize)
+		restLength = keySize;
 
 	for (i = low, j = 1; i <= high; i++,j++)
 	{
-		offset1 = (i - 1) * recSize + AM_sl;
-		offset2 = (j - 1) * recSize + AM_sl;
-		bcopy(pageBuf + offset1,tempPage + offset2,header->attrLength);
-		bcopy(pageBuf + offset1 + header->attrLength,(char *)&nextRec
-		      ,AM_ss);
-		bcopy((char *)&recIdPtr,tempPage + offset2 + header->attrLength,
-		       AM_ss);
+		AM_GetLeafKey(pageBuf,header,i,key);
+		if (j == 1)
+			bcopy(key,AM_LEAFPREFIX(tempPage),prefixLength);
+		memset(AM_LEAFKEY(tempPage,tempheader,j),0,keySize);
+		bcopy(key + prefixLength,AM_LEAFKEY(tempPage,tempheader,j),
+		      restLength);
+		link = AM_LEAFHEAD(tempPage,tempheader,j);
+		bcopy(AM_LEAFHEAD(pageBuf,header,i),(char *)&nextRec,AM_ss);
 		while (nextRec != 0)
 		{
-			bcopy(pageBuf + nextRec,tempPage + recIdPtr,AM_si);
 			recIdPtr = recIdPtr - AM_si - AM_ss;
-			bcopy((char *)&recIdPtr,tempPage + recIdPtr + 2 * AM_si 
-			       + AM_ss,
-			AM_ss);
+			bcopy(pageBuf + nextRec,tempPage + recIdPtr,AM_si);
+			bcopy((char *)&recIdPtr,link,AM_ss);
+			link = tempPage + recIdPtr + AM_si;
 			bcopy(pageBuf + nextRec + AM_si,(char *)&nextRec,AM_ss);
 		}
-		bcopy((char *)&nextRec,tempPage + recIdPtr + 2 * AM_si + AM_ss,
-		      AM_ss);
+		bcopy((char *)&null,link,AM_ss);
 	}
 
 	/* Initialise the header appropriately */
-	tempheader->pageType = header->pageType;
-	tempheader->nextLeafPage = header->nextLeafPage;
-	tempheader->recIdPtr = recIdPtr + AM_si + AM_ss;
-	tempheader->keyPtr = offset2 + recSize;
+	tempheader->recIdPtr = recIdPtr;
+	tempheader->keyPtr = AM_sl + AM_KEYSIZE(prefixLength) +
+			     tempheader->numKeys*(keySize + AM_ss);
 	tempheader->freeListPtr = 0;
 	tempheader->numinfreeList = 0;
-	tempheader->attrLength = header->attrLength;
-	tempheader->numKeys = high - low + 1;
-	tempheader->maxKeys = header->maxKeys;
 	bcopy(tempheader,tempPage,AM_sl);
 
-}
\ No newline at end of file
+}
+
+
+/* Copies key number index of a leaf, in full, to key - attrLength bytes */
+/* ADDED void return type */
+void AM_GetLeafKey(pageBuf,header,index,key)
+char *pageBuf;
+AM_LEAFHEADER *header;
+int index;
+char *key;
+
+{
+	int restLength = header->attrLength - header->prefixLength;
+
+	if (restLength > header->keySize)
+		restLength = header->keySize;
+	bcopy(AM_LEAFPREFIX(pageBuf),key,header->prefixLength);
+	bcopy(AM_LEAFKEY(pageBuf,header,index),key + header->prefixLength,
+	      restLength);
+	memset(key + header->prefixLength + restLength,0,header->attrLength -
+	       header->prefixLength - restLength);
+}
+
+
+/* TRUE if value can go into a leaf as it is stored: it begins with the
+prefix of the leaf, and the rest fits in a key */
+/* ADDED int return type */
+int AM_LeafKeyFits(header,prefix,compress,value)
+AM_LEAFHEADER *header;
+char *prefix; /* of the leaf */
+int compress; /* as the compressKeys of the index */
+char *value; /* in canonical form */
+
+{
+	if (!compress)
+		return(TRUE);
+	return((memcmp(value,prefix,header->prefixLength) == 0) &&
+	       (strnlen(value + header->prefixLength,header->attrLength -
+			header->prefixLength) <= header->keySize));
+}
+
+
+/* Works out the tightest way to store keys low to high of a leaf, and
+value as well unless it is NULL: the length of the prefix they have in
+common, and the key size that holds the longest of their rests.  Keys
+of an index that does not compress them are kept whole */
+/* ADDED void return type */
+void AM_LeafEncoding(pageBuf,header,low,high,value,compress,prefixLength,
+		     keySize)
+char *pageBuf;
+AM_LEAFHEADER *header;
+int low,high; /* keys to store */
+char *value; /* one more key, in canonical form, or NULL */
+int compress; /* as the compressKeys of the index */
+int *prefixLength; /* gets the prefix length */
+int *keySize; /* gets the key size */
+
+{
+	char first[AM_MAXATTRLENGTH]; /* keys in full */
+	char key[AM_MAXATTRLENGTH];
+	int attrLength = header->attrLength;
+	int longest = 0; /* longest key */
+	int length;
+	int i;
+
+	if (!compress)
+	{
+		*prefixLength = 0;
+		*keySize = AM_KEYSIZE(attrLength);
+		return;
+	}
+
+	/* the prefix of keys in order is the one the first shares with each
+	of the others - with one key there is no prefix to speak of */
+	if (low <= high)
+		AM_GetLeafKey(pageBuf,header,low,first);
+	else
+		bcopy(value,first,attrLength);
+	*prefixLength = (high - low + 1 + (value != NULL) > 1) ?
+			strnlen(first,attrLength) : 0;
+	for (i = low; i <= high + (value != NULL); i++)
+	{
+		if (i <= high)
+			AM_GetLeafKey(pageBuf,header,i,key);
+		else
+			bcopy(value,key,attrLength);
+		length = strnlen(key,attrLength);
+		if (length > longest)
+			longest = length;
+		while ((*prefixLength > 0) &&
+		       (memcmp(first,key,*prefixLength) != 0))
+			(*prefixLength)--;
+	}
+
+	/* a rest of zero bytes still needs a key of its own */
+	length = longest - *prefixLength;
+	*keySize = AM_KEYSIZE((length > 0) ? length : 1);
+}
@@ -0,0 +1,172 @@
+# include <stdio.h>
+# include <string.h>
+# include <sched.h>
+# include "am.h"
+# include "pf.h"
+# include "pftypes.h"
+
+/* Optimistic lock coupling.  Every page of an index is covered by one of
+the version counters in its handle.  The single writer (inserts, deletes
+and bulk loads take ih->writeMutex) makes a counter odd before it changes
+a page the counter covers, and even again, one higher, when its call is
+over.  Readers take no latch: they note the counter, copy the page out of
+the buffer pool, and keep the copy only if the counter has not moved.  On
+the way down a reader checks the parent's counter again after it has the
+child, so a child pointer that went stale sends it back to the root.
+
+Pages cannot be read in place, as a page fixed by the writer cannot be
+fixed by anybody else, so readers work on copies made by PF_CopyPage. */
+
+# define AM_SLOT(page) ((page) % AM_NUMVERSIONS)
+
+
+/* Makes the counter of page odd, unless the writer already holds it.  Must
+be called by the writer before the page is changed */
+void AM_LockNode(ih,page)
+AM_INDEXHANDLE *ih;
+int page;
+
+{
+	int slot = AM_SLOT(page);
+	int i;
+
+	for (i = 0; i < ih->numLocked; i++)
+		if (ih->lockedSlots[i] == slot)
+			return;
+	ih->lockedSlots[ih->numLocked++] = slot;
+	__atomic_store_n(&ih->versions[slot],ih->versions[slot] + 1,
+			 __ATOMIC_RELAXED);
+	/* the counter is odd before any change to the page can be seen */
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+
+/* Makes every counter the writer holds even again, publishing its
+changes */
+void AM_UnlockNodes(ih)
+AM_INDEXHANDLE *ih;
+
+{
+	int slot;
+
+	while (ih->numLocked > 0)
+	{
+		slot = ih->lockedSlots[--ih->numLocked];
+		__atomic_store_n(&ih->versions[slot],ih->versions[slot] + 1,
+				 __ATOMIC_RELEASE);
+	}
+}
+
+
+/* Returns the counter of page once it is even, waiting out the writer */
+unsigned long AM_ReadVersion(ih,page)
+AM_INDEXHANDLE *ih;
+int page;
+
+{
+	unsigned long version;
+
+	while ((version = __atomic_load_n(&ih->versions[AM_SLOT(page)],
+					  __ATOMIC_ACQUIRE)) & 1)
+		sched_yield();
+	return(version);
+}
+
+
+/* TRUE if page has not changed since its counter read version */
+int AM_CheckVersion(ih,page,version)
+AM_INDEXHANDLE *ih;
+int page;
+unsigned long version;
+
+{
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	return(__atomic_load_n(&ih->versions[AM_SLOT(page)],__ATOMIC_RELAXED)
+	       == version);
+}
+
+
+/* Copies a page of the index into buf, as it was between two changes by
+the writer, and returns the counter it was copied under in *version */
+int AM_ReadNode(ih,page,buf,version)
+AM_INDEXHANDLE *ih;
+int page;
+char *buf; /* PF_PAGE_SIZE bytes */
+unsigned long *version;
+
+{
+	int errVal;
+
+	for (;;)
+	{
+		*version = AM_ReadVersion(ih,page);
+		errVal = PF_CopyPage(ih->fileDesc,page,buf,PF_PAGE_SIZE);
+		AM_Check;
+		if (AM_CheckVersion(ih,page,*version))
+			return(AME_OK);
+		__atomic_fetch_add(&ih->restarts,1,__ATOMIC_RELAXED);
+	}
+}
+
+
+/* AM_Search for readers: finds the leaf where value is or would go
+without fixing a page or using the stack, and leaves a copy of the leaf in
+pageBuf.  Returns AM_FOUND or AM_NOT_FOUND, or an AM error code */
+int AM_OptSearch(ih,value,pageNum,pageBuf,indexPtr)
+AM_INDEXHANDLE *ih; /* open index */
+char *value;
+int *pageNum; /* page number of the leaf */
+char *pageBuf; /* PF_PAGE_SIZE bytes - gets a copy of the leaf */
+int *indexPtr; /* index in the leaf where value is or can be inserted */
+
+{
+	char childBuf[PF_PAGE_SIZE]; /* copy of the next node down */
+	unsigned long headerVersion,version,childVersion;
+	int nextPage; /* next page on the path from root to leaf */
+	int errVal;
+	AM_LEAFHEADER lhead;
+	AM_INTHEADER ihead;
+
+restart:
+	/* the root, as the header counter says it was */
+	headerVersion = AM_ReadVersion(ih,AM_HEADERPAGE);
+	*pageNum = __atomic_load_n(&ih->rootPageNum,__ATOMIC_RELAXED);
+	errVal = AM_ReadNode(ih,*pageNum,pageBuf,&version);
+	if (errVal != AME_OK)
+		return(errVal);
+	if (!AM_CheckVersion(ih,AM_HEADERPAGE,headerVersion))
+	{
+		__atomic_fetch_add(&ih->restarts,1,__ATOMIC_RELAXED);
+		goto restart;
+	}
+
+	while (*pageBuf != 'l')
+	{
+		bcopy(pageBuf,&ihead,AM_sint);
+		if (ihead.attrLength != ih->attrLength)
+			return(AME_INVALIDATTRLENGTH);
+		nextPage = (*ih->keyOps->intSearch)(pageBuf,ih->attrType,
+					ih->attrLength,value,indexPtr,&ihead);
+
+		errVal = AM_ReadNode(ih,nextPage,childBuf,&childVersion);
+		if (errVal != AME_OK)
+			return(errVal);
+
+		/* nextPage is only the right child if the parent is still
+		as it was copied */
+		if (!AM_CheckVersion(ih,*pageNum,version))
+		{
+			__atomic_fetch_add(&ih->restarts,1,__ATOMIC_RELAXED);
+			goto restart;
+		}
+		bcopy(childBuf,pageBuf,PF_PAGE_SIZE);
+		*pageNum = nextPage;
+		version = childVersion;
+	}
+
+	bcopy(pageBuf,&lhead,AM_sl);
+	if (lhead.attrLength != ih->attrLength)
+		return(AME_INVALIDATTRLENGTH);
+	return((*ih->keyOps->leafSearch)(pageBuf,ih->attrType,ih->attrLength,
+					 value,indexPtr,&lhead));
+}
@@ -16,21 +16,25 @@ int tempPageint;
 int i;
 int recSize;
 AM_INTHEADER *header;
+char key[AM_MAXATTRLENGTH]; /* a key, padded out to attrLength */
 
 
 header = (AM_INTHEADER *) calloc(1,AM_sint);
 bcopy(pageBuf,header,AM_sint);
-recSize = header->attrLength + AM_si;
+recSize = header->keySize + AM_si;
 printf("PAGETYPE %c\n",header->pageType);
 printf("NUMKEYS %d\n",header->numKeys);
-printf("MAXKEYS %d\n",header->maxKeys);
+printf("KEYSIZE %d\n",header->keySize);
 printf("ATTRLENGTH %d\n",header->attrLength);
 bcopy(pageBuf + AM_sint,&tempPageint,AM_si);
 printf("FIRSTPAGE is %d\n",tempPageint);
 for(i = 1 ; i <= (header->numKeys);i++)
   {
-   AM_PrintAttr(pageBuf + (i-1)*recSize + AM_sint + AM_si,attrType,
-                 header->attrLength);
+   memset(key,0,header->attrLength);
+   bcopy(pageBuf + (i-1)*recSize + AM_sint + AM_si,key,
+         (header->keySize < header->attrLength) ? header->keySize :
+         header->attrLength);
+   AM_PrintAttr(key,attrType,header->attrLength);
    bcopy(pageBuf + i*recSize + AM_sint,&tempPageint,AM_si);
    printf("NEXTPAGE is %d\n",tempPageint);
   }
@@ -45,14 +49,12 @@ char attrType;
 {
 short nextRec;
 int i;
-int recSize;
 int recId;
-int offset1;
 AM_LEAFHEADER *header;
+char key[AM_MAXATTRLENGTH]; /* a key in full */
 
 header = (AM_LEAFHEADER *) calloc(1,AM_sl);
 bcopy(pageBuf,header,AM_sl);
-recSize = header->attrLength + AM_ss;
 printf("PAGETYPE %c\n",header->pageType);
 printf("NEXTLEAFPAGE %d\n",header->nextLeafPage);
 /*printf("RECIDPTR %d\n",header->recIdPtr);
@@ -60,13 +62,13 @@ printf("KEYPTR %d\n",header->keyPtr);
 printf("FREELISTPTR %d\n",header->freeListPtr);
 printf("NUMINFREELIST %d\n",header->numinfreeList);
 printf("ATTRLENGTH %d\n",header->attrLength);
-printf("MAXKEYS %d\n",header->maxKeys);*/
+printf("PREFIXLENGTH %d\n",header->prefixLength);*/
 printf("NUMKEYS %d\n",header->numKeys);
 for (i = 1; i <= header->numKeys; i++)
   {
-  offset1 = (i - 1) * recSize + AM_sl;
-  AM_PrintAttr(pageBuf + AM_sl + (i-1)*recSize,attrType,header->attrLength);
-  bcopy(pageBuf + offset1 + header->attrLength,(char *)&nextRec,AM_ss);
+  AM_GetLeafKey(pageBuf,header,i,key);
+  AM_PrintAttr(key,attrType,header->attrLength);
+  bcopy(AM_LEAFHEAD(pageBuf,header,i),(char *)&nextRec,AM_ss);
   while (nextRec != 0)
     {
     bcopy(pageBuf + nextRec,(char *)&recId,AM_si);
@@ -79,14 +81,14 @@ for (i = 1; i <= header->numKeys; i++)
 }
 
 /* ADDED int return type */
-int AM_DumpLeafPages(fileDesc,min,attrType,attrLength)
-int fileDesc;
+int AM_DumpLeafPages(ih,min)
+AM_INDEXHANDLE *ih;
 int min;
-int attrLength;
-char attrType;
 
 
 {
+int fileDesc = ih->fileDesc;
+char attrType = ih->attrType;
 int pageNum;
 char *value;
 char *pageBuf;
@@ -97,12 +99,12 @@ AM_LEAFHEADER *header;
 
 value = malloc(AM_si);
 bcopy((char*)&min,value,AM_si); /* ADDED (char*) cast */
-printf("%d PAGE \n",AM_LeftPageNum);
-PF_GetThisPage(fileDesc,AM_LeftPageNum,&pageBuf);
+printf("%d PAGE \n",ih->leftPageNum);
+PF_GetThisPage(fileDesc,ih->leftPageNum,&pageBuf);
 header = (AM_LEAFHEADER *) calloc(1,AM_sl);
 bcopy(pageBuf,header,AM_sl);
-/* ADDED: pageNum = AM_LeftPageNum; */
-pageNum = AM_LeftPageNum; 
+/* ADDED: pageNum = ih->leftPageNum; */
+pageNum = ih->leftPageNum; 
 while(header->nextLeafPage != -1)
   {
    printf("PAGENUMBER = %d\n",pageNum);   
@@ -132,19 +134,17 @@ char attrType;
 {
 short nextRec;
 int i;
-int recSize;
 int recId;
-int offset1;
 AM_LEAFHEADER *header;
+char key[AM_MAXATTRLENGTH]; /* a key in full */
 
 header = (AM_LEAFHEADER *) calloc(1,AM_sl);
 bcopy(pageBuf,header,AM_sl);
-recSize = header->attrLength + AM_ss;
 for (i = 1; i <= header->numKeys; i++)
   {
-  offset1 = (i - 1) * recSize + AM_sl;
-  AM_PrintAttr(pageBuf + AM_sl + (i-1)*recSize,attrType,header->attrLength);
-  bcopy(pageBuf + offset1 + header->attrLength,(char *)&nextRec,AM_ss);
+  AM_GetLeafKey(pageBuf,header,i,key);
+  AM_PrintAttr(key,attrType,header->attrLength);
+  bcopy(AM_LEAFHEAD(pageBuf,header,i),(char *)&nextRec,AM_ss);
   while (nextRec != 0)
     {
     bcopy(pageBuf + nextRec,(char *)&recId,AM_si);
@@ -193,12 +193,13 @@ switch(attrType)
 
 
 /* ADDED void return type */
-void AM_PrintTree(fileDesc,pageNum,attrType)
+void AM_PrintTree(ih,pageNum)
+AM_INDEXHANDLE *ih;
 int pageNum;
-int fileDesc;
-char attrType;
 
 {
+int fileDesc = ih->fileDesc;
+char attrType = ih->attrType;
 int nextPage;
 /* int errVal; */ /* REMOVED - Unused variable */
 AM_INTHEADER *header;
@@ -223,11 +224,11 @@ if (*tempPage == 'l')
   }
 header = (AM_INTHEADER *)calloc(1,AM_sint);
 bcopy(tempPage,header,AM_sint);
-recSize = header->attrLength + AM_si;
+recSize = header->keySize + AM_si;
 for(i = 1; i <= (header->numKeys + 1); i++)
   {
    bcopy(tempPage + AM_sint + (i-1)*recSize,&nextPage,AM_si);
-   AM_PrintTree(fileDesc,nextPage,attrType);
+   AM_PrintTree(ih,nextPage);
   }
 printf("PAGENUM = %d",pageNum);
 AM_PrintIntNode(tempPage,attrType);
@@ -0,0 +1,300 @@
+# include <stdio.h>
+# include <string.h>
+# include "am.h"
+# include "pf.h"
+# include "pftypes.h"
+
+/* Rebuilds an index made before AM_FORMAT in the current page layout.
+Only the leaves of the old index are read: they are linked in key order
+from the leftmost one, so their (key,recId) pairs can go straight into
+AM_BulkLoad on a new index of the same name.  The old file is renamed
+out of the way while that happens, removed once the new index is built,
+and put back if the build fails.  The first indexes had no header page:
+page 0 is their root, and the leftmost leaf is found by following first
+children down from it. */
+
+typedef struct am_oldleafheader
+	{
+		char pageType;
+		int nextLeafPage;
+		short recIdPtr;
+		short keyPtr;
+		short freeListPtr;
+		short numinfreeList;
+		short attrLength;
+		short numKeys;
+		short maxKeys;
+	}  AM_OLDLEAFHEADER; /* Header for a leaf page of the first layout,
+			where each key is followed by the head of its recId
+			list */
+
+typedef struct am_v2leafheader
+	{
+		char pageType;
+		short attrLength;
+		short keySize;
+		short numKeys;
+		int nextLeafPage;
+		short recIdPtr;
+		short keyPtr;
+		short freeListPtr;
+		short numinfreeList;
+		short maxKeys;
+	}  AM_V2LEAFHEADER; /* Header for a leaf page of AM_FORMAT2, with
+			whole keys of keySize bytes in an array of their own,
+			and their heads after it */
+
+typedef struct am_oldintheader
+	{
+		char pageType;
+		short numKeys;
+		short maxKeys;
+		short attrLength;
+	}  AM_OLDINTHEADER; /* Header for an internal node of the first
+			layout, followed by its first child */
+
+typedef struct am_oldleafscan
+	{
+		int fileDesc; /* the old index */
+		int format; /* AM_FORMAT2, or anything for the first layout */
+		int attrLength;
+		char pageBuf[PF_PAGE_SIZE]; /* copy of the leaf being read */
+		int nextLeafPage; /* from its header */
+		int numKeys;
+		int keyOffset,keyStep; /* key i is at keyOffset + (i-1)*keyStep */
+		int headOffset,headStep; /* and its head likewise */
+		int index; /* key being read, from 1 */
+		short nextRec; /* its next list entry, AM_NULL at the end */
+	} AM_OLDLEAFSCAN;
+
+
+/* copies leaf pageNum of the old index into the scan */
+static int AM_ReadOldLeaf(scan,pageNum)
+AM_OLDLEAFSCAN *scan;
+int pageNum;
+
+{
+	AM_OLDLEAFHEADER head;
+	AM_V2LEAFHEADER head2;
+	int errVal;
+
+	errVal = PF_CopyPage(scan->fileDesc,pageNum,scan->pageBuf,PF_PAGE_SIZE);
+	AM_Check;
+	if (scan->format == AM_FORMAT2)
+	{
+		bcopy(scan->pageBuf,&head2,sizeof(AM_V2LEAFHEADER));
+		if ((head2.pageType != 'l') ||
+		    (head2.attrLength != scan->attrLength))
+			return(AME_INTERROR);
+		scan->nextLeafPage = head2.nextLeafPage;
+		scan->numKeys = head2.numKeys;
+		scan->keyOffset = sizeof(AM_V2LEAFHEADER);
+		scan->keyStep = head2.keySize;
+		scan->headOffset = scan->keyOffset + head2.numKeys*head2.keySize;
+		scan->headStep = AM_ss;
+	}
+	else
+	{
+		bcopy(scan->pageBuf,&head,sizeof(AM_OLDLEAFHEADER));
+		if ((head.pageType != 'l') ||
+		    (head.attrLength != scan->attrLength))
+			return(AME_INTERROR);
+		scan->nextLeafPage = head.nextLeafPage;
+		scan->numKeys = head.numKeys;
+		scan->keyOffset = sizeof(AM_OLDLEAFHEADER);
+		scan->keyStep = scan->attrLength + AM_ss;
+		scan->headOffset = scan->keyOffset + scan->attrLength;
+		scan->headStep = scan->keyStep;
+	}
+	scan->index = 0;
+	scan->nextRec = AM_NULL;
+	return(AME_OK);
+}
+
+
+/* finds the leftmost leaf of an index without a header page, whose root
+is page 0, and the attrLength it was made with */
+static int AM_OldLeftLeaf(fileDesc,leafPage,attrLength)
+int fileDesc;
+int *leafPage;
+int *attrLength;
+
+{
+	char pageBuf[PF_PAGE_SIZE];
+	AM_OLDLEAFHEADER head;
+	int pageNum;
+	int depth;
+	int errVal;
+
+	pageNum = AM_HEADERPAGE;
+	for (depth = 0; depth < AM_MAXSTACK; depth++)
+	{
+		errVal = PF_CopyPage(fileDesc,pageNum,pageBuf,PF_PAGE_SIZE);
+		AM_Check;
+		if (pageBuf[0] == 'l')
+		{
+			bcopy(pageBuf,&head,sizeof(AM_OLDLEAFHEADER));
+			*leafPage = pageNum;
+			*attrLength = head.attrLength;
+			return(AME_OK);
+		}
+		if (pageBuf[0] != 'i')
+			return(AME_INTERROR);
+		bcopy(pageBuf + sizeof(AM_OLDINTHEADER),(char *)&pageNum,AM_si);
+	}
+	return(AME_INTERROR);
+}
+
+
+/* AM_BulkLoad iterator: the next pair of the old leaves */
+static int AM_OldNextEntry(arg,value,recId)
+void *arg;
+char *value;
+int *recId;
+
+{
+	AM_OLDLEAFSCAN *scan = (AM_OLDLEAFSCAN *)arg;
+	int errVal;
+
+	/* find the next key with recIds left, leaf after leaf */
+	while (scan->nextRec == AM_NULL)
+	{
+		if (scan->index == scan->numKeys)
+		{
+			if (scan->nextLeafPage == AM_NULL_PAGE)
+				return(FALSE);
+			errVal = AM_ReadOldLeaf(scan,scan->nextLeafPage);
+			if (errVal != AME_OK)
+				return(errVal);
+			continue;
+		}
+		scan->index++;
+		bcopy(scan->pageBuf + scan->headOffset +
+		      (scan->index - 1)*scan->headStep,
+		      (char *)&scan->nextRec,AM_ss);
+	}
+
+	bcopy(scan->pageBuf + scan->keyOffset +
+	      (scan->index - 1)*scan->keyStep,value,scan->attrLength);
+	bcopy(scan->pageBuf + scan->nextRec,(char *)recId,AM_si);
+	bcopy(scan->pageBuf + scan->nextRec + AM_si,(char *)&scan->nextRec,
+	      AM_ss);
+	return(TRUE);
+}
+
+
+/* Brings the index fileName.indexNo, which AM_OpenIndex turned down with
+AME_OLDFORMAT, up to the current layout.  Leaves and internal nodes of the
+new index are filled to fillPercent percent, as by AM_BulkLoad.  An index
+that is already up to date is left alone.  The index must not be open */
+int AM_RebuildIndex(fileName,indexNo,attrType,fillPercent)
+char *fileName; /* name of indexed file */
+int indexNo; /* number of this index for file */
+char attrType; /* 'c', 'i' or 'f', as given to AM_CreateIndex - the first
+		  indexes did not record it */
+int fillPercent; /* 1-100 */
+
+{
+	char indexfName[AM_MAX_FNAME_LENGTH];
+	char oldfName[AM_MAX_FNAME_LENGTH + 4];
+	AM_INDEXHEADER indexHead;
+	AM_INDEXHANDLE ih;
+	AM_OLDLEAFSCAN scan;
+	char *pageBuf;
+	int leftPage;
+	int fileDesc;
+	int errVal;
+
+	if ((fillPercent < 1) || (fillPercent > 100))
+		{
+		 AM_Errno = AME_INVALIDVALUE;
+		 return(AME_INVALIDVALUE);
+		}
+
+	/* read the header - the fields before format are the same in every
+	layout that has one */
+	sprintf(indexfName,"%s.%d",fileName,indexNo);
+	fileDesc = PF_OpenFile(indexfName,PF_LRU);
+	if (fileDesc < 0)
+		{
+		 AM_Errno = AME_PF;
+		 return(AME_PF);
+		}
+	errVal = PF_GetThisPage(fileDesc,AM_HEADERPAGE,&pageBuf);
+	if (errVal != PFE_OK)
+		{
+		 PF_CloseFile(fileDesc);
+		 AM_Errno = AME_PF;
+		 return(AME_PF);
+		}
+	bcopy(pageBuf,&indexHead,sizeof(AM_INDEXHEADER));
+	PF_UnfixPage(fileDesc,AM_HEADERPAGE,FALSE);
+	if ((indexHead.pageType == 'l') || (indexHead.pageType == 'i'))
+		{
+		 /* no header page: page 0 is the root */
+		 errVal = AM_OldLeftLeaf(fileDesc,&leftPage,&scan.attrLength);
+		 scan.format = 0;
+		}
+	else if (indexHead.pageType != 'h')
+		errVal = AME_NOTINDEX;
+	else if (indexHead.attrType != attrType)
+		errVal = AME_INVALIDATTRTYPE;
+	else
+		{
+		 leftPage = indexHead.leftPageNum;
+		 scan.attrLength = indexHead.attrLength;
+		 scan.format = indexHead.format;
+		 errVal = AME_OK;
+		}
+	if (PF_CloseFile(fileDesc) != PFE_OK)
+		errVal = AME_PF;
+	if (errVal != AME_OK)
+		{
+		 AM_Errno = errVal;
+		 return(errVal);
+		}
+	if ((indexHead.pageType == 'h') && (indexHead.format == AM_FORMAT))
+		return(AME_OK);
+
+	/* move the old index aside and make a new one in its place */
+	sprintf(oldfName,"%s.old",indexfName);
+	if (rename(indexfName,oldfName) != 0)
+		{
+		 AM_Errno = AME_INTERROR;
+		 return(AME_INTERROR);
+		}
+	errVal = AM_CreateIndex(fileName,indexNo,attrType,scan.attrLength);
+	if (errVal == AME_OK)
+		errVal = AM_OpenIndex(fileName,indexNo,&ih);
+	if (errVal != AME_OK)
+		{
+		 AM_DestroyIndex(fileName,indexNo);
+		 rename(oldfName,indexfName);
+		 AM_Errno = errVal;
+		 return(errVal);
+		}
+
+	/* stream the old leaves into the new index */
+	scan.fileDesc = PF_OpenFile(oldfName,PF_LRU);
+	if (scan.fileDesc < 0)
+		errVal = AME_PF;
+	else
+		errVal = AM_ReadOldLeaf(&scan,leftPage);
+	if (errVal == AME_OK)
+		errVal = AM_BulkLoad(&ih,AM_OldNextEntry,&scan,fillPercent);
+	if (AM_CloseIndex(&ih) != AME_OK)
+		errVal = AME_PF;
+	if (scan.fileDesc >= 0)
+		PF_CloseFile(scan.fileDesc);
+
+	if (errVal != AME_OK)
+		{
+		 AM_DestroyIndex(fileName,indexNo);
+		 rename(oldfName,indexfName);
+		 AM_Errno = errVal;
+		 return(errVal);
+		}
+	errVal = PF_DestroyFile(oldfName);
+	AM_Check;
+	return(AME_OK);
+}
@@ -1,32 +1,51 @@
 # include <stdio.h>
+# include <string.h>
+# include <pthread.h>
 # include "am.h"
 # include "pf.h"
 # include "pftypes.h" /* ADDED */
 
 /* The structure of the scan Table */
 struct {
-         int fileDesc;
+         AM_INDEXHANDLE *ih;
          int op;
          int attrType;
-         int pageNum;
-         short index;
-         short actindex;
+         char value[AM_MAXATTRLENGTH]; /* value for comparison */
          int nextpageNum;
-         char nextvalue[AM_MAXATTRLENGTH];
-         short nextIndex;
-         short nextRecIdPtr;
-         int lastpageNum;
-         short lastIndex;
+         short nextIndex; /* key the scan is at */
+         short nextRecIdPtr; /* its next list entry, AM_NULL before the
+                                scan has checked the key */
          int status;
+         char pageBuf[PF_PAGE_SIZE]; /* copy of leaf nextpageNum */
        } AM_scanTable[MAXSCANS];
 
+/* Scans take no latch: each leaf is read once, as a copy taken between
+two changes by the writer (see amolc.c), and the scan goes through that
+copy until it moves on to the next leaf.  Inserts and deletes can go on
+while scans of the same index run; a split of the leaf being scanned
+leaves the copy, and its position in it, as they were.
+
+The original scan read the leaf again on every call, so it had to check
+whether the key it was at had moved down a place, after the caller
+deleted the last recId of the key before it.  Keys never move in the
+copy, so that check is gone: a caller may still delete each recId as
+the scan returns it, and the scan goes on with the next one in the
+copy.  Changes made to the leaf after it was copied, by the caller or
+anyone else, show up only in later scans.
+
+A scan is over when it comes to a key the operator rules out from there
+on, not at a place fixed when it was opened: a key with more recIds than
+a leaf holds goes on into the next leaves, and the scan follows it */
+
+/* guards the search for a vacant place in the scan table, which scans
+of different indexes share */
+static pthread_mutex_t AM_scanMutex = PTHREAD_MUTEX_INITIALIZER;
+
 
 /* Opens an index scan */
 /* ADDED int return type */
-int AM_OpenIndexScan(fileDesc,attrType,attrLength,op,value)
-int fileDesc; /* file Descriptor */
-char attrType; /* 'i' or 'c' or 'f' */
-int attrLength; /* 4 for 'i' or 'f' , 1-255 for 'c' */
+int AM_OpenIndexScan(ih,op,value)
+AM_INDEXHANDLE *ih; /* open index */
 int op; /* operator for comparison */
 char *value; /* value for comparison */
 
@@ -35,244 +54,76 @@ int scanDesc; /* index into scan table */
 int status; /* whether value is found or not in the tree */
 int index; /* index of value in leaf */
 int pageNum;/* page number of leaf page where value is found */
-int recSize; /* size of key,ptr pair in leaf */
-char *pageBuf; /* buffer for page */
-int errVal; /* return value of functions */
-AM_LEAFHEADER head,*header; /* local header */
-int searchpageNum;
-
+char *pageBuf; /* copy of a leaf, in the scan table */
+unsigned long version; /* counter the copy was taken under */
 
 
 /* check the parameters */
-if (fileDesc < 0)
+if ((ih == NULL) || (ih->fileDesc < 0))
   {
    AM_Errno = AME_FD;
    return(AME_FD);
   }
-
-if ((attrType != 'i') && (attrType != 'c') && (attrType != 'f'))
+if (value == NULL)
+  op = ALL;
+if ((op < ALL) || (op > NOT_EQUAL))
   {
-  AM_Errno = AME_INVALIDATTRTYPE;
-  return(AME_INVALIDATTRTYPE);
+   AM_Errno = AME_INVALID_OP_TO_SCAN;
+   return(AME_INVALID_OP_TO_SCAN);
   }
 
-/* initialise header */
-header = &head;
-
 /* find a vacant place in the scan table */
+pthread_mutex_lock(&AM_scanMutex);
 for (scanDesc = 0; scanDesc <  MAXSCANS;scanDesc++)
   if (AM_scanTable[scanDesc].status == FREE) break;
 
 /* scan table is full */
 if (scanDesc > MAXSCANS - 1) 
  {
+ pthread_mutex_unlock(&AM_scanMutex);
  AM_Errno = AME_SCAN_TAB_FULL;
  return(AME_SCAN_TAB_FULL);
  }
 
 /* there is room */
 AM_scanTable[scanDesc].status = FIRST;
-AM_scanTable[scanDesc].attrType = attrType;
-
-/* initialise AM_LeftPageNum */
-AM_LeftPageNum = GetLeftPageNum(fileDesc);
+pthread_mutex_unlock(&AM_scanMutex);
+AM_scanTable[scanDesc].ih = ih;
+AM_scanTable[scanDesc].op = op;
+AM_scanTable[scanDesc].attrType = ih->attrType;
+pageBuf = AM_scanTable[scanDesc].pageBuf;
 
-/* scan of all keys */
-if (value == NULL)
+/* keep the value, strings zero-padded as the keys are */
+if (op != ALL)
   {
-   AM_scanTable[scanDesc].fileDesc = fileDesc;
-   AM_scanTable[scanDesc].op = ALL;
-   AM_scanTable[scanDesc].nextpageNum = AM_LeftPageNum;
-   AM_scanTable[scanDesc].nextIndex = 1;
-   AM_scanTable[scanDesc].actindex = 1;
-   errVal = PF_GetThisPage(fileDesc,AM_LeftPageNum,&pageBuf);
-   AM_Check;
-   bcopy(pageBuf + AM_sl + attrLength,&AM_scanTable[scanDesc].nextRecIdPtr,AM_ss);
-   errVal = PF_UnfixPage(fileDesc,AM_LeftPageNum,FALSE);
-   AM_Check;
-   return(scanDesc);
-  }
-  
-/* search for the pagenumber and index of value */
-status = AM_Search(fileDesc,attrType,attrLength,value,&pageNum,&pageBuf,&index);
-searchpageNum = pageNum;
-/* check for errors */
-if (status < 0) 
-  { AM_scanTable[scanDesc].status = FREE;
-    AM_Errno = status;
-    return(status);
+   if (ih->attrType == 'c')
+     strncpy(AM_scanTable[scanDesc].value,value,ih->attrLength);
+   else
+     bcopy(value,AM_scanTable[scanDesc].value,ih->attrLength);
   }
 
-bcopy(pageBuf,header,AM_sl);
-recSize = attrLength + AM_ss;
-AM_scanTable[scanDesc].fileDesc = fileDesc;
-AM_scanTable[scanDesc].op = op;
-
-/* value is not in leaf but if inserted will have to be inserted after the last
-key */
-if (index > header->numKeys) 
-  if (header->nextLeafPage != AM_NULL_PAGE)
+/* the scan starts at the first key not below value, or at the leftmost
+leaf if keys below value may be in it */
+if ((op == EQUAL) || (op == GREATER_THAN) || (op == GREATER_THAN_EQUAL))
+  status = AM_OptSearch(ih,AM_scanTable[scanDesc].value,&pageNum,pageBuf,
+			&index);
+else
   {
-  errVal = PF_GetThisPage(fileDesc,header->nextLeafPage,&pageBuf);
-  AM_Check;
-  bcopy(pageBuf,header,AM_sl);
-  /* --- MODIFIED --- Was unfixing nextLeafPage, should unfix pageNum */
-  errVal = PF_UnfixPage(fileDesc,header->nextLeafPage,FALSE);
-  AM_Check;
-  pageNum = header->nextLeafPage;
-  index = 1;
+   pageNum = ih->leftPageNum;
+   index = 1;
+   status = AM_ReadNode(ih,pageNum,pageBuf,&version);
+  }
+if (status < 0)
+  {
+   AM_scanTable[scanDesc].status = FREE;
+   AM_Errno = status;
+   return(status);
   }
-  else 
-   pageNum = AM_NULL_PAGE;
-
-AM_scanTable[scanDesc].pageNum = pageNum;
-AM_scanTable[scanDesc].index = index;
-
-
-
-/* case on op */
-switch(op) 
- {
-  case EQUAL : 
-               {
-                /* value not in leaf - no match */
-		if (status != AM_FOUND)
-                   AM_scanTable[scanDesc].status = OVER;
-                else
-                 {
-                  AM_scanTable[scanDesc].nextpageNum = pageNum;
-                  AM_scanTable[scanDesc].nextIndex = index;
-                  AM_scanTable[scanDesc].actindex = index;
-                  bcopy(pageBuf + AM_sl + (index - 1)*recSize + attrLength,
-                          &AM_scanTable[scanDesc].nextRecIdPtr,AM_ss);
-                  AM_scanTable[scanDesc].lastpageNum  = pageNum;
-                  AM_scanTable[scanDesc].lastIndex  = index;
-                 }
-                break;
-               }
-  case LESS_THAN : 
-               {
-                AM_scanTable[scanDesc].nextpageNum = AM_LeftPageNum;
-                AM_scanTable[scanDesc].nextIndex = 1;
-                AM_scanTable[scanDesc].actindex = 1;
-                if (searchpageNum != AM_LeftPageNum)
-		 { errVal = PF_GetThisPage(fileDesc,AM_LeftPageNum,&pageBuf);
-                  AM_Check;
-                 }
-                bcopy(pageBuf + AM_sl + attrLength,
-                        &AM_scanTable[scanDesc].nextRecIdPtr,AM_ss);
-                if (searchpageNum != AM_LeftPageNum)
-		 {
-		  errVal = PF_UnfixPage(fileDesc,AM_LeftPageNum,FALSE);
-                  AM_Check;
-                 }
-                AM_scanTable[scanDesc].lastpageNum  = pageNum;
-                AM_scanTable[scanDesc].lastIndex  = index - 1 ;
-                break;
-               }
-  case GREATER_THAN :
-               {
-                if (status == AM_FOUND)
-                 if ((index + 1) <= (header->numKeys))
-                  {
-                   AM_scanTable[scanDesc].nextpageNum = pageNum;
-                   AM_scanTable[scanDesc].nextIndex = index + 1;
-                   AM_scanTable[scanDesc].actindex = index + 1;
-                   bcopy(pageBuf + AM_sl + (index)*recSize + attrLength,
-                             &AM_scanTable[scanDesc].nextRecIdPtr,AM_ss);
-                  }
-                 else
-                   /* got to start from next leaf page */
-		   if (header->nextLeafPage != AM_NULL_PAGE)
-                   {
-                   AM_scanTable[scanDesc].nextpageNum = header->nextLeafPage;
-                   AM_scanTable[scanDesc].nextIndex =  1;
-                   AM_scanTable[scanDesc].actindex = 1;
-                   errVal =PF_GetThisPage(fileDesc,header->nextLeafPage,&pageBuf);
-                   AM_Check;
-                   bcopy(pageBuf + AM_sl + attrLength,
-                           &AM_scanTable[scanDesc].nextRecIdPtr,AM_ss);
-                   errVal = PF_UnfixPage(fileDesc,header->nextLeafPage,FALSE);
-                   AM_Check;
-                   }
-                   else /* Nextleafpage is not last NULL page */
-                     AM_scanTable[scanDesc].status = OVER;
-                else /* status == AM_NOT_FOUND */ 
-                 {
-                   AM_scanTable[scanDesc].nextpageNum = pageNum;
-                   AM_scanTable[scanDesc].nextIndex = index ;
-                   AM_scanTable[scanDesc].actindex = index;
-                   bcopy(pageBuf + AM_sl + (index - 1)*recSize + attrLength,
-                              &AM_scanTable[scanDesc].nextRecIdPtr,AM_ss);
-                 }
-                break;
-               }
-  case LESS_THAN_EQUAL :
-               {
-               AM_scanTable[scanDesc].nextpageNum = AM_LeftPageNum;
-               AM_scanTable[scanDesc].nextIndex = 1;
-               AM_scanTable[scanDesc].actindex = 1;
-                if (searchpageNum != AM_LeftPageNum)
-		 { errVal = PF_GetThisPage(fileDesc,AM_LeftPageNum,&pageBuf);
-                  AM_Check;
-                 }
-               bcopy(pageBuf + AM_sl + attrLength,
-                                 &AM_scanTable[scanDesc].nextRecIdPtr,AM_ss);
-               if (searchpageNum != AM_LeftPageNum)
-		 {
-		  errVal = PF_UnfixPage(fileDesc,AM_LeftPageNum,FALSE);
-                  AM_Check;
-                 }		   
-               AM_scanTable[scanDesc].lastpageNum  = pageNum;
-               if (status == AM_FOUND)
-                AM_scanTable[scanDesc].lastIndex  = index ;
-               else
-                AM_scanTable[scanDesc].lastIndex  = index - 1;
-               break;
-               }
-  case GREATER_THAN_EQUAL :
-                
-               {
-                AM_scanTable[scanDesc].nextpageNum = pageNum;
-                AM_scanTable[scanDesc].nextIndex = index;
-                AM_scanTable[scanDesc].actindex = index;
-                bcopy(pageBuf + AM_sl + (index - 1)*recSize + attrLength,
-                        &AM_scanTable[scanDesc].nextRecIdPtr,   AM_ss);
-                break;
-               }
-  case NOT_EQUAL :
-               {
-               if(status == AM_FOUND)
-                {
-                AM_scanTable[scanDesc].nextpageNum = AM_LeftPageNum;
-                AM_scanTable[scanDesc].nextIndex = 1;
-                AM_scanTable[scanDesc].actindex = 1;
-                if (searchpageNum != AM_LeftPageNum)
-		  {
-		  errVal = PF_GetThisPage(fileDesc,AM_LeftPageNum,&pageBuf);
-                  AM_Check;
-		  }
-                bcopy(pageBuf + AM_sl + attrLength,
-                              &AM_scanTable[scanDesc].nextRecIdPtr,   AM_ss);
-                if (searchpageNum != AM_LeftPageNum)
-		 { errVal = PF_UnfixPage(fileDesc,AM_LeftPageNum,FALSE);
-                  AM_Check;
-                 }
-                }
-               else 
-                AM_scanTable[scanDesc].pageNum = AM_NULL_PAGE;
-               break;
-               }
-  default : {
-             AM_scanTable[scanDesc].status = FREE;
-	     AM_Errno = AME_INVALID_OP_TO_SCAN;
-	     return(AME_INVALID_OP_TO_SCAN);
-             break;
-            }
- }
 
-errVal = PF_UnfixPage(fileDesc,searchpageNum,FALSE);
-AM_Check;
+AM_scanTable[scanDesc].nextpageNum = pageNum;
+AM_scanTable[scanDesc].nextIndex = index;
+AM_scanTable[scanDesc].nextRecIdPtr = AM_NULL;
+AM_scanTable[scanDesc].status = BUSY;
 return(scanDesc);
 }
 
@@ -284,11 +135,14 @@ int scanDesc;/* index scan descriptor */
 
 {
 int recId; /* recordId to be returned */
-char *pageBuf;/* buffer for page */
+char *pageBuf;/* copy of the leaf, in the scan table */
+unsigned long version; /* counter the copy was taken under */
+AM_INDEXHANDLE *ih; /* index scanned */
 int errVal;/* return value for functions */
 AM_LEAFHEADER head,*header; /* local header */
-int recSize;/* size of key,ptr pair for leaf */
+int op; /* operator of the scan */
 int compareVal; /* value returned by compare routine */
+char key[AM_MAXATTRLENGTH]; /* a key of the leaf, in full */
 
 
 /* check if scanDesc is valid */
@@ -302,109 +156,57 @@ if ((scanDesc < 0) || (scanDesc > MAXSCANS - 1))
 if (AM_scanTable[scanDesc].status == OVER)
       return(AME_EOF);
 
-if (AM_scanTable[scanDesc].nextpageNum == AM_NULL_PAGE)
- {
-  AM_scanTable[scanDesc].status = OVER;
-  return(AME_EOF);
- }
-
 header = &head;
-errVal = PF_GetThisPage(AM_scanTable[scanDesc].fileDesc
-                        ,AM_scanTable[scanDesc].nextpageNum,&pageBuf);
-AM_Check;
-
+ih = AM_scanTable[scanDesc].ih;
+op = AM_scanTable[scanDesc].op;
+pageBuf = AM_scanTable[scanDesc].pageBuf;
 bcopy(pageBuf,header,AM_sl);
-recSize = header->attrLength + AM_ss;
-
-errVal = PF_UnfixPage(AM_scanTable[scanDesc].fileDesc
-           ,AM_scanTable[scanDesc].nextpageNum,FALSE);
-AM_Check;
 
-/* Get next non empty leaf page */
-while(header->numKeys == 0)
-  if(header->nextLeafPage == AM_NULL_PAGE)
-   {
-    AM_scanTable[scanDesc].status = OVER; 
-    return(AME_EOF);
-   }
-  else
+/* find the next key with recIds to return, leaf after leaf */
+while (AM_scanTable[scanDesc].nextRecIdPtr == AM_NULL)
+ {
+  /* the leaf is over - go on to the next one */
+  if (AM_scanTable[scanDesc].nextIndex > header->numKeys)
    {
-    errVal = PF_GetThisPage(AM_scanTable[scanDesc].fileDesc,header->nextLeafPage,&pageBuf);
-    AM_Check;
-    errVal = PF_UnfixPage(AM_scanTable[scanDesc].fileDesc,header->nextLeafPage,FALSE);
-    AM_Check;
+    if (header->nextLeafPage == AM_NULL_PAGE)
+     {
+      AM_scanTable[scanDesc].status = OVER;
+      return(AME_EOF);
+     }
     AM_scanTable[scanDesc].nextpageNum = header->nextLeafPage;
     AM_scanTable[scanDesc].nextIndex = 1;
-    AM_scanTable[scanDesc].actindex = 1;
+    errVal = AM_ReadNode(ih,header->nextLeafPage,pageBuf,&version);
+    AM_Check;
     bcopy(pageBuf,header,AM_sl);
-    bcopy(pageBuf + AM_sl +  (AM_scanTable[scanDesc].nextIndex-1)*recSize
-    + header->attrLength, &AM_scanTable[scanDesc].nextRecIdPtr,AM_ss);
-    AM_scanTable[scanDesc].status = FIRST;
+    continue;
    }
 
-/* if op is < or <= check if you are done - might have overshot while scanning
-empty pages*/
-if ((AM_scanTable[scanDesc].op == LESS_THAN) || 
-  (AM_scanTable[scanDesc].op == LESS_THAN_EQUAL))
- if ((AM_scanTable[scanDesc].lastpageNum <= AM_scanTable[scanDesc].nextpageNum)
- && (AM_scanTable[scanDesc].lastIndex == 0))
- {
-  AM_scanTable[scanDesc].status = OVER;
-  return(AME_EOF);
- }
-
-/* if op is not equal then check if we have to skip this value */
-if (AM_scanTable[scanDesc].op == NOT_EQUAL)
-  if ((AM_scanTable[scanDesc].pageNum == AM_scanTable[scanDesc].nextpageNum)
-    && (AM_scanTable[scanDesc].index == AM_scanTable[scanDesc].actindex))
-       
-       /*skip this value */
-       if ((AM_scanTable[scanDesc].nextIndex + 1) <= (header->numKeys))
-         {
-          AM_scanTable[scanDesc].nextIndex++;
-          AM_scanTable[scanDesc].actindex++;
-          bcopy(pageBuf + AM_sl +  (AM_scanTable[scanDesc].nextIndex-1)*recSize
-          + header->attrLength, &AM_scanTable[scanDesc].nextRecIdPtr,AM_ss);
-         }
-       else
-          if (header->nextLeafPage == AM_NULL_PAGE)
-            return(AME_EOF); 
-          else
-           {
-            AM_scanTable[scanDesc].nextpageNum = header->nextLeafPage;
-            AM_scanTable[scanDesc].nextIndex =  1;
-            AM_scanTable[scanDesc].actindex = 1;
-            errVal =PF_GetThisPage(AM_scanTable[scanDesc].fileDesc,
-                  header->nextLeafPage,&pageBuf);
-            AM_Check;
-            bcopy(pageBuf + AM_sl + header->attrLength,
-               &AM_scanTable[scanDesc].nextRecIdPtr,AM_ss);
-            bcopy(pageBuf,header,AM_sl);
-            errVal = PF_UnfixPage(AM_scanTable[scanDesc].fileDesc
-                ,header->nextLeafPage,FALSE);
-            AM_Check;
-           }
-/* if not the first call to findnextentry , check if previous record has 
-been deleted */
-if (AM_scanTable[scanDesc].status != FIRST)
- {
-  compareVal = AM_Compare(pageBuf + (AM_scanTable[scanDesc].nextIndex - 1)
-                *recSize + AM_sl,AM_scanTable[scanDesc].attrType,
-		header->attrLength,AM_scanTable[scanDesc].nextvalue);
-  if (compareVal != 0)
+  /* check the key against the operator */
+  if (op != ALL)
    {
-    /* prev record deleted */
-    AM_scanTable[scanDesc].nextIndex--;
-    bcopy(pageBuf + AM_sl + (AM_scanTable[scanDesc].nextIndex -1)*recSize + 
-    header->attrLength, &AM_scanTable[scanDesc].nextRecIdPtr,AM_ss);
+    AM_GetLeafKey(pageBuf,header,AM_scanTable[scanDesc].nextIndex,key);
+    compareVal = (*ih->keyOps->compare)(key,AM_scanTable[scanDesc].attrType,
+		  header->attrLength,AM_scanTable[scanDesc].value);
+    if (((op == EQUAL) && (compareVal != 0)) ||
+        ((op == LESS_THAN) && (compareVal <= 0)) ||
+        ((op == LESS_THAN_EQUAL) && (compareVal < 0)))
+     {
+      /* no key from here on will do */
+      AM_scanTable[scanDesc].status = OVER;
+      return(AME_EOF);
+     }
+    if (((op == GREATER_THAN) || (op == NOT_EQUAL)) && (compareVal == 0))
+     {
+      /* skip this value */
+      AM_scanTable[scanDesc].nextIndex++;
+      continue;
+     }
    }
+  bcopy(AM_LEAFHEAD(pageBuf,header,AM_scanTable[scanDesc].nextIndex),
+	&AM_scanTable[scanDesc].nextRecIdPtr,AM_ss);
+  if (AM_scanTable[scanDesc].nextRecIdPtr == AM_NULL)
+    AM_scanTable[scanDesc].nextIndex++;
  }
-else 
-  /* make the status busy - no more the first call */
-  { AM_scanTable[scanDesc].status = BUSY;
-    bcopy(pageBuf + AM_sl + (AM_scanTable[scanDesc].nextIndex - 1)*recSize,
-    AM_scanTable[scanDesc].nextvalue, header->attrLength);
-  }
 
 /* copy the recId to be returned */
 bcopy(pageBuf + AM_scanTable[scanDesc].nextRecIdPtr,&recId,AM_si);
@@ -413,59 +215,9 @@ bcopy(pageBuf + AM_scanTable[scanDesc].nextRecIdPtr,&recId,AM_si);
 bcopy(pageBuf + AM_scanTable[scanDesc].nextRecIdPtr + AM_si,
           &AM_scanTable[scanDesc].nextRecIdPtr,AM_ss);
 
-
 /* check if this keys list is over */
-if (AM_scanTable[scanDesc].nextRecIdPtr == (short)0)
-   if ((AM_scanTable[scanDesc].nextIndex + 1) <= (header->numKeys))
-    {
-     AM_scanTable[scanDesc].nextIndex++;
-     AM_scanTable[scanDesc].actindex++;
-     bcopy(pageBuf + AM_sl + (AM_scanTable[scanDesc].nextIndex - 1)*recSize + 
-     header->attrLength , &AM_scanTable[scanDesc].nextRecIdPtr, AM_ss);
-     bcopy(pageBuf + AM_sl + (AM_scanTable[scanDesc].nextIndex -1 )*recSize,
-     AM_scanTable[scanDesc].nextvalue,header->attrLength); 
-    }
-   else
-    /* got to go to next page */
-    if (header->nextLeafPage == AM_NULL_PAGE)
-      AM_scanTable[scanDesc].status = OVER;
-    else
-     {
-      AM_scanTable[scanDesc].nextpageNum = header->nextLeafPage;
-      AM_scanTable[scanDesc].nextIndex =  1;
-      AM_scanTable[scanDesc].actindex = 1;
-      errVal =PF_GetThisPage(AM_scanTable[scanDesc].fileDesc,
-        header->nextLeafPage,&pageBuf);
-      AM_Check;
-      bcopy(pageBuf + AM_sl + header->attrLength,
-         &AM_scanTable[scanDesc].nextRecIdPtr,AM_ss);
-      errVal = PF_UnfixPage(AM_scanTable[scanDesc].fileDesc
-                ,header->nextLeafPage,FALSE);
-      AM_Check;
-      bcopy(pageBuf + AM_sl + (AM_scanTable[scanDesc].nextIndex -1 )*recSize,
-      AM_scanTable[scanDesc].nextvalue,header->attrLength); 
-      bcopy(pageBuf,header,AM_sl);
-     }
-
-/* If op is equal then see if you are done */
-if (AM_scanTable[scanDesc].op == EQUAL)
-  if ((AM_scanTable[scanDesc].pageNum != AM_scanTable[scanDesc].nextpageNum)
-    || (AM_scanTable[scanDesc].index != AM_scanTable[scanDesc].actindex))
-     AM_scanTable[scanDesc].status = OVER;
-
-/* see if you are at the last record if op is < or <= */
-if ((AM_scanTable[scanDesc].op == LESS_THAN) || 
-  (AM_scanTable[scanDesc].op == LESS_THAN_EQUAL))
-   if ((AM_scanTable[scanDesc].lastpageNum == AM_scanTable[scanDesc].nextpageNum)
-    && (AM_scanTable[scanDesc].lastIndex == AM_scanTable[scanDesc].actindex))
-       AM_scanTable[scanDesc].status = LAST;
-  else  if ((AM_scanTable[scanDesc].lastpageNum == AM_scanTable[scanDesc].nextpageNum)
-    && (AM_scanTable[scanDesc].lastIndex  <  AM_scanTable[scanDesc].actindex))
-        AM_scanTable[scanDesc].status = OVER;
-    else
-      if (AM_scanTable[scanDesc].status == LAST)
-        AM_scanTable[scanDesc].status = OVER;
-        
+if (AM_scanTable[scanDesc].nextRecIdPtr == AM_NULL)
+  AM_scanTable[scanDesc].nextIndex++;
 
 return(recId);
 }
@@ -486,24 +238,3 @@ AM_scanTable[scanDesc].status = FREE;
 return(AME_OK);
 }
 
-
-/* ADDED int return type */
-int GetLeftPageNum(fileDesc)
-int fileDesc;
-
-{
-char *pageBuf;
-int pageNum;
-int errVal;
-
-errVal = PF_GetFirstPage(fileDesc,&pageNum,&pageBuf);
-AM_Check;
-if (*pageBuf == 'l')
-  AM_LeftPageNum = pageNum;
-else
-  AM_LeftPageNum = 2;
-errVal = PF_UnfixPage(fileDesc,pageNum,FALSE);
-AM_Check;
-return(AM_LeftPageNum);
-
-}
\ No newline at end of file
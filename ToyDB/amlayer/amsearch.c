@@ -8,10 +8,8 @@
 returns the pagenumber and the offset where key is present or could 
 be inserted */
 /* ADDED int return type */
-int AM_Search(fileDesc,attrType,attrLength,value,pageNum,pageBuf,indexPtr)
-int fileDesc;
-char attrType;
-int attrLength;
+int AM_Search(ih,value,pageNum,pageBuf,indexPtr)
+AM_INDEXHANDLE *ih; /* open index */
 char *value;
 int *pageNum; /* page number of page where key is present or can be inserted*/
 char **pageBuf; /* pointer to buffer in memory where leaf page corresponding                                                        to pageNum can be found */
@@ -20,6 +18,9 @@ int *indexPtr; /* pointer to index in leaf where key is present or
 
 {
 	int errVal;
+	int fileDesc = ih->fileDesc;
+	char attrType = ih->attrType;
+	int attrLength = ih->attrLength;
 	int nextPage; /* next page to be followed on the path from root to leaf*/
 	/* int retval; */ /* return value - REMOVED, unused */
 	AM_LEAFHEADER lhead,*lheader; /* local pointer to leaf header */
@@ -30,8 +31,8 @@ int *indexPtr; /* pointer to index in leaf where key is present or
 	iheader = &ihead;
 
         /* get the root of the B+ tree */
-
-	errVal = PF_GetFirstPage(fileDesc,pageNum,pageBuf);
+	*pageNum = ih->rootPageNum;
+	errVal = PF_GetThisPage(fileDesc,*pageNum,pageBuf);
 	AM_Check;
 	if (**pageBuf == 'l' ) 
 		/* if root is a leaf page */
@@ -51,12 +52,12 @@ int *indexPtr; /* pointer to index in leaf where key is present or
 	while ((**pageBuf) != 'l')
 	{
 		/* find the next page to be followed */
-		nextPage = AM_BinSearch(*pageBuf,attrType,attrLength,value,
-					indexPtr,iheader);
+		nextPage = (*ih->keyOps->intSearch)(*pageBuf,attrType,
+					attrLength,value,indexPtr,iheader);
 
 		/* push onto stack for backtracking and splitting nodes if 
 		needed later */
-		AM_PushStack(*pageNum,*indexPtr);
+		AM_PushStack(ih,*pageNum,*indexPtr);
 
 		errVal = PF_UnfixPage(fileDesc,*pageNum,FALSE);
 		AM_Check;
@@ -84,11 +85,16 @@ int *indexPtr; /* pointer to index in leaf where key is present or
 		}
 	}
 	/* find whether key is in leaf or not */
-	return(AM_SearchLeaf(*pageBuf,attrType,attrLength,value,indexPtr,lheader));
+	return((*ih->keyOps->leafSearch)(*pageBuf,attrType,attrLength,value,
+					 indexPtr,lheader));
 }
 
 
-/* Finds the place (index) from where the next page to be followed is got*/
+/* Finds the place (index) from where the next page to be followed is got.
+A key with more recIds than a leaf holds goes on into the leaves after
+it, so a child may end with the key that follows it in the node: the
+child followed is the leftmost that can hold value, the one after the
+last key below value, and *indexPtr is the number of keys below value */
 /* ADDED int return type */
 int AM_BinSearch(pageBuf,attrType,attrLength,value,indexPtr,header)
 char *pageBuf; /* buffer where the page is found */
@@ -102,85 +108,44 @@ AM_INTHEADER *header;
 	int low,high,mid; /* for binary search */
 	int compareVal; /* result of comparison of key with value */
 	int recSize; /* size in bytes of a key,ptr pair */
+	int keySize; /* bytes of a key compared */
 	int pageNum; /* page number of node to be followed along the B+ tree */
+	char *keyPtr;
+
+	recSize = AM_si + header->keySize;
+	keySize = (header->keySize < attrLength) ? header->keySize : attrLength;
 
-	recSize = AM_si  + attrLength;
+	/* low ends on the first key not below value */
 	low = 1;
 	high = header->numKeys;
-
-	while ((high - low ) > 1)
+	while (low <= high)
 	{
 		/* get the middle key */
 		mid = (low + high) / 2;
+		keyPtr = pageBuf + AM_sint + AM_si + (mid - 1)*recSize;
 
-		/* compare the value with the middle key */
-		compareVal = AM_Compare(pageBuf + AM_sint + AM_si + 
-		(mid - 1)*recSize,attrType,attrLength,value); 
-		
-		if (compareVal < 0) 
-			high = mid - 1 ;
-		else if (compareVal > 0)
-			low = mid + 1;
-		else 
-	        {   
-			/* value = middle key */
-			bcopy(pageBuf + AM_sint + mid*recSize,(char *)&pageNum,
-			      AM_si);
-			*indexPtr = mid;
-			return(pageNum);
-	        }
-	}
+		/* compare the value with the middle key - a string node may
+		hold keys cut short of attrLength, and a value that goes on
+		past the end of one the same as it so far is above it */
+		compareVal = AM_Compare(keyPtr,attrType,keySize,value);
+		if ((compareVal == 0) && (keySize < attrLength) &&
+		    (keyPtr[keySize - 1] != '\0') && (value[keySize] != '\0'))
+			compareVal = 1;
 
-	
-	/* check the border cases */
-	if ((high - low) == 0)
-		if(AM_Compare(pageBuf+AM_sint+AM_si +(low - 1)*recSize,attrType,
-		attrLength, value) < 0)
-		{
-			bcopy(pageBuf+AM_sint+(low-1)*recSize,(char *)&pageNum,
-			      AM_si);
-			*indexPtr = low -1;
-			return(pageNum);
-		}
-		else
-		{
-			bcopy(pageBuf+AM_sint+low*recSize,(char *)&pageNum,
-			      AM_si);
-			*indexPtr = low;
-			return(pageNum);
-		}
-
-	if ((high - low) == 1)
-		if(AM_Compare(pageBuf+AM_sint+AM_si +(low - 1)*recSize,attrType,
-		attrLength, value) < 0)
-		{
-			bcopy(pageBuf+AM_sint+(low-1)*recSize,(char *)&pageNum,
-		              AM_si);
-			*indexPtr = low -1;
-			return(pageNum);
-		}
+		if (compareVal > 0)
+			low = mid + 1;
 		else
-			if(AM_Compare(pageBuf+AM_sint+AM_si +low*recSize,
-			attrType,attrLength, value) < 0)
-			{
-				bcopy(pageBuf+AM_sint+low*recSize,
-				      (char *)&pageNum,AM_si);
-				*indexPtr = low;
-				return(pageNum);
-			}
-			else 
-		        {
-			bcopy(pageBuf+AM_sint+(low+1)*recSize,(char *)&pageNum,
-			      AM_si);
-			*indexPtr = low + 1;
-			return(pageNum);
-		        }
-    /* ADDED default return to fix warning */
-    return(0); 
+			high = mid - 1;
+	}
+	*indexPtr = low - 1;
+	bcopy(pageBuf + AM_sint + (low - 1)*recSize,(char *)&pageNum,AM_si);
+	return(pageNum);
 }
 
 
 
+static int AM_SearchLeafChar(char *, char, int, char *, int *, AM_LEAFHEADER *);
+
 /* search a leaf node for the key- returns the place where it is found or can
 be inserted */
 /* ADDED int return type */
@@ -196,9 +161,14 @@ AM_LEAFHEADER *header;
 {
 	int low,high,mid; /* for binary search */
 	int compareVal; /* result of comparison of key with value */
-	int recSize; /* size in bytes of a key,ptr pair */
+	int recSize; /* size in bytes of a key in the key array */
 
-	recSize = AM_ss + attrLength;
+	if (attrType == 'c')
+		return(AM_SearchLeafChar(pageBuf,attrType,attrLength,value,
+					 indexPtr,header));
+
+	/* the rest of this is for ints and floats, which are kept whole */
+	recSize = header->keySize;
 	low = 1;
 	high = header->numKeys;
 
@@ -295,6 +265,78 @@ AM_LEAFHEADER *header;
 
 
 
+/* Compares a string value with the rest of a key in a leaf, after the
+prefix: returns -1, 0 or 1 as AM_Compare does.  The value has restLength
+bytes and the key keySize, zero past its end */
+static int AM_CompareRest(keyPtr,keySize,value,restLength)
+char *keyPtr;
+int keySize;
+char *value;
+int restLength;
+
+{
+	int compareVal;
+
+	if (restLength <= keySize)
+		return(strncmp(value,keyPtr,restLength));
+	compareVal = strncmp(value,keyPtr,keySize);
+	if ((compareVal == 0) && (value[keySize] != '\0'))
+		return(1); /* the value goes on past the end of the key */
+	return(compareVal);
+}
+
+
+/* AM_SearchLeaf for strings, stored after the prefix of the leaf */
+static int AM_SearchLeafChar(pageBuf,attrType,attrLength,value,indexPtr,
+			     header)
+char *pageBuf;
+char attrType;
+int attrLength;
+char *value;
+int *indexPtr;
+AM_LEAFHEADER *header;
+
+{
+	char *keys = AM_LEAFKEY(pageBuf,header,1);
+	int keySize = header->keySize;
+	int low,high,mid; /* for binary search */
+	int compareVal;
+
+	/* a value that does not begin with the prefix is below or above
+	every key in the leaf */
+	compareVal = strncmp(value,AM_LEAFPREFIX(pageBuf),header->prefixLength);
+	if (compareVal != 0)
+	{
+		*indexPtr = (compareVal < 0) ? 1 : header->numKeys + 1;
+		return(AM_NOT_FOUND);
+	}
+	value += header->prefixLength;
+	attrLength -= header->prefixLength;
+
+	/* low ends on the first key above value */
+	low = 1;
+	high = header->numKeys;
+	while (low <= high)
+	{
+		mid = (low + high) / 2;
+		compareVal = AM_CompareRest(keys + (mid - 1)*keySize,keySize,
+					    value,attrLength);
+		if (compareVal < 0)
+			high = mid - 1;
+		else if (compareVal > 0)
+			low = mid + 1;
+		else
+		{
+			*indexPtr = mid;
+			return(AM_FOUND);
+		}
+	}
+	*indexPtr = low;
+	return(AM_NOT_FOUND);
+}
+
+
+
 /* Compare value in bufPtr with value in valPtr - returns -1 ,0 or 1 according
 to whether value in valPtr is less than , equal to or greater than value 
 in BufPtr*/
@@ -334,4 +376,182 @@ int attrLength;
 	}
     /* ADDED default return to fix warning */
     return(0);
-}
\ No newline at end of file
+}
+
+
+
+/* Key routines for each key type.  A compare routine of a type gives the
+answer AM_Compare would, on native values and without the switch.
+AM_DEFINE_KEYOPS makes the node searches of the type from keycmp, which
+compares a key with a value by an operator and expands in line, so each
+probe is one native comparison.  The binary searches have no data
+dependent branch: each step keeps the lower or upper half with a
+conditional move, so a node of n keys takes the same log2(n) steps
+whatever is searched for.  They give the same answers as AM_BinSearch
+and AM_SearchLeaf.  AM_OpenIndex binds the table of the index's type. */
+
+static int AM_CompareInt(char *, char, int, char *);
+static int AM_CompareFloat(char *, char, int, char *);
+static int AM_CompareChar(char *, char, int, char *);
+
+static int AM_CompareInt(bufPtr,attrType,attrLength,valPtr)
+char *bufPtr;
+char attrType;
+int attrLength;
+char *valPtr;
+
+{
+	int bufint,valint;
+
+	memcpy(&bufint,bufPtr,AM_si);
+	memcpy(&valint,valPtr,AM_si);
+	return((valint > bufint) - (valint < bufint));
+}
+
+
+static int AM_CompareFloat(bufPtr,attrType,attrLength,valPtr)
+char *bufPtr;
+char attrType;
+int attrLength;
+char *valPtr;
+
+{
+	float buffloat,valfloat;
+
+	memcpy(&buffloat,bufPtr,AM_sf);
+	memcpy(&valfloat,valPtr,AM_sf);
+	return((valfloat > buffloat) - (valfloat < buffloat));
+}
+
+
+static int AM_CompareChar(bufPtr,attrType,attrLength,valPtr)
+char *bufPtr;
+char attrType;
+int attrLength;
+char *valPtr;
+
+{
+	return(strncmp(valPtr,bufPtr,attrLength));
+}
+
+
+static inline int AM_IntKey(char *ptr)
+{
+	int key;
+
+	memcpy(&key,ptr,AM_si);
+	return(key);
+}
+
+
+static inline float AM_FloatKey(char *ptr)
+{
+	float key;
+
+	memcpy(&key,ptr,AM_sf);
+	return(key);
+}
+
+/* key op value, for the key at keyPtr and the value at valPtr */
+# define AM_INTCMP(keyPtr,valPtr,op) (AM_IntKey(keyPtr) op AM_IntKey(valPtr))
+# define AM_FLOATCMP(keyPtr,valPtr,op) \
+	(AM_FloatKey(keyPtr) op AM_FloatKey(valPtr))
+
+
+/* keyLength is the key length, as a constant - it is also the keySize of
+a node, as ints and floats need no padding and have no prefix */
+# define AM_DEFINE_KEYOPS(ops,compare,intSearch,leafSearch,keycmp,keyLength) \
+static int intSearch(char *, char, int, char *, int *, AM_INTHEADER *);	\
+static int leafSearch(char *, char, int, char *, int *, AM_LEAFHEADER *); \
+									\
+static int intSearch(pageBuf,attrType,attrLength,value,indexPtr,header) \
+char *pageBuf;								\
+char attrType;								\
+int attrLength;								\
+char *value;								\
+int *indexPtr;								\
+AM_INTHEADER *header;							\
+{									\
+	char *keys = pageBuf + AM_sint + AM_si; /* key i at (i-1)*recSize */ \
+	int recSize = AM_si + (keyLength);				\
+	int base = 0,n = header->numKeys,half,pageNum;			\
+									\
+	/* the child is after the last key below value */		\
+	while (n > 1)							\
+	{								\
+		half = n / 2;						\
+		base = keycmp(keys + (base + half)*recSize,value,<) ?	\
+			base + half : base;				\
+		n -= half;						\
+	}								\
+	*indexPtr = base + keycmp(keys + base*recSize,value,<);	\
+	bcopy(pageBuf + AM_sint + (*indexPtr)*recSize,(char *)&pageNum,AM_si); \
+	return(pageNum);						\
+}									\
+									\
+static int leafSearch(pageBuf,attrType,attrLength,value,indexPtr,header) \
+char *pageBuf;								\
+char attrType;								\
+int attrLength;								\
+char *value;								\
+int *indexPtr;								\
+AM_LEAFHEADER *header;							\
+{									\
+	char *keys = pageBuf + AM_sl; /* key i at (i-1)*recSize */	\
+	int recSize = (keyLength); /* the key array is dense */	\
+	int base = 0,n = header->numKeys,half;				\
+									\
+	if (n == 0)							\
+	{								\
+		*indexPtr = 1;						\
+		return(AM_NOT_FOUND);					\
+	}								\
+	/* base ends on the first key not less than value, if any */	\
+	while (n > 1)							\
+	{								\
+		half = n / 2;						\
+		base = keycmp(keys + (base + half)*recSize,value,<) ?	\
+			base + half : base;				\
+		n -= half;						\
+	}								\
+	base += keycmp(keys + base*recSize,value,<);			\
+	*indexPtr = base + 1;						\
+	if ((base < header->numKeys) &&					\
+	    keycmp(keys + base*recSize,value,==))			\
+		return(AM_FOUND);					\
+	return(AM_NOT_FOUND);						\
+}									\
+									\
+AM_KEYOPS ops = { compare, intSearch, leafSearch };
+
+AM_DEFINE_KEYOPS(AM_intOps,AM_CompareInt,AM_BinSearchInt,AM_SearchLeafInt,
+		 AM_INTCMP,AM_si)
+AM_DEFINE_KEYOPS(AM_floatOps,AM_CompareFloat,AM_BinSearchFloat,
+		 AM_SearchLeafFloat,AM_FLOATCMP,AM_sf)
+
+/* a string probe is a call to strncmp whichever way it is made, and the
+branch-free searches, which cannot stop at an equal key, lose to the
+branchy ones, so strings keep the general search of internal nodes and
+have a compare of their own only for scans, bulk loads and builds */
+AM_KEYOPS AM_charOps = { AM_CompareChar, AM_BinSearch, AM_SearchLeafChar };
+
+/* the routines every index had before: AM_Compare, with its switch, on
+every probe */
+AM_KEYOPS AM_generalOps = { AM_Compare, AM_BinSearch, AM_SearchLeaf };
+
+
+/* Binds the key routines of an open index to its key type */
+/* ADDED void return type */
+void AM_BindKeyOps(ih)
+AM_INDEXHANDLE *ih;
+
+{
+	if ((ih->attrType == 'i') && (ih->attrLength == AM_si))
+		ih->keyOps = &AM_intOps;
+	else if ((ih->attrType == 'f') && (ih->attrLength == AM_sf))
+		ih->keyOps = &AM_floatOps;
+	else if (ih->attrType == 'c')
+		ih->keyOps = &AM_charOps;
+	else
+		ih->keyOps = &AM_generalOps;
+}
@@ -2,46 +2,43 @@
 # include "am.h"
 # include "pf.h"
 
-# define AM_MAXSTACK 50
-
-struct
-    {
-     int pageNumber;
-     int offset;
-    } AM_Stack[AM_MAXSTACK];
-
-int AM_topofStackPtr = -1;
+/* The path stack of AM_Search lives in the index handle, so that two
+indexes, or two threads on different indexes, do not share one */
 
 /* ADDED void return type */
-void AM_PushStack(pageNum,offset)
+void AM_PushStack(ih,pageNum,offset)
+AM_INDEXHANDLE *ih;
 int pageNum;
 int offset;
 
 {
-AM_topofStackPtr++;
-AM_Stack[AM_topofStackPtr].pageNumber  = pageNum;
-AM_Stack[AM_topofStackPtr].offset  = offset;
+ih->topofStack++;
+ih->stack[ih->topofStack].pageNumber  = pageNum;
+ih->stack[ih->topofStack].offset  = offset;
 }
 
 /* ADDED void return type */
-void AM_PopStack()
+void AM_PopStack(ih)
+AM_INDEXHANDLE *ih;
 
 {
-AM_topofStackPtr--;
+ih->topofStack--;
 }
 
 /* ADDED void return type */
-void AM_topofStack(pageNum,offset)
+void AM_topofStack(ih,pageNum,offset)
+AM_INDEXHANDLE *ih;
 int *pageNum;
 int *offset;
 {
-*pageNum = AM_Stack[AM_topofStackPtr].pageNumber ;
-*offset = AM_Stack[AM_topofStackPtr].offset ;
+*pageNum = ih->stack[ih->topofStack].pageNumber ;
+*offset = ih->stack[ih->topofStack].offset ;
 }
 
 /* ADDED void return type */
-void AM_EmptyStack()
+void AM_EmptyStack(ih)
+AM_INDEXHANDLE *ih;
 
 {
-AM_topofStackPtr = -1;
-}
\ No newline at end of file
+ih->topofStack = -1;
+}
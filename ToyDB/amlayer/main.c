@@ -9,8 +9,7 @@
 
 main()
 {
-int fd;	/* file descriptor for the index */
-char fname[FNAME_LENGTH];	/* file name */
+AM_INDEXHANDLE ih;	/* handle of the index */
 int recnum;	/* record number */
 int sd;	/* scan descriptor */
 int numrec;	/* # of records retrieved */
@@ -26,23 +25,22 @@ int testval;
 
 	/* open the index */
 	printf("opening index\n");
-	sprintf(fname,"%s.0",RELNAME);
-	fd = PF_OpenFile(fname,PF_MRU);
+	AM_OpenIndex(RELNAME,0,&ih);
 
 	/* first, make sure that simple deletions work */
 	printf("inserting into index\n");
 	for (recnum=0; recnum < 20; recnum++){
-		AM_InsertEntry(fd,INT_TYPE,sizeof(int),(char *)&recnum,
+		AM_InsertEntry(&ih,(char *)&recnum,
 				recnum);
 	}
 	printf("deleting odd number records\n");
 	for (recnum=1; recnum < 20; recnum += 2)
-		AM_DeleteEntry(fd,INT_TYPE,sizeof(int),(char *)&recnum,
+		AM_DeleteEntry(&ih,(char *)&recnum,
 					recnum);
 
 	printf("retrieving even number records\n");
 	numrec= 0;
-	sd = AM_OpenIndexScan(fd,INT_TYPE,sizeof(int),EQ_OP,NULL);
+	sd = AM_OpenIndexScan(&ih,EQ_OP,NULL);
 	while((recnum=AM_FindNextEntry(sd))>= 0){
 		printf("%d\n",recnum);
 		numrec++;
@@ -52,12 +50,12 @@ int testval;
 
 	printf("deleting even number records\n");
 	for (recnum=0; recnum < 20; recnum += 2)
-		AM_DeleteEntry(fd,INT_TYPE,sizeof(int),(char *)&recnum,
+		AM_DeleteEntry(&ih,(char *)&recnum,
 					recnum);
 
 	printf("retrieving from empty index\n");
 	numrec= 0;
-	sd = AM_OpenIndexScan(fd,INT_TYPE,sizeof(int),EQ_OP,NULL);
+	sd = AM_OpenIndexScan(&ih,EQ_OP,NULL);
 	while((recnum=AM_FindNextEntry(sd))>= 0){
 		printf("%d\n",recnum);
 		numrec++;
@@ -70,27 +68,27 @@ int testval;
 	printf("begin test of complex delete\n");
 	printf("inserting into index\n");
 	for (recnum=0; recnum < MAXRECS; recnum+=2){
-		AM_InsertEntry(fd,INT_TYPE,sizeof(int),(char *)&recnum,
+		AM_InsertEntry(&ih,(char *)&recnum,
 				recnum);
 	}
 	for (recnum=1; recnum < MAXRECS; recnum+=2)
-		AM_InsertEntry(fd,INT_TYPE,sizeof(int),(char *)&recnum,
+		AM_InsertEntry(&ih,(char *)&recnum,
 			recnum);
 
 	/* delete everything */
 	printf("deleting everything\n");
 	for (recnum=1; recnum < MAXRECS; recnum += 2)
-		AM_DeleteEntry(fd,INT_TYPE,sizeof(int),(char *)&recnum,
+		AM_DeleteEntry(&ih,(char *)&recnum,
 					recnum);
 	for (recnum=0; recnum < MAXRECS; recnum +=2)
-		AM_DeleteEntry(fd,INT_TYPE,sizeof(int),(char *)&recnum,
+		AM_DeleteEntry(&ih,(char *)&recnum,
 				recnum);
 
 
 	/* print out what remains */
 	printf("printing empty index\n");
 	numrec= 0;
-	sd = AM_OpenIndexScan(fd,INT_TYPE,sizeof(int),EQ_OP,NULL);
+	sd = AM_OpenIndexScan(&ih,EQ_OP,NULL);
 	while((recnum=AM_FindNextEntry(sd))>= 0){
 		printf("%d\n",recnum);
 		numrec++;
@@ -101,19 +99,19 @@ int testval;
 	/* insert everything back */
 	printf("inserting everything back\n");
 	for (recnum=0; recnum < MAXRECS; recnum++){
-		AM_InsertEntry(fd,INT_TYPE,sizeof(int),(char *)&recnum,
+		AM_InsertEntry(&ih,(char *)&recnum,
 				recnum);
 	}
 	/* delete records less than 100, using scan!! */
 	printf("delete records less than 100\n");
 	testval = 100;
-	sd = AM_OpenIndexScan(fd,INT_TYPE,sizeof(int),LT_OP,(char *)&testval);
+	sd = AM_OpenIndexScan(&ih,LT_OP,(char *)&testval);
 	while((recnum=AM_FindNextEntry(sd))>= 0){
 		if (recnum >= 100){
 			printf("invalid recnum %d\n",recnum);
 			exit(1);
 		}
-		AM_DeleteEntry(fd,INT_TYPE,sizeof(int),(char *)&recnum,
+		AM_DeleteEntry(&ih,(char *)&recnum,
 		recnum);
 	}
 	AM_CloseIndexScan(sd);
@@ -121,13 +119,13 @@ int testval;
 	/* delete records greater than 150, using scan */
 	printf("delete records greater than 150\n");
 	testval = 150;
-	sd = AM_OpenIndexScan(fd,INT_TYPE,sizeof(int),GT_OP,(char *)&testval);
+	sd = AM_OpenIndexScan(&ih,GT_OP,(char *)&testval);
 	while((recnum=AM_FindNextEntry(sd))>= 0){
 		if (recnum <= 150){
 			printf("invalid recnum %d\n",recnum);
 			exit(1);
 		}
-		AM_DeleteEntry(fd,INT_TYPE,sizeof(int),(char *)&recnum,
+		AM_DeleteEntry(&ih,(char *)&recnum,
 					recnum);
 	}
 	AM_CloseIndexScan(sd);
@@ -136,7 +134,7 @@ int testval;
 	/* print out what remains */
    printf("printing between 100 and 150\n");
 	numrec= 0;
-	sd = AM_OpenIndexScan(fd,INT_TYPE,sizeof(int),EQ_OP,NULL);
+	sd = AM_OpenIndexScan(&ih,EQ_OP,NULL);
 	while((recnum=AM_FindNextEntry(sd))>= 0){
 		printf("%d\n",recnum);
 		numrec++;
@@ -146,7 +144,7 @@ int testval;
 
 	/* destroy everything */
 	printf("closing down\n");
-	PF_CloseFile(fd);
+	AM_CloseIndex(&ih);
 		AM_DestroyIndex(RELNAME,0);
 
 	printf("test3 done!\n");
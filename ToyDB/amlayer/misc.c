@@ -53,55 +53,77 @@ int errval;
 }
 
 /* ADDED int return type */
-int xAM_InsertEntry(fd,attrtype,attrlen,val,recid)
-int fd;
-char attrtype;
-int attrlen;
+int xAM_OpenIndex(fname,indexno,ih)
+char *fname;
+int indexno;
+AM_INDEXHANDLE *ih;
+{
+int errval;
+
+	if ((errval=AM_OpenIndex(fname,indexno,ih)) != AME_OK){
+		printf("AM_OpenIndex(%s,%d) failed: %d\n",fname,indexno,errval);
+		exit(1);
+	}
+	return(errval);
+}
+
+/* ADDED int return type */
+int xAM_CloseIndex(ih)
+AM_INDEXHANDLE *ih;
+{
+int errval;
+
+	if ((errval=AM_CloseIndex(ih)) != AME_OK){
+		printf("AM_CloseIndex(%d) failed: %d\n",ih->fileDesc,errval);
+		exit(1);
+	}
+	return(errval);
+}
+
+/* ADDED int return type */
+int xAM_InsertEntry(ih,val,recid)
+AM_INDEXHANDLE *ih;
 char *val;
 RecIdType recid;
 {
 int errval;
 
-	if ((errval=AM_InsertEntry(fd,attrtype,attrlen,val,recid))!=AME_OK){
-		printf("AM_InsertEntry(%d,'%c',%d,val,%d) failed: %d\n",
-			fd,attrtype,attrlen,RecIdToInt(recid),errval);
+	if ((errval=AM_InsertEntry(ih,val,recid))!=AME_OK){
+		printf("AM_InsertEntry(%d,val,%d) failed: %d\n",
+			ih->fileDesc,RecIdToInt(recid),errval);
 		exit(1);
 	}
 	return(errval);
 }
 
 /* ADDED int return type */
-int xAM_DeleteEntry(fd,attrtype,attrlen,val,recid)
-int fd;
-char attrtype;
-int attrlen;
+int xAM_DeleteEntry(ih,val,recid)
+AM_INDEXHANDLE *ih;
 char *val;
 RecIdType recid;
 {
 int errval;
 
-	if ((errval=AM_DeleteEntry(fd,attrtype,attrlen,val,recid))!= AME_OK){
-		printf("AM_DeleteEntry(%d,'%c',%d,val,%d) failed: %d\n",
-			fd,attrtype,attrlen,RecIdToInt(recid),errval);
+	if ((errval=AM_DeleteEntry(ih,val,recid))!= AME_OK){
+		printf("AM_DeleteEntry(%d,val,%d) failed: %d\n",
+			ih->fileDesc,RecIdToInt(recid),errval);
 		exit(1);
 	}
 	return(errval);
 }
 
 /* ADDED int return type */
-int xAM_OpenIndexScan(fd,attrtype,attrlen,op,val)
-int fd;
-char attrtype;
+int xAM_OpenIndexScan(ih,op,val)
+AM_INDEXHANDLE *ih;
 int  op;
-int attrlen;
 char *val;
 {
 int sd;
 
 
-	if ((sd=AM_OpenIndexScan(fd,attrtype,attrlen,op,val))<0 ){
-		printf("AM_OpenIndexScan(%d,'%c',%d,%d,rec) failed: %d\n",
-			fd,attrtype,attrlen,op,sd);
+	if ((sd=AM_OpenIndexScan(ih,op,val))<0 ){
+		printf("AM_OpenIndexScan(%d,%d,rec) failed: %d\n",
+			ih->fileDesc,op,sd);
 		exit(1);
 	}
 	return(sd);
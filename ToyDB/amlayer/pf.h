@@ -44,13 +44,14 @@ typedef enum {
 #define PFE_PAGEINBUF	-17	/* new page to be allocated already in buffer */
 #define PFE_HASHNOTFOUND -18	/* hash table entry not found */
 #define PFE_HASHPAGEEXIST -19	/* page already exist in hash table */
+#define PFE_BADPAGE	-20	/* compressed page is corrupt */
 
 
 /* page size */
 #define PF_PAGE_SIZE	1020
 
 /* externs from the PF layer */
-extern int PFerrno;		/* error number of last error */
+extern _Thread_local int PFerrno;	/* error number of last error, per thread */
 /* --- MODIFIED --- Corrected prototype to match pf.c */
 extern void PF_PrintError(char *);
 
@@ -63,7 +64,12 @@ extern int PF_CloseFile(int);
 extern int PF_GetFirstPage(int, int *, char **);
 extern int PF_GetNextPage(int, int *, char **);
 extern int PF_GetThisPage(int, int, char **);
+extern int PF_CopyPage(int, int, char *, int);
+extern int PF_GetNumPages(int);
+extern int PF_SetCompression(int, int);
 extern int PF_AllocPage(int, int *, char **);
+extern int PF_AppendPages(int, char *, int, int *);
+extern int PF_ReadPages(int, int, int, char *);
 extern int PF_DisposePage(int, int);
 extern int PF_UnfixPage(int, int, int);
 extern int PF_MarkDirty(int, int);
@@ -74,6 +80,8 @@ extern long PF_GetLogicalIOs();
 extern long PF_GetPhysicalIOs();
 extern long PF_GetDiskReads();
 extern long PF_GetDiskWrites();
+extern long PF_GetBytesRead();
+extern long PF_GetBytesWritten();
 
 
 #endif /* PF_H */
\ No newline at end of file
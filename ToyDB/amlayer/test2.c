@@ -10,8 +10,7 @@ splitting of pages of your B+ tree */
 
 main()
 {
-int fd;	/* file descriptor for the index */
-char fname[FNAME_LENGTH];	/* file name */
+AM_INDEXHANDLE ih;	/* handle of the index */
 char buf[STRING_SIZE];	/* buf to store data to be inserted into index */
 int recnum;	/* record number */
 int sd;	/* scan descriptor */
@@ -27,19 +26,18 @@ int numrec;	/* # of records retrieved in s scan */
 
 	/* open the index */
 	printf("opening index\n");
-	sprintf(fname,"%s.0",RELNAME);
-	fd = xPF_OpenFile(fname);
+	xAM_OpenIndex(RELNAME,0,&ih);
 
 	/* insert into index on character */
 	printf("inserting into index on char\n");
 	for (recnum=0; recnum < MAXRECS; recnum++){
 		sprintf(buf,"%d",recnum);
 		padstring(buf,STRING_SIZE);
-		xAM_InsertEntry(fd,CHAR_TYPE,STRING_SIZE,buf,IntToRecId(recnum));
+		xAM_InsertEntry(&ih,buf,IntToRecId(recnum));
 	}
 
 	printf("opening index scan on char\n");
-	sd = xAM_OpenIndexScan(fd,CHAR_TYPE,STRING_SIZE,EQ_OP,NULL);
+	sd = xAM_OpenIndexScan(&ih,EQ_OP,NULL);
 	printf("retrieving recid's from scan descriptor %d\n",sd);
 	numrec = 0;
 	while((recnum=RecIdToInt(xAM_FindNextEntry(sd)))>= 0){
@@ -51,7 +49,7 @@ int numrec;	/* # of records retrieved in s scan */
 	/* destroy everything */
 	printf("closing down\n");
 	xAM_CloseIndexScan(sd);
-	xPF_CloseFile(fd);
+	xAM_CloseIndex(&ih);
 	xAM_DestroyIndex(RELNAME,0);
 
 	printf("test2 done!\n");
@@ -8,8 +8,7 @@
 
 main()
 {
-int fd;	/* file descriptor for the index */
-char fname[FNAME_LENGTH];	/* file name */
+AM_INDEXHANDLE ih;	/* handle of the index */
 int recnum;	/* record number */
 int sd;	/* scan descriptor */
 int numrec;	/* # of records retrieved */
@@ -25,23 +24,22 @@ int testval;
 
 	/* open the index */
 	printf("opening index\n");
-	sprintf(fname,"%s.0",RELNAME);
-	fd = xPF_OpenFile(fname);
+	xAM_OpenIndex(RELNAME,0,&ih);
 
 	/* first, make sure that simple deletions work */
 	printf("inserting into index\n");
 	for (recnum=0; recnum < 20; recnum++){
-		xAM_InsertEntry(fd,INT_TYPE,sizeof(int),(char *)&recnum,
+		xAM_InsertEntry(&ih,(char *)&recnum,
 				IntToRecId(recnum));
 	}
 	printf("deleting odd number records\n");
 	for (recnum=1; recnum < 20; recnum += 2)
-		xAM_DeleteEntry(fd,INT_TYPE,sizeof(int),(char *)&recnum,
+		xAM_DeleteEntry(&ih,(char *)&recnum,
 					IntToRecId(recnum));
 
 	printf("retrieving even number records\n");
 	numrec= 0;
-	sd = xAM_OpenIndexScan(fd,INT_TYPE,sizeof(int),EQ_OP,NULL);
+	sd = xAM_OpenIndexScan(&ih,EQ_OP,NULL);
 	while((recnum=RecIdToInt(xAM_FindNextEntry(sd)))>= 0){
 		printf("%d\n",recnum);
 		numrec++;
@@ -51,12 +49,12 @@ int testval;
 
 	printf("deleting even number records\n");
 	for (recnum=0; recnum < 20; recnum += 2)
-		xAM_DeleteEntry(fd,INT_TYPE,sizeof(int),(char *)&recnum,
+		xAM_DeleteEntry(&ih,(char *)&recnum,
 					IntToRecId(recnum));
 
 	printf("retrieving from empty index\n");
 	numrec= 0;
-	sd = xAM_OpenIndexScan(fd,INT_TYPE,sizeof(int),EQ_OP,NULL);
+	sd = xAM_OpenIndexScan(&ih,EQ_OP,NULL);
 	while((recnum=RecIdToInt(xAM_FindNextEntry(sd)))>= 0){
 		printf("%d\n",recnum);
 		numrec++;
@@ -69,27 +67,27 @@ int testval;
 	printf("begin test of complex delete\n");
 	printf("inserting into index\n");
 	for (recnum=0; recnum < MAXRECS; recnum+=2){
-		xAM_InsertEntry(fd,INT_TYPE,sizeof(int),(char *)&recnum,
+		xAM_InsertEntry(&ih,(char *)&recnum,
 				IntToRecId(recnum));
 	}
 	for (recnum=1; recnum < MAXRECS; recnum+=2)
-		xAM_InsertEntry(fd,INT_TYPE,sizeof(int),(char *)&recnum,
+		xAM_InsertEntry(&ih,(char *)&recnum,
 				IntToRecId(recnum));
 
 	/* delete everything */
 	printf("deleting everything\n");
 	for (recnum=1; recnum < MAXRECS; recnum += 2)
-		xAM_DeleteEntry(fd,INT_TYPE,sizeof(int),(char *)&recnum,
+		xAM_DeleteEntry(&ih,(char *)&recnum,
 					IntToRecId(recnum));
 	for (recnum=0; recnum < MAXRECS; recnum +=2)
-		xAM_DeleteEntry(fd,INT_TYPE,sizeof(int),(char *)&recnum,
+		xAM_DeleteEntry(&ih,(char *)&recnum,
 					IntToRecId(recnum));
 
 
 	/* print out what remains */
 	printf("printing empty index\n");
 	numrec= 0;
-	sd = xAM_OpenIndexScan(fd,INT_TYPE,sizeof(int),EQ_OP,NULL);
+	sd = xAM_OpenIndexScan(&ih,EQ_OP,NULL);
 	while((recnum=RecIdToInt(xAM_FindNextEntry(sd)))>= 0){
 		printf("%d\n",recnum);
 		numrec++;
@@ -100,20 +98,20 @@ int testval;
 	/* insert everything back */
 	printf("inserting everything back\n");
 	for (recnum=0; recnum < MAXRECS; recnum++){
-		xAM_InsertEntry(fd,INT_TYPE,sizeof(int),(char *)&recnum,
+		xAM_InsertEntry(&ih,(char *)&recnum,
 				IntToRecId(recnum));
 	}
 
 	/* delete records less than 100, using scan!! */
 	printf("delete records less than 100\n");
 	testval = 100;
-	sd = xAM_OpenIndexScan(fd,INT_TYPE,sizeof(int),LT_OP,(char *)&testval);
+	sd = xAM_OpenIndexScan(&ih,LT_OP,(char *)&testval);
 	while((recnum=RecIdToInt(xAM_FindNextEntry(sd)))>= 0){
 		if (recnum >= 100){
 			printf("invalid recnum %d\n",recnum);
 			exit(1);
 		}
-		xAM_DeleteEntry(fd,INT_TYPE,sizeof(int),(char *)&recnum,IntToRecId
+		xAM_DeleteEntry(&ih,(char *)&recnum,IntToRecId
 					(recnum));
 	}
 	xAM_CloseIndexScan(sd);
@@ -121,13 +119,13 @@ int testval;
 	/* delete records greater than 150, using scan */
 	printf("delete records greater than 150\n");
 	testval = 150;
-	sd = xAM_OpenIndexScan(fd,INT_TYPE,sizeof(int),GT_OP,(char *)&testval);
+	sd = xAM_OpenIndexScan(&ih,GT_OP,(char *)&testval);
 	while((recnum=RecIdToInt(xAM_FindNextEntry(sd)))>= 0){
 		if (recnum <= 150){
 			printf("invalid recnum %d\n",recnum);
 			exit(1);
 		}
-		xAM_DeleteEntry(fd,INT_TYPE,sizeof(int),(char *)&recnum,
+		xAM_DeleteEntry(&ih,(char *)&recnum,
 					IntToRecId(recnum));
 	}
 	xAM_CloseIndexScan(sd);
@@ -135,7 +133,7 @@ int testval;
 	/* print out what remains */
 	printf("printing between 100 and 150\n");
 	numrec= 0;
-	sd = xAM_OpenIndexScan(fd,INT_TYPE,sizeof(int),EQ_OP,NULL);
+	sd = xAM_OpenIndexScan(&ih,EQ_OP,NULL);
 	while((recnum=RecIdToInt(xAM_FindNextEntry(sd)))>= 0){
 		printf("%d\n",recnum);
 		numrec++;
@@ -145,7 +143,7 @@ int testval;
 
 	/* destroy everything */
 	printf("closing down\n");
-	xPF_CloseFile(fd);
+	xAM_CloseIndex(&ih);
 	xAM_DestroyIndex(RELNAME,0);
 
 	printf("test3 done!\n");
@@ -5,29 +5,70 @@
  * 1. Incremental Load: Building RM file and AM index simultaneously.
  * 2. Bulk Load (Unsorted): Scanning an existing RM file.
  * 3. Optimized Bulk Load (Sorted): Scanning, sorting, then loading.
+ * 4. Bottom-up Bulk Load: Scanning, sorting, then AM_BulkLoad, which
+ *    builds packed leaves and the levels above them without searching.
+ * 5. External Sort + Bottom-up Bulk Load: as 4, but the pairs are
+ *    sorted by RM_Sort in a few buffer frames instead of in an array.
+ * 6. Parallel Build: AM_BuildIndex with 1 to 16 threads scanning page
+ *    ranges and sorting runs, merged into the bottom-up builder.
+ * 7. Two Indexes at Once: inserts alternating between two open index
+ *    handles, then one thread per index inserting concurrently.
+ * 8. Index Meta Page: the root, leftmost leaf, height and entry count
+ *    survive a reopen, and a point lookup requests height pages.
+ * 9. Mixed Reads and Inserts: one thread inserts and deletes half the
+ *    keys while 0 to 8 threads look up and range-scan the other half.
+ * 10. Node Search: lookups per second on an 'i', an 'f' and a 'c' index
+ *    with the general node search (AM_Compare on every probe) and with
+ *    the one AM_OpenIndex picks for the key type, which must agree, also
+ *    on indexes of repeated keys.
+ * 11. Key Routines: inserts, a build, lookups and scans on the roll
+ *    number index with the general key routines and the bound ones.
+ * 12. Leaf Layout: cache lines per leaf search with keys interleaved
+ *    and in a key array, and AM_RebuildIndex on an index of the old layout.
+ * 13. Character Keys: height, pages and pages per lookup of course-code
+ *    and email indexes, with whole keys and with leaf prefixes and
+ *    truncated separators.
  */
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <pthread.h>
 #include "pf.h" // From amlayer directory
+#include "rm.h" // From rmlayer directory (before am.h, for AM_BuildIndex)
 #include "am.h" // From amlayer directory
-#include "rm.h" // From amlayer directory (copied)
 
 /* --- File Definitions --- */
 #define STUDENT_DB_FILE "student_slotted.db"
 #define STUDENT_TXT_FILE "../../data/student.txt"
 #define INDEX_FILE "student_index"
+#define COURSE_TXT_FILE "../../data/courses.txt"
+#define EMAIL_TXT_FILE "../../data/studemail.txt"
 
 /* --- Index Definitions --- */
 #define INDEX_ATTR_TYPE 'i'
 #define INDEX_ATTR_LEN sizeof(int)
-#define INDEX_FILE_NAME "student_index.0"
 
 /* --- Other Constants --- */
 #define MAX_RECORDS 20000 // Max records to load
 #define MAX_LINE_LEN 256
 #define MAX_TEST_NAME_LEN 100
+#define SORT_FRAMES 16 // Memory of the external sort in Test 5
+#define MAX_BUILD_THREADS 16 // Test 6 doubles the threads up to this
+#define BUILD_ROUNDS 5 // Test 6 times the best of this many builds
+#define MAX_READERS 8 // Test 9 doubles the reader threads up to this
+#define MIXED_LOOKUPS 20000 // Lookups made by each Test 9 reader
+#define RANGE_EVERY 16 // Every 16th Test 9 lookup is also a range scan
+#define RANGE_LEN 32 // of this many entries
+#define NODE_LOOKUPS 1000000 // Test 10 descents through in-memory pages
+#define INDEX_LOOKUPS 200000 // Test 10 lookups through AM_OpenIndexScan
+#define DUP_KEYS 2000 // Test 10 also inserts this many keys
+#define DUP_COPIES 8 // this many times each
+#define DUP_RUN 2000 // and one of them this many more, over several leaves
+#define KEY_PHASES 4 // Test 11 times inserts, a build, lookups and scans
+#define CACHE_LINE 64 // Bytes per line in Test 12's count
+#define COURSE_KEY_LEN 32 // Declared length of Test 13's course codes
+#define EMAIL_KEY_LEN 64 // and of its email addresses
 
 /*
  * This struct is for the "Optimized Bulk Load" test.
@@ -47,6 +88,121 @@ int compare_key_rid_pairs(const void *a, const void *b) {
     return (pairA->key - pairB->key);
 }
 
+/*
+ * Iterator over a sorted KeyRidPair array, for AM_BulkLoad
+ */
+typedef struct {
+    KeyRidPair *pairs;
+    long numPairs;
+    long next;
+} PairIterator;
+
+int next_pair(void *arg, char *value, int *recId) {
+    PairIterator *it = (PairIterator *)arg;
+    if (it->next == it->numPairs)
+        return FALSE;
+    memcpy(value, &it->pairs[it->next].key, sizeof(int));
+    *recId = it->pairs[it->next].rid;
+    it->next++;
+    return TRUE;
+}
+
+/*
+ * Key of type attrType for the number x: an int, a float, or CHAR_KEY_LEN
+ * bytes of zero-padded digits, which sort as the numbers do
+ */
+#define CHAR_KEY_LEN 12
+int key_length(char attrType) {
+    return (attrType == 'c') ? CHAR_KEY_LEN : (int)sizeof(int);
+}
+
+void make_key(char attrType, double x, char *value) {
+    int i = (int)x;
+    float f = (float)x;
+
+    if (attrType == 'i')
+        memcpy(value, &i, sizeof(int));
+    else if (attrType == 'f')
+        memcpy(value, &f, sizeof(float));
+    else {
+        memset(value, 0, CHAR_KEY_LEN);
+        snprintf(value, CHAR_KEY_LEN, "%011d", i);
+    }
+}
+
+/* As next_pair, with keys of another type */
+typedef struct {
+    PairIterator it;
+    char attrType;
+} TypedPairIterator;
+
+int next_typed_pair(void *arg, char *value, int *recId) {
+    TypedPairIterator *tit = (TypedPairIterator *)arg;
+    if (tit->it.next == tit->it.numPairs)
+        return FALSE;
+    make_key(tit->attrType, tit->it.pairs[tit->it.next].key, value);
+    *recId = tit->it.pairs[tit->it.next].rid;
+    tit->it.next++;
+    return TRUE;
+}
+
+/*
+ * RM_Sort comparison function: key, then RID
+ */
+int compare_sorted_pairs(void *arg, char *a, int aLen, char *b, int bLen) {
+    KeyRidPair pairA, pairB;
+    memcpy(&pairA, a, sizeof(KeyRidPair));
+    memcpy(&pairB, b, sizeof(KeyRidPair));
+    if (pairA.key != pairB.key)
+        return (pairA.key > pairB.key) - (pairA.key < pairB.key);
+    return (pairA.rid > pairB.rid) - (pairA.rid < pairB.rid);
+}
+
+/*
+ * AM_BulkLoad iterator over the output of an external sort
+ */
+int next_sorted_pair(void *arg, char *value, int *recId) {
+    KeyRidPair pair;
+    char *data;
+    int len, err;
+
+    if ((err = RM_SortNext((RM_Sort *)arg, &data, &len)) == RME_EOF)
+        return FALSE;
+    if (err != RME_OK || len != sizeof(KeyRidPair))
+        return AME_INTERROR;
+    memcpy(&pair, data, sizeof(KeyRidPair));
+    memcpy(value, &pair.key, sizeof(int));
+    *recId = pair.rid;
+    return TRUE;
+}
+
+/*
+ * Helper: verify_index
+ * Looks every key up with an EQUAL scan and counts the entries a full
+ * scan returns. Returns the number of keys whose RID was not found.
+ */
+long verify_index(AM_INDEXHANDLE *ih, KeyRidPair *pairs, long numPairs, long *scanned) {
+    long i, bad = 0;
+    int sd, recId, found;
+
+    for (i = 0; i < numPairs; i++) {
+        sd = AM_OpenIndexScan(ih, EQUAL, (char *)&pairs[i].key);
+        found = FALSE;
+        while ((recId = AM_FindNextEntry(sd)) >= 0)
+            if (recId == pairs[i].rid)
+                found = TRUE;
+        AM_CloseIndexScan(sd);
+        if (!found)
+            bad++;
+    }
+    *scanned = 0;
+    sd = AM_OpenIndexScan(ih, ALL, NULL);
+    while (AM_FindNextEntry(sd) >= 0)
+        (*scanned)++;
+    AM_CloseIndexScan(sd);
+    return bad;
+}
+
 /*
  * Helper: create_variable_record (Copied from test_rm.c)
  * Creates a simulated variable-length record.
@@ -93,6 +249,814 @@ int extract_key_from_record(char *recordData) {
     return -1; // Error
 }
 
+/*
+ * Helper: extract_numeric_key
+ * Like extract_key_from_record, but -1 unless the 2nd ID is all digits.
+ * atoi() turns the roll numbers with letters into a few small keys that
+ * each have more RIDs than one leaf page can hold.
+ */
+int extract_numeric_key(char *recordData) {
+    char id1_str[50], id2_str[50];
+    if (sscanf(recordData, "%49[^;];%49[^;];", id1_str, id2_str) == 2 &&
+        strspn(id2_str, "0123456789") == strlen(id2_str)) {
+        return atoi(id2_str);
+    }
+    return -1;
+}
+
+/*
+ * AM_BuildIndex key function: the numeric roll number, if any
+ */
+int build_key(void *arg, char *rec, int recLength, char *value) {
+    char recordData[MAX_LINE_LEN];
+    int key;
+
+    if (recLength >= MAX_LINE_LEN)
+        recLength = MAX_LINE_LEN - 1;
+    memcpy(recordData, rec, recLength);
+    recordData[recLength] = '\0';
+    if ((key = extract_numeric_key(recordData)) == -1)
+        return FALSE;
+    memcpy(value, &key, sizeof(int));
+    return TRUE;
+}
+
+/* Wall-clock seconds; clock() would add up the CPU time of all threads */
+double wall_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+/*
+ * Test 7 worker: inserts pairs into one index, forwards or backwards
+ */
+typedef struct {
+    AM_INDEXHANDLE *ih;
+    KeyRidPair *pairs;
+    long numPairs;
+    int reverse;
+    int err;
+} InsertJob;
+
+void *insert_pairs(void *arg) {
+    InsertJob *job = (InsertJob *)arg;
+    long i, j;
+
+    job->err = AME_OK;
+    for (i = 0; i < job->numPairs && job->err == AME_OK; i++) {
+        j = job->reverse ? job->numPairs - 1 - i : i;
+        job->err = AM_InsertEntry(job->ih, (char *)&job->pairs[j].key, job->pairs[j].rid);
+    }
+    return NULL;
+}
+
+/*
+ * Test 7: creates indexes 0 and 1, fills 0 forwards and 1 backwards,
+ * alternating between them or on one thread each, and checks both
+ */
+void fill_two_indexes(KeyRidPair *pairs, long numPairs, int threaded) {
+    AM_INDEXHANDLE ih[2];
+    InsertJob jobs[2];
+    pthread_t thread;
+    long i, bad, scanned;
+    double t0;
+    int k;
+
+    for (k = 0; k < 2; k++) {
+        AM_DestroyIndex(INDEX_FILE, k);
+        AM_CreateIndex(INDEX_FILE, k, INDEX_ATTR_TYPE, INDEX_ATTR_LEN);
+        AM_OpenIndex(INDEX_FILE, k, &ih[k]);
+        jobs[k].ih = &ih[k];
+        jobs[k].pairs = pairs;
+        jobs[k].numPairs = numPairs;
+        jobs[k].reverse = k;
+        jobs[k].err = AME_OK;
+    }
+
+    t0 = wall_seconds();
+    if (threaded) {
+        pthread_create(&thread, NULL, insert_pairs, &jobs[1]);
+        insert_pairs(&jobs[0]);
+        pthread_join(thread, NULL);
+    } else {
+        for (i = 0; i < numPairs && jobs[0].err == AME_OK && jobs[1].err == AME_OK; i++) {
+            jobs[0].err = AM_InsertEntry(&ih[0], (char *)&pairs[i].key, pairs[i].rid);
+            jobs[1].err = AM_InsertEntry(&ih[1], (char *)&pairs[numPairs - 1 - i].key,
+                                         pairs[numPairs - 1 - i].rid);
+        }
+    }
+    printf("Results for Test 7 (%s): %f sec\n",
+           threaded ? "one thread per index" : "alternating", wall_seconds() - t0);
+
+    for (k = 0; k < 2; k++) {
+        bad = verify_index(&ih[k], pairs, numPairs, &scanned);
+        printf("  Index %d: height %d, %d pages, %ld of %ld keys not found, "
+               "%ld entries%s\n", k, ih[k].height, PF_GetNumPages(ih[k].fileDesc),
+               bad, numPairs, scanned, (jobs[k].err == AME_OK) ? "" : " (insert failed)");
+        AM_CloseIndex(&ih[k]);
+        AM_DestroyIndex(INDEX_FILE, k);
+    }
+}
+
+/*
+ * Test 9 writer: inserts its pairs, then deletes and inserts them again
+ * until the readers are done, so that it ends with all of them inserted
+ */
+typedef struct {
+    AM_INDEXHANDLE *ih;
+    KeyRidPair *pairs;
+    long numPairs;
+    int *stop; // set when the readers are done
+    long inserts;
+    int err;
+    double seconds;
+} ChurnJob;
+
+void *churn_pairs(void *arg) {
+    ChurnJob *job = (ChurnJob *)arg;
+    double t0 = wall_seconds();
+    long i;
+
+    job->err = AME_OK;
+    job->inserts = 0;
+    for (;;) {
+        for (i = 0; i < job->numPairs && job->err == AME_OK; i++, job->inserts++)
+            job->err = AM_InsertEntry(job->ih, (char *)&job->pairs[i].key, job->pairs[i].rid);
+        if (job->err != AME_OK || __atomic_load_n(job->stop, __ATOMIC_ACQUIRE))
+            break;
+        for (i = 0; i < job->numPairs && job->err == AME_OK; i++)
+            job->err = AM_DeleteEntry(job->ih, (char *)&job->pairs[i].key, job->pairs[i].rid);
+    }
+    job->seconds = wall_seconds() - t0;
+    return NULL;
+}
+
+/*
+ * Test 9 reader: looks up random pairs that are known to be in the index,
+ * and every RANGE_EVERY lookups scans RANGE_LEN entries from the key on
+ */
+typedef struct {
+    AM_INDEXHANDLE *ih;
+    KeyRidPair *pairs;
+    long numPairs;
+    unsigned int seed;
+    long misses;
+    long shortRanges; // range scans that ended early
+    double seconds;
+} LookupJob;
+
+void *lookup_pairs(void *arg) {
+    LookupJob *job = (LookupJob *)arg;
+    double t0 = wall_seconds();
+    KeyRidPair *pair;
+    int n, sd, recId, found;
+
+    job->misses = job->shortRanges = 0;
+    for (n = 0; n < MIXED_LOOKUPS; n++) {
+        pair = &job->pairs[rand_r(&job->seed) % job->numPairs];
+        sd = AM_OpenIndexScan(job->ih, EQUAL, (char *)&pair->key);
+        found = FALSE;
+        while ((recId = AM_FindNextEntry(sd)) >= 0)
+            if (recId == pair->rid)
+                found = TRUE;
+        AM_CloseIndexScan(sd);
+        if (!found)
+            job->misses++;
+
+        if (n % RANGE_EVERY == 0) {
+            sd = AM_OpenIndexScan(job->ih, GREATER_THAN_EQUAL, (char *)&pair->key);
+            for (found = 0; found < RANGE_LEN && AM_FindNextEntry(sd) >= 0; found++)
+                ;
+            AM_CloseIndexScan(sd);
+            // Only the last few keys have fewer than RANGE_LEN entries from them on
+            if (found == 0)
+                job->shortRanges++;
+        }
+    }
+    job->seconds = wall_seconds() - t0;
+    return NULL;
+}
+
+/*
+ * Test 9: loads the even pairs, then inserts (and deletes and inserts
+ * again) the odd ones on one thread while numReaders threads look up
+ * even ones, and checks the index
+ */
+void mixed_workload(KeyRidPair *pairs, long numPairs, int numReaders) {
+    AM_INDEXHANDLE ih;
+    KeyRidPair *loaded, *inserted;
+    ChurnJob writer;
+    LookupJob readers[MAX_READERS];
+    pthread_t writerThread, threads[MAX_READERS];
+    long i, numLoaded = 0, numInserted = 0, misses = 0, shortRanges = 0, bad, scanned;
+    double readSeconds = 0;
+    int k, stop = (numReaders == 0);
+
+    loaded = malloc(sizeof(KeyRidPair) * numPairs);
+    inserted = malloc(sizeof(KeyRidPair) * numPairs);
+    for (i = 0; i < numPairs; i++) {
+        if (i % 2 == 0)
+            loaded[numLoaded++] = pairs[i];
+        else
+            inserted[numInserted++] = pairs[i];
+    }
+
+    AM_DestroyIndex(INDEX_FILE, 0);
+    AM_CreateIndex(INDEX_FILE, 0, INDEX_ATTR_TYPE, INDEX_ATTR_LEN);
+    AM_OpenIndex(INDEX_FILE, 0, &ih);
+    for (i = 0; i < numLoaded; i++)
+        AM_InsertEntry(&ih, (char *)&loaded[i].key, loaded[i].rid);
+    ih.restarts = 0;
+
+    writer.ih = &ih;
+    writer.pairs = inserted;
+    writer.numPairs = numInserted;
+    writer.stop = &stop;
+    pthread_create(&writerThread, NULL, churn_pairs, &writer);
+    for (k = 0; k < numReaders; k++) {
+        readers[k].ih = &ih;
+        readers[k].pairs = loaded;
+        readers[k].numPairs = numLoaded;
+        readers[k].seed = k + 1;
+        pthread_create(&threads[k], NULL, lookup_pairs, &readers[k]);
+    }
+    for (k = 0; k < numReaders; k++) {
+        pthread_join(threads[k], NULL);
+        misses += readers[k].misses;
+        shortRanges += readers[k].shortRanges;
+        if (readers[k].seconds > readSeconds)
+            readSeconds = readers[k].seconds;
+    }
+    __atomic_store_n(&stop, TRUE, __ATOMIC_RELEASE);
+    pthread_join(writerThread, NULL);
+
+    bad = verify_index(&ih, pairs, numPairs, &scanned);
+    if (numReaders == 0)
+        printf("  0 readers: %9s lookups/s, %8.0f inserts/s\n", "-",
+               writer.inserts / writer.seconds);
+    else
+        printf("  %d readers: %9.0f lookups/s, %8.0f inserts/s, %ld misses, "
+               "%ld empty ranges, %ld restarts\n", numReaders,
+               numReaders * MIXED_LOOKUPS / readSeconds, writer.inserts / writer.seconds,
+               misses, shortRanges, ih.restarts);
+    printf("             final check: %ld of %ld keys not found, %ld entries%s\n",
+           bad, numPairs, scanned, (writer.err == AME_OK) ? "" : " (insert failed)");
+    AM_CloseIndex(&ih);
+    AM_DestroyIndex(INDEX_FILE, 0);
+    free(loaded);
+    free(inserted);
+}
+
+/*
+ * Test 10 helper: finds the leaf and index of value in a copy of the
+ * index pages, with the node searches set in the handle. As a scan does,
+ * it goes on to the next leaf if value is above every key of the leftmost
+ * leaf that can hold it.
+ */
+int descend(AM_INDEXHANDLE *ih, char *pages, char *value, int *leaf, int *index) {
+    char *page;
+    AM_INTHEADER ihead;
+    AM_LEAFHEADER lhead;
+    int pageNum = ih->rootPageNum, status;
+
+    for (page = pages + (long)pageNum * PF_PAGE_SIZE; *page != 'l';
+         page = pages + (long)pageNum * PF_PAGE_SIZE) {
+        memcpy(&ihead, page, sizeof(AM_INTHEADER));
+        pageNum = ih->keyOps->intSearch(page, ih->attrType, ih->attrLength, value, index, &ihead);
+    }
+    memcpy(&lhead, page, sizeof(AM_LEAFHEADER));
+    status = ih->keyOps->leafSearch(page, ih->attrType, ih->attrLength, value, index, &lhead);
+    if (*index > lhead.numKeys && lhead.nextLeafPage != AM_NULL_PAGE) {
+        pageNum = lhead.nextLeafPage;
+        page = pages + (long)pageNum * PF_PAGE_SIZE;
+        memcpy(&lhead, page, sizeof(AM_LEAFHEADER));
+        status = ih->keyOps->leafSearch(page, ih->attrType, ih->attrLength, value, index, &lhead);
+    }
+    *leaf = pageNum;
+    return status;
+}
+
+/*
+ * Test 10: bulk loads the pairs into an index of type attrType, and times
+ * lookups with the general node search and with the typed one. Every key,
+ * and the values either side of it, must land on the same leaf and index
+ * with both.
+ */
+void time_node_search(KeyRidPair *pairs, long numPairs, char attrType) {
+    AM_INDEXHANDLE ih;
+    AM_KEYOPS *typedOps;
+    TypedPairIterator tit = { { pairs, numPairs, 0 }, attrType };
+    char *pages, value[AM_MAXATTRLENGTH];
+    double t0, nodeRate[2], indexRate[2];
+    long i, n, found[2] = { 0, 0 }, mismatches = 0;
+    int numPages, mode, leaf[2], index[2], status[2], sd, d;
+    unsigned int seed;
+
+    AM_DestroyIndex(INDEX_FILE, 0);
+    AM_CreateIndex(INDEX_FILE, 0, attrType, key_length(attrType));
+    AM_OpenIndex(INDEX_FILE, 0, &ih);
+    AM_BulkLoad(&ih, next_typed_pair, &tit, 100);
+    typedOps = ih.keyOps;
+
+    numPages = PF_GetNumPages(ih.fileDesc);
+    pages = malloc((long)numPages * PF_PAGE_SIZE);
+    for (i = 1; i < numPages; i++)
+        PF_CopyPage(ih.fileDesc, i, pages + i * PF_PAGE_SIZE, PF_PAGE_SIZE);
+
+    // The typed search must agree with the general one everywhere
+    for (i = 0; i < numPairs; i++)
+        for (d = -1; d <= 1; d++) {
+            for (mode = 0; mode < 2; mode++) {
+                ih.keyOps = mode ? typedOps : &AM_generalOps;
+                make_key(attrType, pairs[i].key + d * ((attrType == 'f') ? 0.5 : 1), value);
+                status[mode] = descend(&ih, pages, value, &leaf[mode], &index[mode]);
+            }
+            if (status[0] != status[1] || leaf[0] != leaf[1] || index[0] != index[1])
+                mismatches++;
+        }
+
+    for (mode = 0; mode < 2; mode++) {
+        ih.keyOps = mode ? typedOps : &AM_generalOps;
+
+        seed = 1;
+        t0 = wall_seconds();
+        for (n = 0; n < NODE_LOOKUPS; n++) {
+            i = rand_r(&seed) % numPairs;
+            make_key(attrType, pairs[i].key, value);
+            found[mode] += (descend(&ih, pages, value, &leaf[0], &index[0]) == AM_FOUND);
+        }
+        nodeRate[mode] = NODE_LOOKUPS / (wall_seconds() - t0);
+
+        t0 = wall_seconds();
+        for (n = 0; n < INDEX_LOOKUPS; n++) {
+            i = rand_r(&seed) % numPairs;
+            make_key(attrType, pairs[i].key, value);
+            sd = AM_OpenIndexScan(&ih, EQUAL, value);
+            while (AM_FindNextEntry(sd) >= 0)
+                ;
+            AM_CloseIndexScan(sd);
+        }
+        indexRate[mode] = INDEX_LOOKUPS / (wall_seconds() - t0);
+    }
+
+    printf("  '%c' index, height %d: %ld mismatches, %ld and %ld of %d keys found\n",
+           attrType, ih.height, mismatches, found[0], found[1], NODE_LOOKUPS);
+    printf("    Descents through copied pages: %10.0f/s general, %10.0f/s typed, %.2fx\n",
+           nodeRate[0], nodeRate[1], nodeRate[1] / nodeRate[0]);
+    printf("    Lookups through index scans:   %10.0f/s general, %10.0f/s typed, %.2fx\n",
+           indexRate[0], indexRate[1], indexRate[1] / indexRate[0]);
+    free(pages);
+    AM_CloseIndex(&ih);
+    AM_DestroyIndex(INDEX_FILE, 0);
+}
+
+/*
+ * Test 10 helper: inserts DUP_KEYS keys DUP_COPIES times each, round after
+ * round, into an index of type attrType, then one of them DUP_RUN more
+ * times, which takes several leaves. The general and the typed node
+ * searches must agree on every key and the values either side of it, an
+ * EQUAL scan of a key must return all its copies, and deletes must find
+ * recIds anywhere in the long run. What is left of the run is then
+ * deleted through a scan, each recId as the scan returns it.
+ */
+void check_duplicate_keys(char attrType) {
+    AM_INDEXHANDLE ih;
+    AM_KEYOPS *typedOps;
+    char *pages, value[AM_MAXATTRLENGTH];
+    long i, mismatches = 0, short_lists = 0, scanned = 0, failed = 0;
+    int numPages, mode, leaf[2], index[2], status[2], sd, d, c, n, recId, gone, left;
+
+    AM_DestroyIndex(INDEX_FILE, 0);
+    AM_CreateIndex(INDEX_FILE, 0, attrType, key_length(attrType));
+    AM_OpenIndex(INDEX_FILE, 0, &ih);
+    for (c = 0; c < DUP_COPIES; c++)
+        for (i = 0; i < DUP_KEYS; i++) {
+            make_key(attrType, i, value);
+            if (AM_InsertEntry(&ih, value, (int)(c * DUP_KEYS + i)) != AME_OK)
+                failed++;
+        }
+    make_key(attrType, DUP_KEYS / 2, value);
+    for (i = 0; i < DUP_RUN; i++)
+        if (AM_InsertEntry(&ih, value, (int)(DUP_COPIES * DUP_KEYS + i)) != AME_OK)
+            failed++;
+    typedOps = ih.keyOps;
+
+    numPages = PF_GetNumPages(ih.fileDesc);
+    pages = malloc((long)numPages * PF_PAGE_SIZE);
+    for (i = 1; i < numPages; i++)
+        PF_CopyPage(ih.fileDesc, i, pages + i * PF_PAGE_SIZE, PF_PAGE_SIZE);
+    for (i = 0; i < DUP_KEYS; i++)
+        for (d = -1; d <= 1; d++) {
+            for (mode = 0; mode < 2; mode++) {
+                ih.keyOps = mode ? typedOps : &AM_generalOps;
+                make_key(attrType, i + d * ((attrType == 'f') ? 0.5 : 1), value);
+                status[mode] = descend(&ih, pages, value, &leaf[mode], &index[mode]);
+            }
+            if (status[0] != status[1] || leaf[0] != leaf[1] || index[0] != index[1])
+                mismatches++;
+        }
+    ih.keyOps = typedOps;
+
+    for (i = 0; i < DUP_KEYS; i++) {
+        make_key(attrType, i, value);
+        sd = AM_OpenIndexScan(&ih, EQUAL, value);
+        for (n = 0; AM_FindNextEntry(sd) >= 0; n++)
+            ;
+        AM_CloseIndexScan(sd);
+        if (n != DUP_COPIES + ((i == DUP_KEYS / 2) ? DUP_RUN : 0))
+            short_lists++;
+    }
+    sd = AM_OpenIndexScan(&ih, ALL, NULL);
+    while (AM_FindNextEntry(sd) >= 0)
+        scanned++;
+    AM_CloseIndexScan(sd);
+
+    // Every other recId of the long run, wherever in the run it is
+    make_key(attrType, DUP_KEYS / 2, value);
+    for (i = 0; i < DUP_RUN; i += 2)
+        if (AM_DeleteEntry(&ih, value, (int)(DUP_COPIES * DUP_KEYS + i)) != AME_OK)
+            failed++;
+    sd = AM_OpenIndexScan(&ih, EQUAL, value);
+    for (n = 0; AM_FindNextEntry(sd) >= 0; n++)
+        ;
+    AM_CloseIndexScan(sd);
+
+    // The scan goes on through its copy of the leaf the deletes change
+    sd = AM_OpenIndexScan(&ih, EQUAL, value);
+    for (gone = 0; (recId = AM_FindNextEntry(sd)) >= 0; gone++)
+        if (AM_DeleteEntry(&ih, value, recId) != AME_OK)
+            failed++;
+    AM_CloseIndexScan(sd);
+    sd = AM_OpenIndexScan(&ih, EQUAL, value);
+    for (left = 0; AM_FindNextEntry(sd) >= 0; left++)
+        ;
+    AM_CloseIndexScan(sd);
+
+    printf("  '%c' index of %d keys x %d, one x %d more, height %d, %d pages: "
+           "%ld mismatches, %ld keys without every copy, %ld entries, %d left of "
+           "the run after deletes, %d deleted through a scan, %d left, %ld calls failed\n",
+           attrType, DUP_KEYS, DUP_COPIES, DUP_RUN, ih.height, numPages, mismatches,
+           short_lists, scanned, n, gone, left, failed);
+    free(pages);
+    AM_CloseIndex(&ih);
+    AM_DestroyIndex(INDEX_FILE, 0);
+}
+
+/*
+ * Test 11: times the AM calls that compare keys on the roll-number index,
+ * once with the general routines (AM_generalOps) in the handle and once
+ * with those AM_OpenIndex binds: inserts, a one-thread AM_BuildIndex
+ * (whose sort and merge compare), lookups and full scans. Best of
+ * BUILD_ROUNDS; the index of each round is checked.
+ */
+void time_key_routines(KeyRidPair *pairs, long numPairs, RM_FileHandle *rmFile) {
+    static const char *names[KEY_PHASES] = { "Inserts", "1-thread build", "Lookups",
+                                             "Full scans" };
+    AM_INDEXHANDLE ih;
+    double t0, t[KEY_PHASES], best[KEY_PHASES][2];
+    long i, bad = 0, scanned, entries = 0;
+    int mode, round, phase, sd, err = AME_OK;
+
+    for (mode = 0; mode < 2; mode++)
+        for (round = 0; round < BUILD_ROUNDS; round++) {
+            AM_DestroyIndex(INDEX_FILE, 0);
+            AM_CreateIndex(INDEX_FILE, 0, INDEX_ATTR_TYPE, INDEX_ATTR_LEN);
+            AM_OpenIndex(INDEX_FILE, 0, &ih);
+            if (mode == 0)
+                ih.keyOps = &AM_generalOps;
+            t0 = wall_seconds();
+            for (i = 0; i < numPairs && err == AME_OK; i++)
+                err = AM_InsertEntry(&ih, (char *)&pairs[i].key, pairs[i].rid);
+            t[0] = wall_seconds() - t0;
+            AM_CloseIndex(&ih);
+
+            AM_DestroyIndex(INDEX_FILE, 0);
+            AM_CreateIndex(INDEX_FILE, 0, INDEX_ATTR_TYPE, INDEX_ATTR_LEN);
+            AM_OpenIndex(INDEX_FILE, 0, &ih);
+            if (mode == 0)
+                ih.keyOps = &AM_generalOps;
+            t0 = wall_seconds();
+            if (err == AME_OK)
+                err = AM_BuildIndex(&ih, rmFile, 1, build_key, NULL, 100);
+            t[1] = wall_seconds() - t0;
+
+            t0 = wall_seconds();
+            bad += verify_index(&ih, pairs, numPairs, &scanned);
+            t[2] = wall_seconds() - t0;
+
+            t0 = wall_seconds();
+            entries = 0;
+            sd = AM_OpenIndexScan(&ih, ALL, NULL);
+            while (AM_FindNextEntry(sd) >= 0)
+                entries++;
+            AM_CloseIndexScan(sd);
+            t[3] = wall_seconds() - t0;
+            if (entries != numPairs)
+                bad++;
+            AM_CloseIndex(&ih);
+
+            for (phase = 0; phase < KEY_PHASES; phase++)
+                if (round == 0 || t[phase] < best[phase][mode])
+                    best[phase][mode] = t[phase];
+        }
+
+    for (phase = 0; phase < KEY_PHASES; phase++)
+        printf("  %-15s %f sec general, %f sec bound, %.2fx\n", names[phase],
+               best[phase][0], best[phase][1], best[phase][0] / best[phase][1]);
+    printf("  %ld entries per index, %ld keys not found%s\n", entries, bad,
+           (err == AME_OK) ? "" : " (insert or build failed)");
+    AM_DestroyIndex(INDEX_FILE, 0);
+}
+
+/*
+ * Test 12 helper: cache lines read by the typed leaf search for int key
+ * number target (from 0) of a leaf of numKeys keys, with key i at
+ * keyOffset + i * stride in the page. Pages are taken to start on a line.
+ */
+void touch_key(int offset, int *lines, int *numLines) {
+    int line, i;
+
+    // A key can straddle two lines
+    for (line = offset / CACHE_LINE; line <= (offset + (int)sizeof(int) - 1) / CACHE_LINE;
+         line++) {
+        for (i = 0; i < *numLines && lines[i] != line; i++)
+            ;
+        if (i == *numLines)
+            lines[(*numLines)++] = line;
+    }
+}
+
+int leaf_search_lines(int numKeys, int target, int keyOffset, int stride) {
+    int lines[2 * 16], numLines = 0, base = 0, n = numKeys, half;
+
+    // The probes of the typed leaf search for key number target
+    while (n > 1) {
+        half = n / 2;
+        touch_key(keyOffset + (base + half) * stride, lines, &numLines);
+        if (base + half < target)
+            base += half;
+        n -= half;
+    }
+    touch_key(keyOffset + base * stride, lines, &numLines);
+    if (base < target)
+        touch_key(keyOffset + ++base * stride, lines, &numLines);
+    return numLines;
+}
+
+/*
+ * Test 12 helper: writes the pairs as an index of the layout before
+ * AM_FORMAT, whose leaves interleave each key with the head of its recId
+ * list. Only what AM_RebuildIndex reads is written, the header page and
+ * the chain of leaves. A headerless index, as the first ones were, has
+ * an internal root on page 0 instead, and only its first child is set.
+ * Returns the number of leaves.
+ */
+typedef struct {
+    char pageType;
+    int nextLeafPage;
+    short recIdPtr;
+    short keyPtr;
+    short freeListPtr;
+    short numinfreeList;
+    short attrLength;
+    short numKeys;
+    short maxKeys;
+} OldLeafHeader;
+
+typedef struct {
+    char pageType;
+    short numKeys;
+    short maxKeys;
+    short attrLength;
+} OldIntHeader;
+
+int write_old_index(KeyRidPair *pairs, long numPairs, int headerless) {
+    char name[MAX_TEST_NAME_LEN], *headerBuf, *leafBuf, *nextBuf;
+    AM_INDEXHEADER indexHead;
+    OldLeafHeader head;
+    OldIntHeader rootHead;
+    int fd, headerPage, leafPage, nextPage, numLeaves = 1;
+    short entry, null = AM_NULL;
+    long i;
+
+    sprintf(name, "%s.0", INDEX_FILE);
+    PF_DestroyFile(name);
+    PF_CreateFile(name);
+    fd = PF_OpenFile(name, PF_LRU);
+    PF_AllocPage(fd, &headerPage, &headerBuf);
+    PF_AllocPage(fd, &leafPage, &leafBuf);
+
+    memset(&head, 0, sizeof(head));
+    head.pageType = 'l';
+    head.nextLeafPage = AM_NULL_PAGE;
+    head.recIdPtr = PF_PAGE_SIZE;
+    head.keyPtr = sizeof(OldLeafHeader);
+    head.attrLength = sizeof(int);
+    head.maxKeys = 126;
+    for (i = 0; i < numPairs; i++) {
+        if (i > 0 && pairs[i].key == pairs[i - 1].key) {
+            // Another recId, at the head of the last key's list
+            if (head.recIdPtr - head.keyPtr < 6)
+                break;
+            head.recIdPtr -= 6;
+            memcpy(leafBuf + head.recIdPtr, &pairs[i].rid, sizeof(int));
+            memcpy(leafBuf + head.recIdPtr + 4, leafBuf + head.keyPtr - 2, 2);
+            memcpy(leafBuf + head.keyPtr - 2, &head.recIdPtr, 2);
+            continue;
+        }
+        if (head.recIdPtr - head.keyPtr < 12) {
+            // The leaf is full: link it to a new one
+            PF_AllocPage(fd, &nextPage, &nextBuf);
+            head.nextLeafPage = nextPage;
+            memcpy(leafBuf, &head, sizeof(head));
+            PF_UnfixPage(fd, leafPage, TRUE);
+            leafPage = nextPage;
+            leafBuf = nextBuf;
+            head.nextLeafPage = AM_NULL_PAGE;
+            head.recIdPtr = PF_PAGE_SIZE;
+            head.keyPtr = sizeof(OldLeafHeader);
+            head.numKeys = 0;
+            numLeaves++;
+        }
+        head.recIdPtr -= 6;
+        entry = head.recIdPtr;
+        memcpy(leafBuf + entry, &pairs[i].rid, sizeof(int));
+        memcpy(leafBuf + entry + 4, &null, 2);
+        memcpy(leafBuf + head.keyPtr, &pairs[i].key, sizeof(int));
+        memcpy(leafBuf + head.keyPtr + 4, &entry, 2);
+        head.keyPtr += 6;
+        head.numKeys++;
+    }
+    memcpy(leafBuf, &head, sizeof(head));
+    PF_UnfixPage(fd, leafPage, TRUE);
+
+    if (headerless) {
+        // The root, over the leftmost leaf (page 1)
+        memset(&rootHead, 0, sizeof(rootHead));
+        rootHead.pageType = 'i';
+        rootHead.numKeys = 1;
+        rootHead.maxKeys = 126;
+        rootHead.attrLength = sizeof(int);
+        memcpy(headerBuf, &rootHead, sizeof(rootHead));
+        leafPage = 1;
+        memcpy(headerBuf + sizeof(rootHead), &leafPage, sizeof(int));
+        PF_UnfixPage(fd, headerPage, TRUE);
+        PF_CloseFile(fd);
+        return numLeaves;
+    }
+
+    // The header as it was, without the format
+    memset(&indexHead, 0, sizeof(indexHead));
+    indexHead.pageType = 'h';
+    indexHead.attrType = 'i';
+    indexHead.attrLength = sizeof(int);
+    indexHead.rootPageNum = 1;
+    indexHead.leftPageNum = 1;
+    indexHead.height = 1;
+    indexHead.numEntries = numPairs;
+    memcpy(headerBuf, &indexHead, sizeof(indexHead));
+    PF_UnfixPage(fd, headerPage, TRUE);
+    PF_CloseFile(fd);
+    return numLeaves;
+}
+
+/*
+ * Test 12: counts the cache lines a leaf search reads in the bulk-loaded
+ * roll-number index, in the key array and as it would in the interleaved
+ * layout, then makes an index of the interleaved layout and rebuilds it
+ */
+void leaf_layout(KeyRidPair *pairs, long numPairs) {
+    AM_INDEXHANDLE ih;
+    AM_LEAFHEADER head;
+    PairIterator it = { pairs, numPairs, 0 };
+    char page[PF_PAGE_SIZE];
+    long searches = 0, oldLines = 0, newLines = 0, bad, scanned;
+    int pageNum, k, numLeaves, openErr, err, again;
+    double t0, t;
+
+    AM_DestroyIndex(INDEX_FILE, 0);
+    AM_CreateIndex(INDEX_FILE, 0, INDEX_ATTR_TYPE, INDEX_ATTR_LEN);
+    AM_OpenIndex(INDEX_FILE, 0, &ih);
+    AM_BulkLoad(&ih, next_pair, &it, 100);
+    for (pageNum = ih.leftPageNum; pageNum != AM_NULL_PAGE; pageNum = head.nextLeafPage) {
+        PF_CopyPage(ih.fileDesc, pageNum, page, PF_PAGE_SIZE);
+        memcpy(&head, page, sizeof(head));
+        for (k = 0; k < head.numKeys; k++) {
+            // Both layouts start the keys right after a header of the same size
+            oldLines += leaf_search_lines(head.numKeys, k, sizeof(AM_LEAFHEADER),
+                                          sizeof(int) + sizeof(short));
+            newLines += leaf_search_lines(head.numKeys, k, sizeof(AM_LEAFHEADER),
+                                          head.keySize);
+            searches++;
+        }
+    }
+    printf("  Leaf search: %.2f cache lines interleaved, %.2f in the key array "
+           "(%ld searches)\n", (double)oldLines / searches, (double)newLines / searches,
+           searches);
+    AM_CloseIndex(&ih);
+
+    for (k = 0; k < 2; k++) {
+        numLeaves = write_old_index(pairs, numPairs, k);
+        openErr = AM_OpenIndex(INDEX_FILE, 0, &ih);
+        if (openErr == AME_OK)
+            AM_CloseIndex(&ih);
+        t0 = wall_seconds();
+        err = AM_RebuildIndex(INDEX_FILE, 0, INDEX_ATTR_TYPE, 100);
+        t = wall_seconds() - t0;
+        again = AM_RebuildIndex(INDEX_FILE, 0, INDEX_ATTR_TYPE, 100);
+        printf("  Old index of %d leaves%s: open returned %d, rebuild %d in %f sec, "
+               "again %d\n", numLeaves, k ? " (no header)" : "", openErr, err, t, again);
+        if (AM_OpenIndex(INDEX_FILE, 0, &ih) == AME_OK) {
+            bad = verify_index(&ih, pairs, numPairs, &scanned);
+            printf("  Rebuilt index: height %d, %d pages, %ld of %ld keys not found, "
+                   "%ld entries\n", ih.height, PF_GetNumPages(ih.fileDesc), bad, numPairs,
+                   scanned);
+            AM_CloseIndex(&ih);
+        } else
+            printf("  Rebuilt index does not open\n");
+    }
+    AM_DestroyIndex(INDEX_FILE, 0);
+}
+
+/*
+ * Test 13 helper: reads field (from 0) of every ';' separated line after
+ * the header into keys, keyLength zero-padded bytes each, and returns the
+ * number of keys read
+ */
+long read_char_keys(const char *fileName, int field, int keyLength, char *keys, long maxKeys) {
+    FILE *f;
+    char line[MAX_LINE_LEN];
+    char *start, *end;
+    long n = 0;
+    int i, len;
+
+    if ((f = fopen(fileName, "r")) == NULL)
+        return 0;
+    fgets(line, MAX_LINE_LEN, f); // header
+    while (n < maxKeys && fgets(line, MAX_LINE_LEN, f)) {
+        line[strcspn(line, "\r\n")] = 0;
+        for (start = line, i = 0; i < field && start != NULL; i++)
+            start = ((start = strchr(start, ';')) != NULL) ? start + 1 : NULL;
+        if (start == NULL)
+            continue;
+        end = strchr(start, ';');
+        len = (end != NULL) ? (int)(end - start) : (int)strlen(start);
+        if (len > keyLength)
+            len = keyLength;
+        memset(keys + n * keyLength, 0, keyLength);
+        memcpy(keys + n * keyLength, start, len);
+        n++;
+    }
+    fclose(f);
+    return n;
+}
+
+/*
+ * Test 13: inserts the keys in file order into a 'c' index of keyLength
+ * bytes, compressed or not, and reports the height, the pages
+ * and the pages each point lookup requests. Every key is looked up.
+ */
+void char_key_index(const char *name, char *keys, long numKeys, int keyLength, int compress) {
+    AM_INDEXHANDLE ih;
+    long i, pages, totalPages = 0, maxPages = 0, bad = 0, scanned = 0;
+    int sd, recId, found, err = AME_OK;
+
+    AM_DestroyIndex(INDEX_FILE, 0);
+    AM_CreateIndexEncoding(INDEX_FILE, 0, 'c', keyLength, compress);
+    AM_OpenIndex(INDEX_FILE, 0, &ih);
+    for (i = 0; i < numKeys && err == AME_OK; i++)
+        err = AM_InsertEntry(&ih, keys + i * keyLength, (int)i);
+
+    for (i = 0; i < numKeys; i++) {
+        PF_ResetStats();
+        sd = AM_OpenIndexScan(&ih, EQUAL, keys + i * keyLength);
+        pages = PF_GetLogicalIOs();
+        found = FALSE;
+        while ((recId = AM_FindNextEntry(sd)) >= 0)
+            if (recId == i)
+                found = TRUE;
+        AM_CloseIndexScan(sd);
+        totalPages += pages;
+        if (pages > maxPages)
+            maxPages = pages;
+        if (!found)
+            bad++;
+    }
+    sd = AM_OpenIndexScan(&ih, ALL, NULL);
+    while (AM_FindNextEntry(sd) >= 0)
+        scanned++;
+    AM_CloseIndexScan(sd);
+
+    printf("  %-12s %-10s height %d, %4d pages, %.2f pages per lookup (max %ld), "
+           "%ld of %ld keys not found, %ld entries%s\n", name,
+           compress ? "prefixes" : "whole keys", ih.height, PF_GetNumPages(ih.fileDesc),
+           (double)totalPages / numKeys, maxPages, bad, numKeys, scanned,
+           (err == AME_OK) ? "" : ", insert failed");
+    AM_CloseIndex(&ih);
+    AM_DestroyIndex(INDEX_FILE, 0);
+}
 
 int main() {
     RM_FileHandle rm_fh;
@@ -104,7 +1068,7 @@ int main() {
     char *var_record;
     RID rid;
     int key;
-    int am_fd;
+    AM_INDEXHANDLE am_ih;
     long record_count = 0;
     
     clock_t start, end;
@@ -164,7 +1128,7 @@ int main() {
     RM_CreateFile("temp_rm.db");
     AM_CreateIndex(INDEX_FILE, 0, INDEX_ATTR_TYPE, INDEX_ATTR_LEN);
     RM_OpenFile("temp_rm.db", PF_LRU, &rm_fh);
-    am_fd = PF_OpenFile(INDEX_FILE_NAME, PF_LRU);
+    AM_OpenIndex(INDEX_FILE, 0, &am_ih);
     
     if ((txt_file = fopen(STUDENT_TXT_FILE, "r")) == NULL) return 1;
 
@@ -185,7 +1149,7 @@ int main() {
         // 2. Extract key and insert into AM index
         key = extract_key_from_record(var_record);
         if (key != -1) {
-            AM_InsertEntry(am_fd, INDEX_ATTR_TYPE, INDEX_ATTR_LEN, (char *)&key, rid);
+            AM_InsertEntry(&am_ih, (char *)&key, rid);
             record_count++;
         }
         free(var_record);
@@ -200,7 +1164,7 @@ int main() {
     printf("  Physical I/Os: %ld\n\n", phys_ios);
     
     fclose(txt_file);
-    PF_CloseFile(am_fd);
+    AM_CloseIndex(&am_ih);
     RM_CloseFile(&rm_fh);
     AM_DestroyIndex(INDEX_FILE, 0);
     RM_DestroyFile("temp_rm.db");
@@ -213,23 +1177,23 @@ int main() {
     printf("--- Test 2: Bulk Load (Unsorted Scan) ---\n");
     AM_DestroyIndex(INDEX_FILE, 0);
     AM_CreateIndex(INDEX_FILE, 0, INDEX_ATTR_TYPE, INDEX_ATTR_LEN);
-    am_fd = PF_OpenFile(INDEX_FILE_NAME, PF_LRU);
+    AM_OpenIndex(INDEX_FILE, 0, &am_ih);
     RM_OpenFile(STUDENT_DB_FILE, PF_LRU, &rm_fh);
-    RM_OpenScan(&rm_fh, &rm_scan);
+    RM_OpenScan(&rm_fh, &rm_scan, NULL, NULL);
 
     PF_ResetStats();
     start = clock();
     // RM_GetNextRecord(&rm_scan, &rid, record_buf, PF_PAGE_SIZE, &record_len);RM_GetNextRecord(&rm_scan, &rid, record_buf, PF_PAGE_SIZE, &record_len);
     while (record_count--) {
         RM_GetNextRecord(&rm_scan, &rid, record_buf, PF_PAGE_SIZE, &record_len);
-        phys_ios+= PF_GetPhysicalIOs();
         key = extract_key_from_record(record_buf);
         if (key != -1) {
-            AM_InsertEntry(am_fd, INDEX_ATTR_TYPE, INDEX_ATTR_LEN, (char *)&key, rid);
+            AM_InsertEntry(&am_ih, (char *)&key, rid);
         }
     }
 
     end = clock();
+    phys_ios = PF_GetPhysicalIOs();
     cpu_time = ((double)(end - start))*100/ CLOCKS_PER_SEC;
 
     printf("Results for Test 2 (Bulk - Unsorted):\n");
@@ -238,7 +1202,7 @@ int main() {
 
     RM_CloseScan(&rm_scan);
     RM_CloseFile(&rm_fh);
-    PF_CloseFile(am_fd);
+    AM_CloseIndex(&am_ih);
     AM_DestroyIndex(INDEX_FILE, 0);
 
 
@@ -251,7 +1215,7 @@ int main() {
     // Step 3a: Scan RM file and fill the sort buffer
     printf("  Scanning and buffering records...\n");
     RM_OpenFile(STUDENT_DB_FILE, PF_LRU, &rm_fh);
-    RM_OpenScan(&rm_fh, &rm_scan);
+    RM_OpenScan(&rm_fh, &rm_scan, NULL, NULL);
     record_count = 0;
     while (record_count < MAX_RECORDS-278) {
         RM_GetNextRecord(&rm_scan, &rid, record_buf, PF_PAGE_SIZE, &record_len);
@@ -273,16 +1237,17 @@ int main() {
     // Step 3c: Create index and insert from the sorted buffer
     AM_DestroyIndex(INDEX_FILE, 0);
     AM_CreateIndex(INDEX_FILE, 0, INDEX_ATTR_TYPE, INDEX_ATTR_LEN);
-    am_fd = PF_OpenFile(INDEX_FILE_NAME, PF_LRU);
+    AM_OpenIndex(INDEX_FILE, 0, &am_ih);
 
     printf("  Inserting sorted keys into index...\n");
     PF_ResetStats();
     start = clock();
     
+    long failed_inserts = 0;
     for (long i = 0; i < record_count; i++) {
-        AM_InsertEntry(am_fd, INDEX_ATTR_TYPE, INDEX_ATTR_LEN,
-                       (char *)&(key_rid_buffer[i].key),
-                       key_rid_buffer[i].rid);
+        if (AM_InsertEntry(&am_ih, (char *)&(key_rid_buffer[i].key),
+                           key_rid_buffer[i].rid) != AME_OK)
+            failed_inserts++;
     }
     
     end = clock();
@@ -291,11 +1256,333 @@ int main() {
 
     printf("Results for Test 3 (Optimized - Sorted):\n");
     printf("  Time Taken: %f sec\n", cpu_time);
-    printf("  Physical I/Os: %ld\n\n", phys_ios);
+    printf("  Physical I/Os: %ld\n", phys_ios);
+    printf("  Index pages: %d\n", PF_GetNumPages(am_ih.fileDesc));
+    printf("  Inserts: %ld, %ld failed\n", record_count, failed_inserts);
 
-    PF_CloseFile(am_fd);
+    AM_CloseIndex(&am_ih);
+    printf("  Physical I/Os incl. close: %ld\n\n", PF_GetPhysicalIOs());
     AM_DestroyIndex(INDEX_FILE, 0);
+
+
+    /*
+     * Test 4: Bottom-up Bulk Load (AM_BulkLoad)
+     * (Scans, sorts in memory, then builds the tree leaves first;
+     * each index page is written once)
+     */
+    printf("--- Test 4: Bottom-up Bulk Load (AM_BulkLoad) ---\n");
+
+    // Step 4a: Scan RM file and fill the sort buffer. AM_BulkLoad
+    // refuses a key whose RIDs do not fit in a leaf, so only numeric
+    // roll numbers are taken
+    RM_OpenFile(STUDENT_DB_FILE, PF_LRU, &rm_fh);
+    RM_OpenScan(&rm_fh, &rm_scan, NULL, NULL);
+    record_count = 0;
+    while (record_count < MAX_RECORDS &&
+           RM_GetNextRecord(&rm_scan, &rid, record_buf, PF_PAGE_SIZE, &record_len) == RME_OK) {
+        key = extract_numeric_key(record_buf);
+        if (key != -1) {
+            key_rid_buffer[record_count].key = key;
+            key_rid_buffer[record_count].rid = rid;
+            record_count++;
+        }
+    }
+    RM_CloseScan(&rm_scan);
+    RM_CloseFile(&rm_fh);
+
+    // Step 4b: Sort the buffer
+    printf("  Sorting %ld (key, RID) pairs in memory...\n", record_count);
+    qsort(key_rid_buffer, record_count, sizeof(KeyRidPair), compare_key_rid_pairs);
+
+    // Step 4c: Build the index at two fill factors
+    for (int fill = 100; fill >= 70; fill -= 30) {
+        PairIterator it = { key_rid_buffer, record_count, 0 };
+        long bad, scanned;
+        int err;
+
+        AM_DestroyIndex(INDEX_FILE, 0);
+        AM_CreateIndex(INDEX_FILE, 0, INDEX_ATTR_TYPE, INDEX_ATTR_LEN);
+        AM_OpenIndex(INDEX_FILE, 0, &am_ih);
+
+        PF_ResetStats();
+        start = clock();
+        err = AM_BulkLoad(&am_ih, next_pair, &it, fill);
+        end = clock();
+        phys_ios = PF_GetPhysicalIOs();
+        cpu_time = ((double)(end - start)) / CLOCKS_PER_SEC;
+
+        printf("Results for Test 4 (Bottom-up, %d%% fill):\n", fill);
+        if (err != AME_OK)
+            printf("  Error: AM_BulkLoad returned %d\n", err);
+        printf("  Time Taken: %f sec\n", cpu_time);
+        printf("  Physical I/Os: %ld\n", phys_ios);
+        AM_CloseIndex(&am_ih);
+        printf("  Physical I/Os incl. close: %ld\n", PF_GetPhysicalIOs());
+
+        AM_OpenIndex(INDEX_FILE, 0, &am_ih);
+        printf("  Index pages: %d\n", PF_GetNumPages(am_ih.fileDesc));
+        bad = verify_index(&am_ih, key_rid_buffer, record_count, &scanned);
+        printf("  Check: %ld of %ld keys not found, %ld entries in a full scan\n\n",
+               bad, record_count, scanned);
+        AM_CloseIndex(&am_ih);
+        AM_DestroyIndex(INDEX_FILE, 0);
+    }
+
+
+    /*
+     * Test 5: External Sort + Bottom-up Bulk Load
+     * (The pairs go through RM_Sort, which spills sorted runs to a
+     * temporary file and merges them, so the index build is not
+     * limited to what fits in memory)
+     */
+    printf("--- Test 5: External Sort + Bottom-up Bulk Load ---\n");
+    {
+        RM_Sort sort;
+        KeyRidPair pair;
+        long numPairs = 0, bad, scanned, sortBytes;
+        int err;
+
+        AM_DestroyIndex(INDEX_FILE, 0);
+        AM_CreateIndex(INDEX_FILE, 0, INDEX_ATTR_TYPE, INDEX_ATTR_LEN);
+        AM_OpenIndex(INDEX_FILE, 0, &am_ih);
+
+        // Step 5a: Scan RM file into the sort; the array only keeps
+        // pairs for the check
+        PF_ResetStats();
+        start = clock();
+        err = RM_BeginSort(&sort, compare_sorted_pairs, NULL, SORT_FRAMES);
+        RM_OpenFile(STUDENT_DB_FILE, PF_LRU, &rm_fh);
+        RM_OpenScan(&rm_fh, &rm_scan, NULL, NULL);
+        record_count = 0;
+        while (err == RME_OK &&
+               RM_GetNextRecord(&rm_scan, &rid, record_buf, PF_PAGE_SIZE, &record_len) == RME_OK) {
+            if ((pair.key = extract_numeric_key(record_buf)) == -1)
+                continue;
+            pair.rid = rid;
+            err = RM_SortAdd(&sort, (char *)&pair, sizeof(pair));
+            if (record_count < MAX_RECORDS)
+                key_rid_buffer[record_count++] = pair;
+            numPairs++;
+        }
+        RM_CloseScan(&rm_scan);
+        RM_CloseFile(&rm_fh);
+        if (err == RME_OK)
+            err = RM_SortDone(&sort);
+        sortBytes = PF_GetBytesWritten();
+
+        // Step 5b: Build the index straight from the merge
+        if (err == RME_OK)
+            err = AM_BulkLoad(&am_ih, next_sorted_pair, &sort, 100);
+        end = clock();
+        phys_ios = PF_GetPhysicalIOs();
+        cpu_time = ((double)(end - start)) / CLOCKS_PER_SEC;
+
+        printf("Results for Test 5 (%d frames, 100%% fill):\n", SORT_FRAMES);
+        if (err != RME_OK)
+            printf("  Error: %d\n", err);
+        printf("  Pairs: %ld, sorted in %d runs and %d merge passes\n",
+               numPairs, sort.numRuns, sort.numPasses);
+        printf("  Time Taken (scan, sort and build): %f sec\n", cpu_time);
+        printf("  Bytes written to runs: %ld, read by scan and merge: %ld\n",
+               sortBytes, PF_GetBytesRead());
+        printf("  Physical I/Os (buffer pool): %ld\n", phys_ios);
+        RM_EndSort(&sort);
+        AM_CloseIndex(&am_ih);
+
+        AM_OpenIndex(INDEX_FILE, 0, &am_ih);
+        printf("  Index pages: %d\n", PF_GetNumPages(am_ih.fileDesc));
+        bad = verify_index(&am_ih, key_rid_buffer, record_count, &scanned);
+        printf("  Check: %ld of %ld keys not found, %ld entries in a full scan\n\n",
+               bad, record_count, scanned);
+        AM_CloseIndex(&am_ih);
+        AM_DestroyIndex(INDEX_FILE, 0);
+    }
+
+
+    /*
+     * Test 6: Parallel Build (AM_BuildIndex)
+     * (Worker threads scan page ranges and sort their own runs; the
+     * runs are merged into AM_BulkLoad. Wall-clock time, best of
+     * BUILD_ROUNDS, with the RM file's pages in the OS cache)
+     */
+    printf("--- Test 6: Parallel Build (AM_BuildIndex) ---\n");
+    {
+        double best, oneThread = 0, t0, t;
+        long bad, scanned;
+        int threads, round, err = AME_OK;
+
+        RM_OpenFile(STUDENT_DB_FILE, PF_LRU, &rm_fh);
+        for (threads = 1; threads <= MAX_BUILD_THREADS; threads *= 2) {
+            best = 0;
+            for (round = 0; round < BUILD_ROUNDS; round++) {
+                AM_DestroyIndex(INDEX_FILE, 0);
+                AM_CreateIndex(INDEX_FILE, 0, INDEX_ATTR_TYPE, INDEX_ATTR_LEN);
+                AM_OpenIndex(INDEX_FILE, 0, &am_ih);
+                t0 = wall_seconds();
+                err = AM_BuildIndex(&am_ih, &rm_fh, threads, build_key, NULL, 100);
+                t = wall_seconds() - t0;
+                if (round == 0 || t < best)
+                    best = t;
+                AM_CloseIndex(&am_ih);
+            }
+            if (threads == 1)
+                oneThread = best;
+
+            // The last build is checked against Test 5's pairs
+            AM_OpenIndex(INDEX_FILE, 0, &am_ih);
+            bad = verify_index(&am_ih, key_rid_buffer, record_count, &scanned);
+            printf("  %2d threads: %f sec, speedup %.2fx, %d pages, %ld keys not found, "
+                   "%ld entries%s\n", threads, best, oneThread / best,
+                   PF_GetNumPages(am_ih.fileDesc), bad, scanned,
+                   (err == AME_OK) ? "" : " (build failed)");
+            AM_CloseIndex(&am_ih);
+            AM_DestroyIndex(INDEX_FILE, 0);
+        }
+        RM_CloseFile(&rm_fh);
+        printf("\n");
+    }
+
+
+    /*
+     * Test 7: Two Indexes at Once
+     * (Each index has its own handle, with its own root, leftmost leaf
+     * and search path, so neither disturbs the other)
+     */
+    printf("--- Test 7: Two Indexes at Once ---\n");
+    fill_two_indexes(key_rid_buffer, record_count, FALSE);
+    fill_two_indexes(key_rid_buffer, record_count, TRUE);
+    printf("\n");
+
+
+    /*
+     * Test 8: Index Meta Page
+     * (The meta page is read once by AM_OpenIndex; lookups start at the
+     * cached root and scans at the cached leftmost leaf)
+     */
+    printf("--- Test 8: Index Meta Page ---\n");
+    {
+        long minPages = -1, maxPages = 0, totalPages = 0, pages, i;
+        int sd, err = AME_OK;
+
+        AM_DestroyIndex(INDEX_FILE, 0);
+        AM_CreateIndex(INDEX_FILE, 0, INDEX_ATTR_TYPE, INDEX_ATTR_LEN);
+        AM_OpenIndex(INDEX_FILE, 0, &am_ih);
+        for (i = 0; i < record_count && err == AME_OK; i++)
+            err = AM_InsertEntry(&am_ih, (char *)&key_rid_buffer[i].key, key_rid_buffer[i].rid);
+        AM_CloseIndex(&am_ih);
+
+        AM_OpenIndex(INDEX_FILE, 0, &am_ih);
+        printf("Results for Test 8 (%ld inserts%s):\n", record_count,
+               (err == AME_OK) ? "" : ", insert failed");
+        printf("  Meta page: root %d, leftmost leaf %d, height %d, %d entries\n",
+               am_ih.rootPageNum, am_ih.leftPageNum, am_ih.height, am_ih.numEntries);
+
+        for (i = 0; i < record_count; i++) {
+            PF_ResetStats();
+            sd = AM_OpenIndexScan(&am_ih, EQUAL, (char *)&key_rid_buffer[i].key);
+            pages = PF_GetLogicalIOs();
+            AM_CloseIndexScan(sd);
+            totalPages += pages;
+            if (minPages < 0 || pages < minPages)
+                minPages = pages;
+            if (pages > maxPages)
+                maxPages = pages;
+        }
+        printf("  Pages per point lookup: %ld to %ld, %.2f on average\n",
+               minPages, maxPages, (double)totalPages / record_count);
+
+        PF_ResetStats();
+        sd = AM_OpenIndexScan(&am_ih, ALL, NULL);
+        printf("  Pages to open a full scan: %ld\n\n", PF_GetLogicalIOs());
+        AM_CloseIndexScan(sd);
+        AM_CloseIndex(&am_ih);
+        AM_DestroyIndex(INDEX_FILE, 0);
+    }
+
+
+    /*
+     * Test 9: Mixed Reads and Inserts
+     * (Readers take no latch: they copy each node and keep the copy only
+     * if its version did not move, so they run while the writer splits)
+     */
+    printf("--- Test 9: Mixed Reads and Inserts ---\n");
+    {
+        int readers;
+
+        printf("Results for Test 9 (%ld loaded, %ld inserted, %d lookups per reader):\n",
+               (record_count + 1) / 2, record_count / 2, MIXED_LOOKUPS);
+        for (readers = 0; readers <= MAX_READERS; readers = (readers == 0) ? 1 : 2 * readers)
+            mixed_workload(key_rid_buffer, record_count, readers);
+        printf("\n");
+    }
+
+
+    /*
+     * Test 10: Node Search
+     * (AM_OpenIndex picks the node search for the key type once; the
+     * typed searches load native keys and have no data dependent branch)
+     */
+    printf("--- Test 10: Node Search ---\n");
+    printf("Results for Test 10 (%ld pairs):\n", record_count);
+    // Since Test 5 the pairs are in file order; AM_BulkLoad takes key order
+    qsort(key_rid_buffer, record_count, sizeof(KeyRidPair), compare_key_rid_pairs);
+    time_node_search(key_rid_buffer, record_count, 'i');
+    time_node_search(key_rid_buffer, record_count, 'f');
+    time_node_search(key_rid_buffer, record_count, 'c');
+    // Repeated keys, whose separators the two searches must route alike
+    check_duplicate_keys('i');
+    check_duplicate_keys('f');
+    check_duplicate_keys('c');
+    printf("\n");
+
+
+    /*
+     * Test 11: Key Routines
+     * (The compare and node searches of the key type are bound to the
+     * handle at open; the general ones switch on the type on every call)
+     */
+    printf("--- Test 11: Key Routines ---\n");
+    printf("Results for Test 11 (%ld roll numbers):\n", record_count);
+    RM_OpenFile(STUDENT_DB_FILE, PF_LRU, &rm_fh);
+    time_key_routines(key_rid_buffer, record_count, &rm_fh);
+    RM_CloseFile(&rm_fh);
+    printf("\n");
+
+
+    /*
+     * Test 12: Leaf Layout
+     * (Leaves keep their keys in a dense, aligned array, apart from the
+     * heads of the recId lists; AM_RebuildIndex converts older indexes)
+     */
+    printf("--- Test 12: Leaf Layout ---\n");
+    printf("Results for Test 12 (%ld roll numbers):\n", record_count);
+    leaf_layout(key_rid_buffer, record_count);
+    printf("\n");
     free(key_rid_buffer);
+
+
+    /*
+     * Test 13: Character Keys
+     * (Leaves of a 'c' index keep the prefix their keys share once and
+     * only the rest of each key; separators are cut to the bytes that
+     * tell the two leaves apart)
+     */
+    printf("--- Test 13: Character Keys ---\n");
+    {
+        char *keys = malloc((long)MAX_RECORDS * EMAIL_KEY_LEN);
+        long numKeys;
+
+        numKeys = read_char_keys(COURSE_TXT_FILE, 0, COURSE_KEY_LEN, keys, MAX_RECORDS);
+        printf("Results for Test 13 (%ld course codes of %d bytes, then emails of %d):\n",
+               numKeys, COURSE_KEY_LEN, EMAIL_KEY_LEN);
+        char_key_index("course code", keys, numKeys, COURSE_KEY_LEN, FALSE);
+        char_key_index("course code", keys, numKeys, COURSE_KEY_LEN, TRUE);
+        numKeys = read_char_keys(EMAIL_TXT_FILE, 1, EMAIL_KEY_LEN, keys, MAX_RECORDS);
+        char_key_index("email", keys, numKeys, EMAIL_KEY_LEN, FALSE);
+        char_key_index("email", keys, numKeys, EMAIL_KEY_LEN, TRUE);
+        printf("\n");
+        free(keys);
+    }
     
     printf("========================================\n");
     printf("All tests complete.\n");
@@ -1,8 +1,25 @@
 #include <stdio.h>
 #include <stdlib.h> /* For malloc */
+#include <string.h>
+#include <pthread.h>
 #include "pf.h"
 #include "pftypes.h"
 
+/*
+ * The buffer pool is shared by every thread of the process. All list,
+ * hash table and counter updates happen under PFbufMutex; the exported
+ * PFbuf* routines take it and call the unlocked PFbufDo* bodies below.
+ * A page fixed by one thread is still owned by that thread alone.
+ *
+ * A page that is not in the pool is read in without PFbufMutex (see
+ * PFbufReadIn), so a miss does not hold up the other threads for the
+ * time of a disk read and its decompression. Threads that want the same
+ * page meanwhile wait on PFbufReadDone. Writing back a dirty page to
+ * free its frame is still done under the mutex.
+ */
+static pthread_mutex_t PFbufMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t PFbufReadDone = PTHREAD_COND_INITIALIZER;
+
 /* Global static variables for the buffer manager */
 static int PFnumbpage = 0;	/* # of buffer pages in memory */
 static int PF_MAX_BUFS;     /* Max # of buffers, set by PFbufInit */
@@ -160,41 +177,84 @@ void PFbufInit(int bufsize)
 }
 
 
-int PFbufGet(int fd, int pagenum, PFfpage **fpage,
+/*
+ * Finds page pagenum of fd in the buffer, or NULL. A page another thread
+ * is reading in is waited for; as the read may fail and free the frame,
+ * the page is then looked up again.
+ */
+static PFbpage *PFbufFind(int fd, int pagenum)
+{
+    PFbpage *bpage;
+
+	while ((bpage=PFhashFind(fd,pagenum)) != NULL && bpage->reading)
+		pthread_cond_wait(&PFbufReadDone, &PFbufMutex);
+	return(bpage);
+}
+
+/*
+ * Reads page pagenum of fd into a new frame, returned fixed in *bpage.
+ * The frame goes into the hash table marked reading before PFbufMutex is
+ * let go for the read: being fixed, it is not taken for another page,
+ * and a thread that wants the same page waits in PFbufFind rather than
+ * reading it a second time. Called, and returns, with the mutex held.
+ */
+static int PFbufReadIn(int fd, int pagenum, PFbpage **bpage,
              int (*readfcn)(int, int, PFfpage*),
              int (*writefcn)(int, int, PFfpage*))
 {
-    PFbpage *bpage;	/* pointer to buffer */
     int error;
 
-    PF_logical_ios++;
+	if ((error=PFbufInternalAlloc(bpage, writefcn, fd))!= PFE_OK)
+		return(error);
 
-	if ((bpage=PFhashFind(fd,pagenum)) == NULL){
-		/* page not in buffer. */
-		if ((error=PFbufInternalAlloc(&bpage, writefcn, fd))!= PFE_OK){
-			*fpage = NULL;
-			return(error);
-		}
-		
-		if ((error=(*readfcn)(fd, pagenum, &bpage->fpage))!= PFE_OK){
-			PFbufUnlink(bpage);
-			PFbufInsertFree(bpage);
-			*fpage = NULL;
-			return(error);
-		}
+	if ((error=PFhashInsert(fd,pagenum,*bpage))!=PFE_OK){
+		PFbufUnlink(*bpage);
+		PFbufInsertFree(*bpage);
+		return(error);
+	}
+
+	(*bpage)->fd = fd;
+	(*bpage)->page = pagenum;
+	(*bpage)->dirty = FALSE;
+	(*bpage)->fixed = TRUE;
+	(*bpage)->reading = TRUE;
+
+	pthread_mutex_unlock(&PFbufMutex);
+	error = (*readfcn)(fd, pagenum, &(*bpage)->fpage);
+	pthread_mutex_lock(&PFbufMutex);
+
+	(*bpage)->reading = FALSE;
+	pthread_cond_broadcast(&PFbufReadDone);
+
+	if (error != PFE_OK){
+		PFhashDelete(fd,pagenum);
+		PFbufUnlink(*bpage);
+		PFbufInsertFree(*bpage);
+		PFerrno = error;
+		return(error);
+	}
 
         PF_disk_reads++;
         PF_physical_ios++;
+	return(PFE_OK);
+}
 
-		if ((error=PFhashInsert(fd,pagenum,bpage))!=PFE_OK){
-			PFbufUnlink(bpage);
-			PFbufInsertFree(bpage);
+static int PFbufDoGet(int fd, int pagenum, PFfpage **fpage,
+             int (*readfcn)(int, int, PFfpage*),
+             int (*writefcn)(int, int, PFfpage*))
+{
+    PFbpage *bpage;	/* pointer to buffer */
+    int error;
+
+    PF_logical_ios++;
+
+	if ((bpage=PFbufFind(fd,pagenum)) == NULL){
+		/* page not in buffer. */
+		if ((error=PFbufReadIn(fd, pagenum, &bpage, readfcn, writefcn))
+				!= PFE_OK){
+			*fpage = NULL;
 			return(error);
 		}
-
-		bpage->fd = fd;
-		bpage->page = pagenum;
-		bpage->dirty = FALSE;
 	}
 	else if (bpage->fixed){
 		*fpage = &bpage->fpage;
@@ -213,10 +273,44 @@ int PFbufGet(int fd, int pagenum, PFfpage **fpage,
 	return(PFE_OK);
 }
 
-int PFbufUnfix(int fd, int pagenum, int dirty)
+/*
+ * Copies a page without fixing it. A page not in the buffer is read into
+ * a frame that is left unfixed; a page fixed by another thread is copied
+ * as it stands, which may be in the middle of a change.
+ */
+static int PFbufDoCopy(int fd, int pagenum, char *buf, int length,
+             int (*readfcn)(int, int, PFfpage*),
+             int (*writefcn)(int, int, PFfpage*))
+{
+    PFbpage *bpage;
+    int error;
+
+    PF_logical_ios++;
+
+	if ((bpage=PFbufFind(fd,pagenum)) == NULL){
+		if ((error=PFbufReadIn(fd, pagenum, &bpage, readfcn, writefcn))
+				!= PFE_OK)
+			return(error);
+		bpage->fixed = FALSE;
+	}
+	else if (!bpage->fixed){
+		/* a copy is a use of the page, as an unfix is */
+		PFbufUnlink(bpage);
+		PFbufLinkHead(bpage);
+	}
+
+	if (bpage->fpage.nextfree != PF_PAGE_USED){
+		PFerrno = PFE_INVALIDPAGE;
+		return(PFerrno);
+	}
+
+	memcpy(buf, bpage->fpage.pagebuf, length);
+	return(PFE_OK);
+}
+
+static int PFbufDoUnfix(int fd, int pagenum, int dirty)
 {
     PFbpage *bpage;
-    PF_Strategy strategy;
 
 	if ((bpage= PFhashFind(fd,pagenum))==NULL){
 		PFerrno = PFE_PAGENOTINBUF;
@@ -233,17 +327,13 @@ int PFbufUnfix(int fd, int pagenum, int dirty)
 	
 	bpage->fixed = FALSE;
 	
-    strategy = PFftab[fd].strategy;
-	fprintf(stderr, "DEBUG: PF_OpenFile fd=%d strategy=%d (macro)\n", fd, PFftab[fd].strategy);
-
-    
 	PFbufUnlink(bpage);
 	PFbufLinkHead(bpage); 
 
 	return(PFE_OK);
 }
 
-int PFbufAlloc(int fd, int pagenum, PFfpage **fpage, int (*writefcn)(int, int, PFfpage*))
+static int PFbufDoAlloc(int fd, int pagenum, PFfpage **fpage, int (*writefcn)(int, int, PFfpage*))
 {
     PFbpage *bpage;
     int error;
@@ -268,13 +358,14 @@ int PFbufAlloc(int fd, int pagenum, PFfpage **fpage, int (*writefcn)(int, int, P
 	bpage->page = pagenum;
 	bpage->fixed = TRUE;
 	bpage->dirty = FALSE;
+	bpage->reading = FALSE;
 
 	*fpage = &bpage->fpage;
 	return(PFE_OK);
 }
 
 
-int PFbufReleaseFile(int fd, int (*writefcn)(int, int, PFfpage*))
+static int PFbufDoReleaseFile(int fd, int (*writefcn)(int, int, PFfpage*))
 {
     PFbpage *bpage;	
     PFbpage *temppage;
@@ -314,7 +405,7 @@ int PFbufReleaseFile(int fd, int (*writefcn)(int, int, PFfpage*))
 }
 
 
-int PFbufUsed(int fd, int pagenum)
+static int PFbufDoUsed(int fd, int pagenum)
 {
     PFbpage *bpage;	
 
@@ -333,7 +424,7 @@ int PFbufUsed(int fd, int pagenum)
 	return(PFE_OK);
 }
 
-int PFbufMarkDirty(int fd, int pagenum)
+static int PFbufDoMarkDirty(int fd, int pagenum)
 {
     PFbpage *bpage;
 
@@ -352,6 +443,85 @@ int PFbufMarkDirty(int fd, int pagenum)
 }
 
 
+/****************************************************************************
+ * Exported routines: serialize on PFbufMutex
+ ****************************************************************************/
+
+int PFbufGet(int fd, int pagenum, PFfpage **fpage,
+             int (*readfcn)(int, int, PFfpage*),
+             int (*writefcn)(int, int, PFfpage*))
+{
+    int error;
+
+    pthread_mutex_lock(&PFbufMutex);
+    error = PFbufDoGet(fd, pagenum, fpage, readfcn, writefcn);
+    pthread_mutex_unlock(&PFbufMutex);
+    return(error);
+}
+
+int PFbufCopy(int fd, int pagenum, char *buf, int length,
+             int (*readfcn)(int, int, PFfpage*),
+             int (*writefcn)(int, int, PFfpage*))
+{
+    int error;
+
+    pthread_mutex_lock(&PFbufMutex);
+    error = PFbufDoCopy(fd, pagenum, buf, length, readfcn, writefcn);
+    pthread_mutex_unlock(&PFbufMutex);
+    return(error);
+}
+
+int PFbufUnfix(int fd, int pagenum, int dirty)
+{
+    int error;
+
+    pthread_mutex_lock(&PFbufMutex);
+    error = PFbufDoUnfix(fd, pagenum, dirty);
+    pthread_mutex_unlock(&PFbufMutex);
+    return(error);
+}
+
+int PFbufAlloc(int fd, int pagenum, PFfpage **fpage, int (*writefcn)(int, int, PFfpage*))
+{
+    int error;
+
+    pthread_mutex_lock(&PFbufMutex);
+    error = PFbufDoAlloc(fd, pagenum, fpage, writefcn);
+    pthread_mutex_unlock(&PFbufMutex);
+    return(error);
+}
+
+int PFbufReleaseFile(int fd, int (*writefcn)(int, int, PFfpage*))
+{
+    int error;
+
+    pthread_mutex_lock(&PFbufMutex);
+    error = PFbufDoReleaseFile(fd, writefcn);
+    pthread_mutex_unlock(&PFbufMutex);
+    return(error);
+}
+
+int PFbufUsed(int fd, int pagenum)
+{
+    int error;
+
+    pthread_mutex_lock(&PFbufMutex);
+    error = PFbufDoUsed(fd, pagenum);
+    pthread_mutex_unlock(&PFbufMutex);
+    return(error);
+}
+
+int PFbufMarkDirty(int fd, int pagenum)
+{
+    int error;
+
+    pthread_mutex_lock(&PFbufMutex);
+    error = PFbufDoMarkDirty(fd, pagenum);
+    pthread_mutex_unlock(&PFbufMutex);
+    return(error);
+}
+
+
 void PFbufPrint()
 {
     PFbpage *bpage;
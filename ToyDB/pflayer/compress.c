@@ -0,0 +1,188 @@
+/* compress.c: LZ4-style page compression for the PF layer */
+#include <string.h>
+#include "pftypes.h"
+
+/*
+ * Block format (the LZ4 block format):
+ * a sequence of
+ *	token		high 4 bits: literal count, low 4 bits: match length - 4
+ *	[length]	if the literal count is 15: more bytes of 255 ...
+ *			and a final byte < 255 that are added to it
+ *	literals
+ *	offset		2 bytes, little endian: how far back the match starts
+ *	[length]	continuation of the match length, as for literals
+ * The last sequence has literals only and ends the block.
+ */
+#define PFLZ_MINMATCH	4	/* shortest match worth encoding */
+#define PFLZ_HASHLOG	12	/* 4096 entry match finder */
+#define PFLZ_LASTLITERALS 5	/* the last bytes are always literals */
+#define PFLZ_MFLIMIT	12	/* no match starts this close to the end */
+#define PFLZ_MAXOFFSET	65535
+
+static unsigned int PFlzHash(const unsigned char *p)
+/****************************************************************************
+SPECIFICATIONS:
+	Hash the 4 bytes at p into a match finder slot.
+*****************************************************************************/
+{
+    unsigned int v;
+
+	memcpy(&v,p,sizeof(v));
+	return((v * 2654435761U) >> (32 - PFLZ_HASHLOG));
+}
+
+static unsigned char *PFlzPutLength(unsigned char *op, int len)
+/****************************************************************************
+SPECIFICATIONS:
+	Write the continuation bytes of a literal or match length.
+*****************************************************************************/
+{
+	while (len >= 255){
+		*op++ = 255;
+		len -= 255;
+	}
+	*op++ = len;
+	return(op);
+}
+
+int PFcompress(const char *src, int srcLen, char *dst, int dstCap)
+/****************************************************************************
+SPECIFICATIONS:
+	Compress srcLen bytes at src into at most dstCap bytes at dst.
+	Return the compressed length, or -1 if it would not fit.
+*****************************************************************************/
+{
+    const unsigned char *base = (const unsigned char *)src;
+    const unsigned char *ip = base;		/* next input byte */
+    const unsigned char *anchor = base;	/* first pending literal */
+    const unsigned char *iend = base + srcLen;
+    const unsigned char *mflimit = iend - PFLZ_MFLIMIT;
+    const unsigned char *matchlimit = iend - PFLZ_LASTLITERALS;
+    const unsigned char *match;
+    unsigned char *op = (unsigned char *)dst;
+    unsigned char *oend = op + dstCap;
+    unsigned char *token;
+    int table[1 << PFLZ_HASHLOG];	/* last position of each hash */
+    int litLen, matchLen, offset, h;
+
+	memset(table,-1,sizeof(table));
+
+	while (srcLen > PFLZ_MFLIMIT && ip < mflimit){
+		/* look for an earlier occurrence of the next 4 bytes */
+		h = PFlzHash(ip);
+		match = (table[h] >= 0) ? base + table[h] : NULL;
+		table[h] = ip - base;
+		if (match == NULL || ip - match > PFLZ_MAXOFFSET
+				|| memcmp(match,ip,PFLZ_MINMATCH) != 0){
+			ip++;
+			continue;
+		}
+
+		/* extend the match backwards over pending literals, then forwards */
+		while (ip > anchor && match > base && ip[-1] == match[-1]){
+			ip--;
+			match--;
+		}
+		matchLen = PFLZ_MINMATCH;
+		while (ip + matchLen < matchlimit && ip[matchLen] == match[matchLen])
+			matchLen++;
+
+		/* emit the sequence: literals, then the match */
+		litLen = ip - anchor;
+		if (op + 1 + litLen/255 + 1 + litLen + 2 + matchLen/255 + 1 > oend)
+			return(-1);
+		token = op++;
+		*token = (litLen >= 15 ? 15 : litLen) << 4;
+		if (litLen >= 15)
+			op = PFlzPutLength(op,litLen - 15);
+		memcpy(op,anchor,litLen);
+		op += litLen;
+
+		offset = ip - match;
+		*op++ = offset & 0xff;
+		*op++ = offset >> 8;
+		matchLen -= PFLZ_MINMATCH;
+		*token |= (matchLen >= 15) ? 15 : matchLen;
+		if (matchLen >= 15)
+			op = PFlzPutLength(op,matchLen - 15);
+
+		ip += matchLen + PFLZ_MINMATCH;
+		anchor = ip;
+	}
+
+	/* the last literals */
+	litLen = iend - anchor;
+	if (op + 1 + litLen/255 + 1 + litLen > oend)
+		return(-1);
+	token = op++;
+	*token = (litLen >= 15 ? 15 : litLen) << 4;
+	if (litLen >= 15)
+		op = PFlzPutLength(op,litLen - 15);
+	memcpy(op,anchor,litLen);
+	op += litLen;
+
+	return(op - (unsigned char *)dst);
+}
+
+int PFdecompress(const char *src, int srcLen, char *dst, int dstLen)
+/****************************************************************************
+SPECIFICATIONS:
+	Decompress the block of srcLen bytes at src into at most dstLen
+	bytes at dst. Return the decompressed length, or -1 if the block
+	is corrupt. Never reads or writes outside the two buffers.
+*****************************************************************************/
+{
+    const unsigned char *ip = (const unsigned char *)src;
+    const unsigned char *iend = ip + srcLen;
+    unsigned char *op = (unsigned char *)dst;
+    unsigned char *oend = op + dstLen;
+    const unsigned char *match;
+    int token, len, offset, b;
+
+	while (ip < iend){
+		token = *ip++;
+
+		/* literals */
+		len = token >> 4;
+		if (len == 15){
+			do {
+				if (ip >= iend)
+					return(-1);
+				len += (b = *ip++);
+			} while (b == 255);
+		}
+		if (len > iend - ip || len > oend - op)
+			return(-1);
+		memcpy(op,ip,len);
+		op += len;
+		ip += len;
+		if (ip == iend)
+			break;	/* the last sequence has no match */
+
+		/* match */
+		if (iend - ip < 2)
+			return(-1);
+		offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+		if (offset == 0 || offset > op - (unsigned char *)dst)
+			return(-1);
+		len = token & 15;
+		if (len == 15){
+			do {
+				if (ip >= iend)
+					return(-1);
+				len += (b = *ip++);
+			} while (b == 255);
+		}
+		len += PFLZ_MINMATCH;
+		if (len > oend - op)
+			return(-1);
+
+		/* byte by byte: the match may overlap what it produces */
+		match = op - offset;
+		while (len-- > 0)
+			*op++ = *match++;
+	}
+
+	return(op - (unsigned char *)dst);
+}
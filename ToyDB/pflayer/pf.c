@@ -4,15 +4,23 @@
 #include <sys/types.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <sys/uio.h>
+#include <pthread.h>
 #include "pf.h"
 #include "pftypes.h"
 
-/* To keep system V and PC users happy */
-#ifndef L_SET
-#define L_SET 0
-#endif
+_Thread_local int PFerrno = PFE_OK;	/* one per thread, see pf.h */
 
-int PFerrno = PFE_OK;
+/* bytes moved by PFreadfcn()/PFwritefcn(), see PF_GetBytesRead();
+PF_ReadPages() and PF_AppendPages() may run outside PFbufMutex, so the
+counters have their own lock */
+static long PFbytesRead = 0;
+static long PFbytesWritten = 0;
+static pthread_mutex_t PFstatMutex = PTHREAD_MUTEX_INITIALIZER;
+
+#define PFcountBytes(counter,n) { pthread_mutex_lock(&PFstatMutex); \
+				(counter) += (n); \
+				pthread_mutex_unlock(&PFstatMutex); }
 
 /* table of opened files - NOT static, so buf.c can see it */
 PFftab_ele PFftab[PF_FTAB_SIZE]; 
@@ -78,27 +86,68 @@ int PFreadfcn(int fd, int pagenum, PFfpage *buf)
 /****************************************************************************
 SPECIFICATIONS:
 	Read the paged numbered "pagenum" from the file indexed by "fd"
-	into the page buffer "buf".
+	into the page buffer "buf". A page stored compressed is
+	decompressed into "buf", so callers always see the page as it was
+	written. For a file with compression on, only PF_COMP_PROBE bytes
+	are read at first, and the rest of the page only if it is needed.
 *****************************************************************************/
 {
+    PFcpage cpage;	/* compressed image of the page */
     int error;
+    int count;		/* # of bytes read so far */
+    int want;		/* # of bytes the page occupies in the file */
+    off_t offset;	/* where the page begins in the file */
+
+	/* the buffer pool calls this without PFbufMutex, so the reads
+	name their offset instead of seeking the shared file position */
+	offset = (off_t)pagenum*sizeof(PFfpage)+PF_HDR_SIZE;
 
-	/* seek to the appropriate place */
-	if ((error=lseek(PFftab[fd].unixfd, (long)(pagenum*sizeof(PFfpage)+PF_HDR_SIZE),
-				L_SET)) == -1){
+	/* read the data (or the start of it) */
+	want = PFftab[fd].compress ? PF_COMP_PROBE : sizeof(PFfpage);
+	if ((count=pread(PFftab[fd].unixfd,(char *)buf,want,offset)) < 0){
 		PFerrno = PFE_UNIX;
 		return(PFerrno);
 	}
 
-	/* read the data */
-	if((error=read(PFftab[fd].unixfd,(char *)buf,sizeof(PFfpage)))
-			!=sizeof(PFfpage)){
-		if (error <0)
-			PFerrno = PFE_UNIX;
-		else	PFerrno = PFE_INCOMPLETEREAD;
-		return(PFerrno);
+	if (count >= PF_CPAGE_HDR && buf->nextfree == PF_PAGE_COMPRESSED){
+		/* compressed: collect the whole image, then expand it into buf */
+		memcpy((char *)&cpage,(char *)buf,count);
+		if (cpage.length <= 0 || cpage.length > PF_PAGE_SIZE){
+			PFerrno = PFE_BADPAGE;
+			return(PFerrno);
+		}
+		want = PF_CPAGE_HDR + cpage.length;
+		if (count < want){
+			if ((error=pread(PFftab[fd].unixfd,(char *)&cpage + count,
+					want - count,offset + count)) != want - count){
+				if (error < 0)
+					PFerrno = PFE_UNIX;
+				else	PFerrno = PFE_INCOMPLETEREAD;
+				return(PFerrno);
+			}
+			count = want;
+		}
+		if (PFdecompress(cpage.data,cpage.length,buf->pagebuf,
+				PF_PAGE_SIZE) != PF_PAGE_SIZE){
+			PFerrno = PFE_BADPAGE;
+			return(PFerrno);
+		}
+		buf->nextfree = PF_PAGE_USED;
+	}
+	else if (count < sizeof(PFfpage)){
+		/* a raw page: read the rest of it */
+		want = sizeof(PFfpage) - count;
+		if ((error=pread(PFftab[fd].unixfd,(char *)buf + count,want,
+				offset + count)) != want){
+			if (error <0)
+				PFerrno = PFE_UNIX;
+			else	PFerrno = PFE_INCOMPLETEREAD;
+			return(PFerrno);
+		}
+		count += want;
 	}
 
+	PFcountBytes(PFbytesRead,count);
 	return(PFE_OK);
 }
 
@@ -106,27 +155,38 @@ int PFwritefcn(int fd, int pagenum, PFfpage *buf)
 /****************************************************************************
 SPECIFICATIONS:
 	Write the page numbered "pagenum" from the buffer indexed
-	by "buf" into the file indexed by "fd".
+	by "buf" into the file indexed by "fd". If the file has
+	compression on and the page is in use, it is written compressed
+	when that saves at least PF_COMP_MINSAVE bytes.
 *****************************************************************************/
 {
+    PFcpage cpage;	/* compressed image of the page */
+    char *data;		/* what to write */
+    int count;		/* # of bytes to write */
     int error;
 
-	/* seek to the right place */
-	if ((error=lseek(PFftab[fd].unixfd, (long)(pagenum*sizeof(PFfpage)+PF_HDR_SIZE),
-				L_SET)) == -1){
-		PFerrno = PFE_UNIX;
-		return(PFerrno);
-	}
-
-	/* write out the page */
-	if((error=write(PFftab[fd].unixfd,(char *)buf,sizeof(PFfpage)))
-			!=sizeof(PFfpage)){
+	data = (char *)buf;
+	count = sizeof(PFfpage);
+	if (PFftab[fd].compress && buf->nextfree == PF_PAGE_USED &&
+			(error=PFcompress(buf->pagebuf,PF_PAGE_SIZE,cpage.data,
+				PF_PAGE_SIZE - PF_COMP_MINSAVE)) > 0){
+		cpage.nextfree = PF_PAGE_COMPRESSED;
+		cpage.length = error;
+		data = (char *)&cpage;
+		count = PF_CPAGE_HDR + cpage.length;
+	}
+
+	/* write out the page, at its offset rather than the shared file
+	position, as PFreadfcn() reads */
+	if((error=pwrite(PFftab[fd].unixfd,data,count,
+			(off_t)pagenum*sizeof(PFfpage)+PF_HDR_SIZE)) != count){
 		if (error <0)
 			PFerrno = PFE_UNIX;
 		else	PFerrno = PFE_INCOMPLETEWRITE;
 		return(PFerrno);
 	}
 
+	PFcountBytes(PFbytesWritten,count);
 	return(PFE_OK);
 
 }
@@ -270,6 +330,7 @@ SPECIFICATIONS:
 
     /* Store the replacement strategy */
     PFftab[fd].strategy = strategy;
+	PFftab[fd].compress = FALSE;
 
 	return(fd);
 }
@@ -296,17 +357,9 @@ SPECIFICATIONS:
 		return(error);
 
 	if (PFftab[fd].hdrchanged){
-		/* write the header back to the file */
-		/* First seek to the appropriate place */
-		if ((error=lseek(PFftab[fd].unixfd,(long)0,L_SET)) == -1){
-			/* seek error */
-			PFerrno = PFE_UNIX;
-			return(PFerrno);
-		}
-
-		/* write header*/
-		if((error=write(PFftab[fd].unixfd, (char *)&PFftab[fd].hdr,
-				PF_HDR_SIZE))!=PF_HDR_SIZE){
+		/* write the header back to the start of the file */
+		if((error=pwrite(PFftab[fd].unixfd, (char *)&PFftab[fd].hdr,
+				PF_HDR_SIZE,(off_t)0))!=PF_HDR_SIZE){
 			if (error <0)
 				PFerrno = PFE_UNIX;
 			else	PFerrno = PFE_HDRWRITE;
@@ -431,6 +484,42 @@ SPECIFICATIONS:
 	}
 }
 
+int PF_CopyPage(int fd, int pagenum, char *buf, int length)
+/****************************************************************************
+SPECIFICATIONS:
+	Copy the first "length" bytes of page "pagenum" into "buf" without
+	fixing the page. The page may be fixed by another thread, and may be
+	changing as it is copied; the caller must be able to tell.
+*****************************************************************************/
+{
+	if (PFinvalidFd(fd)){
+		PFerrno = PFE_FD;
+		return(PFerrno);
+	}
+
+	if (PFinvalidPagenum(fd,pagenum) || (length < 0) || (length > PF_PAGE_SIZE)){
+		PFerrno = PFE_INVALIDPAGE;
+		return(PFerrno);
+	}
+
+	return(PFbufCopy(fd,pagenum,buf,length,PFreadfcn,PFwritefcn));
+}
+
+int PF_GetNumPages(int fd)
+/****************************************************************************
+SPECIFICATIONS:
+	Return the number of pages in file "fd", free pages included.
+	Valid page numbers are 0 .. PF_GetNumPages(fd)-1; callers that
+	split a file into page ranges use this as the upper bound.
+*****************************************************************************/
+{
+	if (PFinvalidFd(fd)){
+		PFerrno = PFE_FD;
+		return(PFerrno);
+	}
+	return(PFftab[fd].hdr.numpages);
+}
+
 int PF_AllocPage(int fd, int *pagenum, char **pagebuf)
 /****************************************************************************
 SPECIFICATIONS:
@@ -488,10 +577,9 @@ SPECIFICATIONS:
     }
 
     /* zero out the page. Seems to be a nice thing to do,
-    at least for debugging. */
-    /*
-    bzero(fpage->pagebuf,PF_PAGE_SIZE);
-    */
+    at least for debugging; it also keeps stale bytes in the unused
+    part of the page from being written out (and compressed). */
+    memset(fpage->pagebuf,0,PF_PAGE_SIZE);
 
     /* Mark the new page used */
     fpage->nextfree = PF_PAGE_USED;
@@ -502,6 +590,138 @@ SPECIFICATIONS:
     return(PFE_OK);
 }
 
+int PF_AppendPages(int fd, char *pages, int numpages, int *firstpage)
+/****************************************************************************
+SPECIFICATIONS:
+	Append "numpages" pages, taken from consecutive PF_PAGE_SIZE
+	slices of "pages", to the end of file "fd" and set *firstpage to
+	the number of the first one. The pages are written straight to
+	the file, PF_APPEND_IOV of them per pwritev(), and never enter
+	the buffer pool, so they are not counted as disk writes there.
+	The free list is left alone: appended pages always come after
+	the last page of the file. A file with compression on is
+	written a page at a time through PFwritefcn().
+*****************************************************************************/
+{
+    struct iovec iov[2*PF_APPEND_IOV];	/* page header, page data, ... */
+    int used = PF_PAGE_USED;	/* nextfree of every appended page */
+    PFfpage fpage;	/* page image, for compressed files */
+    int pagenum;	/* next page to write */
+    int i, j, n, error;
+    long count;		/* # of bytes in one pwritev() */
+    off_t offset;	/* where page pagenum begins in the file */
+
+	if (PFinvalidFd(fd)){
+		PFerrno = PFE_FD;
+		return(PFerrno);
+	}
+	*firstpage = pagenum = PFftab[fd].hdr.numpages;
+
+	if (PFftab[fd].compress){
+		fpage.nextfree = PF_PAGE_USED;
+		for (i=0; i < numpages; i++, pagenum++){
+			memcpy(fpage.pagebuf,pages + (long)i*PF_PAGE_SIZE,PF_PAGE_SIZE);
+			if ((error=PFwritefcn(fd,pagenum,&fpage)) != PFE_OK)
+				return(error);
+		}
+	}
+	else {
+		offset = (off_t)pagenum*sizeof(PFfpage)+PF_HDR_SIZE;
+		for (i=0; i < numpages; i += n){
+			n = (numpages - i < PF_APPEND_IOV) ? numpages - i : PF_APPEND_IOV;
+			count = 0;
+			for (j=0; j < n; j++){
+				iov[2*j].iov_base = (char *)&used;
+				iov[2*j].iov_len = sizeof(int);
+				iov[2*j+1].iov_base = pages + (long)(i+j)*PF_PAGE_SIZE;
+				iov[2*j+1].iov_len = PF_PAGE_SIZE;
+				count += sizeof(PFfpage);
+			}
+			if ((error=pwritev(PFftab[fd].unixfd,iov,2*n,offset)) != count){
+				if (error < 0)
+					PFerrno = PFE_UNIX;
+				else	PFerrno = PFE_INCOMPLETEWRITE;
+				return(PFerrno);
+			}
+			PFcountBytes(PFbytesWritten,count);
+			offset += count;
+		}
+	}
+
+	PFftab[fd].hdr.numpages += numpages;
+	PFftab[fd].hdrchanged = TRUE;
+	return(PFE_OK);
+}
+
+int PF_ReadPages(int fd, int firstpage, int numpages, char *pages)
+/****************************************************************************
+SPECIFICATIONS:
+	Read pages "firstpage" .. "firstpage"+"numpages"-1 of file "fd"
+	into consecutive PF_PAGE_SIZE slices of "pages", PF_APPEND_IOV
+	pages per preadv(). Like PF_AppendPages(), this goes around the
+	buffer pool: a page that is fixed or dirty there is read as it
+	is on disk. All the pages must be in use. A file with
+	compression on is read a page at a time through PFreadfcn().
+*****************************************************************************/
+{
+    struct iovec iov[2*PF_APPEND_IOV];	/* page header, page data, ... */
+    int nextfree[PF_APPEND_IOV];	/* page headers read */
+    PFfpage fpage;	/* page image, for compressed files */
+    int i, j, n, error;
+    long count;		/* # of bytes in one preadv() */
+    off_t offset;	/* where the next pages begin in the file */
+
+	if (PFinvalidFd(fd)){
+		PFerrno = PFE_FD;
+		return(PFerrno);
+	}
+	if (numpages < 0 || (numpages > 0 && (PFinvalidPagenum(fd,firstpage) ||
+			PFinvalidPagenum(fd,firstpage + numpages - 1)))){
+		PFerrno = PFE_INVALIDPAGE;
+		return(PFerrno);
+	}
+
+	if (PFftab[fd].compress){
+		for (i=0; i < numpages; i++){
+			if ((error=PFreadfcn(fd,firstpage + i,&fpage)) != PFE_OK)
+				return(error);
+			if (fpage.nextfree != PF_PAGE_USED){
+				PFerrno = PFE_INVALIDPAGE;
+				return(PFerrno);
+			}
+			memcpy(pages + (long)i*PF_PAGE_SIZE,fpage.pagebuf,PF_PAGE_SIZE);
+		}
+		return(PFE_OK);
+	}
+
+	offset = (off_t)firstpage*sizeof(PFfpage)+PF_HDR_SIZE;
+	for (i=0; i < numpages; i += n){
+		n = (numpages - i < PF_APPEND_IOV) ? numpages - i : PF_APPEND_IOV;
+		count = 0;
+		for (j=0; j < n; j++){
+			iov[2*j].iov_base = (char *)&nextfree[j];
+			iov[2*j].iov_len = sizeof(int);
+			iov[2*j+1].iov_base = pages + (long)(i+j)*PF_PAGE_SIZE;
+			iov[2*j+1].iov_len = PF_PAGE_SIZE;
+			count += sizeof(PFfpage);
+		}
+		if ((error=preadv(PFftab[fd].unixfd,iov,2*n,offset)) != count){
+			if (error < 0)
+				PFerrno = PFE_UNIX;
+			else	PFerrno = PFE_INCOMPLETEREAD;
+			return(PFerrno);
+		}
+		PFcountBytes(PFbytesRead,count);
+		offset += count;
+		for (j=0; j < n; j++)
+			if (nextfree[j] != PF_PAGE_USED){
+				PFerrno = PFE_INVALIDPAGE;
+				return(PFerrno);
+			}
+	}
+	return(PFE_OK);
+}
+
 int PF_DisposePage(int fd, int pagenum)
 /****************************************************************************
 SPECIFICATIONS:
@@ -600,7 +820,8 @@ static char *PFerrormsg[]={
 "page already unfixed",
 "new page to be allocated already in buffer",
 "hash table entry not found",
-"page already in hash table"
+"page already in hash table",
+"compressed page is corrupt"
 };
 
 void PF_PrintError(char *s)
@@ -648,9 +869,31 @@ int PF_MarkDirty(int fd, int pagenum) {
 }
 
 
+int PF_SetCompression(int fd, int on)
+/****************************************************************************
+SPECIFICATIONS:
+	Turn page compression on or off for the open file "fd". It
+	affects how pages are written from now on; compressed and raw
+	pages can be read back either way, so the setting need not be
+	the same every time the file is opened.
+*****************************************************************************/
+{
+	if (PFinvalidFd(fd)){
+		PFerrno = PFE_FD;
+		return(PFerrno);
+	}
+	PFftab[fd].compress = on ? TRUE : FALSE;
+	return(PFE_OK);
+}
+
+
 void PF_ResetStats()
 {
     PFbufResetStats();
+    pthread_mutex_lock(&PFstatMutex);
+    PFbytesRead = 0;
+    PFbytesWritten = 0;
+    pthread_mutex_unlock(&PFstatMutex);
 }
 
 long PF_GetLogicalIOs()
@@ -671,4 +914,14 @@ long PF_GetDiskReads()
 long PF_GetDiskWrites()
 {
     return PFbufGetDiskWrites();
+}
+
+long PF_GetBytesRead()
+{
+    return PFbytesRead;
+}
+
+long PF_GetBytesWritten()
+{
+    return PFbytesWritten;
 }
\ No newline at end of file
@@ -28,6 +28,23 @@ typedef struct PFfpage {
 	char pagebuf[PF_PAGE_SIZE];	/* actual page data */
 } PFfpage;
 
+/* A used page may instead be stored compressed, when the file has
+compression on (see PF_SetCompression). It then starts with this
+header and only PF_CPAGE_HDR + length bytes of its slot are written.
+In the buffer pool a page is always uncompressed. */
+#define PF_PAGE_COMPRESSED	-3	/* on disk only: used page, compressed */
+typedef struct PFcpage {
+	int nextfree;	/* PF_PAGE_COMPRESSED */
+	int length;	/* bytes of compressed data */
+	char data[PF_PAGE_SIZE];	/* compressed page data */
+} PFcpage;
+
+#define PF_CPAGE_HDR	(2*sizeof(int))	/* size of the compressed page header */
+#define PF_COMP_PROBE	1024	/* bytes first read from a compressed file */
+#define PF_COMP_MINSAVE	256	/* store raw unless this much is saved */
+
+#define PF_APPEND_IOV	256	/* pages per pwritev() in PF_AppendPages */
+
 /*************************** Opened File Table **********************/
 #define PF_FTAB_SIZE	20	/* size of open file table */
 
@@ -38,6 +55,7 @@ typedef struct PFftab_ele {
 	PFhdr_str hdr;	/* file header */
 	short hdrchanged; /* TRUE if file header has changed */
     PF_Strategy strategy; /* Replacement strategy for this file (PF_LRU or PF_MRU) */
+	short compress;	/* TRUE if pages are written compressed */
 } PFftab_ele;
 
 /*
@@ -62,7 +80,9 @@ typedef struct PFbpage {
 	struct PFbpage *prevpage;	/* previous in the linked list
 					of buffer pages */
 	short	dirty:1,		/* TRUE if page is dirty */
-		fixed:1;		/* TRUE if page is fixed in buffer*/
+		fixed:1,		/* TRUE if page is fixed in buffer*/
+		reading:1;		/* TRUE while the page is read in,
+					outside PFbufMutex */
 	int	page;			/* page number of this page */
 	int	fd;			/* file desciptor of this page */
 	PFfpage fpage; /* page data from the file */
@@ -92,6 +112,10 @@ extern int PFhashInsert(int fd, int page, PFbpage *bpage);
 extern int PFhashDelete(int fd, int page);
 extern void PFhashPrint();
 
+/****************** Interface functions from Page Compression ***********/
+extern int PFcompress(const char *src, int srcLen, char *dst, int dstCap);
+extern int PFdecompress(const char *src, int srcLen, char *dst, int dstLen);
+
 /****************** Interface functions from Buffer Manager *************/
 /*
  * These are the internal functions of the buffer manager,
@@ -106,6 +130,11 @@ extern int PFbufGet(int fd, int pagenum, PFfpage **fpage,
                      int (*readfcn)(int, int, PFfpage*),
                      int (*writefcn)(int, int, PFfpage*));
 
+/* Copy a page out of the buffer without fixing it */
+extern int PFbufCopy(int fd, int pagenum, char *buf, int length,
+                     int (*readfcn)(int, int, PFfpage*),
+                     int (*writefcn)(int, int, PFfpage*));
+
 /* Unfix a page from the buffer */
 extern int PFbufUnfix(int fd, int pagenum, int dirty);
 
@@ -33,6 +33,7 @@
 #define PFE_PAGEINBUF	-17	/* new page to be allocated already in buffer */
 #define PFE_HASHNOTFOUND -18	/* hash table entry not found */
 #define PFE_HASHPAGEEXIST -19	/* page already exist in hash table */
+#define PFE_BADPAGE	-20	/* compressed page is corrupt */
 
 
 /* page size */
@@ -42,7 +43,11 @@
 typedef enum { PF_LRU = 0, PF_MRU = 1 } PF_Strategy;
 
 /* externs from the PF layer */
-extern int PFerrno;		/* error number of last error */
+/*
+ * Error number of the last error. Each thread has its own copy, so
+ * threads sharing the buffer pool do not clobber each other's errors.
+ */
+extern _Thread_local int PFerrno;
 
 /************************************************************
  * PF Layer Interface
@@ -138,6 +143,29 @@ extern int PF_GetNextPage(int fd, int *pagenum, char **pagebuf);
  */
 extern int PF_GetThisPage(int fd, int pagenum, char **pagebuf);
 
+/*
+ * PF_CopyPage
+ *
+ * Desc: Copy the first 'length' bytes of page 'pagenum' into 'buf'.
+ * The page is not fixed, so the copy is taken even while another
+ * thread has the page fixed; the caller must check it is consistent.
+ * Params: (int) fd - file descriptor.
+ * (int) pagenum - page number to copy.
+ * (char*) buf - (out) at least 'length' bytes.
+ * (int) length - bytes to copy, at most PF_PAGE_SIZE.
+ * Returns: PFE_OK if success, or a PF error code otherwise.
+ */
+extern int PF_CopyPage(int fd, int pagenum, char *buf, int length);
+
+/*
+ * PF_GetNumPages
+ *
+ * Desc: Get the number of pages in the file, free pages included.
+ * Params: (int) fd - file descriptor.
+ * Returns: The page count (>= 0) if success, or a PF error code otherwise.
+ */
+extern int PF_GetNumPages(int fd);
+
 /*
  * PF_AllocPage
  *
@@ -150,6 +178,35 @@ extern int PF_GetThisPage(int fd, int pagenum, char **pagebuf);
  */
 extern int PF_AllocPage(int fd, int *pagenum, char **pagebuf);
 
+/*
+ * PF_AppendPages
+ *
+ * Desc: Write numpages pages, stored back to back in 'pages', to the
+ * end of the file with a few large writes. The pages bypass the
+ * buffer pool and the free list; use it to load new files in bulk.
+ * Params: (int) fd - file descriptor.
+ * (char*) pages - numpages * PF_PAGE_SIZE bytes of page data.
+ * (int) numpages - number of pages to append.
+ * (int*) firstpage - (out) page number of the first appended page.
+ * Returns: PFE_OK if success, or a PF error code otherwise.
+ */
+extern int PF_AppendPages(int fd, char *pages, int numpages, int *firstpage);
+
+/*
+ * PF_ReadPages
+ *
+ * Desc: Read numpages consecutive pages of the file, from firstpage on,
+ * into 'pages' back to back with a few large reads. The pages bypass
+ * the buffer pool; use it to stream back pages written by
+ * PF_AppendPages. Every page must be in use.
+ * Params: (int) fd - file descriptor.
+ * (int) firstpage - page number of the first page to read.
+ * (int) numpages - number of pages to read.
+ * (char*) pages - (out) numpages * PF_PAGE_SIZE bytes of page data.
+ * Returns: PFE_OK if success, or a PF error code otherwise.
+ */
+extern int PF_ReadPages(int fd, int firstpage, int numpages, char *pages);
+
 /*
  * PF_DisposePage
  *
@@ -173,6 +230,28 @@ extern int PF_DisposePage(int fd, int pagenum);
  */
 extern int PF_UnfixPage(int fd, int pagenum, int dirty);
 
+/*
+ * PF_SetCompression
+ *
+ * Desc: Turn page compression on or off for an open file. Pages are
+ * then written LZ4-style compressed when that saves space, and only
+ * the compressed bytes move between disk and the buffer pool. Pages
+ * are decompressed into their buffer frame when read, so callers
+ * never see the difference. Files may hold both kinds of page; the
+ * setting is not stored and only affects writes and read sizes.
+ * Params: (int) fd - file descriptor.
+ * (int) on - TRUE to compress, FALSE to write raw pages.
+ * Returns: PFE_OK if success, or a PF error code otherwise.
+ */
+extern int PF_SetCompression(int fd, int on);
+
+/*
+ * Thread safety: fixing, unfixing and marking pages dirty may be done
+ * from several threads at once, as long as no two threads fix the same
+ * page. Opening, closing, allocating and disposing must not race with
+ * other calls on the same file.
+ */
+
 /*
  * PF_MarkDirty
  *
@@ -229,6 +308,16 @@ extern long PF_GetDiskReads();
  */
 extern long PF_GetDiskWrites();
 
+/*
+ * PF_GetBytesRead / PF_GetBytesWritten
+ *
+ * Desc: Get the number of bytes moved between the buffer pool and
+ * disk. With compression these are less than pages * page size.
+ * Returns: (long) The byte count.
+ */
+extern long PF_GetBytesRead();
+extern long PF_GetBytesWritten();
+
 
 /************************************************************
  * Error Handling
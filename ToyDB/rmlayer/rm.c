@@ -1,7 +1,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 #include "rm.h"
+#include "rmtypes.h"
 #include "pf.h"
 #include "pftypes.h" 
 
@@ -14,41 +16,223 @@
 /* SlotEntry: An entry in the slot directory (at the end of the page) */
 typedef struct {
     int recordOffset; // Byte offset from the start of the page
-    int recordLength; // Length of the record in bytes
+    int recordLength; // Length of the record in bytes (plus SLOT_* flags)
 } SlotEntry;
 
 #define SLOT_EMPTY -1 // A recordLength of -1 indicates an empty/deleted slot
+#define SLOT_NONE  -1 // End of the chain of empty slots
+
+/*
+ * The empty slots of a page are chained through their recordOffset,
+ * starting at PageHeader.freeSlot, so an insert finds one in O(1).
+ * Empty slots at the end of the directory are dropped instead, which
+ * gives their space back to the page.
+ */
+
+/*
+ * A record too large for one page lives in a chain of overflow pages.
+ * Its slot then holds an OverflowStub and has SLOT_OVERFLOW set in
+ * recordLength.
+ *
+ * A record that outgrew its page on update lives elsewhere so that its
+ * RID stays the same: its home slot holds a ForwardStub (SLOT_FORWARD)
+ * and the slot it moved to starts with the home RID (SLOT_MOVED). Only
+ * the home RID is ever handed out; scans skip forwarding stubs and
+ * return moved records under their home RID.
+ *
+ * The remaining bits of recordLength are the bytes used in the page.
+ */
+#define SLOT_OVERFLOW 0x40000000
+#define SLOT_FORWARD  0x20000000
+#define SLOT_MOVED    0x10000000
+#define SLOT_FLAGS    (SLOT_OVERFLOW | SLOT_FORWARD | SLOT_MOVED)
+#define SLOT_HAS(slot, flag) ((slot)->recordLength != SLOT_EMPTY && \
+                              ((slot)->recordLength & (flag)))
+#define SLOT_IS_OVERFLOW(slot) SLOT_HAS(slot, SLOT_OVERFLOW)
+#define SLOT_BYTES(slot) ((slot)->recordLength & ~SLOT_FLAGS) // Bytes used in the page
+
+typedef struct {
+    int totalLength;    // Length of the whole record
+    int firstPage;      // First page of its overflow chain
+} OverflowStub;
+
+typedef struct {
+    RID target;         // Where the record lives now (a SLOT_MOVED slot)
+} ForwardStub;
+
+/* Page types, the first int of every page of a slotted RM file */
+#define RM_PAGE_DATA     0  // Slotted page (PF_AllocPage zeroes new pages)
+#define RM_PAGE_OVERFLOW 1  // Piece of a large record
+#define RM_PAGE_COMPACT  2  // Slotted page of an RM_FMT_COMPACT file
 
 /* PageHeader: Metadata at the very beginning of the page */
 typedef struct {
+    int pageType;       // RM_PAGE_DATA
     int numSlots;       // Total number of slots in the directory
     int freeSpaceOffset; // Offset of the start of free space (end of data)
+    int freeSlot;       // First empty slot of the chain, or SLOT_NONE
 } PageHeader;
 
+/*
+ * A compact page holds the same header and slots in unsigned shorts,
+ * which is enough for any offset or length inside a page: 0xFFFF is
+ * SLOT_EMPTY/SLOT_NONE, and the SLOT_* flags move down into the top bits
+ * of the 2-byte recordLength. The code works on PageHeader and SlotEntry
+ * copies through RM_GetHeader/RM_GetSlot and writes them back with
+ * RM_SetHeader/RM_SetSlot, which translate for compact pages.
+ */
+typedef struct {
+    int pageType;       // RM_PAGE_COMPACT
+    unsigned short numSlots;
+    unsigned short freeSpaceOffset;
+    unsigned short freeSlot;
+    unsigned short unused;
+} CompactHeader;
+
+typedef struct {
+    unsigned short recordOffset;
+    unsigned short recordLength;
+} CompactSlot;
+
+#define COMPACT_NONE       0xFFFF
+#define COMPACT_FLAG_SHIFT 16     // SLOT_* flags >> 16 fit above the 12 length bits
+
+/* OverflowHeader: Start of an overflow page; the data follows it */
+typedef struct {
+    int pageType;       // RM_PAGE_OVERFLOW
+    int nextPage;       // Next page of the chain, -1 = last
+    int length;         // Bytes of the record on this page
+} OverflowHeader;
+
+#define OVERFLOW_CAPACITY ((int)(PF_PAGE_SIZE - sizeof(OverflowHeader)))
+
+// Largest record stored in a data page of either layout; longer ones go
+// to overflow pages
+#define RM_MAX_INLINE ((int)(PF_PAGE_SIZE - sizeof(PageHeader) - sizeof(SlotEntry)))
+// Largest record that can be moved (it is prefixed with its home RID)
+#define RM_MAX_MOVED (RM_MAX_INLINE - (int)sizeof(RID))
+
+
+/*
+ * RM_FileHeader: Contents of page 0 of every RM file. It identifies the
+ * file as an RM file and records its page layout and record schema.
+ */
+typedef struct {
+    int magic;          // RM_MAGIC
+    int format;         // RM_FMT_*
+    RM_Schema schema;   // numAttrs == 0 for untyped files
+    int recordLength;   // RM_FMT_FIXED: length of every record
+} RM_FileHeader;
+
+#define RM_HEADER_PAGE 0
+#define RM_MAGIC 0x524D4631 // "RMF1"
+
 
 /* --- Helper Macros --- */
 #define RM_PAGE_SIZE PF_PAGE_SIZE
 
-// Get a pointer to the Page Header (at the very start of the page data)
-#define GET_HEADER(pageData) ((PageHeader*) (pageData))
+// The type of a page of a slotted file (the first int of every page)
+#define GET_PAGE_TYPE(pageData) (*(int *)(pageData))
+#define IS_DATA_PAGE(pageData) \
+    (GET_PAGE_TYPE(pageData) == RM_PAGE_DATA || GET_PAGE_TYPE(pageData) == RM_PAGE_COMPACT)
+#define IS_COMPACT(pageData) (GET_PAGE_TYPE(pageData) == RM_PAGE_COMPACT)
 
-// Get a pointer to the Slot Directory entry for a given SlotID
-// The slot directory grows *backwards* from the end of the page.
-#define GET_SLOT(pageData, slotID) \
-    ((SlotEntry*) ( (pageData) + RM_PAGE_SIZE - sizeof(SlotEntry) * (slotID + 1) ))
+// Size of one entry of the page's slot directory
+#define SLOT_SIZE(pageData) \
+    (IS_COMPACT(pageData) ? (int)sizeof(CompactSlot) : (int)sizeof(SlotEntry))
+
+// The slot directory grows *backwards* from the end of the page
+#define WIDE_SLOT(pageData, slotID) \
+    ((SlotEntry*) ( (pageData) + RM_PAGE_SIZE - sizeof(SlotEntry) * ((slotID) + 1) ))
+#define COMPACT_SLOT(pageData, slotID) \
+    ((CompactSlot*) ( (pageData) + RM_PAGE_SIZE - sizeof(CompactSlot) * ((slotID) + 1) ))
 
 // Calculate the amount of *contiguous* free space in the middle
-#define GET_CONTIGUOUS_FREE_SPACE(pageData) \
-    ( (RM_PAGE_SIZE) - (GET_HEADER(pageData)->numSlots * sizeof(SlotEntry)) - (GET_HEADER(pageData)->freeSpaceOffset) )
+#define GET_CONTIGUOUS_FREE_SPACE(pageData, header) \
+    ( (RM_PAGE_SIZE) - ((header)->numSlots * SLOT_SIZE(pageData)) - ((header)->freeSpaceOffset) )
+
+static int RM_Widen(unsigned short value) {
+    return (value == COMPACT_NONE) ? -1 : value;
+}
+
+/*
+ * RM_GetHeader / RM_SetHeader
+ * Desc: Copy a data page's header out of and back into the page.
+ */
+static void RM_GetHeader(char *pageData, PageHeader *header) {
+    CompactHeader *ch = (CompactHeader *)pageData;
+
+    if (!IS_COMPACT(pageData)) {
+        *header = *(PageHeader *)pageData;
+        return;
+    }
+    header->pageType = ch->pageType;
+    header->numSlots = ch->numSlots;
+    header->freeSpaceOffset = ch->freeSpaceOffset;
+    header->freeSlot = RM_Widen(ch->freeSlot);
+}
+
+static void RM_SetHeader(char *pageData, PageHeader *header) {
+    CompactHeader *ch = (CompactHeader *)pageData;
+
+    if (header->pageType != RM_PAGE_COMPACT) {
+        *(PageHeader *)pageData = *header;
+        return;
+    }
+    ch->pageType = header->pageType;
+    ch->numSlots = header->numSlots;
+    ch->freeSpaceOffset = header->freeSpaceOffset;
+    ch->freeSlot = (unsigned short)header->freeSlot; // SLOT_NONE -> 0xFFFF
+}
+
+/*
+ * RM_GetSlot / RM_SetSlot
+ * Desc: Copy a slot directory entry out of and back into the page.
+ */
+static void RM_GetSlot(char *pageData, int slotID, SlotEntry *slot) {
+    CompactSlot *cs;
+
+    if (!IS_COMPACT(pageData)) {
+        *slot = *WIDE_SLOT(pageData, slotID);
+        return;
+    }
+    cs = COMPACT_SLOT(pageData, slotID);
+    slot->recordOffset = RM_Widen(cs->recordOffset);
+    if (cs->recordLength == COMPACT_NONE)
+        slot->recordLength = SLOT_EMPTY;
+    else
+        slot->recordLength = (cs->recordLength & ~(SLOT_FLAGS >> COMPACT_FLAG_SHIFT)) |
+                             ((cs->recordLength & (SLOT_FLAGS >> COMPACT_FLAG_SHIFT)) << COMPACT_FLAG_SHIFT);
+}
+
+static void RM_SetSlot(char *pageData, int slotID, SlotEntry *slot) {
+    CompactSlot *cs;
+
+    if (!IS_COMPACT(pageData)) {
+        *WIDE_SLOT(pageData, slotID) = *slot;
+        return;
+    }
+    cs = COMPACT_SLOT(pageData, slotID);
+    cs->recordOffset = (unsigned short)slot->recordOffset;
+    if (slot->recordLength == SLOT_EMPTY)
+        cs->recordLength = COMPACT_NONE;
+    else
+        cs->recordLength = SLOT_BYTES(slot) | ((slot->recordLength & SLOT_FLAGS) >> COMPACT_FLAG_SHIFT);
+}
 
 /*
  * RM_InitPage
- * Desc: Initializes a new, empty page as a slotted page.
+ * Desc: Initializes a new, empty page as a slotted page of the file's
+ *       format.
  */
-static void RM_InitPage(char *pageData) {
-    PageHeader *header = GET_HEADER(pageData);
-    header->numSlots = 0;
-    header->freeSpaceOffset = sizeof(PageHeader);
+void RM_InitPage(RM_FileHandle *fh, char *pageData) {
+    PageHeader header;
+    header.pageType = (fh->format == RM_FMT_COMPACT) ? RM_PAGE_COMPACT : RM_PAGE_DATA;
+    header.numSlots = 0;
+    header.freeSpaceOffset = (header.pageType == RM_PAGE_COMPACT) ?
+                             sizeof(CompactHeader) : sizeof(PageHeader);
+    header.freeSlot = SLOT_NONE;
+    RM_SetHeader(pageData, &header);
 }
 
 /* --- Helper Functions for Packed RID --- */
@@ -66,8 +250,73 @@ void RM_UnpackRID(RID rid, int *pageNum, int *slotNum) {
 
 /* --- File Management --- */
 
+/*
+ * RM_CreateHeader
+ * Desc: Creates the PF file and writes its header page.
+ */
+static int RM_CreateHeader(char *fileName, int format, RM_Schema *schema, int recordLength) {
+    RM_FileHeader *hdr;
+    char *pageData;
+    int pf_fd, pf_err, pageNum;
+
+    if ((pf_err = PF_CreateFile(fileName)) != PFE_OK)
+        return pf_err;
+    if ((pf_fd = PF_OpenFile(fileName, PF_LRU)) < 0) {
+        PF_PrintError("RM_CreateHeader: PF_OpenFile");
+        return pf_fd;
+    }
+
+    // The first page of a new file is page 0: the header
+    if ((pf_err = PF_AllocPage(pf_fd, &pageNum, &pageData)) != PFE_OK) {
+        PF_PrintError("RM_CreateHeader: PF_AllocPage");
+        PF_CloseFile(pf_fd);
+        return pf_err;
+    }
+    memset(pageData, 0, RM_PAGE_SIZE);
+    hdr = (RM_FileHeader *)pageData;
+    hdr->magic = RM_MAGIC;
+    hdr->format = format;
+    hdr->recordLength = recordLength;
+    if (schema != NULL)
+        hdr->schema = *schema;
+    else
+        hdr->schema.numAttrs = 0;
+
+    if ((pf_err = PF_UnfixPage(pf_fd, pageNum, TRUE)) != PFE_OK) {
+        PF_PrintError("RM_CreateHeader: PF_UnfixPage");
+        PF_CloseFile(pf_fd);
+        return pf_err;
+    }
+    return PF_CloseFile(pf_fd);
+}
+
 int RM_CreateFile(char *fileName) {
-    return PF_CreateFile(fileName);
+    return RM_CreateTypedFile(fileName, NULL);
+}
+
+int RM_CreateTypedFile(char *fileName, RM_Schema *schema) {
+    return RM_CreateFileFormat(fileName, RM_FMT_SLOTTED, schema);
+}
+
+int RM_CreateFileFormat(char *fileName, int format, RM_Schema *schema) {
+    RM_PaxLayout layout;
+
+    // PAX pages are cut up by attribute, so they need a schema that fits
+    if (format == RM_FMT_PAX) {
+        if (schema == NULL || RM_PaxInitLayout(schema, &layout) == 0)
+            return RME_INVALIDARG;
+    } else if (format != RM_FMT_SLOTTED && format != RM_FMT_COMPACT) {
+        return RME_INVALIDARG; // RM_FMT_FIXED needs a length: RM_CreateFixedFile
+    }
+    return RM_CreateHeader(fileName, format, schema, 0);
+}
+
+int RM_CreateFixedFile(char *fileName, int recordLength, RM_Schema *schema) {
+    RM_FixedLayout layout;
+
+    if (RM_FixedInitLayout(recordLength, &layout) == 0)
+        return RME_INVALIDARG;
+    return RM_CreateHeader(fileName, RM_FMT_FIXED, schema, recordLength);
 }
 
 int RM_DestroyFile(char *fileName) {
@@ -75,283 +324,1381 @@ int RM_DestroyFile(char *fileName) {
 }
 
 int RM_OpenFile(char *fileName, PF_Strategy strategy, RM_FileHandle *fh) {
-    int pf_fd;
+    RM_FileHeader *hdr;
+    char *pageData;
+    int pf_fd, pf_err;
+
     if ((pf_fd = PF_OpenFile(fileName, strategy)) < 0) {
         PF_PrintError("RM_OpenFile: PF_OpenFile");
         return pf_fd; // Return the PF error code
     }
     fh->pfFileDesc = pf_fd;
+    fh->insertPage = -1; // No insert hint yet
+    fh->roomMap = NULL;  // Built by the first search for room
+    fh->roomLeaves = 0;
+
+    // Load the header page
+    if ((pf_err = PF_GetThisPage(pf_fd, RM_HEADER_PAGE, &pageData)) != PFE_OK) {
+        PF_CloseFile(pf_fd);
+        return (pf_err == PFE_INVALIDPAGE) ? RME_NOTRMFILE : pf_err;
+    }
+    hdr = (RM_FileHeader *)pageData;
+    if (hdr->magic != RM_MAGIC) {
+        PF_UnfixPage(pf_fd, RM_HEADER_PAGE, FALSE);
+        PF_CloseFile(pf_fd);
+        return RME_NOTRMFILE;
+    }
+    fh->format = hdr->format;
+    fh->schema = hdr->schema;
+    if (fh->format == RM_FMT_FIXED)
+        RM_FixedInitLayout(hdr->recordLength, &fh->fixed);
+    PF_UnfixPage(pf_fd, RM_HEADER_PAGE, FALSE);
+
+    if (fh->format == RM_FMT_PAX)
+        RM_PaxInitLayout(&fh->schema, &fh->pax);
     return RME_OK;
 }
 
 int RM_CloseFile(RM_FileHandle *fh) {
+    free(fh->roomMap);
+    fh->roomMap = NULL;
+    fh->roomLeaves = 0;
     return PF_CloseFile(fh->pfFileDesc);
 }
 
+RM_Schema *RM_GetSchema(RM_FileHandle *fh) {
+    return (fh->schema.numAttrs > 0) ? &fh->schema : NULL;
+}
+
+
+/* --- Free Space Map --- */
+
+// Room of a page the map has not been told about: it may take anything
+#define RM_ROOM_UNKNOWN SHRT_MAX
+
+/*
+ * RM_GrowRoomMap
+ * Desc: Makes the map cover pages 0 .. numPages-1. The map is a complete
+ *       binary tree in an array: the leaves are the pages, and each inner
+ *       node holds the largest room below it.
+ */
+static int RM_GrowRoomMap(RM_FileHandle *fh, int numPages) {
+    short *tree;
+    int leaves, i;
+
+    leaves = (fh->roomLeaves > 0) ? fh->roomLeaves : 64;
+    while (leaves < numPages)
+        leaves *= 2;
+    if (leaves == fh->roomLeaves)
+        return RME_OK;
+    if ((tree = malloc(2 * leaves * sizeof(short))) == NULL)
+        return RME_NOMEM;
+
+    // Keep what is known; pages below the first data page have no room
+    for (i = 0; i < leaves; i++) {
+        if (i < fh->roomLeaves)
+            tree[leaves + i] = fh->roomMap[fh->roomLeaves + i];
+        else
+            tree[leaves + i] = (i < RM_FIRST_DATA_PAGE) ? 0 : RM_ROOM_UNKNOWN;
+    }
+    for (i = leaves - 1; i > 0; i--)
+        tree[i] = (tree[2 * i] > tree[2 * i + 1]) ? tree[2 * i] : tree[2 * i + 1];
+
+    free(fh->roomMap);
+    fh->roomMap = tree;
+    fh->roomLeaves = leaves;
+    return RME_OK;
+}
+
+void RM_NoteRoom(RM_FileHandle *fh, int pageNum, int room) {
+    short *tree;
+    int i;
+
+    // Without memory to grow the map the page stays unknown, which only
+    // costs a read the next time a search gets to it
+    if (pageNum >= fh->roomLeaves && RM_GrowRoomMap(fh, pageNum + 1) != RME_OK)
+        return;
+    if (room < 0)
+        room = 0;
+    if (room >= RM_ROOM_UNKNOWN)
+        room = RM_ROOM_UNKNOWN - 1;
+
+    tree = fh->roomMap;
+    i = fh->roomLeaves + pageNum;
+    tree[i] = room;
+    for (i /= 2; i > 0; i /= 2)
+        tree[i] = (tree[2 * i] > tree[2 * i + 1]) ? tree[2 * i] : tree[2 * i + 1];
+}
+
+int RM_FindRoom(RM_FileHandle *fh, int room, int *pageNum) {
+    short *tree;
+    int numPages, i;
+
+    if ((numPages = PF_GetNumPages(fh->pfFileDesc)) < 0)
+        return numPages;
+    if (numPages > fh->roomLeaves && RM_GrowRoomMap(fh, numPages) != RME_OK)
+        return RME_NOMEM;
+
+    // Walk down to the leftmost leaf with enough room
+    tree = fh->roomMap;
+    if (tree[1] < room)
+        return RME_EOF;
+    for (i = 1; i < fh->roomLeaves; )
+        i = (tree[2 * i] >= room) ? 2 * i : 2 * i + 1;
+    if (i - fh->roomLeaves >= numPages)
+        return RME_EOF; // Only past the end of the file
+    *pageNum = i - fh->roomLeaves;
+    return RME_OK;
+}
+
+
+/* --- Overflow Chains --- */
+
+/*
+ * RM_FreeOverflow
+ * Desc: Disposes of every page of an overflow chain.
+ */
+static int RM_FreeOverflow(RM_FileHandle *fh, int firstPage) {
+    char *pageData;
+    int pf_err, pageNum, nextPage;
+
+    for (pageNum = firstPage; pageNum != -1; pageNum = nextPage) {
+        if ((pf_err = PF_GetThisPage(fh->pfFileDesc, pageNum, &pageData)) != PFE_OK) {
+            PF_PrintError("RM_FreeOverflow: PF_GetThisPage");
+            return pf_err;
+        }
+        nextPage = ((OverflowHeader *)pageData)->nextPage;
+        PF_UnfixPage(fh->pfFileDesc, pageNum, FALSE);
+        if ((pf_err = PF_DisposePage(fh->pfFileDesc, pageNum)) != PFE_OK) {
+            PF_PrintError("RM_FreeOverflow: PF_DisposePage");
+            return pf_err;
+        }
+    }
+    return RME_OK;
+}
+
+/*
+ * RM_WriteOverflow
+ * Desc: Copies a large record into a new chain of overflow pages.
+ * Params: (int*) firstPage - (out) first page of the chain
+ */
+static int RM_WriteOverflow(RM_FileHandle *fh, char *data, int dataLength, int *firstPage) {
+    OverflowHeader *ovf;
+    char *pageData, *nextData;
+    int pf_err, pageNum, nextPage, chunk, pos = 0;
+
+    if ((pf_err = PF_AllocPage(fh->pfFileDesc, &pageNum, &pageData)) != PFE_OK) {
+        PF_PrintError("RM_WriteOverflow: PF_AllocPage");
+        return pf_err;
+    }
+    *firstPage = pageNum;
+
+    while (TRUE) {
+        // 1. Fill this page with the next piece
+        ovf = (OverflowHeader *)pageData;
+        chunk = dataLength - pos;
+        if (chunk > OVERFLOW_CAPACITY)
+            chunk = OVERFLOW_CAPACITY;
+        ovf->pageType = RM_PAGE_OVERFLOW;
+        ovf->nextPage = -1;
+        RM_NoteRoom(fh, pageNum, 0); // Never takes records
+        ovf->length = chunk;
+        memcpy(pageData + sizeof(OverflowHeader), data + pos, chunk);
+        pos += chunk;
+        if (pos == dataLength)
+            break;
+
+        // 2. Chain the next page before letting go of this one
+        if ((pf_err = PF_AllocPage(fh->pfFileDesc, &nextPage, &nextData)) != PFE_OK) {
+            PF_PrintError("RM_WriteOverflow: PF_AllocPage");
+            PF_UnfixPage(fh->pfFileDesc, pageNum, TRUE);
+            RM_FreeOverflow(fh, *firstPage);
+            return pf_err;
+        }
+        ovf->nextPage = nextPage;
+        PF_UnfixPage(fh->pfFileDesc, pageNum, TRUE);
+        pageNum = nextPage;
+        pageData = nextData;
+    }
+
+    if ((pf_err = PF_UnfixPage(fh->pfFileDesc, pageNum, TRUE)) != PFE_OK) {
+        PF_PrintError("RM_WriteOverflow: PF_UnfixPage");
+        return pf_err;
+    }
+    return RME_OK;
+}
+
+/*
+ * RM_CopyOverflow
+ * Desc: Copies the whole record of an overflow chain into dataBuf, which
+ *       must hold stub->totalLength bytes. The chain's pages are read
+ *       with PF_CopyPage and never fixed, so scans of other page ranges
+ *       that reach them cannot collide with this one.
+ */
+static int RM_CopyOverflow(RM_FileHandle *fh, OverflowStub *stub, char *dataBuf) {
+    OverflowHeader *ovf;
+    char pageData[PF_PAGE_SIZE];
+    int pf_err, pageNum, pos = 0;
+
+    ovf = (OverflowHeader *)pageData;
+    for (pageNum = stub->firstPage; pageNum != -1 && pos < stub->totalLength; pageNum = ovf->nextPage) {
+        if ((pf_err = PF_CopyPage(fh->pfFileDesc, pageNum, pageData, PF_PAGE_SIZE)) != PFE_OK) {
+            PF_PrintError("RM_CopyOverflow: PF_CopyPage");
+            return pf_err;
+        }
+        if (ovf->pageType != RM_PAGE_OVERFLOW || ovf->length < 0
+                || ovf->length > stub->totalLength - pos)
+            return RME_ERROR; // Broken chain
+        memcpy(dataBuf + pos, pageData + sizeof(OverflowHeader), ovf->length);
+        pos += ovf->length;
+    }
+
+    return (pos == stub->totalLength) ? RME_OK : RME_ERROR;
+}
+
+/*
+ * RM_LoadOverflow
+ * Desc: Reads the large record behind the stub at stubPtr into *buf,
+ *       which is grown with realloc() as needed (*bufSize is its size).
+ */
+static int RM_LoadOverflow(RM_FileHandle *fh, char *stubPtr, char **buf, int *bufSize, int *length) {
+    OverflowStub stub;
+    char *newBuf;
+    int err;
+
+    memcpy(&stub, stubPtr, sizeof(stub));
+    if (*bufSize < stub.totalLength) {
+        if ((newBuf = realloc(*buf, stub.totalLength)) == NULL)
+            return RME_NOMEM;
+        *buf = newBuf;
+        *bufSize = stub.totalLength;
+    }
+    if ((err = RM_CopyOverflow(fh, &stub, *buf)) != RME_OK)
+        return err;
+
+    *length = stub.totalLength;
+    return RME_OK;
+}
+
 
 /* --- Record Management --- */
 
-int RM_InsertRecord(RM_FileHandle *fh, char *data, int dataLength, RID *rid) {
+/*
+ * RM_PageHasRoom
+ * Desc: Checks whether a record of dataLength bytes fits in the page.
+ *       *slotID is set to a reusable empty slot, or -1 if a new slot
+ *       has to be appended to the directory.
+ */
+static int RM_PageHasRoom(char *pageData, int dataLength, int *slotID) {
+    PageHeader header;
+    int spaceNeeded = dataLength;
+
+    // The head of the empty-slot chain, if there is one
+    RM_GetHeader(pageData, &header);
+    *slotID = header.freeSlot;
+
+    if (*slotID == SLOT_NONE) {
+        spaceNeeded += SLOT_SIZE(pageData); // Need space for data AND a new slot
+    }
+
+    return GET_CONTIGUOUS_FREE_SPACE(pageData, &header) >= spaceNeeded;
+}
+
+/*
+ * RM_PageRoom
+ * Desc: Returns the longest record that fits in the page, for the
+ *       free-space map: RM_PageHasRoom(pageData, n) holds for n <= it.
+ */
+int RM_PageRoom(char *pageData) {
+    PageHeader header;
+    int room;
+
+    RM_GetHeader(pageData, &header);
+    room = GET_CONTIGUOUS_FREE_SPACE(pageData, &header);
+    if (header.freeSlot == SLOT_NONE)
+        room -= SLOT_SIZE(pageData);
+    return (room > 0) ? room : 0;
+}
+
+/*
+ * RM_FreeSlot
+ * Desc: Marks a slot empty. An empty tail of the directory is cut off
+ *       (and the chain rebuilt without it); any other slot is pushed
+ *       on the chain of empty slots.
+ */
+static void RM_FreeSlot(char *pageData, int slotNum) {
+    PageHeader header;
+    SlotEntry slot;
+    int i, last;
+
+    RM_GetHeader(pageData, &header);
+    slot.recordLength = SLOT_EMPTY;
+    if (slotNum < header.numSlots - 1) {
+        slot.recordOffset = header.freeSlot;
+        RM_SetSlot(pageData, slotNum, &slot);
+        header.freeSlot = slotNum;
+        RM_SetHeader(pageData, &header);
+        return;
+    }
+    slot.recordOffset = SLOT_NONE;
+    RM_SetSlot(pageData, slotNum, &slot);
+
+    // Truncate trailing empty slots; their directory space becomes free
+    while (header.numSlots > 0) {
+        RM_GetSlot(pageData, header.numSlots - 1, &slot);
+        if (slot.recordLength != SLOT_EMPTY)
+            break;
+        header.numSlots--;
+    }
+
+    // Relink the empty slots that are left, lowest first
+    header.freeSlot = SLOT_NONE;
+    last = SLOT_NONE;
+    for (i = 0; i < header.numSlots; i++) {
+        RM_GetSlot(pageData, i, &slot);
+        if (slot.recordLength != SLOT_EMPTY)
+            continue;
+        if (last == SLOT_NONE) {
+            header.freeSlot = i;
+        } else {
+            RM_GetSlot(pageData, last, &slot);
+            slot.recordOffset = i;
+            RM_SetSlot(pageData, last, &slot);
+        }
+        last = i;
+    }
+    if (last != SLOT_NONE) {
+        RM_GetSlot(pageData, last, &slot);
+        slot.recordOffset = SLOT_NONE;
+        RM_SetSlot(pageData, last, &slot);
+    }
+    RM_SetHeader(pageData, &header);
+}
+
+/*
+ * RM_InsertInPage
+ * Desc: Places dataLength bytes in a slot of a data page; flags are
+ *       or'ed into the slot's recordLength.
+ */
+static int RM_InsertInPage(RM_FileHandle *fh, char *data, int dataLength, int flags, RID *rid) {
     int pageNum, pf_err;
     char *pageData;
-    int spaceNeeded = dataLength; // Space for data
-    
-    int foundEmptySlot = FALSE;
     int targetSlotID = -1;
+    int found = FALSE;
 
-    // 1. Find a page with enough space
-    pageNum = -1;
-    while (PF_GetNextPage(fh->pfFileDesc, &pageNum, &pageData) == PFE_OK) {
-        PageHeader *header = GET_HEADER(pageData);
-        
-        // Check for an empty slot
-        foundEmptySlot = FALSE;
-        for (int i = 0; i < header->numSlots; i++) {
-            if (GET_SLOT(pageData, i)->recordLength == SLOT_EMPTY) {
-                foundEmptySlot = TRUE;
-                targetSlotID = i;
-                break;
+    // 1. Try the page the previous insert went to; appends mostly land there
+    if (fh->insertPage != -1) {
+        pageNum = fh->insertPage;
+        if ((pf_err = PF_GetThisPage(fh->pfFileDesc, pageNum, &pageData)) != PFE_OK) {
+            PF_PrintError("RM_InsertInPage: PF_GetThisPage");
+            return pf_err;
+        }
+        if (RM_PageHasRoom(pageData, dataLength, &targetSlotID)) {
+            found = TRUE;
+        } else {
+            RM_NoteRoom(fh, pageNum, RM_PageRoom(pageData));
+            if ((pf_err = PF_UnfixPage(fh->pfFileDesc, pageNum, FALSE)) != PFE_OK) {
+                PF_PrintError("RM_InsertRecord: PF_UnfixPage");
+                return pf_err;
             }
         }
+    }
 
-        int currentSpaceNeeded = spaceNeeded;
-        if (!foundEmptySlot) {
-            currentSpaceNeeded += sizeof(SlotEntry); // Need space for data AND a new slot
+    // 2. Otherwise take the first page the free-space map says may have
+    //    room, noting the real room of each page that turns out not to
+    while (!found && (pf_err = RM_FindRoom(fh, dataLength, &pageNum)) == RME_OK) {
+        if ((pf_err = PF_GetThisPage(fh->pfFileDesc, pageNum, &pageData)) != PFE_OK) {
+            if (pf_err != PFE_INVALIDPAGE) {
+                PF_PrintError("RM_InsertRecord: PF_GetThisPage");
+                return pf_err;
+            }
+            RM_NoteRoom(fh, pageNum, 0); // A free page of the PF file
+            continue;
         }
-
-        if (GET_CONTIGUOUS_FREE_SPACE(pageData) >= currentSpaceNeeded) {
+        if (IS_DATA_PAGE(pageData) &&
+            RM_PageHasRoom(pageData, dataLength, &targetSlotID)) {
             // Found a page with space!
+            found = TRUE;
             break;
         }
-        
-        // Unfix the page (not dirty) and continue to the next one
+        RM_NoteRoom(fh, pageNum, IS_DATA_PAGE(pageData) ? RM_PageRoom(pageData) : 0);
+
+        // Unfix the page (not dirty) and try the next one
         if ((pf_err = PF_UnfixPage(fh->pfFileDesc, pageNum, FALSE)) != PFE_OK) {
             PF_PrintError("RM_InsertRecord: PF_UnfixPage");
             return pf_err;
         }
     }
 
-    // 2. If no page found, allocate a new one
-    if (PFerrno == PFE_EOF || pageNum == -1) {
+    // 3. If no page found, allocate a new one
+    if (!found) {
+        if (pf_err != RME_EOF)
+            return pf_err; // PF_GetNumPages failed, or no memory for the map
         if ((pf_err = PF_AllocPage(fh->pfFileDesc, &pageNum, &pageData)) != PFE_OK) {
             PF_PrintError("RM_InsertRecord: PF_AllocPage");
             return pf_err;
         }
         // Initialize the new page
-        RM_InitPage(pageData);
-        targetSlotID = -1; // Will use slot 0
-    } else if (PFerrno != PFE_OK) {
-        // Some other error occurred
-        PF_PrintError("RM_InsertRecord: PF_GetNextPage");
-        return PFerrno;
+        RM_InitPage(fh, pageData);
+        targetSlotID = SLOT_NONE; // Will use slot 0
     }
+    fh->insertPage = pageNum;
 
-    // 3. We now have a page (pageData) and pageNum. Insert the record.
-    PageHeader *header = GET_HEADER(pageData);
+    // 4. We now have a page (pageData) and pageNum. Insert the record.
+    PageHeader header;
+    SlotEntry slot;
+    RM_GetHeader(pageData, &header);
     
-    // 3a. Finalize slot
-    if (targetSlotID == -1) {
-        targetSlotID = header->numSlots; // Use a new slot
+    // 4a. Finalize slot: take the head of the empty-slot chain, or a new one
+    if (targetSlotID == SLOT_NONE) {
+        targetSlotID = header.numSlots; // Use a new slot
+    } else {
+        RM_GetSlot(pageData, targetSlotID, &slot);
+        header.freeSlot = slot.recordOffset;
     }
 
-    // 4. Add the data to the page
-    SlotEntry *slot = GET_SLOT(pageData, targetSlotID);
-    int dataOffset = header->freeSpaceOffset;
+    // 5. Add the data to the page
+    int dataOffset = header.freeSpaceOffset;
     memcpy(pageData + dataOffset, data, dataLength);
 
-    // 5. Update the slot and header
-    slot->recordOffset = dataOffset;
-    slot->recordLength = dataLength;
+    // 6. Update the slot and header
+    slot.recordOffset = dataOffset;
+    slot.recordLength = dataLength | flags;
+    RM_SetSlot(pageData, targetSlotID, &slot);
     
-    header->freeSpaceOffset += dataLength;
-    if (targetSlotID == header->numSlots) {
-        header->numSlots++;
+    header.freeSpaceOffset += dataLength;
+    if (targetSlotID == header.numSlots) {
+        header.numSlots++;
     }
+    RM_SetHeader(pageData, &header);
+    RM_NoteRoom(fh, pageNum, RM_PageRoom(pageData));
 
-    // 6. Set the output RID (PACKED)
+    // 7. Set the output RID (PACKED)
     *rid = RM_PackRID(pageNum, targetSlotID);
 
-    // 7. Unfix the page, marking it as dirty
+    // 8. Unfix the page, marking it as dirty
     if ((pf_err = PF_UnfixPage(fh->pfFileDesc, pageNum, TRUE)) != PFE_OK) {
-        PF_PrintError("RM_InsertRecord: PF_UnfixPage (dirty)");
+        PF_PrintError("RM_InsertInPage: PF_UnfixPage (dirty)");
         return pf_err;
     }
 
     return RME_OK;
 }
 
-int RM_DeleteRecord(RM_FileHandle *fh, RID rid) {
-    char *pageData;
-    int pf_err, pageNum, slotNum;
+/*
+ * RM_PageAppend
+ * Desc: Adds a record in a new slot at the end of the directory of a
+ *       page being built in memory. Returns the slot number, or -1 if
+ *       the page has no room for it.
+ */
+int RM_PageAppend(char *pageData, char *data, int dataLength) {
+    PageHeader header;
+    SlotEntry slot;
+
+    RM_GetHeader(pageData, &header);
+    if (GET_CONTIGUOUS_FREE_SPACE(pageData, &header) < dataLength + SLOT_SIZE(pageData))
+        return -1;
+
+    slot.recordOffset = header.freeSpaceOffset;
+    slot.recordLength = dataLength;
+    memcpy(pageData + slot.recordOffset, data, dataLength);
+    RM_SetSlot(pageData, header.numSlots, &slot);
+
+    header.freeSpaceOffset += dataLength;
+    header.numSlots++;
+    RM_SetHeader(pageData, &header);
+    return header.numSlots - 1;
+}
 
-    // 1. Unpack the RID
-    RM_UnpackRID(rid, &pageNum, &slotNum);
+int RM_InsertRecord(RM_FileHandle *fh, char *data, int dataLength, RID *rid) {
+    OverflowStub stub;
+    int err;
+
+    if (fh->format == RM_FMT_PAX)
+        return RM_PaxInsertRecord(fh, data, dataLength, rid);
+    if (fh->format == RM_FMT_FIXED)
+        return RM_FixedInsertRecord(fh, data, dataLength, rid);
+    if (dataLength < 0)
+        return RME_INVALIDARG;
+
+    // A record that fits in an empty page next to its slot goes in a page
+    if (dataLength <= RM_MAX_INLINE)
+        return RM_InsertInPage(fh, data, dataLength, 0, rid);
+
+    // Anything larger goes to an overflow chain, with a stub in the slot
+    stub.totalLength = dataLength;
+    if ((err = RM_WriteOverflow(fh, data, dataLength, &stub.firstPage)) != RME_OK)
+        return err;
+    if ((err = RM_InsertInPage(fh, (char *)&stub, sizeof(stub), SLOT_OVERFLOW, rid)) != RME_OK) {
+        RM_FreeOverflow(fh, stub.firstPage);
+        return err;
+    }
+    return RME_OK;
+}
 
-    // 2. Get the page
-    if ((pf_err = PF_GetThisPage(fh->pfFileDesc, pageNum, &pageData)) != PFE_OK) {
-        PF_PrintError("RM_DeleteRecord: PF_GetThisPage");
-        return (pf_err == PFE_INVALIDPAGE) ? RME_INVALIDRID : pf_err;
+/*
+ * RM_SlotPayload
+ * Desc: Locates the bytes a used slot stores for its record: the record
+ *       itself, or an OverflowStub/ForwardStub (see the SLOT_* flags),
+ *       without the home RID of a moved record.
+ */
+static void RM_SlotPayload(char *pageData, SlotEntry *slot, char **payload, int *payloadLength) {
+    int skip = SLOT_HAS(slot, SLOT_MOVED) ? (int)sizeof(RID) : 0;
+    *payload = pageData + slot->recordOffset + skip;
+    *payloadLength = SLOT_BYTES(slot) - skip;
+}
+
+/*
+ * RM_CutSlotBytes
+ * Desc: Removes a slot's bytes from the page and closes the hole, so the
+ *       freed space joins the contiguous free space. The slot is left
+ *       holding zero bytes.
+ */
+static void RM_CutSlotBytes(char *pageData, int slotNum) {
+    PageHeader header;
+    SlotEntry slot, otherSlot;
+    RM_GetHeader(pageData, &header);
+    RM_GetSlot(pageData, slotNum, &slot);
+    int cutOffset = slot.recordOffset;
+    int cutLength = SLOT_BYTES(&slot);
+
+    // Move all data *after* the record to the left
+    char *holeStart = pageData + cutOffset;
+    char *holeEnd = holeStart + cutLength;
+    char *dataEnd = pageData + header.freeSpaceOffset;
+    memmove(holeStart, holeEnd, dataEnd - holeEnd);
+
+    // Update all other slot offsets
+    for (int i = 0; i < header.numSlots; i++) {
+        RM_GetSlot(pageData, i, &otherSlot);
+        if (i != slotNum && otherSlot.recordLength != SLOT_EMPTY &&
+            otherSlot.recordOffset > cutOffset) {
+            otherSlot.recordOffset -= cutLength;
+            RM_SetSlot(pageData, i, &otherSlot);
+        }
     }
 
-    PageHeader *header = GET_HEADER(pageData);
+    header.freeSpaceOffset -= cutLength;
+    RM_SetHeader(pageData, &header);
+    slot.recordOffset = header.freeSpaceOffset;
+    slot.recordLength = 0;
+    RM_SetSlot(pageData, slotNum, &slot);
+}
+
+/*
+ * RM_PutSlotBytes
+ * Desc: Appends bytes for an existing slot at the start of the free
+ *       space. The caller has checked that they fit.
+ */
+static void RM_PutSlotBytes(char *pageData, int slotNum, char *bytes, int length, int flags) {
+    PageHeader header;
+    SlotEntry slot;
+
+    RM_GetHeader(pageData, &header);
+    memcpy(pageData + header.freeSpaceOffset, bytes, length);
+    slot.recordOffset = header.freeSpaceOffset;
+    slot.recordLength = length | flags;
+    RM_SetSlot(pageData, slotNum, &slot);
+    header.freeSpaceOffset += length;
+    RM_SetHeader(pageData, &header);
+}
+
+/*
+ * RM_FixSlot
+ * Desc: Fixes a page and checks that the slot holds a record; moved
+ *       records are only accepted when 'moved' is TRUE (they must be
+ *       reached through their home slot). On RME_OK the page is fixed
+ *       and *slot is a copy of its entry.
+ */
+static int RM_FixSlot(RM_FileHandle *fh, int pageNum, int slotNum, int moved,
+                      char *caller, char **pageData, SlotEntry *slot) {
+    int pf_err;
 
-    // 3. Check if RID is valid
-    if (slotNum >= header->numSlots) {
-        PF_UnfixPage(fh->pfFileDesc, pageNum, FALSE); // Not dirty
+    if (pageNum == RM_HEADER_PAGE)
+        return RME_INVALIDRID; // The header page holds no records
+    if ((pf_err = PF_GetThisPage(fh->pfFileDesc, pageNum, pageData)) != PFE_OK) {
+        PF_PrintError(caller);
+        return (pf_err == PFE_INVALIDPAGE) ? RME_INVALIDRID : pf_err;
+    }
+
+    PageHeader header;
+    RM_GetHeader(*pageData, &header);
+    if (!IS_DATA_PAGE(*pageData) || slotNum >= header.numSlots) {
+        PF_UnfixPage(fh->pfFileDesc, pageNum, FALSE);
         return RME_INVALIDRID;
     }
-    
-    SlotEntry *slot = GET_SLOT(pageData, slotNum);
-    if (slot->recordLength == SLOT_EMPTY) {
-        PF_UnfixPage(fh->pfFileDesc, pageNum, FALSE); // Not dirty
-        return RME_INVALIDRID; // Already deleted
+    RM_GetSlot(*pageData, slotNum, slot);
+    if (slot->recordLength == SLOT_EMPTY || (SLOT_HAS(slot, SLOT_MOVED) != 0) != (moved != 0)) {
+        PF_UnfixPage(fh->pfFileDesc, pageNum, FALSE);
+        return RME_INVALIDRID; // Deleted, or not what the caller was after
+    }
+    return RME_OK;
+}
+
+/*
+ * RM_ReadPayload
+ * Desc: Copies the record behind a slot payload (the record itself, or
+ *       an OverflowStub when isOverflow) into dataBuf.
+ */
+static int RM_ReadPayload(RM_FileHandle *fh, char *payload, int payloadLength, int isOverflow,
+                          char *dataBuf, int bufSize, int *dataLength) {
+    OverflowStub stub;
+    int err;
+
+    if (!isOverflow) {
+        if (bufSize < payloadLength)
+            return RME_BUFTOOSMALL;
+        memcpy(dataBuf, payload, payloadLength);
+        *dataLength = payloadLength;
+        return RME_OK;
     }
 
-    // 4. Get info about the record to be deleted
-    int deletedOffset = slot->recordOffset;
-    int deletedLength = slot->recordLength;
+    memcpy(&stub, payload, sizeof(stub));
+    if (bufSize < stub.totalLength)
+        return RME_BUFTOOSMALL;
+    if ((err = RM_CopyOverflow(fh, &stub, dataBuf)) != RME_OK)
+        return err;
+    *dataLength = stub.totalLength;
+    return RME_OK;
+}
 
-    // 5. Mark the slot as empty
-    slot->recordLength = SLOT_EMPTY;
+/*
+ * RM_DeleteSlot
+ * Desc: Deletes the record of a slot (a moved one if 'moved') together
+ *       with everything it owns: its overflow chain, or the slot a
+ *       forwarding stub points to.
+ */
+static int RM_DeleteSlot(RM_FileHandle *fh, int pageNum, int slotNum, int moved) {
+    OverflowStub stub;
+    ForwardStub fwd;
+    SlotEntry slot;
+    char *pageData, *payload;
+    int pf_err, payloadLength, isOverflow, isForward;
+
+    // 1. Get the page and check the slot
+    if ((pf_err = RM_FixSlot(fh, pageNum, slotNum, moved, "RM_DeleteRecord: PF_GetThisPage",
+                             &pageData, &slot)) != RME_OK)
+        return pf_err;
 
-    // 6. **Compact the data**
-    //    Move all data *after* the deleted record to the left
-    char *holeStart = pageData + deletedOffset;
-    char *holeEnd = holeStart + deletedLength;
-    char *dataEnd = pageData + header->freeSpaceOffset;
-    
-    memmove(holeStart, holeEnd, dataEnd - holeEnd);
+    // 2. Remember what the record owns outside this slot
+    RM_SlotPayload(pageData, &slot, &payload, &payloadLength);
+    isOverflow = SLOT_HAS(&slot, SLOT_OVERFLOW);
+    isForward = SLOT_HAS(&slot, SLOT_FORWARD);
+    if (isOverflow)
+        memcpy(&stub, payload, sizeof(stub));
+    if (isForward)
+        memcpy(&fwd, payload, sizeof(fwd));
+
+    // 3. Compact the data and give the slot back
+    RM_CutSlotBytes(pageData, slotNum);
+    RM_FreeSlot(pageData, slotNum);
+    RM_NoteRoom(fh, pageNum, RM_PageRoom(pageData));
+
+    // 4. Unfix the page, marking it as dirty
+    if ((pf_err = PF_UnfixPage(fh->pfFileDesc, pageNum, TRUE)) != PFE_OK) {
+        PF_PrintError("RM_DeleteRecord: PF_UnfixPage (dirty)");
+        return pf_err;
+    }
+
+    // 5. Give the pages of a large record back to the file, and delete
+    //    the moved copy of a forwarded one
+    if (isOverflow)
+        return RM_FreeOverflow(fh, stub.firstPage);
+    if (isForward) {
+        RM_UnpackRID(fwd.target, &pageNum, &slotNum);
+        return RM_DeleteSlot(fh, pageNum, slotNum, TRUE);
+    }
+    return RME_OK;
+}
+
+int RM_DeleteRecord(RM_FileHandle *fh, RID rid) {
+    int pageNum, slotNum;
+
+    if (fh->format == RM_FMT_PAX)
+        return RM_PaxDeleteRecord(fh, rid);
+    if (fh->format == RM_FMT_FIXED)
+        return RM_FixedDeleteRecord(fh, rid);
+
+    RM_UnpackRID(rid, &pageNum, &slotNum);
+    return RM_DeleteSlot(fh, pageNum, slotNum, FALSE);
+}
 
-    // 7. Update all other slot offsets
-    for (int i = 0; i < header->numSlots; i++) {
-        SlotEntry *otherSlot = GET_SLOT(pageData, i);
-        if (otherSlot->recordLength != SLOT_EMPTY && otherSlot->recordOffset > deletedOffset) {
-            otherSlot->recordOffset -= deletedLength;
+int RM_UpdateRecord(RM_FileHandle *fh, RID rid, char *data, int dataLength) {
+    OverflowStub stub;
+    ForwardStub fwd, oldFwd;
+    OverflowStub oldStub;
+    PageHeader header;
+    SlotEntry slot;
+    char *pageData, *payload, *moved;
+    char *newBytes = data;
+    int pf_err, err, pageNum, slotNum, payloadLength, room;
+    int newLength = dataLength, newFlags = 0;
+    int oldOverflow, oldForward;
+    RID newRid;
+
+    if (fh->format == RM_FMT_PAX)
+        return RM_PaxUpdateRecord(fh, rid, data, dataLength);
+    if (fh->format == RM_FMT_FIXED)
+        return RM_FixedUpdateRecord(fh, rid, data, dataLength);
+    if (dataLength < 0)
+        return RME_INVALIDARG;
+
+    // 1. Get the home page and check the slot
+    RM_UnpackRID(rid, &pageNum, &slotNum);
+    if ((err = RM_FixSlot(fh, pageNum, slotNum, FALSE, "RM_UpdateRecord: PF_GetThisPage",
+                          &pageData, &slot)) != RME_OK)
+        return err;
+
+    // 2. Remember what the old version owns outside the slot; it is
+    //    released once the new version is in place
+    RM_SlotPayload(pageData, &slot, &payload, &payloadLength);
+    oldOverflow = SLOT_HAS(&slot, SLOT_OVERFLOW);
+    oldForward = SLOT_HAS(&slot, SLOT_FORWARD);
+    if (oldOverflow)
+        memcpy(&oldStub, payload, sizeof(oldStub));
+    if (oldForward)
+        memcpy(&oldFwd, payload, sizeof(oldFwd));
+
+    // 3. The slot's own bytes can be reused, plus the page's free space.
+    //    A record that fits neither there nor (once moved) in an empty
+    //    page goes to an overflow chain; the slot then only takes the stub
+    RM_GetHeader(pageData, &header);
+    room = SLOT_BYTES(&slot) + GET_CONTIGUOUS_FREE_SPACE(pageData, &header);
+    if (dataLength > room && dataLength > RM_MAX_MOVED) {
+        stub.totalLength = dataLength;
+        if ((err = RM_WriteOverflow(fh, data, dataLength, &stub.firstPage)) != RME_OK) {
+            PF_UnfixPage(fh->pfFileDesc, pageNum, FALSE);
+            return err;
         }
+        newBytes = (char *)&stub;
+        newLength = sizeof(stub);
+        newFlags = SLOT_OVERFLOW;
     }
 
-    // 8. Update the header
-    header->freeSpaceOffset -= deletedLength;
+    // 4. Store the new version
+    if (newLength <= room) {
+        // 4a. Rewrite in place
+        RM_CutSlotBytes(pageData, slotNum);
+        RM_PutSlotBytes(pageData, slotNum, newBytes, newLength, newFlags);
+    } else {
+        // 4b. Move the record; the home slot keeps a forwarding stub
+        if (room < (int)sizeof(ForwardStub)) {
+            PF_UnfixPage(fh->pfFileDesc, pageNum, FALSE);
+            if (newFlags & SLOT_OVERFLOW)
+                RM_FreeOverflow(fh, stub.firstPage);
+            return RME_RECTOOLARGE; // Not even room for the stub
+        }
+        PF_UnfixPage(fh->pfFileDesc, pageNum, FALSE);
 
-    // (Optional) We could shrink header->numSlots if this was the last slot,
-    // but we'll leave it for simplicity and slot reuse.
+        if ((moved = malloc(sizeof(RID) + newLength)) == NULL)
+            return RME_NOMEM;
+        memcpy(moved, &rid, sizeof(RID));
+        memcpy(moved + sizeof(RID), newBytes, newLength);
+        err = RM_InsertInPage(fh, moved, sizeof(RID) + newLength, newFlags | SLOT_MOVED, &newRid);
+        free(moved);
+        if (err != RME_OK) {
+            if (newFlags & SLOT_OVERFLOW)
+                RM_FreeOverflow(fh, stub.firstPage);
+            return err;
+        }
 
-    // 9. Unfix the page, marking it as dirty
+        // The home page had no room for the record, so it was not touched
+        if ((pf_err = PF_GetThisPage(fh->pfFileDesc, pageNum, &pageData)) != PFE_OK) {
+            PF_PrintError("RM_UpdateRecord: PF_GetThisPage");
+            return pf_err;
+        }
+        fwd.target = newRid;
+        RM_CutSlotBytes(pageData, slotNum);
+        RM_PutSlotBytes(pageData, slotNum, (char *)&fwd, sizeof(fwd), SLOT_FORWARD);
+    }
+
+    // 5. Unfix the home page, marking it as dirty
+    RM_NoteRoom(fh, pageNum, RM_PageRoom(pageData));
     if ((pf_err = PF_UnfixPage(fh->pfFileDesc, pageNum, TRUE)) != PFE_OK) {
-        PF_PrintError("RM_DeleteRecord: PF_UnfixPage (dirty)");
+        PF_PrintError("RM_UpdateRecord: PF_UnfixPage (dirty)");
         return pf_err;
     }
 
+    // 6. Release the old version's overflow chain or moved copy
+    if (oldOverflow)
+        return RM_FreeOverflow(fh, oldStub.firstPage);
+    if (oldForward) {
+        RM_UnpackRID(oldFwd.target, &pageNum, &slotNum);
+        return RM_DeleteSlot(fh, pageNum, slotNum, TRUE);
+    }
     return RME_OK;
 }
 
 int RM_GetRecord(RM_FileHandle *fh, RID rid, char *dataBuf, int bufSize, int *dataLength) {
-    char *pageData;
-    int pf_err, pageNum, slotNum;
+    ForwardStub fwd;
+    SlotEntry slot;
+    char *pageData, *payload;
+    int pf_err, err, pageNum, slotNum, payloadLength;
+
+    if (fh->format == RM_FMT_PAX)
+        return RM_PaxGetRecord(fh, rid, dataBuf, bufSize, dataLength);
+    if (fh->format == RM_FMT_FIXED)
+        return RM_FixedGetRecord(fh, rid, dataBuf, bufSize, dataLength);
 
-    // 1. Unpack the RID
+    // 1. Get the page and check the slot
     RM_UnpackRID(rid, &pageNum, &slotNum);
+    if ((err = RM_FixSlot(fh, pageNum, slotNum, FALSE, "RM_GetRecord: PF_GetThisPage",
+                          &pageData, &slot)) != RME_OK)
+        return err;
+
+    // 2. Follow a forwarding stub to where the record lives now
+    if (SLOT_HAS(&slot, SLOT_FORWARD)) {
+        RM_SlotPayload(pageData, &slot, &payload, &payloadLength);
+        memcpy(&fwd, payload, sizeof(fwd));
+        PF_UnfixPage(fh->pfFileDesc, pageNum, FALSE);
+        RM_UnpackRID(fwd.target, &pageNum, &slotNum);
+        if ((err = RM_FixSlot(fh, pageNum, slotNum, TRUE, "RM_GetRecord: PF_GetThisPage",
+                              &pageData, &slot)) != RME_OK)
+            return err;
+    }
 
-    // 2. Get the page
-    if ((pf_err = PF_GetThisPage(fh->pfFileDesc, pageNum, &pageData)) != PFE_OK) {
-        PF_PrintError("RM_GetRecord: PF_GetThisPage");
-        return (pf_err == PFE_INVALIDPAGE) ? RME_INVALIDRID : pf_err;
+    // 3. Copy the record (from its overflow chain if it has one)
+    RM_SlotPayload(pageData, &slot, &payload, &payloadLength);
+    err = RM_ReadPayload(fh, payload, payloadLength, SLOT_HAS(&slot, SLOT_OVERFLOW),
+                         dataBuf, bufSize, dataLength);
+
+    // 4. Unfix the page (not dirty)
+    if ((pf_err = PF_UnfixPage(fh->pfFileDesc, pageNum, FALSE)) != PFE_OK) {
+        PF_PrintError("RM_GetRecord: PF_UnfixPage");
+        return pf_err;
     }
 
-    PageHeader *header = GET_HEADER(pageData);
+    return err;
+}
 
-    // 3. Check if RID is valid
-    if (slotNum >= header->numSlots) {
-        PF_UnfixPage(fh->pfFileDesc, pageNum, FALSE);
-        return RME_INVALIDRID;
+
+/*
+ * RM_FetchEntry: One RID of an RM_GetRecords call, with its position in
+ * the caller's array so the original order can be restored.
+ */
+typedef struct {
+    unsigned int rid;
+    int pos;
+} RM_FetchEntry;
+
+/*
+ * RM_FetchState: Records gathered by RM_GetRecords when the caller asked
+ * for its own order; they are copied into one arena and emitted at the end.
+ */
+typedef struct {
+    int keepOrder;
+    RM_ScanCallback callback;
+    void *arg;
+    char *arena;
+    int arenaSize, arenaUsed;
+    int *offsets;    // Per position: where its record starts in the arena
+    int *lengths;
+} RM_FetchState;
+
+static int RM_CompareFetch(const void *a, const void *b) {
+    const RM_FetchEntry *ea = a, *eb = b;
+    if (ea->rid != eb->rid)
+        return (ea->rid < eb->rid) ? -1 : 1;
+    return ea->pos - eb->pos;
+}
+
+/*
+ * RM_DeliverFetched
+ * Desc: Hands one fetched record to the callback, or keeps a copy of it
+ *       for later when the original order has to be restored.
+ */
+static int RM_DeliverFetched(RM_FetchState *st, RM_FetchEntry *e, char *rec, int recLength) {
+    char *newArena;
+    int newSize;
+
+    if (!st->keepOrder)
+        return (*st->callback)(st->arg, (RID)e->rid, rec, recLength);
+
+    if (st->arenaUsed + recLength > st->arenaSize) {
+        newSize = 2 * st->arenaSize + recLength;
+        if ((newArena = realloc(st->arena, newSize)) == NULL)
+            return RME_NOMEM;
+        st->arena = newArena;
+        st->arenaSize = newSize;
     }
+    memcpy(st->arena + st->arenaUsed, rec, recLength);
+    st->offsets[e->pos] = st->arenaUsed;
+    st->lengths[e->pos] = recLength;
+    st->arenaUsed += recLength;
+    return RME_OK;
+}
 
-    SlotEntry *slot = GET_SLOT(pageData, slotNum);
-    if (slot->recordLength == SLOT_EMPTY) {
-        PF_UnfixPage(fh->pfFileDesc, pageNum, FALSE);
-        return RME_INVALIDRID; // Record was deleted
+/*
+ * RM_DeliverSlot
+ * Desc: Delivers the record of a data slot (inline or in overflow pages).
+ */
+static int RM_DeliverSlot(RM_FileHandle *fh, RM_FetchState *st, RM_FetchEntry *e,
+                          char *pageData, SlotEntry *slot, char **spill, int *spillSize) {
+    char *payload;
+    int payloadLength, recLen, err;
+
+    RM_SlotPayload(pageData, slot, &payload, &payloadLength);
+    if (!SLOT_HAS(slot, SLOT_OVERFLOW))
+        return RM_DeliverFetched(st, e, payload, payloadLength);
+    if ((err = RM_LoadOverflow(fh, payload, spill, spillSize, &recLen)) != RME_OK)
+        return err;
+    return RM_DeliverFetched(st, e, *spill, recLen);
+}
+
+/*
+ * RM_FetchPage
+ * Desc: Fetches the records of entries [first, last), which all live on
+ *       one page of a slotted file, with a single fix of that page.
+ *       Forwarded records also fix the page they moved to.
+ */
+static int RM_FetchPage(RM_FileHandle *fh, RM_FetchEntry *entries, int first, int last,
+                        RM_FetchState *st, char **spill, int *spillSize) {
+    ForwardStub fwd;
+    SlotEntry slot, movedSlot;
+    char *pageData, *movedData, *payload;
+    int pageNum, slotNum, movedPage, movedSlotNum, payloadLength, err;
+
+    RM_UnpackRID((RID)entries[first].rid, &pageNum, &slotNum);
+    if ((err = RM_FixSlot(fh, pageNum, slotNum, FALSE, "RM_GetRecords: PF_GetThisPage",
+                          &pageData, &slot)) != RME_OK)
+        return err;
+
+    PageHeader header;
+    RM_GetHeader(pageData, &header);
+    for (int i = first; i < last && err == RME_OK; i++) {
+        RM_UnpackRID((RID)entries[i].rid, &pageNum, &slotNum);
+        if (slotNum >= header.numSlots) {
+            err = RME_INVALIDRID;
+            break;
+        }
+        RM_GetSlot(pageData, slotNum, &slot);
+        if (slot.recordLength == SLOT_EMPTY || SLOT_HAS(&slot, SLOT_MOVED)) {
+            err = RME_INVALIDRID;
+            break;
+        }
+        if (!SLOT_HAS(&slot, SLOT_FORWARD)) {
+            err = RM_DeliverSlot(fh, st, &entries[i], pageData, &slot, spill, spillSize);
+            continue;
+        }
+
+        // The record moved to another page
+        RM_SlotPayload(pageData, &slot, &payload, &payloadLength);
+        memcpy(&fwd, payload, sizeof(fwd));
+        RM_UnpackRID(fwd.target, &movedPage, &movedSlotNum);
+        if ((err = RM_FixSlot(fh, movedPage, movedSlotNum, TRUE, "RM_GetRecords: PF_GetThisPage",
+                              &movedData, &movedSlot)) != RME_OK)
+            break;
+        err = RM_DeliverSlot(fh, st, &entries[i], movedData, &movedSlot, spill, spillSize);
+        PF_UnfixPage(fh->pfFileDesc, movedPage, FALSE);
+    }
+
+    PF_UnfixPage(fh->pfFileDesc, pageNum, FALSE);
+    return err;
+}
+
+int RM_GetRecords(RM_FileHandle *fh, RID *rids, int numRids, int keepOrder,
+                  RM_ScanCallback callback, void *arg) {
+    RM_FetchEntry *entries;
+    RM_FetchState st;
+    char *spill = NULL;
+    char recBuf[RM_PAGE_SIZE];
+    int spillSize = 0, first, last, recLen, i, err = RME_OK;
+
+    if (numRids < 0 || callback == NULL)
+        return RME_INVALIDARG;
+    if (numRids == 0)
+        return RME_OK;
+
+    // 1. Sort the RIDs: records of one page become neighbours, and pages
+    //    are visited in file order
+    if ((entries = malloc(sizeof(RM_FetchEntry) * numRids)) == NULL)
+        return RME_NOMEM;
+    for (i = 0; i < numRids; i++) {
+        entries[i].rid = (unsigned int)rids[i];
+        entries[i].pos = i;
     }
+    qsort(entries, numRids, sizeof(RM_FetchEntry), RM_CompareFetch);
+
+    st.keepOrder = keepOrder;
+    st.callback = callback;
+    st.arg = arg;
+    st.arena = NULL;
+    st.arenaSize = st.arenaUsed = 0;
+    st.offsets = st.lengths = NULL;
+    if (keepOrder) {
+        st.offsets = malloc(sizeof(int) * numRids);
+        st.lengths = malloc(sizeof(int) * numRids);
+        if (st.offsets == NULL || st.lengths == NULL)
+            err = RME_NOMEM;
+    }
+
+    // 2. Fetch page by page, fixing each page once
+    for (first = 0; first < numRids && err == RME_OK; first = last) {
+        last = first + 1;
+        while (last < numRids && (entries[last].rid >> 16) == (entries[first].rid >> 16))
+            last++;
+
+        if (!RM_IS_SLOTTED(fh)) {
+            // PAX and fixed-length records are read one by one; the sort
+            // still makes repeated fetches of a page hit the buffer pool
+            for (i = first; i < last && err == RME_OK; i++) {
+                err = RM_GetRecord(fh, (RID)entries[i].rid, recBuf, sizeof(recBuf), &recLen);
+                if (err == RME_OK)
+                    err = RM_DeliverFetched(&st, &entries[i], recBuf, recLen);
+            }
+        } else {
+            err = RM_FetchPage(fh, entries, first, last, &st, &spill, &spillSize);
+        }
+    }
+
+    // 3. Emit in the caller's order if it was asked for
+    if (keepOrder) {
+        for (i = 0; i < numRids && err == RME_OK; i++)
+            err = (*callback)(arg, rids[i], st.arena + st.offsets[i], st.lengths[i]);
+    }
+
+    free(st.arena);
+    free(st.offsets);
+    free(st.lengths);
+    free(spill);
+    free(entries);
+    return err;
+}
+
 
-    // 4. Check if buffer is large enough
-    if (bufSize < slot->recordLength) {
+/* --- Record Streams --- */
+
+int RM_OpenRecordStream(RM_FileHandle *fh, RID rid, RM_RecordStream *rs) {
+    OverflowStub stub;
+    ForwardStub fwd;
+    SlotEntry slot;
+    char *pageData, *payload;
+    int err, pageNum, slotNum, payloadLength;
+
+    if (!RM_IS_SLOTTED(fh))
+        return RME_INVALIDARG;
+
+    // 1. Find the record's slot, following a forwarding stub
+    RM_UnpackRID(rid, &pageNum, &slotNum);
+    if ((err = RM_FixSlot(fh, pageNum, slotNum, FALSE, "RM_OpenRecordStream: PF_GetThisPage",
+                          &pageData, &slot)) != RME_OK)
+        return err;
+    if (SLOT_HAS(&slot, SLOT_FORWARD)) {
+        RM_SlotPayload(pageData, &slot, &payload, &payloadLength);
+        memcpy(&fwd, payload, sizeof(fwd));
         PF_UnfixPage(fh->pfFileDesc, pageNum, FALSE);
-        return RME_BUFTOOSMALL;
+        RM_UnpackRID(fwd.target, &pageNum, &slotNum);
+        if ((err = RM_FixSlot(fh, pageNum, slotNum, TRUE, "RM_OpenRecordStream: PF_GetThisPage",
+                              &pageData, &slot)) != RME_OK)
+            return err;
     }
 
-    // 5. Copy data to output buffer
-    memcpy(dataBuf, pageData + slot->recordOffset, slot->recordLength);
-    *dataLength = slot->recordLength;
+    // 2. Remember where its first byte is
+    RM_SlotPayload(pageData, &slot, &payload, &payloadLength);
+    rs->fileHandle = fh;
+    rs->position = 0;
+    rs->overflow = SLOT_IS_OVERFLOW(&slot);
+    if (rs->overflow) {
+        memcpy(&stub, payload, sizeof(stub));
+        rs->totalLength = stub.totalLength;
+        rs->page = stub.firstPage;
+        rs->offset = 0;
+    } else {
+        rs->totalLength = payloadLength;
+        rs->page = pageNum;
+        rs->offset = slotNum;
+    }
 
-    // 6. Unfix the page (not dirty)
-    if ((pf_err = PF_UnfixPage(fh->pfFileDesc, pageNum, FALSE)) != PFE_OK) {
-        PF_PrintError("RM_GetRecord: PF_UnfixPage");
-        return pf_err;
+    PF_UnfixPage(fh->pfFileDesc, pageNum, FALSE);
+    return RME_OK;
+}
+
+int RM_ReadRecordStream(RM_RecordStream *rs, char *buf, int bufSize, int *bytesRead) {
+    OverflowHeader *ovf;
+    SlotEntry slot;
+    char *pageData, *payload;
+    int pf_err, pageNum, payloadLength, chunk, fd = rs->fileHandle->pfFileDesc;
+
+    *bytesRead = 0;
+    if (rs->position >= rs->totalLength)
+        return RME_EOF;
+    if (bufSize <= 0)
+        return RME_INVALIDARG;
+
+    // 1. An inline record is copied from its page (re-fixed each call)
+    if (!rs->overflow) {
+        if ((pf_err = PF_GetThisPage(fd, rs->page, &pageData)) != PFE_OK) {
+            PF_PrintError("RM_ReadRecordStream: PF_GetThisPage");
+            return pf_err;
+        }
+        RM_GetSlot(pageData, rs->offset, &slot);
+        RM_SlotPayload(pageData, &slot, &payload, &payloadLength);
+        chunk = rs->totalLength - rs->position;
+        if (chunk > bufSize)
+            chunk = bufSize;
+        memcpy(buf, payload + rs->position, chunk);
+        PF_UnfixPage(fd, rs->page, FALSE);
+        rs->position += chunk;
+        *bytesRead = chunk;
+        return RME_OK;
     }
 
+    // 2. Otherwise walk the chain, one page fixed at a time
+    while (*bytesRead < bufSize && rs->position < rs->totalLength) {
+        pageNum = rs->page;
+        if ((pf_err = PF_GetThisPage(fd, pageNum, &pageData)) != PFE_OK) {
+            PF_PrintError("RM_ReadRecordStream: PF_GetThisPage");
+            return pf_err;
+        }
+        ovf = (OverflowHeader *)pageData;
+        chunk = ovf->length - rs->offset;
+        if (chunk > bufSize - *bytesRead)
+            chunk = bufSize - *bytesRead;
+        memcpy(buf + *bytesRead, pageData + sizeof(OverflowHeader) + rs->offset, chunk);
+        *bytesRead += chunk;
+        rs->position += chunk;
+        rs->offset += chunk;
+        if (rs->offset == ovf->length) {
+            // Page used up: continue on the next one
+            rs->page = ovf->nextPage;
+            rs->offset = 0;
+        }
+        PF_UnfixPage(fd, pageNum, FALSE);
+    }
+    return RME_OK;
+}
+
+int RM_CloseRecordStream(RM_RecordStream *rs) {
+    rs->position = rs->totalLength;
     return RME_OK;
 }
 
 
 /* --- Scanning --- */
 
-int RM_OpenScan(RM_FileHandle *fh, RM_ScanHandle *sh) {
+int RM_OpenScan(RM_FileHandle *fh, RM_ScanHandle *sh, RM_Filter *filter, RM_Projection *proj) {
+    return RM_OpenRangeScan(fh, sh, filter, proj, RM_FIRST_DATA_PAGE, RM_SCAN_TO_EOF);
+}
+
+int RM_OpenRangeScan(RM_FileHandle *fh, RM_ScanHandle *sh, RM_Filter *filter,
+                     RM_Projection *proj, int firstPage, int lastPage) {
+    int numPages;
+
+    if (firstPage < 0 || (lastPage != RM_SCAN_TO_EOF && lastPage < firstPage))
+        return RME_INVALIDARG;
+    if (firstPage < RM_FIRST_DATA_PAGE)
+        firstPage = RM_FIRST_DATA_PAGE;
+    if (lastPage != RM_SCAN_TO_EOF && lastPage < firstPage)
+        lastPage = firstPage; // Empty range
+
+    // A bounded range never reaches past the pages that exist now
+    if (lastPage != RM_SCAN_TO_EOF) {
+        if ((numPages = PF_GetNumPages(fh->pfFileDesc)) < 0) {
+            PF_PrintError("RM_OpenRangeScan: PF_GetNumPages");
+            return numPages;
+        }
+        if (lastPage > numPages)
+            lastPage = numPages;
+    }
+
     sh->fileHandle = fh;
-    sh->currentPage = -1; // Will start with PF_GetNextPage (or First)
+    sh->firstPage = firstPage;
+    sh->lastPage = lastPage;
+    sh->currentPage = firstPage - 1; // The first advance lands on firstPage
     sh->currentSlot = -1; // Start before the first slot
     sh->pageData = NULL;  // No page is pinned yet
+    sh->pinned = FALSE;
+    sh->filter = filter;
+    sh->proj = proj;
     return RME_OK;
 }
 
-int RM_GetNextRecord(RM_ScanHandle *sh, RID *rid, char *dataBuf, int bufSize, int *dataLength) {
-    int pf_err;
+/*
+ * RM_ScanNextPage
+ * Desc: Moves the scan to the next used page, unfixing the one it was on.
+ *       Open-ended scans follow PF_GetNextPage; ranged scans fetch each
+ *       page number below lastPage directly and check its type with
+ *       PF_CopyPage first, so they only ever fix the data pages of their
+ *       own range. Overflow pages are skipped.
+ * Returns: RME_OK, RME_EOF or a PF error code
+ */
+int RM_ScanNextPage(RM_ScanHandle *sh, char *caller) {
+    int pf_err, pageType;
     RM_FileHandle *fh = sh->fileHandle;
 
+    // Release the page we were on (if any)
+    if (sh->pinned) {
+        PF_UnfixPage(fh->pfFileDesc, sh->currentPage, FALSE);
+        sh->pinned = FALSE;
+    }
+    sh->pageData = NULL;
+
     while (TRUE) {
-        // 1. Check if we need to get a new page
-        if (sh->pageData == NULL) {
-            int oldPage = sh->currentPage;
-
-            if (sh->currentPage == -1) { // First call
-                pf_err = PF_GetFirstPage(fh->pfFileDesc, &sh->currentPage, &sh->pageData);
-            } else { // Subsequent calls
-                pf_err = PF_GetNextPage(fh->pfFileDesc, &sh->currentPage, &sh->pageData);
-                // Unfix the *previous* page (if it existed)
-                if (oldPage != -1) {
-                    PF_UnfixPage(fh->pfFileDesc, oldPage, FALSE);
-                }
+        if (sh->lastPage == RM_SCAN_TO_EOF) {
+            pf_err = PF_GetNextPage(fh->pfFileDesc, &sh->currentPage, &sh->pageData);
+        } else {
+            pf_err = PFE_EOF;
+            while (sh->currentPage + 1 < sh->lastPage) {
+                sh->currentPage++;
+                // Look at the page type first: an overflow page may be
+                // read by the scan of the range holding its stub
+                pf_err = PF_CopyPage(fh->pfFileDesc, sh->currentPage, (char *)&pageType, sizeof(pageType));
+                if (pf_err == PFE_OK && RM_IS_SLOTTED(fh) && pageType == RM_PAGE_OVERFLOW)
+                    pf_err = PFE_INVALIDPAGE;
+                else if (pf_err == PFE_OK)
+                    pf_err = PF_GetThisPage(fh->pfFileDesc, sh->currentPage, &sh->pageData);
+                if (pf_err != PFE_INVALIDPAGE)
+                    break;
+                pf_err = PFE_EOF; // Free or overflow page, keep going
             }
+        }
 
-            if (pf_err == PFE_EOF) return RME_EOF; // No more pages
-            if (pf_err != PFE_OK) {
-                PF_PrintError("RM_GetNextRecord: PF_GetFirst/NextPage");
-                return pf_err;
-            }
-            
-            sh->currentSlot = -1; // Reset slot scan for the new page
+        if (pf_err == PFE_EOF) return RME_EOF; // No more pages
+        if (pf_err != PFE_OK) {
+            sh->pageData = NULL;
+            PF_PrintError(caller);
+            return pf_err;
+        }
+
+        // Overflow pages are reached through their stubs, not scanned
+        if (!RM_IS_SLOTTED(fh) || IS_DATA_PAGE(sh->pageData))
+            break;
+        PF_UnfixPage(fh->pfFileDesc, sh->currentPage, FALSE);
+        sh->pageData = NULL;
+    }
+
+    sh->pinned = TRUE;
+    sh->currentSlot = -1; // Reset slot scan for the new page
+    return RME_OK;
+}
+
+/*
+ * RM_ScanRID
+ * Desc: The RID a scan reports for the record of the current slot: its
+ *       home RID if the record was moved there by an update.
+ */
+static RID RM_ScanRID(RM_ScanHandle *sh, SlotEntry *slot) {
+    RID home;
+
+    if (!SLOT_HAS(slot, SLOT_MOVED))
+        return RM_PackRID(sh->currentPage, sh->currentSlot);
+    memcpy(&home, sh->pageData + slot->recordOffset, sizeof(RID));
+    return home;
+}
+
+/*
+ * RM_NextOverflowRecord
+ * Desc: RM_GetNextRecord for a slot that holds an overflow stub. The
+ *       record is read straight into dataBuf when it is returned whole;
+ *       a filter or projection needs it in a temporary buffer first.
+ * Returns: RME_OK, RME_EOF if the filter rejects it, or an error code
+ */
+static int RM_NextOverflowRecord(RM_ScanHandle *sh, char *stubPtr, char *dataBuf,
+                                 int bufSize, int *dataLength) {
+    OverflowStub stub;
+    char *rec = NULL;
+    int recSize = 0, recLen, err;
+
+    memcpy(&stub, stubPtr, sizeof(stub));
+    if (sh->filter == NULL && sh->proj == NULL) {
+        if (bufSize < stub.totalLength) {
+            *dataLength = stub.totalLength;
+            return RME_BUFTOOSMALL;
+        }
+        if ((err = RM_CopyOverflow(sh->fileHandle, &stub, dataBuf)) != RME_OK)
+            return err;
+        *dataLength = stub.totalLength;
+        return RME_OK;
+    }
+
+    err = RM_LoadOverflow(sh->fileHandle, (char *)&stub, &rec, &recSize, &recLen);
+    if (err == RME_OK && !RM_EvalFilter(sh->filter, rec, recLen))
+        err = RME_EOF;
+    else if (err == RME_OK && sh->proj != NULL)
+        err = RM_Project(sh->proj, rec, recLen, dataBuf, bufSize, dataLength);
+    else if (err == RME_OK && bufSize < recLen) {
+        *dataLength = recLen;
+        err = RME_BUFTOOSMALL;
+    }
+    else if (err == RME_OK) {
+        memcpy(dataBuf, rec, recLen);
+        *dataLength = recLen;
+    }
+    free(rec);
+    return err;
+}
+
+int RM_GetNextRecord(RM_ScanHandle *sh, RID *rid, char *dataBuf, int bufSize, int *dataLength) {
+    int err;
+
+    if (sh->fileHandle->format == RM_FMT_PAX)
+        return RM_PaxGetNextRecord(sh, rid, dataBuf, bufSize, dataLength);
+    if (sh->fileHandle->format == RM_FMT_FIXED)
+        return RM_FixedGetNextRecord(sh, rid, dataBuf, bufSize, dataLength);
+
+    while (TRUE) {
+        // 1. Check if we need to get a new page
+        if (sh->pageData == NULL) {
+            if ((err = RM_ScanNextPage(sh, "RM_GetNextRecord: PF_GetFirst/NextPage")) != RME_OK)
+                return err;
         }
 
         // 2. We have a page, scan its slots
-        PageHeader *header = GET_HEADER(sh->pageData);
+        PageHeader header;
+        RM_GetHeader(sh->pageData, &header);
         sh->currentSlot++;
 
-        if (sh->currentSlot < header->numSlots) {
+        if (sh->currentSlot < header.numSlots) {
             // 2a. Check this slot
-            SlotEntry *slot = GET_SLOT(sh->pageData, sh->currentSlot);
-            if (slot->recordLength != SLOT_EMPTY) {
-                // Found a valid record!
-                if (bufSize < slot->recordLength) {
-                    return RME_BUFTOOSMALL;
+            SlotEntry slot;
+            RM_GetSlot(sh->pageData, sh->currentSlot, &slot);
+            if (slot.recordLength != SLOT_EMPTY && !SLOT_HAS(&slot, SLOT_FORWARD)) {
+                char *rec;
+                int recLen;
+                RM_SlotPayload(sh->pageData, &slot, &rec, &recLen);
+
+                // A large record is read from its overflow chain
+                if (SLOT_IS_OVERFLOW(&slot)) {
+                    err = RM_NextOverflowRecord(sh, rec, dataBuf, bufSize, dataLength);
+                    if (err == RME_EOF)
+                        continue; // Rejected by the filter
+                    if (err == RME_BUFTOOSMALL)
+                        sh->currentSlot--; // Returned again by the next call
+                    if (err != RME_OK)
+                        return err;
+                    *rid = RM_ScanRID(sh, &slot);
+                    return RME_OK;
+                }
+
+                // Evaluate the filter in place; rejects are never copied
+                if (!RM_EvalFilter(sh->filter, rec, recLen))
+                    continue;
+
+                // Found a qualifying record!
+                if (sh->proj != NULL) {
+                    err = RM_Project(sh->proj, rec, recLen,
+                                     dataBuf, bufSize, dataLength);
+                    if (err == RME_BUFTOOSMALL)
+                        sh->currentSlot--; // Returned again by the next call
+                    if (err != RME_OK)
+                        return err;
+                } else {
+                    if (bufSize < recLen) {
+                        *dataLength = recLen;
+                        sh->currentSlot--; // Returned again by the next call
+                        return RME_BUFTOOSMALL;
+                    }
+                    // Copy data
+                    memcpy(dataBuf, rec, recLen);
+                    *dataLength = recLen;
                 }
-                // Copy data
-                memcpy(dataBuf, sh->pageData + slot->recordOffset, slot->recordLength);
-                *dataLength = slot->recordLength;
                 
-                // Set the output RID (PACKED)
-                *rid = RM_PackRID(sh->currentPage, sh->currentSlot);
+                // Set the output RID (PACKED; the home RID of a moved record)
+                *rid = RM_ScanRID(sh, &slot);
                 
                 return RME_OK; // Success!
             }
-            // else, slot was empty, loop continues to next slot
+            // else, slot was empty or a forwarding stub, loop continues to next slot
         } else {
             // 2b. Reached end of slots for this page
             //    Flag to fetch a new page on the next loop iteration
@@ -360,14 +1707,133 @@ int RM_GetNextRecord(RM_ScanHandle *sh, RID *rid, char *dataBuf, int bufSize, in
     }
 }
 
+int RM_GetNextRecordAlloc(RM_ScanHandle *sh, RID *rid, char **buf, int *bufSize, int *dataLength) {
+    char *bigger;
+    int err, newSize;
+
+    while (TRUE) {
+        *dataLength = 0; // A PAX scan does not set it on RME_BUFTOOSMALL
+        if ((err = RM_GetNextRecord(sh, rid, *buf, *bufSize, dataLength)) != RME_BUFTOOSMALL)
+            return err;
+
+        // The record stays in the scan until the buffer can hold it
+        newSize = (*dataLength > *bufSize) ? *dataLength : 2 * *bufSize;
+        if ((bigger = realloc(*buf, newSize)) == NULL)
+            return RME_NOMEM;
+        *buf = bigger;
+        *bufSize = newSize;
+    }
+}
+
+int RM_GetNextBatch(RM_ScanHandle *sh, RM_Batch *batch) {
+    int err, n;
+
+    batch->numRecords = 0;
+
+    // The batch points into the page, so there is nothing to project into
+    // (and a PAX page has no whole records to point at)
+    if (sh->proj != NULL || batch->capacity <= 0 || sh->fileHandle->format == RM_FMT_PAX)
+        return RME_INVALIDARG;
+    if (sh->fileHandle->format == RM_FMT_FIXED)
+        return RM_FixedGetNextBatch(sh, batch);
+
+    while (TRUE) {
+        // 1. Move to the next page once the current one is drained
+        if (sh->pageData == NULL) {
+            if ((err = RM_ScanNextPage(sh, "RM_GetNextBatch: PF_GetFirst/NextPage")) != RME_OK)
+                return err;
+        }
+
+        // 2. Collect qualifying slots of this page, up to the capacity
+        PageHeader header;
+        RM_GetHeader(sh->pageData, &header);
+        n = 0;
+        while (n < batch->capacity && sh->currentSlot + 1 < header.numSlots) {
+            SlotEntry slot;
+            RM_GetSlot(sh->pageData, ++sh->currentSlot, &slot);
+            if (slot.recordLength == SLOT_EMPTY || SLOT_HAS(&slot, SLOT_FORWARD))
+                continue;
+
+            char *rec;
+            int recLen;
+            RM_SlotPayload(sh->pageData, &slot, &rec, &recLen);
+
+            // A large record is read into the batch's spill buffer and
+            // ends the batch, as the buffer holds only one
+            if (SLOT_IS_OVERFLOW(&slot)) {
+                err = RM_LoadOverflow(sh->fileHandle, rec, &batch->spill, &batch->spillSize, &recLen);
+                if (err != RME_OK)
+                    return err;
+                if (!RM_EvalFilter(sh->filter, batch->spill, recLen))
+                    continue;
+                batch->rids[n] = RM_ScanRID(sh, &slot);
+                batch->recPtrs[n] = batch->spill;
+                batch->lengths[n] = recLen;
+                n++;
+                break;
+            }
+
+            if (!RM_EvalFilter(sh->filter, rec, recLen))
+                continue;
+
+            batch->rids[n] = RM_ScanRID(sh, &slot);
+            batch->recPtrs[n] = rec;
+            batch->lengths[n] = recLen;
+            n++;
+        }
+
+        // 3. Hand back what we found; the page stays pinned until the
+        //    next call, so the pointers remain valid for the caller
+        if (n > 0) {
+            batch->numRecords = n;
+            return RME_OK;
+        }
+
+        // Drained without a match: move on to the next page
+        sh->pageData = NULL;
+    }
+}
+
 int RM_CloseScan(RM_ScanHandle *sh) {
-    // Unfix the last page we were holding (if any)
-    if (sh->pageData != NULL) {
+    // Unfix the last page we were holding (if any). A drained page is
+    // still pinned even though pageData has been cleared.
+    if (sh->pinned) {
+        sh->pinned = FALSE;
+        sh->pageData = NULL;
         if (PF_UnfixPage(sh->fileHandle->pfFileDesc, sh->currentPage, FALSE) != PFE_OK) {
             PF_PrintError("RM_CloseScan: PF_UnfixPage");
             return PFerrno;
         }
-        sh->pageData = NULL;
     }
     return RME_OK; /* RKE_OK might be a typo, should be RME_OK */
-}
\ No newline at end of file
+}
+
+/* --- Batches --- */
+
+int RM_InitBatch(RM_Batch *batch, int capacity) {
+    batch->capacity = capacity;
+    batch->numRecords = 0;
+    batch->spill = NULL;
+    batch->spillSize = 0;
+    batch->rids = malloc(sizeof(RID) * capacity);
+    batch->recPtrs = malloc(sizeof(char *) * capacity);
+    batch->lengths = malloc(sizeof(int) * capacity);
+    if (batch->rids == NULL || batch->recPtrs == NULL || batch->lengths == NULL) {
+        RM_FreeBatch(batch);
+        return RME_NOMEM;
+    }
+    return RME_OK;
+}
+
+void RM_FreeBatch(RM_Batch *batch) {
+    free(batch->rids);
+    free(batch->recPtrs);
+    free(batch->lengths);
+    free(batch->spill);
+    batch->rids = NULL;
+    batch->recPtrs = NULL;
+    batch->lengths = NULL;
+    batch->spill = NULL;
+    batch->spillSize = 0;
+    batch->capacity = 0;
+}
@@ -13,25 +13,365 @@
  */
 typedef int RID;
 
+/* Attribute types of a typed (schema) record */
+#define RM_INT     'i'  /* 4-byte int */
+#define RM_FLOAT   'f'  /* 4-byte float */
+#define RM_CHAR    'c'  /* Fixed-length string, NUL-padded */
+#define RM_VARCHAR 'v'  /* Variable-length string up to a maximum */
+
+#define RM_MAXATTRS 32  /* Max attributes in one schema */
+#define RM_MAXNAME  24  /* Max attribute name length, NUL included */
+
+/* RM_Attr: One attribute of a schema */
+typedef struct {
+    char name[RM_MAXNAME];
+    char type;      // RM_INT, RM_FLOAT, RM_CHAR or RM_VARCHAR
+    int length;     // Bytes for 'c', max bytes for 'v', 4 for 'i'/'f'
+} RM_Attr;
+
+/*
+ * RM_Schema: Attribute list of a typed RM file.
+ *
+ * A typed record is laid out as
+ *   [null bitmap][offset table][field data]
+ * The bitmap has one bit per attribute (set = NULL). The offset table
+ * holds numAttrs+1 unsigned shorts: field i occupies bytes
+ * off[i] .. off[i+1]-1 of the record, so any field is found with two
+ * loads and no parsing. NULL fields are empty. Ints and floats are
+ * stored in native byte order.
+ */
+typedef struct {
+    int numAttrs;
+    RM_Attr attrs[RM_MAXATTRS];
+} RM_Schema;
+
+/* Page layouts of an RM file, recorded in its header page */
+#define RM_FMT_SLOTTED 0  /* Slotted pages, whole records (the default) */
+#define RM_FMT_PAX     1  /* Typed records split into per-attribute minipages */
+#define RM_FMT_COMPACT 2  /* Slotted pages with 2-byte header fields and slots */
+#define RM_FMT_FIXED   3  /* Records of one length, presence bitmap, no slots */
+
+/*
+ * RM_PaxLayout: Where each attribute's minipage sits in a PAX page.
+ * Derived from the schema when the file is opened. Every page has
+ * room for 'capacity' records; attribute a keeps a null bitmap at
+ * nullOff[a] and 'capacity' values of width[a] bytes at valOff[a].
+ * A varchar value is a 2-byte length followed by its maximum size.
+ */
+typedef struct {
+    int capacity;               // Records per page
+    int presentOff;             // Bitmap of used slots
+    int nullOff[RM_MAXATTRS];
+    int valOff[RM_MAXATTRS];    // 4-byte aligned
+    int width[RM_MAXATTRS];
+} RM_PaxLayout;
+
+/*
+ * RM_FixedLayout: Shape of an RM_FMT_FIXED page. A presence bitmap of
+ * 64-bit words follows the page header and record i of the page starts
+ * at dataOff + i * recordLength.
+ */
+typedef struct {
+    int recordLength;           // Length of every record
+    int capacity;               // Records per page
+    int dataOff;                // Start of record 0
+} RM_FixedLayout;
+
 /*
  * RM_FileHandle: File Handle
  * This struct stores information about an open RM file.
  */
 typedef struct {
     int pfFileDesc; // The file descriptor from the PF layer
+    int insertPage; // Page the last insert went to (-1 = none yet)
+    short *roomMap; // Free-space map: a max-tree over the room left on
+    int roomLeaves; // each page (NULL/0 until the first insert search)
+    int format;     // RM_FMT_* from the header page
+    RM_Schema schema; // Record schema (numAttrs == 0 = untyped bytes)
+    RM_PaxLayout pax; // Page layout, for RM_FMT_PAX files
+    RM_FixedLayout fixed; // Page layout, for RM_FMT_FIXED files
 } RM_FileHandle;
 
+/* Comparison operators for scan predicates (same numbering as the AM ops) */
+#define RM_EQ 1
+#define RM_LT 2
+#define RM_GT 3
+#define RM_LE 4
+#define RM_GE 5
+#define RM_NE 6
+
+#define RM_MAXPREDS  8   /* Max predicates in one filter */
+#define RM_MAXPROJ   16  /* Max fields in one projection */
+#define RM_MAXVALLEN 64  /* Max length of a 'c' predicate constant */
+
+/*
+ * RM_Predicate: One compiled comparison "field <op> constant".
+ * The constant is converted to its native type once, when the
+ * predicate is added, so the scan never re-parses it per record.
+ */
+typedef struct {
+    int field;                  // 0-based field number in the record
+    char attrType;              // 'i', 'f' or 'c'
+    int op;                     // RM_EQ ... RM_NE
+    int intVal;                 // Constant for 'i'
+    float floatVal;             // Constant for 'f'
+    char strVal[RM_MAXVALLEN];  // Constant for 'c' (not NUL-terminated)
+    int strLen;
+} RM_Predicate;
+
+/*
+ * RM_Filter: A conjunction (AND) of predicates over the fields of
+ * delimited records, or of typed records when a schema is attached.
+ * It is evaluated against the record bytes while they are still in
+ * the pinned page.
+ */
+typedef struct {
+    char delim;     // Field separator, e.g. ';'
+    RM_Schema *schema; // Non-NULL: fields are typed attributes
+    int numPreds;
+    RM_Predicate preds[RM_MAXPREDS];
+} RM_Filter;
+
+/*
+ * RM_Projection: The list of fields a scan hands back, in output order.
+ * The selected fields are re-joined with the same delimiter.
+ */
+typedef struct {
+    char delim;
+    int numFields;
+    int fields[RM_MAXPROJ];
+} RM_Projection;
+
+#define RM_FIRST_DATA_PAGE 1  /* Page 0 holds the file header */
+#define RM_SCAN_TO_EOF -1  /* lastPage of a scan that runs to the end */
+#define RM_MAXTHREADS  64  /* Max workers of one RM_ParallelScan */
+
 /*
  * RM_ScanHandle: Scan Handle
  * This struct stores the state of an ongoing scan.
  */
 typedef struct {
     RM_FileHandle *fileHandle;
+    int firstPage;   // First page of the scanned range
+    int lastPage;    // End of the range (exclusive), or RM_SCAN_TO_EOF
     int currentPage; // The page number of the page we are scanning
     int currentSlot; // The slot number of the next record to check
     char *pageData;    // Pinned page buffer from PF layer
+    int pinned;        // TRUE while currentPage is fixed in the buffer
+    RM_Filter *filter;     // Optional filter (NULL = every record)
+    RM_Projection *proj;   // Optional projection (NULL = whole record)
 } RM_ScanHandle;
 
+/*
+ * RM_Batch: Column-wise output of RM_GetNextBatch.
+ * The caller provides the arrays (see RM_InitBatch). Entry i describes
+ * one record: its RID, a pointer to its bytes inside the pinned page and
+ * its length. The pointers stay valid until the next call on the scan.
+ * A record stored in overflow pages is read into the spill buffer; it is
+ * always the last entry of its batch.
+ */
+typedef struct {
+    int capacity;    // Size of the arrays below
+    int numRecords;  // (out) Entries filled by the last call
+    RID *rids;
+    char **recPtrs;
+    int *lengths;
+    char *spill;     // Holds one large record (grown as needed)
+    int spillSize;
+} RM_Batch;
+
+/*
+ * RM_RecordStream: A record read piecewise (see RM_OpenRecordStream),
+ * so a large record never needs a buffer of its full size.
+ */
+typedef struct {
+    RM_FileHandle *fileHandle;
+    int totalLength;  // Length of the whole record
+    int position;     // Bytes already returned
+    int overflow;     // TRUE if the record lives in overflow pages
+    int page;         // Page holding the next byte (the slot's page if inline)
+    int offset;       // Slot number if inline, else offset of the next byte in page's data
+} RM_RecordStream;
+
+
+/*
+ * RM_ScanCallback: Called by RM_ParallelScan for every qualifying record
+ * (and by RM_GetRecords for every fetched one, with its own arg).
+ * rec points into a page pinned by the calling worker (for PAX files,
+ * into the worker's own record buffer) and is only valid during the
+ * call. arg is that worker's own entry of the args array, so per-thread
+ * state (counters, output buffers) needs no locking.
+ * Returning anything but RME_OK stops that worker.
+ */
+typedef int (*RM_ScanCallback)(void *arg, RID rid, char *rec, int recLength);
+
+
+/*
+ * RM_Column: One page's worth of a single attribute, from
+ * RM_GetNextColumn. Slot i of the page holds a record if bit i of
+ * 'present' is set; its value is NULL if bit i of 'nulls' is set, and
+ * otherwise starts at values + i * width. All pointers refer to the
+ * pinned page and stay valid until the next call on the scan.
+ */
+typedef struct {
+    int pageNum;
+    int numSlots;           // Slots to look at (0 .. numSlots-1)
+    int width;              // Bytes per value
+    unsigned char *present;
+    unsigned char *nulls;
+    char *values;
+} RM_Column;
+
+#define RM_BITSET(bitmap, i) ((bitmap)[(i) / 8] & (1 << ((i) % 8)))
+
+
+#define RM_ZONELEN 16  /* Max bytes of a string zone-map bound */
+
+/*
+ * RM_ZoneMap: Min and max of the non-NULL values on one column page.
+ * Bounds are kept in the stored form (4 native bytes for 'i'/'f', the
+ * string bytes for 'c'/'v'). A page holding a string longer than
+ * RM_ZONELEN is left unbounded and can never be skipped.
+ */
+typedef struct {
+    int numValues;          // Non-NULL values (0 = every value is NULL)
+    int bounded;            // FALSE: min/max are not usable
+    short minLen;
+    short maxLen;
+    char min[RM_ZONELEN];
+    char max[RM_ZONELEN];
+} RM_ZoneMap;
+
+/* RM_ColDirEntry: Directory entry for one data page of a column */
+typedef struct {
+    int pageNum;
+    int firstRow;           // Row number of the page's first value
+    int count;              // Values on the page, NULLs included
+    RM_ZoneMap zone;
+} RM_ColDirEntry;
+
+/*
+ * RM_ColumnInfo: The two page chains of one column of a column file:
+ * the data pages, in row order, and a directory holding a copy of
+ * each data page's zone map so a scan can rule pages out unread.
+ */
+typedef struct {
+    int firstPage;          // Data chain (-1 = no rows yet)
+    int lastPage;
+    int firstDirPage;       // Directory chain
+    int lastDirPage;
+    int numPages;           // Data pages (= directory entries)
+    int lastCount;          // Values on lastPage
+    int capacity;           // Values per data page
+} RM_ColumnInfo;
+
+/*
+ * RM_ColFileHandle: An open column file. Each attribute of the schema
+ * is stored in its own chain of pages; rows are numbered 0, 1, ... in
+ * insertion order and row r of every column is the same record.
+ */
+typedef struct {
+    int pfFileDesc;
+    int numRows;
+    RM_Schema schema;
+    RM_ColumnInfo cols[RM_MAXATTRS];
+    int dirty;              // Rows added since the header was written
+} RM_ColFileHandle;
+
+/*
+ * RM_ColScanHandle: State of a column scan. Only the columns named by
+ * the filter or the projection are touched; for each of them the scan
+ * holds its directory in memory and pins at most one data page.
+ */
+typedef struct {
+    RM_ColFileHandle *fileHandle;
+    RM_Filter *filter;
+    int numCols;                        // Projected attributes
+    int cols[RM_MAXPROJ];
+    int nextRow;
+    RM_ColDirEntry *dir[RM_MAXATTRS];   // NULL for untouched columns
+    int entry[RM_MAXATTRS];             // Directory entry of nextRow
+    int pinnedPage[RM_MAXATTRS];        // -1 = none
+    char *pageData[RM_MAXATTRS];
+    long pagesRead;         // (stats) Data pages fixed
+    long pagesSkipped;      // (stats) Data pages ruled out by zone maps
+} RM_ColScanHandle;
+
+/*
+ * RM_DelimFile: A delimited text file mapped into memory and cut into
+ * records and fields in place. Every field ends in the delimiter and a
+ * record ends with one more at the end of a line, so a record may span
+ * several lines (the format of the tables in data/). The mapping is
+ * private: delimiters are overwritten with NULs, the file is not.
+ */
+typedef struct {
+    char *text;             // File contents
+    long size;
+    int mapped;             // TRUE: text is mmap'ed, FALSE: malloc'ed
+    int numRecords;
+    int numAttrs;           // Most fields in one record, up to RM_MAXATTRS
+    char **values;          // Fields of every record, back to back
+    int *first;             // Record r: values[first[r] .. first[r+1]-1]
+} RM_DelimFile;
+
+#define RM_BULK_PAGES 64    /* Pages built in memory per write */
+
+/*
+ * RM_BulkLoader: An append-only load into a slotted RM file. Records
+ * are packed into pages in memory, and RM_BULK_PAGES pages at a time
+ * are written to the end of the file with PF_AppendPages, so the load
+ * neither searches for free space nor goes through the buffer pool.
+ */
+typedef struct {
+    RM_FileHandle *fileHandle;
+    char *pages;            // RM_BULK_PAGES pages (NULL: not slotted)
+    int numPages;           // Pages started; the last one is filling
+    int firstPage;          // Page number pages[0] will get
+    long numRecords;        // Records loaded so far
+} RM_BulkLoader;
+
+/* RM_RidMap: Where RM_VacuumFile moved one record */
+typedef struct {
+    RID oldRid;
+    RID newRid;
+} RM_RidMap;
+
+#define RM_MAXORDER 8       /* Max keys in one ORDER BY */
+
+/*
+ * RM_OrderBy: The sort keys of an ORDER BY over delimited records, or
+ * over typed records when a schema is attached. Keys are compared in
+ * the order they were added; a record missing a key field (or with a
+ * NULL one) sorts first on it.
+ */
+typedef struct {
+    char delim;
+    RM_Schema *schema;      // Non-NULL: fields are typed attributes
+    int numKeys;
+    int fields[RM_MAXORDER];
+    char attrTypes[RM_MAXORDER]; // 'i', 'f' or 'c'
+    int descending[RM_MAXORDER];
+} RM_OrderBy;
+
+/* Three-way comparison of two items of an external sort */
+typedef int (*RM_SortCompareFcn)(void *arg, char *a, int aLen, char *b, int bLen);
+
+#define RM_SORT_MINFRAMES 6 /* Fewest frames an external sort runs in */
+#define RM_SORT_BLOCK 8     /* Pages per run read or write */
+
+/*
+ * RM_Sort: An external merge sort of byte strings. Items are kept in
+ * memory while they fit in the sort's frames; beyond that they are
+ * written out as sorted runs to a temporary PF file and merged back.
+ * The state lives in rmsort.c.
+ */
+typedef struct {
+    struct RM_SortState *state;
+    long numItems;          // Items added
+    int numRuns;            // Runs written by run generation (0: in memory)
+    int numPasses;          // Merge passes over the data, the last included
+} RM_Sort;
+
 
 /* Error codes */
 #define RME_OK         0
@@ -39,6 +379,11 @@ typedef struct {
 #define RME_NOMEM     -2
 #define RME_BUFTOOSMALL -3 /* Provided buffer is too small */
 #define RME_INVALIDRID -4  /* Record (page/slot) does not exist */
+#define RME_INVALIDARG -5  /* Bad filter/projection parameters */
+#define RME_NULLFIELD  -6  /* Typed field is NULL */
+#define RME_NOTRMFILE  -7  /* File has no valid RM header page */
+#define RME_RECTOOLARGE -8 /* Record does not fit in an empty page */
+#define RME_NOTCOLFILE -9  /* File has no valid column-file header page */
 #define RME_ERROR     -99 /* A generic error */
 
 
@@ -61,10 +406,45 @@ void RM_UnpackRID(RID rid, int *pageNum, int *slotNum);
 
 /*
  * RM_CreateFile
- * Desc: Creates a new paged file for the record manager.
+ * Desc: Creates a new paged file for the record manager. Page 0 of every
+ *       RM file is a header page; records start on page 1.
  */
 int RM_CreateFile(char *fileName);
 
+/*
+ * RM_CreateTypedFile
+ * Desc: Creates a slotted RM file whose header records the given schema.
+ *       The schema is handed back by RM_GetSchema after RM_OpenFile.
+ * Params: (RM_Schema*) schema - NULL for an untyped file
+ * Returns: RME_OK or a PF error code
+ */
+int RM_CreateTypedFile(char *fileName, RM_Schema *schema);
+
+/*
+ * RM_CreateFileFormat
+ * Desc: Creates an RM file with the given page layout. RM_FMT_PAX needs
+ *       a schema, and at least one record of it must fit in a page with
+ *       every varchar at its maximum length. RM_FMT_COMPACT stores the
+ *       same slotted pages with half-size slot entries, so more small
+ *       records fit in a page. RM_FMT_FIXED files are made with
+ *       RM_CreateFixedFile. The layout is picked up by RM_OpenFile;
+ *       the record API is the same for all formats.
+ * Returns: RME_OK, RME_INVALIDARG or a PF error code
+ */
+int RM_CreateFileFormat(char *fileName, int format, RM_Schema *schema);
+
+/*
+ * RM_CreateFixedFile
+ * Desc: Creates an RM_FMT_FIXED file, in which every record is exactly
+ *       recordLength bytes. Pages have no slot directory: a bitmap marks
+ *       the used places and a record's offset follows from its slot
+ *       number. Records of any other length are refused.
+ * Params: (RM_Schema*) schema - NULL for an untyped file
+ * Returns: RME_OK, RME_INVALIDARG (no record fits in a page) or a PF
+ *          error code
+ */
+int RM_CreateFixedFile(char *fileName, int recordLength, RM_Schema *schema);
+
 /*
  * RM_DestroyFile
  * Desc: Destroys an existing RM file.
@@ -73,8 +453,8 @@ int RM_DestroyFile(char *fileName);
 
 /*
  * RM_OpenFile
- * Desc: Opens an RM file.
- * Returns: RME_OK or a PF error code
+ * Desc: Opens an RM file and loads its header page.
+ * Returns: RME_OK, RME_NOTRMFILE or a PF error code
  */
 int RM_OpenFile(char *fileName, PF_Strategy strategy, RM_FileHandle *fh);
 
@@ -85,14 +465,87 @@ int RM_OpenFile(char *fileName, PF_Strategy strategy, RM_FileHandle *fh);
  */
 int RM_CloseFile(RM_FileHandle *fh);
 
+/*
+ * RM_GetSchema
+ * Desc: Returns the schema of an open file, or NULL if it is untyped.
+ */
+RM_Schema *RM_GetSchema(RM_FileHandle *fh);
+
+
+/* --- Typed Records --- */
+
+/*
+ * RM_InitSchema
+ * Desc: Initializes an empty schema.
+ */
+void RM_InitSchema(RM_Schema *schema);
+
+/*
+ * RM_AddAttr
+ * Desc: Appends an attribute to the schema.
+ * Params: (char) type - RM_INT, RM_FLOAT, RM_CHAR or RM_VARCHAR
+ *         (int) length - size of a 'c' field / max size of a 'v' field
+ *         (ignored for 'i' and 'f')
+ * Returns: RME_OK or RME_INVALIDARG
+ */
+int RM_AddAttr(RM_Schema *schema, char *name, char type, int length);
+
+/*
+ * RM_BuildRecord
+ * Desc: Builds a typed record from binary field values: fields[i] points
+ *       to lens[i] bytes in the attribute's stored form, or is NULL for a
+ *       NULL field.
+ * Returns: RME_OK or RME_BUFTOOSMALL
+ */
+int RM_BuildRecord(RM_Schema *schema, char **fields, int *lens,
+                   char *recBuf, int bufSize, int *recLength);
+
+/*
+ * RM_EncodeRecord
+ * Desc: Builds a typed record from one text value per attribute, e.g.
+ *       "2001" for an int or "8.25" for a float. A NULL or empty value
+ *       stores a NULL field.
+ * Returns: RME_OK, RME_BUFTOOSMALL, or RME_INVALIDARG if a value is not
+ *          of the attribute's type or longer than its length
+ */
+int RM_EncodeRecord(RM_Schema *schema, char **values, char *recBuf, int bufSize, int *recLength);
+
+/*
+ * RM_EncodeDelimited
+ * Desc: Splits a delimited text record into fields and encodes them
+ *       with RM_EncodeRecord. Missing trailing fields are NULL.
+ */
+int RM_EncodeDelimited(RM_Schema *schema, char *text, char delim,
+                       char *recBuf, int bufSize, int *recLength);
+
+/*
+ * RM_GetField
+ * Desc: Locates attribute 'attr' of a typed record in O(1).
+ * Params: (char**) fieldPtr - (out) first byte of the field, in place
+ *         (int*) fieldLen - (out) its length in bytes
+ * Returns: RME_OK, RME_NULLFIELD or RME_INVALIDARG
+ */
+int RM_GetField(RM_Schema *schema, char *rec, int attr, char **fieldPtr, int *fieldLen);
+
+/*
+ * RM_GetIntField / RM_GetFloatField
+ * Desc: Read an 'i' / 'f' attribute of a typed record.
+ * Returns: RME_OK, RME_NULLFIELD or RME_INVALIDARG (wrong type)
+ */
+int RM_GetIntField(RM_Schema *schema, char *rec, int attr, int *value);
+int RM_GetFloatField(RM_Schema *schema, char *rec, int attr, float *value);
+
 
 /* --- Record Management --- */
 
 /*
  * RM_InsertRecord
  * Desc: Inserts a new record into the file.
+ *       A record too large for a page is stored in a chain of overflow
+ *       pages, with a small stub in the slot.
  * Params: (RID*) rid - (out) the RID of the new record (as a single int)
- * Returns: RME_OK or an error code
+ * Returns: RME_OK, RME_RECTOOLARGE (PAX files only), RME_INVALIDARG
+ *          (wrong length for a fixed-length file) or an error code
  */
 int RM_InsertRecord(RM_FileHandle *fh, char *data, int dataLength, RID *rid);
 
@@ -104,6 +557,19 @@ int RM_InsertRecord(RM_FileHandle *fh, char *data, int dataLength, RID *rid);
  */
 int RM_DeleteRecord(RM_FileHandle *fh, RID rid);
 
+/*
+ * RM_UpdateRecord
+ * Desc: Replaces a record, keeping its RID. The new version is written
+ *       in place when it fits in the record's page; otherwise it moves
+ *       to another page and its old slot keeps a forwarding stub, so
+ *       indexes holding the RID stay valid. Scans return a moved record
+ *       under its original RID.
+ * Params: (RID) rid - the RID of the record to update
+ * Returns: RME_OK, RME_INVALIDRID, RME_RECTOOLARGE (no room left in the
+ *          page even for a forwarding stub), or an error code
+ */
+int RM_UpdateRecord(RM_FileHandle *fh, RID rid, char *data, int dataLength);
+
 /*
  * RM_GetRecord
  * Desc: Retrieves a single record from the file.
@@ -112,24 +578,365 @@ int RM_DeleteRecord(RM_FileHandle *fh, RID rid);
  */
 int RM_GetRecord(RM_FileHandle *fh, RID rid, char *dataBuf, int bufSize, int *dataLength);
 
+/*
+ * RM_GetRecords
+ * Desc: Fetches many records by RID, e.g. the RIDs returned by an index
+ *       scan. The RIDs are sorted so that each page is fixed once and
+ *       pages are read in file order; the records are then passed to
+ *       callback (rec is valid during the call only). With keepOrder
+ *       they are emitted in the order of rids[] (buffered in memory),
+ *       otherwise in RID order.
+ * Params: (RID*) rids - the records to fetch (duplicates allowed)
+ * Returns: RME_OK, RME_INVALIDRID (some RID has no record), RME_NOMEM,
+ *          the first non-RME_OK callback result, or a PF error code
+ */
+int RM_GetRecords(RM_FileHandle *fh, RID *rids, int numRids, int keepOrder,
+                  RM_ScanCallback callback, void *arg);
+
+/*
+ * RM_OpenRecordStream
+ * Desc: Opens a record of a slotted file for reading in pieces. No page
+ *       stays fixed between calls; the record must not be updated or
+ *       deleted while the stream is open.
+ * Params: (RM_RecordStream*) rs - (out) the stream
+ * Returns: RME_OK, RME_INVALIDRID, RME_INVALIDARG (PAX or fixed-length
+ *          file) or an error code
+ */
+int RM_OpenRecordStream(RM_FileHandle *fh, RID rid, RM_RecordStream *rs);
+
+/*
+ * RM_ReadRecordStream
+ * Desc: Copies the next min(bufSize, bytes left) bytes of the record.
+ * Params: (int*) bytesRead - (out) bytes placed in buf
+ * Returns: RME_OK, RME_EOF (whole record already read) or an error code
+ */
+int RM_ReadRecordStream(RM_RecordStream *rs, char *buf, int bufSize, int *bytesRead);
+
+/*
+ * RM_CloseRecordStream
+ * Desc: Closes a record stream.
+ * Returns: RME_OK
+ */
+int RM_CloseRecordStream(RM_RecordStream *rs);
+
+
+/* --- Bulk Loading --- */
+
+/*
+ * RM_OpenDelimFile
+ * Desc: Maps a delimited text file and splits it into records and
+ *       fields (see RM_DelimFile), looking for delimiters and newlines
+ *       16 bytes at a time with SSE2 where the compiler has it.
+ * Params: (char) delim - field delimiter, e.g. ';'
+ *         (int) skipLines - title lines to skip at the start
+ * Returns: RME_OK, RME_NOMEM, or RME_ERROR if the file cannot be read
+ */
+int RM_OpenDelimFile(char *fileName, char delim, int skipLines, RM_DelimFile *df);
+
+/*
+ * RM_GetDelimRecord
+ * Desc: Points values[0 .. df->numAttrs-1] at the fields of record r;
+ *       fields the record does not have are NULL.
+ * Returns: The number of fields the record has
+ */
+int RM_GetDelimRecord(RM_DelimFile *df, int r, char **values);
+
+/*
+ * RM_CloseDelimFile
+ * Desc: Unmaps the file and frees its field table.
+ */
+void RM_CloseDelimFile(RM_DelimFile *df);
+
+/*
+ * RM_BeginBulkLoad
+ * Desc: Starts a bulk load into an open file. Until RM_EndBulkLoad no
+ *       other call may add pages to the file. Files that are not
+ *       slotted are loaded through RM_InsertRecord.
+ * Returns: RME_OK or RME_NOMEM
+ */
+int RM_BeginBulkLoad(RM_FileHandle *fh, RM_BulkLoader *bl);
+
+/*
+ * RM_BulkInsert
+ * Desc: Appends a record to the load and sets *rid. The record reaches
+ *       the file when its batch of pages is written; a record too large
+ *       for a page is inserted at once with an overflow chain.
+ * Returns: RME_OK, RME_INVALIDARG or a PF error code
+ */
+int RM_BulkInsert(RM_BulkLoader *bl, char *data, int dataLength, RID *rid);
+
+/*
+ * RM_EndBulkLoad
+ * Desc: Writes the pages still in memory and frees them. The last page
+ *       becomes the insert hint of the file handle.
+ * Returns: RME_OK or a PF error code
+ */
+int RM_EndBulkLoad(RM_BulkLoader *bl);
+
+
+/* --- Vacuum --- */
+
+/*
+ * RM_VacuumFile
+ * Desc: Rewrites a file that is not open with its live records packed
+ *       into as few pages as they need, in scan order, through the bulk
+ *       loader. Space of deleted records, empty and freed pages and
+ *       forwarding stubs stay behind in the old file, which the new one
+ *       replaces under the same name. Format, schema and record length
+ *       are kept. Index entries are brought up to date from the map.
+ * Params: (RM_RidMap**) map - (out) one entry per live record, sorted by
+ *         oldRid; free() it when done
+ *         (int*) numMapped - (out) number of entries in *map
+ * Returns: RME_OK, RME_NOMEM or an RM/PF error code; on an error the
+ *          file is left as it was
+ */
+int RM_VacuumFile(char *fileName, RM_RidMap **map, int *numMapped);
+
+/*
+ * RM_MapRID
+ * Desc: Looks up the new RID of a record in a map from RM_VacuumFile.
+ * Returns: The new RID, or RME_INVALIDRID if oldRid was not a live record
+ */
+RID RM_MapRID(RM_RidMap *map, int numMapped, RID oldRid);
+
+
+/* --- External Sort --- */
+
+/*
+ * RM_BeginSort
+ * Desc: Starts an external sort. Run generation uses replacement
+ *       selection, so on input in random order runs come out about
+ *       twice as long as memory; the runs are merged with a loser
+ *       tree, as many at a time as the frames allow, and run pages
+ *       are read and written up to RM_SORT_BLOCK at a time by a helper
+ *       thread while the next block is being filled or consumed.
+ * Params: (RM_SortCompareFcn) cmp - orders the items, called with arg
+ *         (int) numFrames - memory of the sort, in PF_PAGE_SIZE frames;
+ *         at least RM_SORT_MINFRAMES
+ * Returns: RME_OK, RME_INVALIDARG or RME_NOMEM
+ */
+int RM_BeginSort(RM_Sort *sort, RM_SortCompareFcn cmp, void *arg, int numFrames);
+
+/*
+ * RM_SortAdd
+ * Desc: Adds a copy of an item of any length to the sort.
+ * Returns: RME_OK, RME_INVALIDARG (after RM_SortDone), RME_NOMEM or a
+ *          PF error code
+ */
+int RM_SortAdd(RM_Sort *sort, char *data, int dataLength);
+
+/*
+ * RM_SortDone
+ * Desc: Ends the input. Writes out what is left in memory if anything
+ *       was spilled and merges runs until one final merge can take the
+ *       rest.
+ * Returns: RME_OK, RME_NOMEM or a PF error code
+ */
+int RM_SortDone(RM_Sort *sort);
+
+/*
+ * RM_SortNext
+ * Desc: Hands back the next item in order. *data points into the
+ *       sort's memory and stays valid until the next call.
+ * Returns: RME_OK, RME_EOF, RME_INVALIDARG (before RM_SortDone) or a PF
+ *          error code
+ */
+int RM_SortNext(RM_Sort *sort, char **data, int *dataLength);
+
+/*
+ * RM_EndSort
+ * Desc: Stops the helper thread, frees the memory and destroys the
+ *       temporary file. Any sort that was begun must be ended.
+ */
+int RM_EndSort(RM_Sort *sort);
+
+/*
+ * RM_InitOrderBy / RM_InitTypedOrderBy
+ * Desc: Initialize an ORDER BY without keys over delimited or typed
+ *       records (all records then compare equal).
+ */
+void RM_InitOrderBy(RM_OrderBy *order, char delim);
+void RM_InitTypedOrderBy(RM_OrderBy *order, RM_Schema *schema);
+
+/*
+ * RM_AddOrderKey
+ * Desc: Appends a sort key. Typed fields must be compared as what they
+ *       are stored as ('c' for both 'c' and 'v' attributes).
+ * Params: (char) attrType - how the field is compared: 'i', 'f' or 'c'
+ *         (int) descending - TRUE for a descending key
+ * Returns: RME_OK or RME_INVALIDARG
+ */
+int RM_AddOrderKey(RM_OrderBy *order, int field, char attrType, int descending);
+
+/*
+ * RM_CompareRecords
+ * Desc: Compares two records on the keys of an ORDER BY, passed as arg;
+ *       an RM_SortCompareFcn.
+ * Returns: <0, 0 or >0
+ */
+int RM_CompareRecords(void *order, char *a, int aLen, char *b, int bLen);
+
+/*
+ * RM_SortFile
+ * Desc: ORDER BY: begins a sort, adds every record of an open file that
+ *       passes the filter (NULL for all) and ends the input. The caller
+ *       reads the records with RM_SortNext and calls RM_EndSort.
+ * Params: (RM_OrderBy*) order - must stay valid until RM_EndSort
+ * Returns: RME_OK or an error code (the sort is ended on an error)
+ */
+int RM_SortFile(RM_FileHandle *fh, RM_Filter *filter, RM_OrderBy *order,
+                int numFrames, RM_Sort *sort);
+
+
+
+
+/*
+ * RM_InitFilter
+ * Desc: Initializes an empty filter (accepts every record).
+ */
+void RM_InitFilter(RM_Filter *filter, char delim);
+
+/*
+ * RM_InitTypedFilter
+ * Desc: Initializes an empty filter over typed records. Predicates then
+ *       name attributes of the schema; their attrType must agree with
+ *       it ('c' for both 'c' and 'v' attributes). NULL fields never
+ *       qualify.
+ */
+void RM_InitTypedFilter(RM_Filter *filter, RM_Schema *schema);
+
+/*
+ * RM_AddPredicate
+ * Desc: Compiles "field <op> value" and ANDs it into the filter.
+ * Params: (char) attrType - how the field is compared: 'i', 'f' or 'c'
+ *         (char*) value - the constant, as a NUL-terminated string
+ * Returns: RME_OK or RME_INVALIDARG
+ */
+int RM_AddPredicate(RM_Filter *filter, int field, char attrType, int op, char *value);
+
+/*
+ * RM_InitProjection
+ * Desc: Initializes an empty projection.
+ */
+void RM_InitProjection(RM_Projection *proj, char delim);
+
+/*
+ * RM_AddProjField
+ * Desc: Appends a field to the projection's output list.
+ * Returns: RME_OK or RME_INVALIDARG
+ */
+int RM_AddProjField(RM_Projection *proj, int field);
+
+/*
+ * RM_EvalFilter
+ * Desc: Evaluates a filter against one record.
+ * Returns: TRUE if the record qualifies (or filter is NULL), else FALSE
+ */
+int RM_EvalFilter(RM_Filter *filter, char *rec, int recLength);
+
+/*
+ * RM_CompareField / RM_ApplyOp
+ * Desc: The two halves of one predicate test, for callers that locate
+ *       fields themselves. RM_CompareField compares a field (typed =
+ *       stored binary form, else text) with the predicate's constant
+ *       and returns <0, 0 or >0; RM_ApplyOp turns that into TRUE/FALSE
+ *       for the operator.
+ */
+int RM_CompareField(RM_Predicate *pred, char *fieldPtr, int fieldLen, int typed);
+int RM_ApplyOp(int op, int cmp);
+
+/*
+ * RM_Project
+ * Desc: Copies the projected fields of one delimited record into dataBuf.
+ *       On RME_BUFTOOSMALL *dataLength is the buffer size needed.
+ * Returns: RME_OK or RME_BUFTOOSMALL
+ */
+int RM_Project(RM_Projection *proj, char *rec, int recLength,
+               char *dataBuf, int bufSize, int *dataLength);
+
 
 /* --- Scanning --- */
 
 /*
  * RM_OpenScan
  * Desc: Initializes a new scan on the file.
+ * Params: (RM_Filter*) filter - records failing it are skipped inside
+ *         the page and never copied out (NULL = no filter)
+ *         (RM_Projection*) proj - fields to return (NULL = whole record)
+ *         Both must stay valid until RM_CloseScan.
  * Returns: RME_OK or an error code
  */
-int RM_OpenScan(RM_FileHandle *fh, RM_ScanHandle *sh);
+int RM_OpenScan(RM_FileHandle *fh, RM_ScanHandle *sh, RM_Filter *filter, RM_Projection *proj);
+
+/*
+ * RM_OpenRangeScan
+ * Desc: Like RM_OpenScan, but only visits pages firstPage .. lastPage-1
+ *       (lastPage = RM_SCAN_TO_EOF for the rest of the file). Only the
+ *       data pages of the range are fixed; overflow chains, which may
+ *       lie in another range, are read with PF_CopyPage. Scans over
+ *       disjoint ranges may therefore run in their own threads.
+ * Returns: RME_OK, RME_INVALIDARG or a PF error code
+ */
+int RM_OpenRangeScan(RM_FileHandle *fh, RM_ScanHandle *sh, RM_Filter *filter,
+                     RM_Projection *proj, int firstPage, int lastPage);
 
 /*
  * RM_GetNextRecord
- * Desc: Retrieves the next record in the scan.
+ * Desc: Retrieves the next qualifying record in the scan. With a
+ *       projection, dataBuf receives the selected fields joined by the
+ *       delimiter and NUL-terminated; *dataLength excludes the NUL.
+ *       A record that does not fit in bufSize is not consumed: the next
+ *       call returns it again. Except in PAX files *dataLength is set to
+ *       the buffer size it needs (with a projection, NUL included).
  * Params: (RID*) rid - (out) RID of the next record
  * Returns: RME_OK (success), RME_EOF (no more records), or an error
  */
 int RM_GetNextRecord(RM_ScanHandle *sh, RID *rid, char *dataBuf, int bufSize, int *dataLength);
 
+/*
+ * RM_GetNextBatch
+ * Desc: Retrieves up to batch->capacity qualifying records at once, all
+ *       from the same page, without copying them. Empty pages are
+ *       skipped. Scans with a projection and scans of PAX files are
+ *       rejected (there are no whole records in the page to point at);
+ *       the filter is applied as usual.
+ * Returns: RME_OK (batch->numRecords > 0), RME_EOF, or an error
+ */
+int RM_GetNextBatch(RM_ScanHandle *sh, RM_Batch *batch);
+
+/*
+ * RM_GetNextColumn
+ * Desc: Column scan of a PAX file: returns attribute 'attr' of the next
+ *       page that has records, as contiguous same-typed values. The
+ *       scan's filter and projection are not applied.
+ * Returns: RME_OK, RME_EOF, RME_INVALIDARG (not a PAX file or bad attr)
+ *          or a PF error code
+ */
+int RM_GetNextColumn(RM_ScanHandle *sh, int attr, RM_Column *col);
+
+/*
+ * RM_InitBatch / RM_FreeBatch
+ * Desc: Allocate / release the arrays of a batch of the given capacity.
+ * Returns: RME_OK or RME_NOMEM
+ */
+int RM_InitBatch(RM_Batch *batch, int capacity);
+void RM_FreeBatch(RM_Batch *batch);
+
+/*
+ * RM_ParallelScan
+ * Desc: Full-table scan split across numThreads worker threads. The
+ *       file's pages are cut into numThreads contiguous ranges; worker t
+ *       scans its range with RM_OpenRangeScan and calls
+ *       callback(args[t], ...) for each record passing the filter.
+ *       Records within a range arrive in file order; there is no order
+ *       across workers. The file must not be modified during the scan.
+ * Params: (void**) args - one callback argument per worker (may be NULL)
+ * Returns: RME_OK, the first non-RME_OK callback/scan result of any
+ *          worker, or RME_INVALIDARG / RME_ERROR
+ */
+int RM_ParallelScan(RM_FileHandle *fh, int numThreads, RM_Filter *filter,
+                    RM_ScanCallback callback, void **args);
+
 /*
  * RM_CloseScan
  * Desc: Finalizes a scan.
@@ -137,4 +944,64 @@ int RM_GetNextRecord(RM_ScanHandle *sh, RID *rid, char *dataBuf, int bufSize, in
  */
 int RM_CloseScan(RM_ScanHandle *sh);
 
+
+/* --- Column Files --- */
+
+/*
+ * RM_CreateColumnFile
+ * Desc: Creates a column file for typed records: a header page plus,
+ *       as rows arrive, one data page chain and one zone-map directory
+ *       chain per attribute. Destroy it with RM_DestroyFile.
+ * Returns: RME_OK, RME_INVALIDARG (a value cannot fit in a page) or a
+ *          PF error code
+ */
+int RM_CreateColumnFile(char *fileName, RM_Schema *schema);
+
+/*
+ * RM_OpenColumnFile / RM_CloseColumnFile
+ * Desc: Opens a column file; closing brings the zone-map directory and
+ *       the header page up to date.
+ * Returns: RME_OK, RME_NOTCOLFILE or a PF error code
+ */
+int RM_OpenColumnFile(char *fileName, PF_Strategy strategy, RM_ColFileHandle *fh);
+int RM_CloseColumnFile(RM_ColFileHandle *fh);
+
+/*
+ * RM_InsertRow
+ * Desc: Appends a typed record (see RM_BuildRecord), splitting it into
+ *       its columns.
+ * Params: (int*) rowNum - (out) row number of the new row
+ * Returns: RME_OK or an error code
+ */
+int RM_InsertRow(RM_ColFileHandle *fh, char *rec, int recLength, int *rowNum);
+
+/*
+ * RM_OpenColumnScan
+ * Desc: Starts a scan that reads only the attributes used by the filter
+ *       and listed in cols. Data pages whose zone map shows that no
+ *       value can satisfy a predicate are skipped without being read.
+ * Params: (RM_Filter*) filter - a typed filter on the file's schema,
+ *         or NULL; it must stay valid until RM_CloseColumnScan
+ *         (int*) cols - numCols attributes to return, in output order
+ * Returns: RME_OK, RME_INVALIDARG, RME_NOMEM or a PF error code
+ */
+int RM_OpenColumnScan(RM_ColFileHandle *fh, RM_ColScanHandle *sh, RM_Filter *filter,
+                      int numCols, int *cols);
+
+/*
+ * RM_GetNextRow
+ * Desc: Retrieves the next qualifying row. fields[i]/lens[i] receive the
+ *       stored form of the i-th projected attribute (NULL for a NULL
+ *       value); they point into pinned pages and stay valid until the
+ *       next call on the scan.
+ * Returns: RME_OK, RME_EOF or an error code
+ */
+int RM_GetNextRow(RM_ColScanHandle *sh, int *rowNum, char **fields, int *lens);
+
+/*
+ * RM_CloseColumnScan
+ * Desc: Unpins the scan's pages and frees its directories.
+ */
+int RM_CloseColumnScan(RM_ColScanHandle *sh);
+
 #endif /* RM_H */
\ No newline at end of file
@@ -0,0 +1,672 @@
+/* rmcolumn.c: column files - one page chain per attribute, with zone maps */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "rm.h"
+#include "pf.h"
+
+/*
+ * File layout
+ *
+ * Page 0 holds a ColFileHeader. Every other page belongs to one column
+ * and is either
+ *   - a data page: ColPageHeader, a null bitmap with one bit per value
+ *     (padded to 4 bytes), then 'capacity' values of the column's width.
+ *     A varchar value is a 2-byte length followed by its maximum size.
+ *   - a directory page: ColDirHeader, then RM_ColDirEntry's, one per
+ *     data page of the column, in row order.
+ * Both kinds are chained through nextPage. Pages are only ever appended,
+ * so a column's values are in row order along its data chain.
+ *
+ * The zone map of a data page is kept up to date in the page itself
+ * on every insert. Its directory entry is copied from the page when the
+ * page fills up, and for the last page when the file is flushed.
+ */
+typedef struct {
+    int magic;          // RM_COL_MAGIC
+    int numRows;
+    RM_Schema schema;
+    RM_ColumnInfo cols[RM_MAXATTRS];
+} ColFileHeader;
+
+typedef struct {
+    int nextPage;       // -1 = last page of the chain
+    int firstRow;
+    int count;          // Values stored, NULLs included
+    RM_ZoneMap zone;
+} ColPageHeader;
+
+typedef struct {
+    int nextPage;
+    int numEntries;
+} ColDirHeader;
+
+#define RM_COL_HEADER_PAGE 0
+#define RM_COL_MAGIC 0x524D4331 // "RMC1"
+
+#define ALIGN4(n) (((n) + 3) & ~3)
+#define NULLMAP_BYTES(capacity) ALIGN4(((capacity) + 7) / 8)
+#define DIR_CAPACITY ((int)((PF_PAGE_SIZE - sizeof(ColDirHeader)) / sizeof(RM_ColDirEntry)))
+
+#define GET_PAGEHDR(pageData) ((ColPageHeader *)(pageData))
+#define GET_NULLMAP(pageData) ((unsigned char *)(pageData) + sizeof(ColPageHeader))
+#define GET_DIRHDR(pageData) ((ColDirHeader *)(pageData))
+#define GET_DIRENTRY(pageData, i) \
+    ((RM_ColDirEntry *)((pageData) + sizeof(ColDirHeader)) + (i))
+
+
+/* --- Layout --- */
+
+/* Bytes one value of the attribute occupies in a data page */
+static int RM_ColWidth(RM_Attr *attr) {
+    return (attr->type == RM_VARCHAR) ? attr->length + 2 : attr->length;
+}
+
+/* Values of the given width that fit in one data page (0 = none) */
+static int RM_ColCapacity(int width) {
+    int avail = PF_PAGE_SIZE - sizeof(ColPageHeader);
+    int cap = (avail * 8) / (width * 8 + 1);
+
+    while (cap > 0 && NULLMAP_BYTES(cap) + cap * width > avail)
+        cap--;
+    return cap;
+}
+
+static char *RM_ColValuePtr(RM_ColumnInfo *col, char *pageData, int width, int idx) {
+    return pageData + sizeof(ColPageHeader) + NULLMAP_BYTES(col->capacity) + idx * width;
+}
+
+
+/* --- Zone Maps --- */
+
+/* Three-way comparison of two stored values of the same attribute */
+static int RM_ColCompare(char type, char *a, int alen, char *b, int blen) {
+    int cmp;
+
+    switch (type) {
+        case RM_INT: {
+            int x, y;
+            memcpy(&x, a, sizeof(int));
+            memcpy(&y, b, sizeof(int));
+            return (x > y) - (x < y);
+        }
+        case RM_FLOAT: {
+            float x, y;
+            memcpy(&x, a, sizeof(float));
+            memcpy(&y, b, sizeof(float));
+            return (x > y) - (x < y);
+        }
+        default: // NUL padding of 'c' values sorts first, like a shorter string
+            cmp = memcmp(a, b, (alen < blen) ? alen : blen);
+            return (cmp != 0) ? cmp : (alen > blen) - (alen < blen);
+    }
+}
+
+static void RM_ZoneInit(RM_ZoneMap *zone) {
+    memset(zone, 0, sizeof(RM_ZoneMap));
+    zone->bounded = TRUE;
+}
+
+/* Widens the zone map to cover one more non-NULL value */
+static void RM_ZoneAdd(RM_ZoneMap *zone, char type, char *value, int len) {
+    if (len > RM_ZONELEN) {
+        zone->bounded = FALSE;
+    } else if (zone->bounded) {
+        if (zone->numValues == 0 || RM_ColCompare(type, value, len, zone->min, zone->minLen) < 0) {
+            memcpy(zone->min, value, len);
+            zone->minLen = len;
+        }
+        if (zone->numValues == 0 || RM_ColCompare(type, value, len, zone->max, zone->maxLen) > 0) {
+            memcpy(zone->max, value, len);
+            zone->maxLen = len;
+        }
+    }
+    zone->numValues++;
+}
+
+/*
+ * RM_ZoneExcludes
+ * Desc: Decides from a page's zone map alone that no value on the page
+ *       can satisfy the predicate.
+ */
+static int RM_ZoneExcludes(RM_ZoneMap *zone, RM_Predicate *pred) {
+    int cmin, cmax;
+
+    if (zone->numValues == 0)
+        return TRUE; // All NULL, and NULL never qualifies
+    if (!zone->bounded)
+        return FALSE;
+
+    cmin = RM_CompareField(pred, zone->min, zone->minLen, TRUE);
+    cmax = RM_CompareField(pred, zone->max, zone->maxLen, TRUE);
+    switch (pred->op) {
+        case RM_EQ: return cmin > 0 || cmax < 0;
+        case RM_LT: return cmin >= 0;
+        case RM_LE: return cmin > 0;
+        case RM_GT: return cmax <= 0;
+        case RM_GE: return cmax < 0;
+        case RM_NE: return cmin == 0 && cmax == 0;
+        default:    return FALSE;
+    }
+}
+
+
+/* --- File Management --- */
+
+int RM_CreateColumnFile(char *fileName, RM_Schema *schema) {
+    ColFileHeader *hdr;
+    char *pageData;
+    int pf_fd, pf_err, pageNum, a;
+
+    if (schema == NULL || schema->numAttrs == 0)
+        return RME_INVALIDARG;
+    for (a = 0; a < schema->numAttrs; a++)
+        if (RM_ColCapacity(RM_ColWidth(&schema->attrs[a])) == 0)
+            return RME_INVALIDARG;
+
+    if ((pf_err = PF_CreateFile(fileName)) != PFE_OK)
+        return pf_err;
+    if ((pf_fd = PF_OpenFile(fileName, PF_LRU)) < 0) {
+        PF_PrintError("RM_CreateColumnFile: PF_OpenFile");
+        return pf_fd;
+    }
+
+    if ((pf_err = PF_AllocPage(pf_fd, &pageNum, &pageData)) != PFE_OK) {
+        PF_PrintError("RM_CreateColumnFile: PF_AllocPage");
+        PF_CloseFile(pf_fd);
+        return pf_err;
+    }
+    memset(pageData, 0, PF_PAGE_SIZE);
+    hdr = (ColFileHeader *)pageData;
+    hdr->magic = RM_COL_MAGIC;
+    hdr->numRows = 0;
+    hdr->schema = *schema;
+    for (a = 0; a < schema->numAttrs; a++) {
+        RM_ColumnInfo *col = &hdr->cols[a];
+        col->firstPage = col->lastPage = -1;
+        col->firstDirPage = col->lastDirPage = -1;
+        col->numPages = 0;
+        col->lastCount = 0;
+        col->capacity = RM_ColCapacity(RM_ColWidth(&schema->attrs[a]));
+    }
+
+    if ((pf_err = PF_UnfixPage(pf_fd, pageNum, TRUE)) != PFE_OK) {
+        PF_PrintError("RM_CreateColumnFile: PF_UnfixPage");
+        PF_CloseFile(pf_fd);
+        return pf_err;
+    }
+    return PF_CloseFile(pf_fd);
+}
+
+int RM_OpenColumnFile(char *fileName, PF_Strategy strategy, RM_ColFileHandle *fh) {
+    ColFileHeader *hdr;
+    char *pageData;
+    int pf_fd, pf_err;
+
+    if ((pf_fd = PF_OpenFile(fileName, strategy)) < 0) {
+        PF_PrintError("RM_OpenColumnFile: PF_OpenFile");
+        return pf_fd;
+    }
+    if ((pf_err = PF_GetThisPage(pf_fd, RM_COL_HEADER_PAGE, &pageData)) != PFE_OK) {
+        PF_CloseFile(pf_fd);
+        return (pf_err == PFE_INVALIDPAGE) ? RME_NOTCOLFILE : pf_err;
+    }
+    hdr = (ColFileHeader *)pageData;
+    if (hdr->magic != RM_COL_MAGIC) {
+        PF_UnfixPage(pf_fd, RM_COL_HEADER_PAGE, FALSE);
+        PF_CloseFile(pf_fd);
+        return RME_NOTCOLFILE;
+    }
+
+    fh->pfFileDesc = pf_fd;
+    fh->numRows = hdr->numRows;
+    fh->schema = hdr->schema;
+    memcpy(fh->cols, hdr->cols, sizeof(fh->cols));
+    fh->dirty = FALSE;
+    PF_UnfixPage(pf_fd, RM_COL_HEADER_PAGE, FALSE);
+    return RME_OK;
+}
+
+/*
+ * RM_ColSyncEntry
+ * Desc: Copies the zone map and count of a column's last data page into
+ *       its directory entry (always the last entry of the last
+ *       directory page).
+ */
+static int RM_ColSyncEntry(RM_ColFileHandle *fh, int attr) {
+    RM_ColumnInfo *col = &fh->cols[attr];
+    RM_ColDirEntry *entry;
+    ColPageHeader *page;
+    char *pageData, *dirData;
+    int pf_err;
+
+    if (col->lastPage < 0)
+        return RME_OK;
+    if ((pf_err = PF_GetThisPage(fh->pfFileDesc, col->lastPage, &pageData)) != PFE_OK) {
+        PF_PrintError("RM_ColSyncEntry: PF_GetThisPage");
+        return pf_err;
+    }
+    if ((pf_err = PF_GetThisPage(fh->pfFileDesc, col->lastDirPage, &dirData)) != PFE_OK) {
+        PF_PrintError("RM_ColSyncEntry: PF_GetThisPage");
+        PF_UnfixPage(fh->pfFileDesc, col->lastPage, FALSE);
+        return pf_err;
+    }
+
+    page = GET_PAGEHDR(pageData);
+    entry = GET_DIRENTRY(dirData, GET_DIRHDR(dirData)->numEntries - 1);
+    entry->count = page->count;
+    entry->zone = page->zone;
+
+    PF_UnfixPage(fh->pfFileDesc, col->lastDirPage, TRUE);
+    PF_UnfixPage(fh->pfFileDesc, col->lastPage, FALSE);
+    return RME_OK;
+}
+
+/*
+ * RM_ColFlush
+ * Desc: Brings every column's directory and the header page up to date.
+ */
+static int RM_ColFlush(RM_ColFileHandle *fh) {
+    ColFileHeader *hdr;
+    char *pageData;
+    int pf_err, a;
+
+    if (!fh->dirty)
+        return RME_OK;
+
+    for (a = 0; a < fh->schema.numAttrs; a++)
+        if ((pf_err = RM_ColSyncEntry(fh, a)) != RME_OK)
+            return pf_err;
+
+    if ((pf_err = PF_GetThisPage(fh->pfFileDesc, RM_COL_HEADER_PAGE, &pageData)) != PFE_OK) {
+        PF_PrintError("RM_ColFlush: PF_GetThisPage");
+        return pf_err;
+    }
+    hdr = (ColFileHeader *)pageData;
+    hdr->numRows = fh->numRows;
+    memcpy(hdr->cols, fh->cols, sizeof(fh->cols));
+    PF_UnfixPage(fh->pfFileDesc, RM_COL_HEADER_PAGE, TRUE);
+
+    fh->dirty = FALSE;
+    return RME_OK;
+}
+
+int RM_CloseColumnFile(RM_ColFileHandle *fh) {
+    int err;
+
+    if ((err = RM_ColFlush(fh)) != RME_OK) {
+        PF_CloseFile(fh->pfFileDesc);
+        return err;
+    }
+    return PF_CloseFile(fh->pfFileDesc);
+}
+
+
+/* --- Inserting --- */
+
+/*
+ * RM_ColAddDirEntry
+ * Desc: Appends the directory entry of a new data page, starting a new
+ *       directory page when the last one is full.
+ */
+static int RM_ColAddDirEntry(RM_ColFileHandle *fh, int attr, int dataPage) {
+    RM_ColumnInfo *col = &fh->cols[attr];
+    RM_ColDirEntry *entry;
+    char *dirData, *newData;
+    int pf_err, newPage;
+
+    if (col->lastDirPage >= 0) {
+        if ((pf_err = PF_GetThisPage(fh->pfFileDesc, col->lastDirPage, &dirData)) != PFE_OK) {
+            PF_PrintError("RM_ColAddDirEntry: PF_GetThisPage");
+            return pf_err;
+        }
+    }
+
+    // 1. Chain a new directory page if needed
+    if (col->lastDirPage < 0 || GET_DIRHDR(dirData)->numEntries == DIR_CAPACITY) {
+        if ((pf_err = PF_AllocPage(fh->pfFileDesc, &newPage, &newData)) != PFE_OK) {
+            PF_PrintError("RM_ColAddDirEntry: PF_AllocPage");
+            if (col->lastDirPage >= 0)
+                PF_UnfixPage(fh->pfFileDesc, col->lastDirPage, FALSE);
+            return pf_err;
+        }
+        GET_DIRHDR(newData)->nextPage = -1;
+        GET_DIRHDR(newData)->numEntries = 0;
+
+        if (col->lastDirPage >= 0) {
+            GET_DIRHDR(dirData)->nextPage = newPage;
+            PF_UnfixPage(fh->pfFileDesc, col->lastDirPage, TRUE);
+        } else {
+            col->firstDirPage = newPage;
+        }
+        col->lastDirPage = newPage;
+        dirData = newData;
+    }
+
+    // 2. The entry starts out empty; RM_ColSyncEntry fills it in
+    entry = GET_DIRENTRY(dirData, GET_DIRHDR(dirData)->numEntries++);
+    entry->pageNum = dataPage;
+    entry->firstRow = fh->numRows;
+    entry->count = 0;
+    RM_ZoneInit(&entry->zone);
+
+    return PF_UnfixPage(fh->pfFileDesc, col->lastDirPage, TRUE);
+}
+
+/*
+ * RM_ColNewPage
+ * Desc: Seals the column's last data page and chains a new, empty one
+ *       whose first value will be row fh->numRows.
+ */
+static int RM_ColNewPage(RM_ColFileHandle *fh, int attr) {
+    RM_ColumnInfo *col = &fh->cols[attr];
+    ColPageHeader *page;
+    char *pageData, *oldData;
+    int pf_err, pageNum;
+
+    // 1. The full page's zone map is final: copy it to the directory
+    if ((pf_err = RM_ColSyncEntry(fh, attr)) != RME_OK)
+        return pf_err;
+
+    // 2. Allocate and link the new page
+    if ((pf_err = PF_AllocPage(fh->pfFileDesc, &pageNum, &pageData)) != PFE_OK) {
+        PF_PrintError("RM_ColNewPage: PF_AllocPage");
+        return pf_err;
+    }
+    memset(pageData, 0, PF_PAGE_SIZE);
+    page = GET_PAGEHDR(pageData);
+    page->nextPage = -1;
+    page->firstRow = fh->numRows;
+    page->count = 0;
+    RM_ZoneInit(&page->zone);
+    PF_UnfixPage(fh->pfFileDesc, pageNum, TRUE);
+
+    if (col->lastPage >= 0) {
+        if ((pf_err = PF_GetThisPage(fh->pfFileDesc, col->lastPage, &oldData)) != PFE_OK) {
+            PF_PrintError("RM_ColNewPage: PF_GetThisPage");
+            return pf_err;
+        }
+        GET_PAGEHDR(oldData)->nextPage = pageNum;
+        PF_UnfixPage(fh->pfFileDesc, col->lastPage, TRUE);
+    } else {
+        col->firstPage = pageNum;
+    }
+
+    // 3. Give it a directory entry
+    if ((pf_err = RM_ColAddDirEntry(fh, attr, pageNum)) != RME_OK)
+        return pf_err;
+
+    col->lastPage = pageNum;
+    col->lastCount = 0;
+    col->numPages++;
+    return RME_OK;
+}
+
+int RM_InsertRow(RM_ColFileHandle *fh, char *rec, int recLength, int *rowNum) {
+    RM_ColumnInfo *col;
+    RM_Attr *attr;
+    ColPageHeader *page;
+    char *pageData, *fieldPtr, *valPtr;
+    int fieldLen, width, err, a;
+    unsigned short vlen;
+
+    if (rec == NULL || recLength <= 0)
+        return RME_INVALIDARG;
+
+    // Check every field first, so a bad record leaves no partial row
+    for (a = 0; a < fh->schema.numAttrs; a++) {
+        err = RM_GetField(&fh->schema, rec, a, &fieldPtr, &fieldLen);
+        if (err != RME_NULLFIELD && (err != RME_OK || fieldLen > fh->schema.attrs[a].length))
+            return RME_INVALIDARG;
+    }
+    fh->dirty = TRUE;
+
+    for (a = 0; a < fh->schema.numAttrs; a++) {
+        col = &fh->cols[a];
+        attr = &fh->schema.attrs[a];
+        width = RM_ColWidth(attr);
+
+        // 1. Make sure the column's last page has room
+        if (col->lastPage < 0 || col->lastCount == col->capacity)
+            if ((err = RM_ColNewPage(fh, a)) != RME_OK)
+                return err;
+
+        // 2. Append the value (or a NULL bit) and widen the zone map
+        if ((err = PF_GetThisPage(fh->pfFileDesc, col->lastPage, &pageData)) != PFE_OK) {
+            PF_PrintError("RM_InsertRow: PF_GetThisPage");
+            return err;
+        }
+        page = GET_PAGEHDR(pageData);
+        err = RM_GetField(&fh->schema, rec, a, &fieldPtr, &fieldLen);
+        if (err == RME_NULLFIELD) {
+            GET_NULLMAP(pageData)[col->lastCount / 8] |= 1 << (col->lastCount % 8);
+        } else {
+            valPtr = RM_ColValuePtr(col, pageData, width, col->lastCount);
+            if (attr->type == RM_VARCHAR) {
+                vlen = fieldLen;
+                memcpy(valPtr, &vlen, sizeof(vlen));
+                memcpy(valPtr + sizeof(vlen), fieldPtr, fieldLen);
+            } else {
+                memcpy(valPtr, fieldPtr, fieldLen);
+            }
+            RM_ZoneAdd(&page->zone, attr->type, fieldPtr, fieldLen);
+        }
+        page->count++;
+        col->lastCount++;
+        PF_UnfixPage(fh->pfFileDesc, col->lastPage, TRUE);
+    }
+
+    *rowNum = fh->numRows++;
+    return RME_OK;
+}
+
+
+/* --- Scanning --- */
+
+/*
+ * RM_ColLoadDir
+ * Desc: Reads a column's directory chain into one malloc'ed array.
+ */
+static int RM_ColLoadDir(RM_ColScanHandle *sh, int attr) {
+    RM_ColumnInfo *col = &sh->fileHandle->cols[attr];
+    char *dirData;
+    int pageNum, next, n = 0, pf_err;
+
+    if ((sh->dir[attr] = malloc(sizeof(RM_ColDirEntry) * (col->numPages + 1))) == NULL)
+        return RME_NOMEM;
+
+    for (pageNum = col->firstDirPage; pageNum >= 0; pageNum = next) {
+        if ((pf_err = PF_GetThisPage(sh->fileHandle->pfFileDesc, pageNum, &dirData)) != PFE_OK) {
+            PF_PrintError("RM_ColLoadDir: PF_GetThisPage");
+            return pf_err;
+        }
+        memcpy(sh->dir[attr] + n, GET_DIRENTRY(dirData, 0),
+               sizeof(RM_ColDirEntry) * GET_DIRHDR(dirData)->numEntries);
+        n += GET_DIRHDR(dirData)->numEntries;
+        next = GET_DIRHDR(dirData)->nextPage;
+        PF_UnfixPage(sh->fileHandle->pfFileDesc, pageNum, FALSE);
+    }
+    return RME_OK;
+}
+
+int RM_OpenColumnScan(RM_ColFileHandle *fh, RM_ColScanHandle *sh, RM_Filter *filter,
+                      int numCols, int *cols) {
+    RM_Schema *schema = &fh->schema;
+    int err, i, a;
+
+    // 1. Validate the filter and projection against the schema
+    if (numCols < 0 || numCols > RM_MAXPROJ)
+        return RME_INVALIDARG;
+    for (i = 0; i < numCols; i++)
+        if (cols[i] < 0 || cols[i] >= schema->numAttrs)
+            return RME_INVALIDARG;
+    if (filter != NULL) {
+        if (filter->schema == NULL)
+            return RME_INVALIDARG; // Column files only hold typed values
+        for (i = 0; i < filter->numPreds; i++)
+            if (filter->preds[i].field >= schema->numAttrs)
+                return RME_INVALIDARG;
+    }
+
+    // 2. Directories must reflect the rows inserted so far
+    if ((err = RM_ColFlush(fh)) != RME_OK)
+        return err;
+
+    sh->fileHandle = fh;
+    sh->filter = filter;
+    sh->numCols = numCols;
+    memcpy(sh->cols, cols, sizeof(int) * numCols);
+    sh->nextRow = 0;
+    sh->pagesRead = 0;
+    sh->pagesSkipped = 0;
+    for (a = 0; a < RM_MAXATTRS; a++) {
+        sh->dir[a] = NULL;
+        sh->entry[a] = 0;
+        sh->pinnedPage[a] = -1;
+    }
+
+    // 3. Load the directories of the referenced columns only
+    for (i = 0; filter != NULL && i < filter->numPreds; i++) {
+        a = filter->preds[i].field;
+        if (sh->dir[a] == NULL && (err = RM_ColLoadDir(sh, a)) != RME_OK) {
+            RM_CloseColumnScan(sh);
+            return err;
+        }
+    }
+    for (i = 0; i < numCols; i++) {
+        a = cols[i];
+        if (sh->dir[a] == NULL && (err = RM_ColLoadDir(sh, a)) != RME_OK) {
+            RM_CloseColumnScan(sh);
+            return err;
+        }
+    }
+    return RME_OK;
+}
+
+/* Advances a column's directory cursor to the entry holding row */
+static RM_ColDirEntry *RM_ColSeek(RM_ColScanHandle *sh, int attr, int row) {
+    RM_ColDirEntry *dir = sh->dir[attr];
+    int last = sh->fileHandle->cols[attr].numPages - 1;
+
+    while (sh->entry[attr] < last &&
+           row >= dir[sh->entry[attr]].firstRow + dir[sh->entry[attr]].count)
+        sh->entry[attr]++;
+    return &dir[sh->entry[attr]];
+}
+
+/*
+ * RM_ColGetValue
+ * Desc: Finds the stored value of one attribute in a row, pinning the
+ *       data page that holds it (and unpinning the column's previous one).
+ * Returns: RME_OK, RME_NULLFIELD or a PF error code
+ */
+static int RM_ColGetValue(RM_ColScanHandle *sh, int attr, int row, char **valPtr, int *valLen) {
+    RM_ColFileHandle *fh = sh->fileHandle;
+    RM_ColumnInfo *col = &fh->cols[attr];
+    RM_Attr *at = &fh->schema.attrs[attr];
+    RM_ColDirEntry *entry = RM_ColSeek(sh, attr, row);
+    unsigned short vlen;
+    char *ptr;
+    int idx, pf_err;
+
+    if (sh->pinnedPage[attr] != entry->pageNum) {
+        if (sh->pinnedPage[attr] >= 0)
+            PF_UnfixPage(fh->pfFileDesc, sh->pinnedPage[attr], FALSE);
+        sh->pinnedPage[attr] = -1;
+        if ((pf_err = PF_GetThisPage(fh->pfFileDesc, entry->pageNum, &sh->pageData[attr])) != PFE_OK) {
+            PF_PrintError("RM_ColGetValue: PF_GetThisPage");
+            return pf_err;
+        }
+        sh->pinnedPage[attr] = entry->pageNum;
+        sh->pagesRead++;
+    }
+
+    idx = row - entry->firstRow;
+    if (RM_BITSET(GET_NULLMAP(sh->pageData[attr]), idx))
+        return RME_NULLFIELD;
+
+    ptr = RM_ColValuePtr(col, sh->pageData[attr], RM_ColWidth(at), idx);
+    if (at->type == RM_VARCHAR) {
+        memcpy(&vlen, ptr, sizeof(vlen));
+        *valPtr = ptr + sizeof(vlen);
+        *valLen = vlen;
+    } else {
+        *valPtr = ptr;
+        *valLen = at->length;
+    }
+    return RME_OK;
+}
+
+int RM_GetNextRow(RM_ColScanHandle *sh, int *rowNum, char **fields, int *lens) {
+    RM_Filter *filter = sh->filter;
+    RM_Predicate *pred;
+    RM_ColDirEntry *entry;
+    char *valPtr;
+    int numPreds = (filter != NULL) ? filter->numPreds : 0;
+    int row, skip, match, valLen, err, i;
+
+    row = sh->nextRow;
+    while (row < sh->fileHandle->numRows) {
+        // 1. Jump over a page whose zone map rules out a predicate
+        skip = FALSE;
+        for (i = 0; i < numPreds; i++) {
+            pred = &filter->preds[i];
+            entry = RM_ColSeek(sh, pred->field, row);
+            if (RM_ZoneExcludes(&entry->zone, pred)) {
+                row = entry->firstRow + entry->count;
+                sh->pagesSkipped++;
+                skip = TRUE;
+                break;
+            }
+        }
+        if (skip)
+            continue;
+
+        // 2. Test the predicates on this row's values
+        match = TRUE;
+        for (i = 0; i < numPreds && match; i++) {
+            pred = &filter->preds[i];
+            err = RM_ColGetValue(sh, pred->field, row, &valPtr, &valLen);
+            if (err == RME_NULLFIELD)
+                match = FALSE;
+            else if (err != RME_OK)
+                return err;
+            else
+                match = RM_ApplyOp(pred->op, RM_CompareField(pred, valPtr, valLen, TRUE));
+        }
+        if (!match) {
+            row++;
+            continue;
+        }
+
+        // 3. Only now read the projected columns
+        for (i = 0; i < sh->numCols; i++) {
+            err = RM_ColGetValue(sh, sh->cols[i], row, &fields[i], &lens[i]);
+            if (err == RME_NULLFIELD) {
+                fields[i] = NULL;
+                lens[i] = 0;
+            } else if (err != RME_OK) {
+                return err;
+            }
+        }
+        *rowNum = row;
+        sh->nextRow = row + 1;
+        return RME_OK;
+    }
+
+    sh->nextRow = row;
+    return RME_EOF;
+}
+
+int RM_CloseColumnScan(RM_ColScanHandle *sh) {
+    int a;
+
+    for (a = 0; a < RM_MAXATTRS; a++) {
+        if (sh->pinnedPage[a] >= 0)
+            PF_UnfixPage(sh->fileHandle->pfFileDesc, sh->pinnedPage[a], FALSE);
+        sh->pinnedPage[a] = -1;
+        free(sh->dir[a]);
+        sh->dir[a] = NULL;
+    }
+    return RME_OK;
+}
@@ -0,0 +1,261 @@
+/*
+ * rmconvert.c: Loads the ';'-delimited tables of data/ into typed RM files.
+ *
+ * Usage: rmconvert [-i] [dataDir [outDir]]      (default ../../data and .)
+ *        rmconvert [-i] -f table.txt [outDir]
+ *
+ * Each data file starts with a "Database dummy - table X" title line.
+ * Every field is terminated by ';' and a record ends with one more ';',
+ * so a record is complete once a line ends in ";;" (crsedetails.txt has
+ * records that span several lines).
+ *
+ * The schema is inferred from the data: a column is an int if every value
+ * is a plain integer (no leading zeros, so codes such as "011007" stay
+ * strings), a float if every value is a decimal number, a fixed 'c' if
+ * every value has the same length and a varchar otherwise. Empty values
+ * become NULLs. The result is written to <table>.rm.
+ *
+ * The file is mapped and split in place by RM_OpenDelimFile and the
+ * records are written with the bulk loader (RM_BeginBulkLoad), which
+ * fills whole pages in memory and appends them to the file in large
+ * writes; -i inserts them one by one with RM_InsertRecord instead, for
+ * comparison. Each table reports its load rate (mapping, splitting,
+ * inference, encoding and writing) and the last line the overall rate.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <time.h>
+#include "pf.h"
+#include "rm.h"
+
+#define MAX_PATH_LEN 512
+#define MAX_FIXED_CHAR 16 /* Longer equal-length columns become varchars */
+
+/* What inference has seen of one column so far */
+typedef struct {
+    int allInt;
+    int allFloat;
+    int fixedLen;       // Common length, -1 if it varies, 0 if unseen
+    int maxLen;
+} ColumnInfo;
+
+static int bulk = TRUE; // FALSE (-i): one RM_InsertRecord per record
+
+static double Now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int IsPlainInt(char *v) {
+    char *p = (*v == '-') ? v + 1 : v;
+    int len = strlen(p);
+
+    if (len == 0 || len > 9 || (p[0] == '0' && len > 1))
+        return FALSE;
+    for (; *p; p++)
+        if (*p < '0' || *p > '9') return FALSE;
+    return TRUE;
+}
+
+static int IsDecimal(char *v) {
+    char *p = (*v == '-') ? v + 1 : v;
+    char *dot = strchr(p, '.');
+
+    if (dot == NULL || dot == p || dot[1] == '\0' || strlen(p) > 12)
+        return FALSE;
+    for (; *p; p++)
+        if ((*p < '0' || *p > '9') && p != dot) return FALSE;
+    return TRUE;
+}
+
+static void InferSchema(RM_DelimFile *df, RM_Schema *schema) {
+    ColumnInfo cols[RM_MAXATTRS];
+    char *values[RM_MAXATTRS];
+    char name[RM_MAXNAME];
+    int r, a, len;
+
+    for (a = 0; a < df->numAttrs; a++) {
+        cols[a].allInt = cols[a].allFloat = TRUE;
+        cols[a].fixedLen = 0;
+        cols[a].maxLen = 0;
+    }
+
+    for (r = 0; r < df->numRecords; r++) {
+        RM_GetDelimRecord(df, r, values);
+        for (a = 0; a < df->numAttrs; a++) {
+            char *v = values[a];
+            if (v == NULL || *v == '\0')
+                continue; // NULL, says nothing about the type
+            len = strlen(v);
+            if (!IsPlainInt(v)) cols[a].allInt = FALSE;
+            if (!IsPlainInt(v) && !IsDecimal(v)) cols[a].allFloat = FALSE;
+            if (cols[a].fixedLen == 0) cols[a].fixedLen = len;
+            else if (cols[a].fixedLen != len) cols[a].fixedLen = -1;
+            if (len > cols[a].maxLen) cols[a].maxLen = len;
+        }
+    }
+
+    RM_InitSchema(schema);
+    for (a = 0; a < df->numAttrs; a++) {
+        sprintf(name, "col%d", a);
+        if (cols[a].maxLen == 0)
+            RM_AddAttr(schema, name, RM_VARCHAR, 1); // Always NULL
+        else if (cols[a].allInt)
+            RM_AddAttr(schema, name, RM_INT, 0);
+        else if (cols[a].allFloat)
+            RM_AddAttr(schema, name, RM_FLOAT, 0);
+        else if (cols[a].fixedLen > 0 && cols[a].fixedLen <= MAX_FIXED_CHAR)
+            RM_AddAttr(schema, name, RM_CHAR, cols[a].fixedLen);
+        else
+            RM_AddAttr(schema, name, RM_VARCHAR,
+                       cols[a].maxLen < PF_PAGE_SIZE ? cols[a].maxLen : PF_PAGE_SIZE - 1);
+    }
+}
+
+static void PrintSchema(RM_Schema *schema) {
+    int a;
+
+    for (a = 0; a < schema->numAttrs; a++) {
+        RM_Attr *attr = &schema->attrs[a];
+        if (attr->type == RM_CHAR || attr->type == RM_VARCHAR)
+            printf("%s%c%d", a ? "," : "", attr->type, attr->length);
+        else
+            printf("%s%c", a ? "," : "", attr->type);
+    }
+}
+
+/*
+ * ConvertFile
+ * Desc: Loads one data file into <outDir>/<table>.rm and adds its rows
+ *       and load time to the totals.
+ */
+static int ConvertFile(char *dataPath, char *table, char *outDir,
+                       long *totalRows, double *totalSec) {
+    RM_DelimFile df;
+    RM_Schema schema;
+    RM_FileHandle fh;
+    RM_BulkLoader bl;
+    RID rid;
+    char rmPath[MAX_PATH_LEN];
+    char recBuf[PF_PAGE_SIZE];
+    char *values[RM_MAXATTRS];
+    long storedBytes = 0;
+    int recLen, loaded = 0, skipped = 0, numPages, r, err;
+    double start = Now(), sec;
+
+    if ((err = RM_OpenDelimFile(dataPath, ';', 1, &df)) != RME_OK) {
+        printf("Error: Could not read %s\n", dataPath);
+        return err;
+    }
+    InferSchema(&df, &schema);
+
+    snprintf(rmPath, sizeof(rmPath), "%s/%s.rm", outDir, table);
+    RM_DestroyFile(rmPath);
+    if ((err = RM_CreateTypedFile(rmPath, &schema)) != RME_OK ||
+        (err = RM_OpenFile(rmPath, PF_LRU, &fh)) != RME_OK ||
+        (err = RM_BeginBulkLoad(&fh, &bl)) != RME_OK) {
+        printf("Error: Could not create %s\n", rmPath);
+        RM_CloseDelimFile(&df);
+        return err;
+    }
+
+    for (r = 0; r < df.numRecords; r++) {
+        RM_GetDelimRecord(&df, r, values);
+        if (RM_EncodeRecord(&schema, values, recBuf, sizeof(recBuf), &recLen) == RME_OK &&
+            (bulk ? RM_BulkInsert(&bl, recBuf, recLen, &rid)
+                  : RM_InsertRecord(&fh, recBuf, recLen, &rid)) == RME_OK) {
+            loaded++;
+            storedBytes += recLen;
+        } else {
+            skipped++; // Longer than recBuf
+        }
+    }
+
+    RM_EndBulkLoad(&bl);
+    numPages = PF_GetNumPages(fh.pfFileDesc);
+    RM_CloseFile(&fh);
+    sec = Now() - start;
+
+    printf("%-12s %7d %7d %6d %9ld %9ld %9.0f  ", table, loaded, skipped,
+           numPages, df.size, storedBytes, loaded / sec);
+    PrintSchema(&schema);
+    printf("\n");
+
+    *totalRows += loaded;
+    *totalSec += sec;
+    RM_CloseDelimFile(&df);
+    return RME_OK;
+}
+
+/* Strips the directory and ".txt" from a data file path */
+static void TableName(char *path, char *table) {
+    char *base = strrchr(path, '/');
+    char *dot;
+
+    strcpy(table, base ? base + 1 : path);
+    if ((dot = strrchr(table, '.')) != NULL && strcmp(dot, ".txt") == 0)
+        *dot = '\0';
+}
+
+static void PrintHeader() {
+    printf("%-12s %7s %7s %6s %9s %9s %9s  %s\n", "table", "rows", "skipped",
+           "pages", "textbytes", "recbytes", "rows/sec", "schema");
+}
+
+static void PrintTotal(int numFiles, long totalRows, double totalSec) {
+    printf("%d files, %ld rows in %f sec: %.0f rows/sec (%s)\n", numFiles, totalRows,
+           totalSec, totalRows / totalSec, bulk ? "bulk load" : "RM_InsertRecord");
+}
+
+int main(int argc, char *argv[]) {
+    char *dataDir = "../../data", *outDir = ".";
+    char path[MAX_PATH_LEN], table[MAX_PATH_LEN];
+    struct dirent **entries;
+    long totalRows = 0;
+    double totalSec = 0;
+    int n, i, len, numFiles = 0, err;
+
+    PF_Init(50);
+
+    if (argc >= 2 && strcmp(argv[1], "-i") == 0) {
+        bulk = FALSE;
+        argc--;
+        argv++;
+    }
+
+    if (argc >= 3 && strcmp(argv[1], "-f") == 0) {
+        if (argc >= 4) outDir = argv[3];
+        TableName(argv[2], table);
+        PrintHeader();
+        err = ConvertFile(argv[2], table, outDir, &totalRows, &totalSec);
+        if (err == RME_OK)
+            PrintTotal(1, totalRows, totalSec);
+        return (err == RME_OK) ? 0 : 1;
+    }
+
+    if (argc >= 2) dataDir = argv[1];
+    if (argc >= 3) outDir = argv[2];
+
+    if ((n = scandir(dataDir, &entries, NULL, alphasort)) < 0) {
+        printf("Error: Could not read directory %s\n", dataDir);
+        return 1;
+    }
+
+    PrintHeader();
+    for (i = 0; i < n; i++) {
+        len = strlen(entries[i]->d_name);
+        if (len > 4 && strcmp(entries[i]->d_name + len - 4, ".txt") == 0) {
+            snprintf(path, sizeof(path), "%s/%s", dataDir, entries[i]->d_name);
+            TableName(path, table);
+            if (ConvertFile(path, table, outDir, &totalRows, &totalSec) == RME_OK)
+                numFiles++;
+        }
+        free(entries[i]);
+    }
+    free(entries);
+    PrintTotal(numFiles, totalRows, totalSec);
+    return 0;
+}
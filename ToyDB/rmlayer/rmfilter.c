@@ -0,0 +1,367 @@
+/* rmfilter.c: compiled scan filters and projections for the RM layer */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "rm.h"
+#include "pf.h"
+
+/*
+ * Records are treated as delimited text that may carry a trailing NUL
+ * (the test programs store it), so a field ends at the delimiter, the
+ * NUL or the record length, whichever comes first.
+ */
+
+/*
+ * RM_FindField
+ * Desc: Locates field number 'field' inside rec[0..recLength).
+ * Returns: Pointer to the first byte of the field (length in *fieldLen),
+ *          or NULL if the record has fewer fields.
+ */
+static char *RM_FindField(char *rec, int recLength, char delim, int field, int *fieldLen) {
+    char *end, *nul, *p, *next;
+
+    // Stop at the first NUL, if the record carries one
+    if ((nul = memchr(rec, '\0', recLength)) != NULL)
+        recLength = nul - rec;
+    end = rec + recLength;
+
+    p = rec;
+    while (field > 0) {
+        if ((next = memchr(p, delim, end - p)) == NULL)
+            return NULL; // Not enough fields
+        p = next + 1;
+        field--;
+    }
+
+    next = memchr(p, delim, end - p);
+    *fieldLen = (next == NULL) ? (end - p) : (next - p);
+    return p;
+}
+
+/*
+ * RM_ParseInt
+ * Desc: atoi() over a non-terminated field; leading blanks and a sign
+ *       are allowed, parsing stops at the first non-digit.
+ */
+static int RM_ParseInt(char *p, int len) {
+    int val = 0, neg = FALSE, i = 0;
+
+    while (i < len && p[i] == ' ') i++;
+    if (i < len && (p[i] == '-' || p[i] == '+')) {
+        neg = (p[i] == '-');
+        i++;
+    }
+    for (; i < len && p[i] >= '0' && p[i] <= '9'; i++)
+        val = val * 10 + (p[i] - '0');
+    return neg ? -val : val;
+}
+
+/*
+ * RM_ParseFloat
+ * Desc: atof() over a non-terminated field.
+ */
+static float RM_ParseFloat(char *p, int len) {
+    char tmp[RM_MAXVALLEN];
+
+    if (len >= RM_MAXVALLEN) len = RM_MAXVALLEN - 1;
+    memcpy(tmp, p, len);
+    tmp[len] = '\0';
+    return (float)atof(tmp);
+}
+
+/* Applies op to a three-way comparison result (field vs constant) */
+int RM_ApplyOp(int op, int cmp) {
+    switch (op) {
+        case RM_EQ: return cmp == 0;
+        case RM_LT: return cmp < 0;
+        case RM_GT: return cmp > 0;
+        case RM_LE: return cmp <= 0;
+        case RM_GE: return cmp >= 0;
+        case RM_NE: return cmp != 0;
+    }
+    return FALSE;
+}
+
+
+/* --- Filters --- */
+
+void RM_InitFilter(RM_Filter *filter, char delim) {
+    filter->delim = delim;
+    filter->schema = NULL;
+    filter->numPreds = 0;
+}
+
+void RM_InitTypedFilter(RM_Filter *filter, RM_Schema *schema) {
+    filter->delim = '\0';
+    filter->schema = schema;
+    filter->numPreds = 0;
+}
+
+int RM_AddPredicate(RM_Filter *filter, int field, char attrType, int op, char *value) {
+    RM_Predicate *pred;
+
+    if (filter->numPreds >= RM_MAXPREDS || field < 0 || value == NULL)
+        return RME_INVALIDARG;
+    if (op < RM_EQ || op > RM_NE)
+        return RME_INVALIDARG;
+
+    // Typed fields must be compared as what they are stored as
+    if (filter->schema != NULL) {
+        char stored;
+        if (field >= filter->schema->numAttrs)
+            return RME_INVALIDARG;
+        stored = filter->schema->attrs[field].type;
+        if (stored == RM_VARCHAR) stored = RM_CHAR;
+        if (attrType != stored)
+            return RME_INVALIDARG;
+    }
+
+    pred = &filter->preds[filter->numPreds];
+    pred->field = field;
+    pred->attrType = attrType;
+    pred->op = op;
+
+    // Compile the constant into its native form
+    switch (attrType) {
+        case 'i':
+            pred->intVal = atoi(value);
+            break;
+        case 'f':
+            pred->floatVal = (float)atof(value);
+            break;
+        case 'c':
+            pred->strLen = strlen(value);
+            if (pred->strLen > RM_MAXVALLEN)
+                return RME_INVALIDARG;
+            memcpy(pred->strVal, value, pred->strLen);
+            break;
+        default:
+            return RME_INVALIDARG;
+    }
+
+    filter->numPreds++;
+    return RME_OK;
+}
+
+int RM_CompareField(RM_Predicate *pred, char *fieldPtr, int fieldLen, int typed) {
+    int cmp;
+
+    switch (pred->attrType) {
+        case 'i': {
+            int v;
+            if (typed)
+                memcpy(&v, fieldPtr, sizeof(int));
+            else
+                v = RM_ParseInt(fieldPtr, fieldLen);
+            return (v > pred->intVal) - (v < pred->intVal);
+        }
+        case 'f': {
+            float v;
+            if (typed)
+                memcpy(&v, fieldPtr, sizeof(float));
+            else
+                v = RM_ParseFloat(fieldPtr, fieldLen);
+            return (v > pred->floatVal) - (v < pred->floatVal);
+        }
+        default: { // 'c': strcmp() ordering on the raw bytes
+            // Fixed-length typed fields are NUL-padded
+            if (typed)
+                while (fieldLen > 0 && fieldPtr[fieldLen - 1] == '\0')
+                    fieldLen--;
+            int n = (fieldLen < pred->strLen) ? fieldLen : pred->strLen;
+            cmp = memcmp(fieldPtr, pred->strVal, n);
+            if (cmp == 0)
+                cmp = (fieldLen > pred->strLen) - (fieldLen < pred->strLen);
+            return cmp;
+        }
+    }
+}
+
+int RM_EvalFilter(RM_Filter *filter, char *rec, int recLength) {
+    RM_Predicate *pred;
+    char *fieldPtr;
+    int fieldLen, i;
+
+    if (filter == NULL)
+        return TRUE;
+
+    for (i = 0; i < filter->numPreds; i++) {
+        pred = &filter->preds[i];
+        if (filter->schema != NULL) {
+            // Typed record: O(1) lookup, NULL never qualifies
+            if (RM_GetField(filter->schema, rec, pred->field, &fieldPtr, &fieldLen) != RME_OK)
+                return FALSE;
+        } else {
+            fieldPtr = RM_FindField(rec, recLength, filter->delim, pred->field, &fieldLen);
+            if (fieldPtr == NULL)
+                return FALSE; // A missing field never qualifies
+        }
+
+        if (!RM_ApplyOp(pred->op, RM_CompareField(pred, fieldPtr, fieldLen, filter->schema != NULL)))
+            return FALSE;
+    }
+    return TRUE;
+}
+
+
+/* --- Projections --- */
+
+void RM_InitProjection(RM_Projection *proj, char delim) {
+    proj->delim = delim;
+    proj->numFields = 0;
+}
+
+int RM_AddProjField(RM_Projection *proj, int field) {
+    if (proj->numFields >= RM_MAXPROJ || field < 0)
+        return RME_INVALIDARG;
+    proj->fields[proj->numFields++] = field;
+    return RME_OK;
+}
+
+/*
+ * RM_Project
+ * Desc: Copies the projected fields of rec into dataBuf, joined by the
+ *       delimiter and NUL-terminated. Missing fields come out empty.
+ *       If they do not fit, *dataLength is set to the buffer size they
+ *       need, NUL included.
+ * Returns: RME_OK or RME_BUFTOOSMALL
+ */
+int RM_Project(RM_Projection *proj, char *rec, int recLength,
+               char *dataBuf, int bufSize, int *dataLength) {
+    char *fieldPtr;
+    int fieldLen, out = 0, fits = TRUE, i;
+
+    for (i = 0; i < proj->numFields; i++) {
+        fieldPtr = RM_FindField(rec, recLength, proj->delim, proj->fields[i], &fieldLen);
+        if (fieldPtr == NULL)
+            fieldLen = 0;
+
+        // Room for the field, a separator and the final NUL; once it
+        // does not fit, only the length is counted
+        if (out + fieldLen + 2 > bufSize)
+            fits = FALSE;
+        if (i > 0) {
+            if (fits)
+                dataBuf[out] = proj->delim;
+            out++;
+        }
+        if (fits && fieldLen > 0)
+            memcpy(dataBuf + out, fieldPtr, fieldLen);
+        out += fieldLen;
+    }
+
+    if (!fits || out + 1 > bufSize) {
+        *dataLength = out + 1;
+        return RME_BUFTOOSMALL;
+    }
+    dataBuf[out] = '\0';
+    *dataLength = out;
+    return RME_OK;
+}
+
+
+/* --- Sort Keys --- */
+
+void RM_InitOrderBy(RM_OrderBy *order, char delim) {
+    order->delim = delim;
+    order->schema = NULL;
+    order->numKeys = 0;
+}
+
+void RM_InitTypedOrderBy(RM_OrderBy *order, RM_Schema *schema) {
+    order->delim = '\0';
+    order->schema = schema;
+    order->numKeys = 0;
+}
+
+int RM_AddOrderKey(RM_OrderBy *order, int field, char attrType, int descending) {
+    if (order->numKeys >= RM_MAXORDER || field < 0)
+        return RME_INVALIDARG;
+    if (attrType != 'i' && attrType != 'f' && attrType != 'c')
+        return RME_INVALIDARG;
+    if (order->schema != NULL) {
+        char stored;
+        if (field >= order->schema->numAttrs)
+            return RME_INVALIDARG;
+        stored = order->schema->attrs[field].type;
+        if (stored == RM_VARCHAR) stored = RM_CHAR;
+        if (attrType != stored)
+            return RME_INVALIDARG;
+    }
+
+    order->fields[order->numKeys] = field;
+    order->attrTypes[order->numKeys] = attrType;
+    order->descending[order->numKeys] = descending;
+    order->numKeys++;
+    return RME_OK;
+}
+
+/*
+ * RM_CompareValues
+ * Desc: Three-way comparison of two fields of one type, stored (typed)
+ *       or as text.
+ */
+static int RM_CompareValues(char attrType, char *a, int aLen, char *b, int bLen, int typed) {
+    int cmp, n;
+
+    switch (attrType) {
+        case 'i': {
+            int va, vb;
+            if (typed) {
+                memcpy(&va, a, sizeof(int));
+                memcpy(&vb, b, sizeof(int));
+            } else {
+                va = RM_ParseInt(a, aLen);
+                vb = RM_ParseInt(b, bLen);
+            }
+            return (va > vb) - (va < vb);
+        }
+        case 'f': {
+            float va, vb;
+            if (typed) {
+                memcpy(&va, a, sizeof(float));
+                memcpy(&vb, b, sizeof(float));
+            } else {
+                va = RM_ParseFloat(a, aLen);
+                vb = RM_ParseFloat(b, bLen);
+            }
+            return (va > vb) - (va < vb);
+        }
+        default: // 'c'
+            if (typed) {
+                while (aLen > 0 && a[aLen - 1] == '\0') aLen--;
+                while (bLen > 0 && b[bLen - 1] == '\0') bLen--;
+            }
+            n = (aLen < bLen) ? aLen : bLen;
+            if ((cmp = memcmp(a, b, n)) == 0)
+                cmp = (aLen > bLen) - (aLen < bLen);
+            return cmp;
+    }
+}
+
+int RM_CompareRecords(void *arg, char *a, int aLen, char *b, int bLen) {
+    RM_OrderBy *order = (RM_OrderBy *)arg;
+    char *fa, *fb;
+    int la, lb, i, cmp;
+
+    for (i = 0; i < order->numKeys; i++) {
+        if (order->schema != NULL) {
+            if (RM_GetField(order->schema, a, order->fields[i], &fa, &la) != RME_OK)
+                fa = NULL;
+            if (RM_GetField(order->schema, b, order->fields[i], &fb, &lb) != RME_OK)
+                fb = NULL;
+        } else {
+            fa = RM_FindField(a, aLen, order->delim, order->fields[i], &la);
+            fb = RM_FindField(b, bLen, order->delim, order->fields[i], &lb);
+        }
+
+        // A missing or NULL field sorts before any value
+        if (fa == NULL || fb == NULL)
+            cmp = (fa != NULL) - (fb != NULL);
+        else
+            cmp = RM_CompareValues(order->attrTypes[i], fa, la, fb, lb, order->schema != NULL);
+        if (cmp != 0)
+            return order->descending[i] ? -cmp : cmp;
+    }
+    return 0;
+}
@@ -0,0 +1,373 @@
+/* rmfixed.c: Fixed-length page layout for RM files */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "rm.h"
+#include "rmtypes.h"
+#include "pf.h"
+
+/*
+ * When every record has the same length the slot directory only repeats
+ * what the slot number already says. A fixed-length page is
+ *
+ *   [FixedPageHeader][present bitmap, 64-bit words][record 0][record 1]...
+ *
+ * and record i sits at dataOff + i * recordLength (see RM_FixedLayout).
+ * An insert takes the first clear bit of the bitmap, a scan walks the
+ * set bits a word at a time. RIDs are (page, slot) and never move.
+ */
+typedef struct {
+    int numSlots;    // Slots ever used (high-water mark)
+    int numRecords;  // Slots with their present bit set
+} FixedPageHeader;
+
+typedef unsigned long long BitWord;
+
+#define FIXED_HEADER(pageData) ((FixedPageHeader *)(pageData))
+#define FIXED_BITMAP(pageData) ((BitWord *)((pageData) + sizeof(FixedPageHeader)))
+#define FIXED_WORDS(capacity) (((capacity) + 63) / 64)
+#define FIXED_RECORD(layout, pageData, slot) \
+    ((pageData) + (layout)->dataOff + (slot) * (layout)->recordLength)
+
+#define WORD_BIT(slot) ((BitWord)1 << ((slot) % 64))
+
+
+/* --- Layout --- */
+
+int RM_FixedInitLayout(int recordLength, RM_FixedLayout *layout) {
+    int capacity;
+
+    layout->recordLength = recordLength;
+    layout->capacity = 0;
+    if (recordLength <= 0 || recordLength > PF_PAGE_SIZE)
+        return 0;
+
+    // Start from the estimate without the bitmap, then shrink
+    capacity = (PF_PAGE_SIZE - sizeof(FixedPageHeader)) / recordLength;
+    if (capacity > 0xFFFF)
+        capacity = 0xFFFF; // Slot numbers are 16 bits in a RID
+    while (capacity > 0 && sizeof(FixedPageHeader) + FIXED_WORDS(capacity) * sizeof(BitWord) +
+                           capacity * recordLength > PF_PAGE_SIZE)
+        capacity--;
+
+    layout->capacity = capacity;
+    layout->dataOff = sizeof(FixedPageHeader) + FIXED_WORDS(capacity) * sizeof(BitWord);
+    return capacity;
+}
+
+/*
+ * RM_FixedNextSlot
+ * Desc: Finds the first used slot in [from, limit) of a page, skipping
+ *       empty words of the bitmap whole.
+ * Returns: the slot, or -1 if there is none
+ */
+static int RM_FixedNextSlot(char *pageData, int from, int limit) {
+    BitWord *bitmap = FIXED_BITMAP(pageData);
+    BitWord bits;
+    int w, slot;
+
+    if (from >= limit)
+        return -1;
+    w = from / 64;
+    bits = bitmap[w] & (~(BitWord)0 << (from % 64));
+    while (bits == 0) {
+        if (++w >= FIXED_WORDS(limit))
+            return -1;
+        bits = bitmap[w];
+    }
+    slot = w * 64 + __builtin_ctzll(bits);
+    return (slot < limit) ? slot : -1;
+}
+
+/* Finds the first free slot of a page that is known to have one */
+static int RM_FixedFreeSlot(RM_FixedLayout *layout, char *pageData) {
+    BitWord *bitmap = FIXED_BITMAP(pageData);
+    int w;
+
+    for (w = 0; w < FIXED_WORDS(layout->capacity); w++) {
+        if (~bitmap[w] != 0)
+            return w * 64 + __builtin_ctzll(~bitmap[w]);
+    }
+    return -1;
+}
+
+
+/* --- Records --- */
+
+int RM_FixedInsertRecord(RM_FileHandle *fh, char *data, int dataLength, RID *rid) {
+    RM_FixedLayout *layout = &fh->fixed;
+    char *pageData;
+    int pageNum, pf_err, slot;
+    int found = FALSE;
+
+    if (dataLength != layout->recordLength)
+        return RME_INVALIDARG;
+
+    // 1. Try the page the previous insert went to
+    if (fh->insertPage != -1) {
+        pageNum = fh->insertPage;
+        if ((pf_err = PF_GetThisPage(fh->pfFileDesc, pageNum, &pageData)) != PFE_OK) {
+            PF_PrintError("RM_FixedInsertRecord: PF_GetThisPage");
+            return pf_err;
+        }
+        if (FIXED_HEADER(pageData)->numRecords < layout->capacity) {
+            found = TRUE;
+        } else {
+            RM_NoteRoom(fh, pageNum, 0);
+            if ((pf_err = PF_UnfixPage(fh->pfFileDesc, pageNum, FALSE)) != PFE_OK) {
+                PF_PrintError("RM_FixedInsertRecord: PF_UnfixPage");
+                return pf_err;
+            }
+        }
+    }
+
+    // 2. Otherwise take the first page the free-space map says may
+    //    have a free slot
+    while (!found && (pf_err = RM_FindRoom(fh, 1, &pageNum)) == RME_OK) {
+        if ((pf_err = PF_GetThisPage(fh->pfFileDesc, pageNum, &pageData)) != PFE_OK) {
+            if (pf_err != PFE_INVALIDPAGE) {
+                PF_PrintError("RM_FixedInsertRecord: PF_GetThisPage");
+                return pf_err;
+            }
+            RM_NoteRoom(fh, pageNum, 0); // A free page of the PF file
+            continue;
+        }
+        if (FIXED_HEADER(pageData)->numRecords < layout->capacity) {
+            found = TRUE;
+            break;
+        }
+        RM_NoteRoom(fh, pageNum, 0);
+        if ((pf_err = PF_UnfixPage(fh->pfFileDesc, pageNum, FALSE)) != PFE_OK) {
+            PF_PrintError("RM_FixedInsertRecord: PF_UnfixPage");
+            return pf_err;
+        }
+    }
+
+    // 3. If no page found, allocate a new one
+    if (!found) {
+        if (pf_err != RME_EOF)
+            return pf_err; // PF_GetNumPages failed, or no memory for the map
+        if ((pf_err = PF_AllocPage(fh->pfFileDesc, &pageNum, &pageData)) != PFE_OK) {
+            PF_PrintError("RM_FixedInsertRecord: PF_AllocPage");
+            return pf_err;
+        }
+        memset(pageData, 0, PF_PAGE_SIZE); // Empty header and bitmap
+    }
+    fh->insertPage = pageNum;
+
+    // 4. Copy the record to its place and mark it used
+    slot = RM_FixedFreeSlot(layout, pageData);
+    memcpy(FIXED_RECORD(layout, pageData, slot), data, dataLength);
+    FIXED_BITMAP(pageData)[slot / 64] |= WORD_BIT(slot);
+    FIXED_HEADER(pageData)->numRecords++;
+    if (slot >= FIXED_HEADER(pageData)->numSlots)
+        FIXED_HEADER(pageData)->numSlots = slot + 1;
+
+    *rid = RM_PackRID(pageNum, slot);
+    RM_NoteRoom(fh, pageNum, layout->capacity - FIXED_HEADER(pageData)->numRecords);
+
+    if ((pf_err = PF_UnfixPage(fh->pfFileDesc, pageNum, TRUE)) != PFE_OK) {
+        PF_PrintError("RM_FixedInsertRecord: PF_UnfixPage (dirty)");
+        return pf_err;
+    }
+    return RME_OK;
+}
+
+/*
+ * RM_FixedFixRecord
+ * Desc: Fixes the page of rid and checks that its slot holds a record.
+ */
+static int RM_FixedFixRecord(RM_FileHandle *fh, RID rid, char *caller,
+                             int *pageNum, int *slot, char **pageData) {
+    int pf_err;
+
+    RM_UnpackRID(rid, pageNum, slot);
+    if (*pageNum < RM_FIRST_DATA_PAGE)
+        return RME_INVALIDRID;
+    if ((pf_err = PF_GetThisPage(fh->pfFileDesc, *pageNum, pageData)) != PFE_OK) {
+        PF_PrintError(caller);
+        return (pf_err == PFE_INVALIDPAGE) ? RME_INVALIDRID : pf_err;
+    }
+    if (*slot >= FIXED_HEADER(*pageData)->numSlots ||
+        !(FIXED_BITMAP(*pageData)[*slot / 64] & WORD_BIT(*slot))) {
+        PF_UnfixPage(fh->pfFileDesc, *pageNum, FALSE);
+        return RME_INVALIDRID;
+    }
+    return RME_OK;
+}
+
+int RM_FixedDeleteRecord(RM_FileHandle *fh, RID rid) {
+    char *pageData;
+    int pageNum, slot, err;
+
+    if ((err = RM_FixedFixRecord(fh, rid, "RM_DeleteRecord: PF_GetThisPage",
+                                 &pageNum, &slot, &pageData)) != RME_OK)
+        return err;
+
+    // The bytes stay behind; only the present bit says the slot is used
+    FIXED_BITMAP(pageData)[slot / 64] &= ~WORD_BIT(slot);
+    FIXED_HEADER(pageData)->numRecords--;
+    RM_NoteRoom(fh, pageNum, fh->fixed.capacity - FIXED_HEADER(pageData)->numRecords);
+    while ((slot = FIXED_HEADER(pageData)->numSlots - 1) >= 0 &&
+           !(FIXED_BITMAP(pageData)[slot / 64] & WORD_BIT(slot)))
+        FIXED_HEADER(pageData)->numSlots--; // Scans stop at the last used slot
+
+    if ((err = PF_UnfixPage(fh->pfFileDesc, pageNum, TRUE)) != PFE_OK) {
+        PF_PrintError("RM_DeleteRecord: PF_UnfixPage (dirty)");
+        return err;
+    }
+    return RME_OK;
+}
+
+int RM_FixedUpdateRecord(RM_FileHandle *fh, RID rid, char *data, int dataLength) {
+    char *pageData;
+    int pageNum, slot, err;
+
+    if (dataLength != fh->fixed.recordLength)
+        return RME_INVALIDARG;
+    if ((err = RM_FixedFixRecord(fh, rid, "RM_UpdateRecord: PF_GetThisPage",
+                                 &pageNum, &slot, &pageData)) != RME_OK)
+        return err;
+
+    // Same length, same place
+    memcpy(FIXED_RECORD(&fh->fixed, pageData, slot), data, dataLength);
+
+    if ((err = PF_UnfixPage(fh->pfFileDesc, pageNum, TRUE)) != PFE_OK) {
+        PF_PrintError("RM_UpdateRecord: PF_UnfixPage (dirty)");
+        return err;
+    }
+    return RME_OK;
+}
+
+int RM_FixedGetRecord(RM_FileHandle *fh, RID rid, char *dataBuf, int bufSize, int *dataLength) {
+    char *pageData;
+    int pageNum, slot, err, pf_err;
+
+    if ((err = RM_FixedFixRecord(fh, rid, "RM_GetRecord: PF_GetThisPage",
+                                 &pageNum, &slot, &pageData)) != RME_OK)
+        return err;
+
+    if (bufSize < fh->fixed.recordLength) {
+        err = RME_BUFTOOSMALL;
+    } else {
+        memcpy(dataBuf, FIXED_RECORD(&fh->fixed, pageData, slot), fh->fixed.recordLength);
+        *dataLength = fh->fixed.recordLength;
+    }
+
+    if ((pf_err = PF_UnfixPage(fh->pfFileDesc, pageNum, FALSE)) != PFE_OK) {
+        PF_PrintError("RM_GetRecord: PF_UnfixPage");
+        return pf_err;
+    }
+    return err;
+}
+
+
+/* --- Scanning --- */
+
+int RM_FixedGetNextRecord(RM_ScanHandle *sh, RID *rid, char *dataBuf, int bufSize, int *dataLength) {
+    RM_FixedLayout *layout = &sh->fileHandle->fixed;
+    char *rec;
+    int err;
+
+    while (TRUE) {
+        // 1. Check if we need to get a new page
+        if (sh->pageData == NULL) {
+            if ((err = RM_ScanNextPage(sh, "RM_GetNextRecord: PF_GetFirst/NextPage")) != RME_OK)
+                return err;
+        }
+
+        // 2. Test the used slots of the page in turn
+        while ((sh->currentSlot = RM_FixedNextSlot(sh->pageData, sh->currentSlot + 1,
+                                                   FIXED_HEADER(sh->pageData)->numSlots)) != -1) {
+            rec = FIXED_RECORD(layout, sh->pageData, sh->currentSlot);
+            if (!RM_EvalFilter(sh->filter, rec, layout->recordLength))
+                continue;
+
+            if (sh->proj != NULL) {
+                if ((err = RM_Project(sh->proj, rec, layout->recordLength,
+                                      dataBuf, bufSize, dataLength)) != RME_OK) {
+                    if (err == RME_BUFTOOSMALL)
+                        sh->currentSlot--; // Returned again by the next call
+                    return err;
+                }
+            } else {
+                if (bufSize < layout->recordLength) {
+                    *dataLength = layout->recordLength;
+                    sh->currentSlot--; // Returned again by the next call
+                    return RME_BUFTOOSMALL;
+                }
+                memcpy(dataBuf, rec, layout->recordLength);
+                *dataLength = layout->recordLength;
+            }
+            *rid = RM_PackRID(sh->currentPage, sh->currentSlot);
+            return RME_OK;
+        }
+
+        // 3. Page drained, move on
+        sh->pageData = NULL;
+    }
+}
+
+int RM_FixedGetNextBatch(RM_ScanHandle *sh, RM_Batch *batch) {
+    RM_FixedLayout *layout = &sh->fileHandle->fixed;
+    BitWord *bitmap, bits;
+    char *rec;
+    int err, n, w, numSlots, slot;
+
+    while (TRUE) {
+        // 1. Move to the next page once the current one is drained
+        if (sh->pageData == NULL) {
+            if ((err = RM_ScanNextPage(sh, "RM_GetNextBatch: PF_GetFirst/NextPage")) != RME_OK)
+                return err;
+        }
+
+        // 2. Walk the bitmap a word at a time, from the slot after the
+        //    last one returned
+        bitmap = FIXED_BITMAP(sh->pageData);
+        numSlots = FIXED_HEADER(sh->pageData)->numSlots;
+        n = 0;
+        while (n < batch->capacity && sh->currentSlot + 1 < numSlots) {
+            slot = sh->currentSlot + 1;
+            w = slot / 64;
+            bits = bitmap[w] & (~(BitWord)0 << (slot % 64));
+            sh->currentSlot = w * 64 + 63; // The whole word, unless the batch fills
+
+            // Unfiltered, a word whose records all fit is taken without
+            // checking each of them
+            if (sh->filter == NULL && __builtin_popcountll(bits) <= batch->capacity - n) {
+                for (; bits != 0; bits &= bits - 1) {
+                    slot = w * 64 + __builtin_ctzll(bits);
+                    batch->rids[n] = RM_PackRID(sh->currentPage, slot);
+                    batch->recPtrs[n] = FIXED_RECORD(layout, sh->pageData, slot);
+                    batch->lengths[n] = layout->recordLength;
+                    n++;
+                }
+                continue;
+            }
+
+            for (; bits != 0; bits &= bits - 1) {
+                slot = w * 64 + __builtin_ctzll(bits);
+                rec = FIXED_RECORD(layout, sh->pageData, slot);
+                if (!RM_EvalFilter(sh->filter, rec, layout->recordLength))
+                    continue;
+                batch->rids[n] = RM_PackRID(sh->currentPage, slot);
+                batch->recPtrs[n] = rec;
+                batch->lengths[n] = layout->recordLength;
+                if (++n == batch->capacity) {
+                    sh->currentSlot = slot; // Resume after it next time
+                    break;
+                }
+            }
+        }
+
+        // 3. Hand back what we found; the page stays pinned until the
+        //    next call, so the pointers remain valid for the caller
+        if (n > 0) {
+            batch->numRecords = n;
+            return RME_OK;
+        }
+
+        // Drained without a match: move on to the next page
+        sh->pageData = NULL;
+    }
+}
@@ -0,0 +1,334 @@
+/* rmload.c: Delimited text files and bulk loading for RM files */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "rm.h"
+#include "rmtypes.h"
+#include "pf.h"
+
+/*
+ * A delimited file is read through a private mapping and cut up where
+ * it lies: each delimiter becomes the NUL ending its field, so a field
+ * is a C string pointing into the file and nothing is copied. The
+ * splitter asks for a bitmask of the delimiters and newlines in the
+ * next 16 bytes and then visits only the set bits, so the bytes inside
+ * fields are compared all at once instead of one at a time.
+ */
+#define SCAN_WIDTH 16
+
+/* Bit i set: p[i] is the delimiter or a newline (SCAN_WIDTH bytes) */
+static unsigned RM_DelimMask(char *p, char delim) {
+#ifdef __SSE2__
+    __m128i chunk = _mm_loadu_si128((__m128i *)p);
+    __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(delim)),
+                                _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n')));
+    return (unsigned)_mm_movemask_epi8(hits);
+#else
+    unsigned mask = 0;
+    int i;
+
+    for (i = 0; i < SCAN_WIDTH; i++)
+        if (p[i] == delim || p[i] == '\n')
+            mask |= 1u << i;
+    return mask;
+#endif
+}
+
+/* Same, for the last n < SCAN_WIDTH bytes of the text */
+static unsigned RM_DelimMaskTail(char *p, int n, char delim) {
+    unsigned mask = 0;
+    int i;
+
+    for (i = 0; i < n; i++)
+        if (p[i] == delim || p[i] == '\n')
+            mask |= 1u << i;
+    return mask;
+}
+
+/*
+ * RM_ReadText
+ * Desc: Maps the file, or reads it into memory when it is empty or its
+ *       last byte is not one the splitter may overwrite with a NUL.
+ */
+static int RM_ReadText(char *fileName, char delim, RM_DelimFile *df) {
+    struct stat st;
+    char last;
+    int fd;
+
+    if ((fd = open(fileName, O_RDONLY)) < 0)
+        return RME_ERROR;
+    if (fstat(fd, &st) < 0) {
+        close(fd);
+        return RME_ERROR;
+    }
+    df->size = st.st_size;
+
+    if (df->size > 0 && pread(fd, &last, 1, df->size - 1) == 1 &&
+        (last == '\n' || last == '\r' || last == delim)) {
+        df->text = mmap(NULL, df->size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (df->text != MAP_FAILED) {
+            madvise(df->text, df->size, MADV_SEQUENTIAL);
+            df->mapped = TRUE;
+            close(fd);
+            return RME_OK;
+        }
+    }
+
+    // Copy with a NUL after the end
+    df->mapped = FALSE;
+    if ((df->text = malloc(df->size + 1)) == NULL) {
+        close(fd);
+        return RME_NOMEM;
+    }
+    if (pread(fd, df->text, df->size, 0) != df->size) {
+        free(df->text);
+        close(fd);
+        return RME_ERROR;
+    }
+    df->text[df->size] = '\0';
+    close(fd);
+    return RME_OK;
+}
+
+/* Appends a field; the table grows by doubling */
+static int RM_AddValue(RM_DelimFile *df, int *numValues, int *capacity, char *value) {
+    if (*numValues == *capacity) {
+        *capacity *= 2;
+        if ((df->values = realloc(df->values, sizeof(char *) * *capacity)) == NULL)
+            return RME_NOMEM;
+    }
+    df->values[(*numValues)++] = value;
+    return RME_OK;
+}
+
+/* Closes the record whose fields are values[first[numRecords] .. numValues-1] */
+static int RM_AddDelimRecord(RM_DelimFile *df, int numValues, int *capacity) {
+    int numFields = numValues - df->first[df->numRecords];
+
+    if (df->numRecords + 1 == *capacity) {
+        *capacity *= 2;
+        if ((df->first = realloc(df->first, sizeof(int) * *capacity)) == NULL)
+            return RME_NOMEM;
+    }
+    if (numFields > df->numAttrs)
+        df->numAttrs = numFields;
+    df->first[++df->numRecords] = numValues;
+    return RME_OK;
+}
+
+int RM_OpenDelimFile(char *fileName, char delim, int skipLines, RM_DelimFile *df) {
+    char *p, *end, *base, *q, *e, *fieldStart;
+    char *lastDelim = NULL, *prevDelim = NULL; // The two latest delimiters
+    int numValues = 0, valueCap = 4096, recordCap = 1024;
+    int numFields = 0; // Fields of the open record, past RM_MAXATTRS too
+    unsigned mask;
+    int err = RME_OK;
+
+    df->numRecords = 0;
+    df->numAttrs = 0;
+    df->values = NULL;
+    df->first = NULL;
+    if ((err = RM_ReadText(fileName, delim, df)) != RME_OK)
+        return err;
+    df->values = malloc(sizeof(char *) * valueCap);
+    df->first = malloc(sizeof(int) * recordCap);
+    if (df->values == NULL || df->first == NULL) {
+        RM_CloseDelimFile(df);
+        return RME_NOMEM;
+    }
+    df->first[0] = 0;
+
+    // 1. Skip the title lines
+    p = df->text;
+    end = df->text + df->size;
+    while (skipLines-- > 0 && p < end) {
+        if ((p = memchr(p, '\n', end - p)) == NULL)
+            p = end;
+        else
+            p++;
+    }
+
+    // 2. Visit every delimiter and newline, SCAN_WIDTH bytes at a time
+    fieldStart = p;
+    for (base = p; base < end; base += SCAN_WIDTH) {
+        if (end - base >= SCAN_WIDTH)
+            mask = RM_DelimMask(base, delim);
+        else
+            mask = RM_DelimMaskTail(base, end - base, delim);
+
+        for (; mask != 0; mask &= mask - 1) {
+            q = base + __builtin_ctz(mask);
+            if (*q == delim) {
+                // End of a field
+                *q = '\0';
+                if (numFields++ < RM_MAXATTRS &&
+                    (err = RM_AddValue(df, &numValues, &valueCap, fieldStart)) != RME_OK)
+                    break;
+                prevDelim = lastDelim;
+                lastDelim = q;
+                fieldStart = q + 1;
+                continue;
+            }
+
+            // A newline ends the record if the line ends in two delimiters
+            // (CRLF tolerated); any other newline is part of the field
+            e = (q > df->text && q[-1] == '\r') ? q - 1 : q;
+            if (numFields == 0 || lastDelim != e - 1 || prevDelim != e - 2)
+                continue;
+            if (numFields <= RM_MAXATTRS)
+                numValues--; // The empty field before the terminator
+            if ((err = RM_AddDelimRecord(df, numValues, &recordCap)) != RME_OK)
+                break;
+            numFields = 0;
+            lastDelim = prevDelim = NULL;
+            fieldStart = q + 1;
+        }
+        if (mask != 0) {
+            RM_CloseDelimFile(df);
+            return err;
+        }
+    }
+
+    // 3. A record after the last terminator (blank lines do not count)
+    e = end;
+    while (e > fieldStart && (e[-1] == '\n' || e[-1] == '\r'))
+        e--;
+    if (e > fieldStart) {
+        *e = '\0'; // A newline, or the NUL after a copied file
+        if (numFields++ < RM_MAXATTRS)
+            err = RM_AddValue(df, &numValues, &valueCap, fieldStart);
+    }
+    if (err == RME_OK && numFields > 0)
+        err = RM_AddDelimRecord(df, numValues, &recordCap);
+    if (err != RME_OK) {
+        RM_CloseDelimFile(df);
+        return err;
+    }
+    return RME_OK;
+}
+
+int RM_GetDelimRecord(RM_DelimFile *df, int r, char **values) {
+    int n = df->first[r + 1] - df->first[r];
+
+    memcpy(values, df->values + df->first[r], sizeof(char *) * n);
+    memset(values + n, 0, sizeof(char *) * (df->numAttrs - n));
+    return n;
+}
+
+void RM_CloseDelimFile(RM_DelimFile *df) {
+    if (df->mapped)
+        munmap(df->text, df->size);
+    else
+        free(df->text);
+    free(df->values);
+    free(df->first);
+    df->text = NULL;
+    df->values = NULL;
+    df->first = NULL;
+}
+
+
+/* --- Bulk Loading --- */
+
+int RM_BeginBulkLoad(RM_FileHandle *fh, RM_BulkLoader *bl) {
+    bl->fileHandle = fh;
+    bl->pages = NULL;
+    bl->numPages = 0;
+    bl->numRecords = 0;
+    if (!RM_IS_SLOTTED(fh))
+        return RME_OK; // RM_BulkInsert falls back to RM_InsertRecord
+
+    if ((bl->pages = malloc((long)RM_BULK_PAGES * PF_PAGE_SIZE)) == NULL)
+        return RME_NOMEM;
+    bl->firstPage = PF_GetNumPages(fh->pfFileDesc);
+    return RME_OK;
+}
+
+/*
+ * RM_FlushBulk
+ * Desc: Appends the pages built so far to the file in one go.
+ */
+static int RM_FlushBulk(RM_BulkLoader *bl) {
+    int fd = bl->fileHandle->pfFileDesc;
+    int firstPage, pf_err, i;
+
+    if (bl->numPages == 0)
+        return RME_OK;
+
+    // The RIDs handed out assume the pages land right after the file's end
+    if (PF_GetNumPages(fd) != bl->firstPage)
+        return RME_ERROR;
+    if ((pf_err = PF_AppendPages(fd, bl->pages, bl->numPages, &firstPage)) != PFE_OK) {
+        PF_PrintError("RM_BulkInsert: PF_AppendPages");
+        return pf_err;
+    }
+
+    for (i = 0; i < bl->numPages; i++)
+        RM_NoteRoom(bl->fileHandle, firstPage + i,
+                    RM_PageRoom(bl->pages + (long)i * PF_PAGE_SIZE));
+    bl->fileHandle->insertPage = firstPage + bl->numPages - 1;
+    bl->firstPage = firstPage + bl->numPages;
+    bl->numPages = 0;
+    return RME_OK;
+}
+
+int RM_BulkInsert(RM_BulkLoader *bl, char *data, int dataLength, RID *rid) {
+    char *pageData;
+    int slotNum = -1, err;
+
+    if (dataLength < 0)
+        return RME_INVALIDARG;
+    if (bl->pages == NULL) {
+        if ((err = RM_InsertRecord(bl->fileHandle, data, dataLength, rid)) == RME_OK)
+            bl->numRecords++;
+        return err;
+    }
+
+    // 1. Try the page being filled
+    if (bl->numPages > 0) {
+        pageData = bl->pages + (long)(bl->numPages - 1) * PF_PAGE_SIZE;
+        slotNum = RM_PageAppend(pageData, data, dataLength);
+    }
+
+    // 2. Otherwise start a new page, writing the batch out if it is full
+    if (slotNum < 0) {
+        if (bl->numPages == RM_BULK_PAGES && (err = RM_FlushBulk(bl)) != RME_OK)
+            return err;
+        pageData = bl->pages + (long)bl->numPages * PF_PAGE_SIZE;
+        memset(pageData, 0, PF_PAGE_SIZE);
+        RM_InitPage(bl->fileHandle, pageData);
+        if ((slotNum = RM_PageAppend(pageData, data, dataLength)) < 0) {
+            // Too large for any page: RM_InsertRecord writes an overflow
+            // chain, which allocates pages, so the batch goes out first
+            if ((err = RM_FlushBulk(bl)) != RME_OK ||
+                (err = RM_InsertRecord(bl->fileHandle, data, dataLength, rid)) != RME_OK)
+                return err;
+            bl->firstPage = PF_GetNumPages(bl->fileHandle->pfFileDesc);
+            bl->numRecords++;
+            return RME_OK;
+        }
+        bl->numPages++;
+    }
+
+    *rid = RM_PackRID(bl->firstPage + bl->numPages - 1, slotNum);
+    bl->numRecords++;
+    return RME_OK;
+}
+
+int RM_EndBulkLoad(RM_BulkLoader *bl) {
+    int err = RME_OK;
+
+    if (bl->pages != NULL) {
+        err = RM_FlushBulk(bl);
+        free(bl->pages);
+        bl->pages = NULL;
+    }
+    return err;
+}
@@ -0,0 +1,120 @@
+/* rmparscan.c: parallel full-table scans for the RM layer */
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "rm.h"
+#include "pf.h"
+
+#define RM_PAR_BATCH 512 /* More than the records of one page */
+
+/* Per-worker state: its page range and where to report */
+typedef struct {
+    RM_FileHandle *fh;
+    RM_Filter *filter;
+    RM_ScanCallback callback;
+    void *arg;
+    int firstPage;
+    int lastPage;
+    int result;     // (out) RME_OK, or why the worker stopped
+} RM_ScanWorker;
+
+/*
+ * RM_ScanWorkerMain
+ * Desc: Thread body. Scans [firstPage, lastPage) a page at a time and
+ *       hands every qualifying record to the callback.
+ */
+static void *RM_ScanWorkerMain(void *p) {
+    RM_ScanWorker *w = (RM_ScanWorker *)p;
+    RM_ScanHandle sh;
+    RM_Batch batch;
+    char recBuf[PF_PAGE_SIZE];
+    RID rid;
+    int err, recLen, i;
+
+    if ((w->result = RM_InitBatch(&batch, RM_PAR_BATCH)) != RME_OK)
+        return NULL;
+    if ((w->result = RM_OpenRangeScan(w->fh, &sh, w->filter, NULL,
+                                      w->firstPage, w->lastPage)) != RME_OK) {
+        RM_FreeBatch(&batch);
+        return NULL;
+    }
+
+    if (w->fh->format == RM_FMT_PAX) {
+        // PAX pages hold no whole records to batch; rebuild them one by one
+        while ((err = RM_GetNextRecord(&sh, &rid, recBuf, sizeof(recBuf), &recLen)) == RME_OK) {
+            if ((err = (*w->callback)(w->arg, rid, recBuf, recLen)) != RME_OK)
+                break;
+        }
+    } else {
+        while ((err = RM_GetNextBatch(&sh, &batch)) == RME_OK) {
+            for (i = 0; i < batch.numRecords; i++) {
+                err = (*w->callback)(w->arg, batch.rids[i], batch.recPtrs[i], batch.lengths[i]);
+                if (err != RME_OK)
+                    break;
+            }
+            if (err != RME_OK)
+                break;
+        }
+    }
+
+    w->result = (err == RME_EOF) ? RME_OK : err;
+    RM_CloseScan(&sh);
+    RM_FreeBatch(&batch);
+    return NULL;
+}
+
+int RM_ParallelScan(RM_FileHandle *fh, int numThreads, RM_Filter *filter,
+                    RM_ScanCallback callback, void **args) {
+    RM_ScanWorker workers[RM_MAXTHREADS];
+    pthread_t threads[RM_MAXTHREADS];
+    int numPages, perThread, extra, page, started, result, t;
+
+    if (numThreads < 1 || numThreads > RM_MAXTHREADS || callback == NULL)
+        return RME_INVALIDARG;
+
+    if ((numPages = PF_GetNumPages(fh->pfFileDesc)) < 0) {
+        PF_PrintError("RM_ParallelScan: PF_GetNumPages");
+        return numPages;
+    }
+    numPages -= RM_FIRST_DATA_PAGE; // Data pages only
+    if (numPages < 0)
+        numPages = 0;
+    if (numThreads > numPages)
+        numThreads = (numPages > 0) ? numPages : 1;
+
+    // 1. Cut the file into contiguous ranges of (almost) equal size
+    perThread = numPages / numThreads;
+    extra = numPages % numThreads;
+    page = RM_FIRST_DATA_PAGE;
+    for (t = 0; t < numThreads; t++) {
+        workers[t].fh = fh;
+        workers[t].filter = filter;
+        workers[t].callback = callback;
+        workers[t].arg = (args != NULL) ? args[t] : NULL;
+        workers[t].firstPage = page;
+        page += perThread + (t < extra ? 1 : 0);
+        workers[t].lastPage = page;
+        workers[t].result = RME_OK;
+    }
+
+    // 2. Run worker 0 on the calling thread, the rest on new threads
+    for (started = 1; started < numThreads; started++) {
+        if (pthread_create(&threads[started], NULL, RM_ScanWorkerMain, &workers[started]) != 0)
+            break;
+    }
+    RM_ScanWorkerMain(&workers[0]);
+
+    // 3. Wait for everyone and report the first failure, if any
+    result = workers[0].result;
+    for (t = 1; t < started; t++) {
+        pthread_join(threads[t], NULL);
+        if (result == RME_OK)
+            result = workers[t].result;
+    }
+    if (started < numThreads) {
+        fprintf(stderr, "RM_ParallelScan: could only start %d of %d threads\n",
+                started, numThreads);
+        return RME_ERROR;
+    }
+    return result;
+}
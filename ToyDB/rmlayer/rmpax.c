@@ -0,0 +1,412 @@
+/* rmpax.c: PAX page layout for typed RM files */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "rm.h"
+#include "rmtypes.h"
+#include "pf.h"
+
+/*
+ * A PAX page keeps the records of the page column by column:
+ *
+ *   [PaxPageHeader][present bitmap][attr 0: null bitmap | values]
+ *                                  [attr 1: null bitmap | values] ...
+ *
+ * Every attribute gets a minipage with one fixed-width value per slot
+ * (see RM_PaxLayout), so slot i of attribute a is always at
+ * valOff[a] + i * width[a] and a column scan reads a plain array.
+ * RIDs are (page, slot) as for slotted pages and never move.
+ */
+typedef struct {
+    int numSlots;    // Slots ever used (high-water mark)
+    int numRecords;  // Slots with their present bit set
+} PaxPageHeader;
+
+#define PAX_HEADER(pageData) ((PaxPageHeader *)(pageData))
+#define PAX_BITMAP_BYTES(capacity) (((capacity) + 7) / 8)
+#define PAX_ALIGN(off) (((off) + 3) & ~3)
+
+#define BIT_SET(bitmap, i)   ((bitmap)[(i) / 8] |= (1 << ((i) % 8)))
+#define BIT_CLEAR(bitmap, i) ((bitmap)[(i) / 8] &= ~(1 << ((i) % 8)))
+
+
+/* --- Layout --- */
+
+/* Places every minipage for 'capacity' slots; returns the bytes used */
+static int RM_PaxPlace(RM_Schema *schema, RM_PaxLayout *layout, int capacity) {
+    int off, a;
+
+    off = sizeof(PaxPageHeader);
+    layout->presentOff = off;
+    off += PAX_BITMAP_BYTES(capacity);
+
+    for (a = 0; a < schema->numAttrs; a++) {
+        layout->nullOff[a] = off;
+        off = PAX_ALIGN(off + PAX_BITMAP_BYTES(capacity));
+        layout->valOff[a] = off;
+        off += capacity * layout->width[a];
+    }
+    return off;
+}
+
+int RM_PaxInitLayout(RM_Schema *schema, RM_PaxLayout *layout) {
+    int rowBytes = 0, capacity, a;
+
+    for (a = 0; a < schema->numAttrs; a++) {
+        RM_Attr *attr = &schema->attrs[a];
+        layout->width[a] = (attr->type == RM_VARCHAR) ? attr->length + 2 : attr->length;
+        rowBytes += layout->width[a];
+    }
+    if (schema->numAttrs == 0 || rowBytes >= PF_PAGE_SIZE) {
+        layout->capacity = 0;
+        return 0;
+    }
+
+    // Start from the estimate without bitmaps and padding, then shrink
+    capacity = (PF_PAGE_SIZE - sizeof(PaxPageHeader)) / rowBytes;
+    if (capacity > 0xFFFF)
+        capacity = 0xFFFF; // Slot numbers are 16 bits in a RID
+    while (capacity > 0 && RM_PaxPlace(schema, layout, capacity) > PF_PAGE_SIZE)
+        capacity--;
+    RM_PaxPlace(schema, layout, capacity);
+
+    layout->capacity = capacity;
+    return capacity;
+}
+
+
+/* --- Records --- */
+
+/*
+ * RM_PaxAssemble
+ * Desc: Gathers slot 'slot' of a PAX page back into a typed record.
+ */
+static int RM_PaxAssemble(RM_FileHandle *fh, char *pageData, int slot,
+                          char *dataBuf, int bufSize, int *dataLength) {
+    RM_Schema *schema = &fh->schema;
+    RM_PaxLayout *layout = &fh->pax;
+    char *fields[RM_MAXATTRS];
+    int lens[RM_MAXATTRS];
+    unsigned short vlen;
+    char *val;
+    int a;
+
+    for (a = 0; a < schema->numAttrs; a++) {
+        if (RM_BITSET((unsigned char *)pageData + layout->nullOff[a], slot)) {
+            fields[a] = NULL;
+            continue;
+        }
+        val = pageData + layout->valOff[a] + slot * layout->width[a];
+        if (schema->attrs[a].type == RM_VARCHAR) {
+            memcpy(&vlen, val, sizeof(vlen));
+            fields[a] = val + sizeof(vlen);
+            lens[a] = vlen;
+        } else {
+            fields[a] = val;
+            lens[a] = layout->width[a];
+        }
+    }
+    return RM_BuildRecord(schema, fields, lens, dataBuf, bufSize, dataLength);
+}
+
+/* Finds the first free slot of a page that is known to have one */
+static int RM_PaxFreeSlot(RM_PaxLayout *layout, char *pageData) {
+    unsigned char *present = (unsigned char *)pageData + layout->presentOff;
+    int slot;
+
+    for (slot = 0; slot < layout->capacity; slot++) {
+        if (present[slot / 8] == 0xFF) {
+            slot += 7; // Whole byte in use
+            continue;
+        }
+        if (!RM_BITSET(present, slot))
+            return slot;
+    }
+    return -1;
+}
+
+/*
+ * RM_PaxSplit
+ * Desc: Locates the fields of a typed record and checks every one of
+ *       them against the schema (fields[a] = NULL for a NULL value).
+ */
+static int RM_PaxSplit(RM_Schema *schema, char *data, char **fields, int *lens) {
+    int err, a;
+
+    for (a = 0; a < schema->numAttrs; a++) {
+        err = RM_GetField(schema, data, a, &fields[a], &lens[a]);
+        if (err == RME_NULLFIELD) {
+            fields[a] = NULL;
+            continue;
+        }
+        if (err != RME_OK)
+            return err;
+        if (schema->attrs[a].type == RM_VARCHAR ? lens[a] > schema->attrs[a].length
+                                                : lens[a] != schema->attrs[a].length)
+            return RME_INVALIDARG;
+    }
+    return RME_OK;
+}
+
+/*
+ * RM_PaxScatter
+ * Desc: Writes the fields of one record into slot 'slot' of every minipage.
+ */
+static void RM_PaxScatter(RM_FileHandle *fh, char *pageData, int slot, char **fields, int *lens) {
+    RM_Schema *schema = &fh->schema;
+    RM_PaxLayout *layout = &fh->pax;
+    unsigned char *nulls;
+    unsigned short vlen;
+    char *val;
+    int a;
+
+    for (a = 0; a < schema->numAttrs; a++) {
+        nulls = (unsigned char *)pageData + layout->nullOff[a];
+        val = pageData + layout->valOff[a] + slot * layout->width[a];
+        if (fields[a] == NULL) {
+            BIT_SET(nulls, slot);
+            continue;
+        }
+        BIT_CLEAR(nulls, slot);
+        if (schema->attrs[a].type == RM_VARCHAR) {
+            vlen = lens[a];
+            memcpy(val, &vlen, sizeof(vlen));
+            memcpy(val + sizeof(vlen), fields[a], lens[a]);
+        } else {
+            memcpy(val, fields[a], lens[a]);
+        }
+    }
+}
+
+int RM_PaxInsertRecord(RM_FileHandle *fh, char *data, int dataLength, RID *rid) {
+    RM_PaxLayout *layout = &fh->pax;
+    char *fields[RM_MAXATTRS];
+    int lens[RM_MAXATTRS];
+    char *pageData;
+    int pageNum, pf_err, err, slot;
+    int found = FALSE;
+
+    // 1. Check every field against the schema before touching a page
+    if ((err = RM_PaxSplit(&fh->schema, data, fields, lens)) != RME_OK)
+        return err;
+
+    // 2. Try the page the previous insert went to
+    if (fh->insertPage != -1) {
+        pageNum = fh->insertPage;
+        if ((pf_err = PF_GetThisPage(fh->pfFileDesc, pageNum, &pageData)) != PFE_OK) {
+            PF_PrintError("RM_PaxInsertRecord: PF_GetThisPage");
+            return pf_err;
+        }
+        if (PAX_HEADER(pageData)->numRecords < layout->capacity) {
+            found = TRUE;
+        } else {
+            RM_NoteRoom(fh, pageNum, 0);
+            if ((pf_err = PF_UnfixPage(fh->pfFileDesc, pageNum, FALSE)) != PFE_OK) {
+                PF_PrintError("RM_PaxInsertRecord: PF_UnfixPage");
+                return pf_err;
+            }
+        }
+    }
+
+    // 3. Otherwise take the first page the free-space map says may
+    //    have a free slot
+    while (!found && (pf_err = RM_FindRoom(fh, 1, &pageNum)) == RME_OK) {
+        if ((pf_err = PF_GetThisPage(fh->pfFileDesc, pageNum, &pageData)) != PFE_OK) {
+            if (pf_err != PFE_INVALIDPAGE) {
+                PF_PrintError("RM_PaxInsertRecord: PF_GetThisPage");
+                return pf_err;
+            }
+            RM_NoteRoom(fh, pageNum, 0); // A free page of the PF file
+            continue;
+        }
+        if (PAX_HEADER(pageData)->numRecords < layout->capacity) {
+            found = TRUE;
+            break;
+        }
+        RM_NoteRoom(fh, pageNum, 0);
+        if ((pf_err = PF_UnfixPage(fh->pfFileDesc, pageNum, FALSE)) != PFE_OK) {
+            PF_PrintError("RM_PaxInsertRecord: PF_UnfixPage");
+            return pf_err;
+        }
+    }
+
+    // 4. If no page found, allocate a new one
+    if (!found) {
+        if (pf_err != RME_EOF)
+            return pf_err; // PF_GetNumPages failed, or no memory for the map
+        if ((pf_err = PF_AllocPage(fh->pfFileDesc, &pageNum, &pageData)) != PFE_OK) {
+            PF_PrintError("RM_PaxInsertRecord: PF_AllocPage");
+            return pf_err;
+        }
+        memset(pageData, 0, PF_PAGE_SIZE); // Empty header and bitmaps
+    }
+    fh->insertPage = pageNum;
+
+    // 5. Scatter the fields into their minipages
+    slot = RM_PaxFreeSlot(layout, pageData);
+    RM_PaxScatter(fh, pageData, slot, fields, lens);
+
+    // 6. Mark the slot used and update the header
+    BIT_SET((unsigned char *)pageData + layout->presentOff, slot);
+    PAX_HEADER(pageData)->numRecords++;
+    if (slot >= PAX_HEADER(pageData)->numSlots)
+        PAX_HEADER(pageData)->numSlots = slot + 1;
+
+    *rid = RM_PackRID(pageNum, slot);
+    RM_NoteRoom(fh, pageNum, layout->capacity - PAX_HEADER(pageData)->numRecords);
+
+    if ((pf_err = PF_UnfixPage(fh->pfFileDesc, pageNum, TRUE)) != PFE_OK) {
+        PF_PrintError("RM_PaxInsertRecord: PF_UnfixPage (dirty)");
+        return pf_err;
+    }
+    return RME_OK;
+}
+
+/*
+ * RM_PaxFixRecord
+ * Desc: Fixes the page of rid and checks that its slot holds a record.
+ */
+static int RM_PaxFixRecord(RM_FileHandle *fh, RID rid, char *caller,
+                           int *pageNum, int *slot, char **pageData) {
+    int pf_err;
+
+    RM_UnpackRID(rid, pageNum, slot);
+    if (*pageNum < RM_FIRST_DATA_PAGE)
+        return RME_INVALIDRID;
+    if ((pf_err = PF_GetThisPage(fh->pfFileDesc, *pageNum, pageData)) != PFE_OK) {
+        PF_PrintError(caller);
+        return (pf_err == PFE_INVALIDPAGE) ? RME_INVALIDRID : pf_err;
+    }
+    if (*slot >= PAX_HEADER(*pageData)->numSlots ||
+        !RM_BITSET((unsigned char *)*pageData + fh->pax.presentOff, *slot)) {
+        PF_UnfixPage(fh->pfFileDesc, *pageNum, FALSE);
+        return RME_INVALIDRID;
+    }
+    return RME_OK;
+}
+
+int RM_PaxDeleteRecord(RM_FileHandle *fh, RID rid) {
+    char *pageData;
+    int pageNum, slot, err;
+
+    if ((err = RM_PaxFixRecord(fh, rid, "RM_DeleteRecord: PF_GetThisPage",
+                               &pageNum, &slot, &pageData)) != RME_OK)
+        return err;
+
+    // The values stay behind; only the present bit says the slot is used
+    BIT_CLEAR((unsigned char *)pageData + fh->pax.presentOff, slot);
+    PAX_HEADER(pageData)->numRecords--;
+    RM_NoteRoom(fh, pageNum, fh->pax.capacity - PAX_HEADER(pageData)->numRecords);
+
+    if ((err = PF_UnfixPage(fh->pfFileDesc, pageNum, TRUE)) != PFE_OK) {
+        PF_PrintError("RM_DeleteRecord: PF_UnfixPage (dirty)");
+        return err;
+    }
+    return RME_OK;
+}
+
+int RM_PaxUpdateRecord(RM_FileHandle *fh, RID rid, char *data, int dataLength) {
+    char *fields[RM_MAXATTRS];
+    int lens[RM_MAXATTRS];
+    char *pageData;
+    int pageNum, slot, err;
+
+    if ((err = RM_PaxSplit(&fh->schema, data, fields, lens)) != RME_OK)
+        return err;
+    if ((err = RM_PaxFixRecord(fh, rid, "RM_UpdateRecord: PF_GetThisPage",
+                               &pageNum, &slot, &pageData)) != RME_OK)
+        return err;
+
+    // Every value has a fixed-width place, so a row always fits in place
+    RM_PaxScatter(fh, pageData, slot, fields, lens);
+
+    if ((err = PF_UnfixPage(fh->pfFileDesc, pageNum, TRUE)) != PFE_OK) {
+        PF_PrintError("RM_UpdateRecord: PF_UnfixPage (dirty)");
+        return err;
+    }
+    return RME_OK;
+}
+
+int RM_PaxGetRecord(RM_FileHandle *fh, RID rid, char *dataBuf, int bufSize, int *dataLength) {
+    char *pageData;
+    int pageNum, slot, err, pf_err;
+
+    if ((err = RM_PaxFixRecord(fh, rid, "RM_GetRecord: PF_GetThisPage",
+                               &pageNum, &slot, &pageData)) != RME_OK)
+        return err;
+
+    err = RM_PaxAssemble(fh, pageData, slot, dataBuf, bufSize, dataLength);
+
+    if ((pf_err = PF_UnfixPage(fh->pfFileDesc, pageNum, FALSE)) != PFE_OK) {
+        PF_PrintError("RM_GetRecord: PF_UnfixPage");
+        return pf_err;
+    }
+    return err;
+}
+
+
+/* --- Scanning --- */
+
+int RM_PaxGetNextRecord(RM_ScanHandle *sh, RID *rid, char *dataBuf, int bufSize, int *dataLength) {
+    RM_FileHandle *fh = sh->fileHandle;
+    unsigned char *present;
+    int err;
+
+    // Records are rebuilt from the minipages; there is no text to project
+    if (sh->proj != NULL)
+        return RME_INVALIDARG;
+
+    while (TRUE) {
+        // 1. Check if we need to get a new page
+        if (sh->pageData == NULL) {
+            if ((err = RM_ScanNextPage(sh, "RM_GetNextRecord: PF_GetFirst/NextPage")) != RME_OK)
+                return err;
+        }
+
+        // 2. Rebuild the next used slot and test it
+        present = (unsigned char *)sh->pageData + fh->pax.presentOff;
+        while (++sh->currentSlot < PAX_HEADER(sh->pageData)->numSlots) {
+            if (!RM_BITSET(present, sh->currentSlot))
+                continue;
+            if ((err = RM_PaxAssemble(fh, sh->pageData, sh->currentSlot,
+                                      dataBuf, bufSize, dataLength)) != RME_OK) {
+                if (err == RME_BUFTOOSMALL)
+                    sh->currentSlot--; // Returned again by the next call
+                return err;
+            }
+            if (!RM_EvalFilter(sh->filter, dataBuf, *dataLength))
+                continue;
+
+            *rid = RM_PackRID(sh->currentPage, sh->currentSlot);
+            return RME_OK;
+        }
+
+        // 3. Page drained, move on
+        sh->pageData = NULL;
+    }
+}
+
+int RM_GetNextColumn(RM_ScanHandle *sh, int attr, RM_Column *col) {
+    RM_FileHandle *fh = sh->fileHandle;
+    int err;
+
+    if (fh->format != RM_FMT_PAX || attr < 0 || attr >= fh->schema.numAttrs)
+        return RME_INVALIDARG;
+
+    while (TRUE) {
+        // One page per call; the previous page is unfixed here
+        if ((err = RM_ScanNextPage(sh, "RM_GetNextColumn: PF_GetFirst/NextPage")) != RME_OK)
+            return err;
+        if (PAX_HEADER(sh->pageData)->numRecords == 0)
+            continue;
+
+        col->pageNum = sh->currentPage;
+        col->numSlots = PAX_HEADER(sh->pageData)->numSlots;
+        col->width = fh->pax.width[attr];
+        col->present = (unsigned char *)sh->pageData + fh->pax.presentOff;
+        col->nulls = (unsigned char *)sh->pageData + fh->pax.nullOff[attr];
+        col->values = sh->pageData + fh->pax.valOff[attr];
+        sh->currentSlot = col->numSlots; // Nothing left for GetNextRecord
+        return RME_OK;
+    }
+}
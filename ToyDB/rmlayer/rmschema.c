@@ -0,0 +1,219 @@
+/* rmschema.c: typed records with a null bitmap and offset table */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "rm.h"
+#include "pf.h"
+
+/*
+ * Record layout (see RM_Schema in rm.h):
+ *   bytes 0 .. NULLBYTES-1          null bitmap, bit i set = attr i NULL
+ *   then (numAttrs+1) RM_Offset     start of each field, plus the end
+ *   then the field data
+ * Offsets are relative to the start of the record.
+ */
+typedef unsigned short RM_Offset;
+
+#define NULLBYTES(schema) (((schema)->numAttrs + 7) / 8)
+#define OFFTABLE(schema, rec) ((RM_Offset *)((rec) + NULLBYTES(schema)))
+#define DATASTART(schema) (NULLBYTES(schema) + ((schema)->numAttrs + 1) * sizeof(RM_Offset))
+
+
+/* --- Schemas --- */
+
+void RM_InitSchema(RM_Schema *schema) {
+    schema->numAttrs = 0;
+}
+
+int RM_AddAttr(RM_Schema *schema, char *name, char type, int length) {
+    RM_Attr *attr;
+
+    if (schema->numAttrs >= RM_MAXATTRS || name == NULL || strlen(name) >= RM_MAXNAME)
+        return RME_INVALIDARG;
+
+    switch (type) {
+        case RM_INT:
+        case RM_FLOAT:
+            length = 4;
+            break;
+        case RM_CHAR:
+        case RM_VARCHAR:
+            if (length <= 0 || length >= PF_PAGE_SIZE)
+                return RME_INVALIDARG;
+            break;
+        default:
+            return RME_INVALIDARG;
+    }
+
+    attr = &schema->attrs[schema->numAttrs++];
+    strcpy(attr->name, name);
+    attr->type = type;
+    attr->length = length;
+    return RME_OK;
+}
+
+
+/* --- Encoding --- */
+
+/*
+ * RM_EncodeValue
+ * Desc: Converts one text value into the attribute's binary form at out.
+ * Returns: Bytes written, or RME_INVALIDARG
+ */
+static int RM_EncodeValue(RM_Attr *attr, char *value, char *out) {
+    char *end;
+    int len;
+
+    switch (attr->type) {
+        case RM_INT: {
+            long v;
+            errno = 0;
+            v = strtol(value, &end, 10);
+            if (end == value || *end != '\0' || errno != 0 || v != (int)v)
+                return RME_INVALIDARG;
+            int iv = (int)v;
+            memcpy(out, &iv, sizeof(int));
+            return sizeof(int);
+        }
+        case RM_FLOAT: {
+            float fv = strtof(value, &end);
+            if (end == value || *end != '\0')
+                return RME_INVALIDARG;
+            memcpy(out, &fv, sizeof(float));
+            return sizeof(float);
+        }
+        case RM_CHAR:
+            if ((len = strlen(value)) > attr->length)
+                return RME_INVALIDARG;
+            memcpy(out, value, len);
+            memset(out + len, '\0', attr->length - len);
+            return attr->length;
+        default: // RM_VARCHAR
+            if ((len = strlen(value)) > attr->length)
+                return RME_INVALIDARG;
+            memcpy(out, value, len);
+            return len;
+    }
+}
+
+int RM_BuildRecord(RM_Schema *schema, char **fields, int *lens,
+                   char *recBuf, int bufSize, int *recLength) {
+    RM_Offset *offsets;
+    int pos, i;
+
+    pos = DATASTART(schema);
+    if (pos > bufSize)
+        return RME_BUFTOOSMALL;
+
+    memset(recBuf, 0, NULLBYTES(schema));
+    offsets = OFFTABLE(schema, recBuf);
+
+    for (i = 0; i < schema->numAttrs; i++) {
+        offsets[i] = pos;
+        if (fields[i] == NULL) {
+            recBuf[i / 8] |= 1 << (i % 8); // NULL: no bytes
+            continue;
+        }
+        if (pos + lens[i] > bufSize)
+            return RME_BUFTOOSMALL;
+        memcpy(recBuf + pos, fields[i], lens[i]);
+        pos += lens[i];
+    }
+    offsets[schema->numAttrs] = pos;
+
+    *recLength = pos;
+    return RME_OK;
+}
+
+int RM_EncodeRecord(RM_Schema *schema, char **values, char *recBuf, int bufSize, int *recLength) {
+    char scratch[PF_PAGE_SIZE];
+    char *fields[RM_MAXATTRS];
+    int lens[RM_MAXATTRS];
+    int pos = 0, n, i;
+
+    // Convert every value to its stored form, then lay the record out
+    for (i = 0; i < schema->numAttrs; i++) {
+        if (values[i] == NULL || values[i][0] == '\0') {
+            fields[i] = NULL;
+            continue;
+        }
+        if (pos + schema->attrs[i].length > (int)sizeof(scratch))
+            return RME_BUFTOOSMALL;
+        if ((n = RM_EncodeValue(&schema->attrs[i], values[i], scratch + pos)) < 0)
+            return n;
+        fields[i] = scratch + pos;
+        lens[i] = n;
+        pos += n;
+    }
+
+    return RM_BuildRecord(schema, fields, lens, recBuf, bufSize, recLength);
+}
+
+int RM_EncodeDelimited(RM_Schema *schema, char *text, char delim,
+                       char *recBuf, int bufSize, int *recLength) {
+    char copy[PF_PAGE_SIZE];
+    char *values[RM_MAXATTRS];
+    char *p, *next;
+    int i;
+
+    if (strlen(text) >= sizeof(copy))
+        return RME_BUFTOOSMALL;
+    strcpy(copy, text);
+
+    // Cut the copy at each delimiter; fields past the end stay NULL
+    p = copy;
+    for (i = 0; i < schema->numAttrs; i++) {
+        if (p == NULL) {
+            values[i] = NULL;
+            continue;
+        }
+        values[i] = p;
+        if ((next = strchr(p, delim)) != NULL)
+            *next++ = '\0';
+        p = next;
+    }
+
+    return RM_EncodeRecord(schema, values, recBuf, bufSize, recLength);
+}
+
+
+/* --- Field Access --- */
+
+int RM_GetField(RM_Schema *schema, char *rec, int attr, char **fieldPtr, int *fieldLen) {
+    RM_Offset *offsets;
+
+    if (attr < 0 || attr >= schema->numAttrs)
+        return RME_INVALIDARG;
+    if (RM_BITSET(rec, attr))
+        return RME_NULLFIELD;
+
+    offsets = OFFTABLE(schema, rec);
+    *fieldPtr = rec + offsets[attr];
+    *fieldLen = offsets[attr + 1] - offsets[attr];
+    return RME_OK;
+}
+
+int RM_GetIntField(RM_Schema *schema, char *rec, int attr, int *value) {
+    char *fieldPtr;
+    int fieldLen, err;
+
+    if (attr < 0 || attr >= schema->numAttrs || schema->attrs[attr].type != RM_INT)
+        return RME_INVALIDARG;
+    if ((err = RM_GetField(schema, rec, attr, &fieldPtr, &fieldLen)) != RME_OK)
+        return err;
+    memcpy(value, fieldPtr, sizeof(int)); // Fields are not aligned
+    return RME_OK;
+}
+
+int RM_GetFloatField(RM_Schema *schema, char *rec, int attr, float *value) {
+    char *fieldPtr;
+    int fieldLen, err;
+
+    if (attr < 0 || attr >= schema->numAttrs || schema->attrs[attr].type != RM_FLOAT)
+        return RME_INVALIDARG;
+    if ((err = RM_GetField(schema, rec, attr, &fieldPtr, &fieldLen)) != RME_OK)
+        return err;
+    memcpy(value, fieldPtr, sizeof(float));
+    return RME_OK;
+}
@@ -0,0 +1,805 @@
+/* rmsort.c: External merge sort for index builds and ORDER BY */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "rm.h"
+#include "rmtypes.h"
+#include "pf.h"
+
+/*
+ * The sort owns numFrames frames of memory. While the input is being
+ * added, 2 * blockPages of them are the run writer's blocks and the rest
+ * hold items in a heap ordered by (run, item): replacement selection.
+ * Each new item goes to the current run if it does not sort before the
+ * item written last, else to the next one, so runs grow past memory.
+ * Nothing touches the disk until memory is full, and a sort that never
+ * fills it hands its items straight out of the heap.
+ *
+ * Runs are stored back to back in one temporary PF file as a stream of
+ * [int length][bytes] packed across pages; items may span pages and
+ * blocks. Blocks are read and written by a helper thread, one request
+ * at a time in the order they were queued, while the sort fills or
+ * consumes the other block of the pair. A merge gives each of its runs
+ * a reader with two blocks and picks the smallest current item with a
+ * loser tree. As many runs as (numFrames - 2 * blockPages) frames can
+ * feed are merged at a time, which leaves room for the writer when the
+ * merge goes to a new run; the oldest runs are merged first until one
+ * final merge can take the rest.
+ */
+#define RM_SORT_READ  0
+#define RM_SORT_WRITE 1
+#define RM_SORT_NAME_LEN 64
+
+/* An item in memory during run generation */
+typedef struct {
+    int run;        // Run it will be written to
+    int len;
+    char *data;
+} RM_SortItem;
+
+/* A run in the temporary file */
+typedef struct {
+    int firstPage;
+    int numPages;
+    long numItems;
+    int pass;       // 0: from run generation, else the merge pass that wrote it
+} RM_SortRun;
+
+/* blockPages pages and the I/O request on them */
+typedef struct RM_SortBlock {
+    char *pages;
+    int op;         // RM_SORT_READ or RM_SORT_WRITE
+    int firstPage;
+    int numPages;   // Pages requested (0: none)
+    int pending;    // Queued or being served
+    int err;
+    struct RM_SortBlock *next; // I/O queue link
+} RM_SortBlock;
+
+/* Writes one run at a time */
+typedef struct {
+    RM_SortBlock blocks[2];
+    int cur;        // Block being filled
+    int used;       // Bytes of it filled
+    RM_SortRun run;
+} RM_SortWriter;
+
+/* Reads one run back */
+typedef struct {
+    RM_SortBlock blocks[2];
+    int cur;        // Block being consumed
+    int pos;        // Next byte of it
+    int avail;      // Bytes in it
+    int nextPage;   // Next page to request
+    int pagesLeft;  // Pages not requested yet
+    long itemsLeft;
+    char *item;     // Current item (NULL: run exhausted)
+    int itemLen;
+    char *stage;    // Copy of an item that spans two blocks
+    int stageSize;
+} RM_SortReader;
+
+struct RM_SortState {
+    RM_SortCompareFcn cmp;
+    void *arg;
+    int numFrames;
+    int blockPages;
+    int fanIn;          // Runs per merge
+    long budget;        // Bytes of items the heap may hold
+    long memUsed;
+    int done;           // RM_SortDone was called
+
+    // Run generation
+    RM_SortItem *heap;
+    int heapSize, heapCap;
+    int curRun;         // Run being written
+    char *lastOut;      // Item written last (NULL: nothing spilled yet)
+    int lastLen;
+    RM_SortItem outItem; // In memory: the item handed out last
+
+    // Runs
+    char fileName[RM_SORT_NAME_LEN];
+    int fd;             // Temporary file (-1: none yet)
+    int nextFilePage;   // Page the next block written will get
+    RM_SortRun *runs;
+    int numRuns, runCap;
+    int firstLive;      // runs[firstLive ..] are not merged yet
+    char *writerFrames; // 2 * blockPages frames
+    char *readerFrames; // fanIn * 2 * blockPages frames, once the input ends
+    RM_SortWriter writer;
+
+    // Merge
+    RM_SortReader *readers;
+    int numReaders;
+    int *tree;          // tree[0]: winner, tree[1 .. numReaders-1]: losers
+    int advance;        // The winner moves on before the next item
+
+    // Helper thread
+    pthread_t ioThread;
+    int ioRunning;
+    int ioStop;
+    pthread_mutex_t ioMutex;
+    pthread_cond_t ioWork;
+    pthread_cond_t ioDone;
+    RM_SortBlock *ioHead, *ioTail;
+};
+
+static int RM_SortFileCounter = 0; // Tells the temporary files of a process apart
+
+/* Memory an item takes in the heap */
+#define RM_SORT_COST(len) ((long)(len) + sizeof(RM_SortItem) + sizeof(int))
+
+
+/* --- Helper Thread --- */
+
+static void *RM_SortIOMain(void *p) {
+    struct RM_SortState *st = (struct RM_SortState *)p;
+    RM_SortBlock *b;
+    int err, firstPage;
+
+    pthread_mutex_lock(&st->ioMutex);
+    for (;;) {
+        while (st->ioHead == NULL && !st->ioStop)
+            pthread_cond_wait(&st->ioWork, &st->ioMutex);
+        if (st->ioHead == NULL)
+            break; // Stopped with nothing left to do
+        b = st->ioHead;
+        if ((st->ioHead = b->next) == NULL)
+            st->ioTail = NULL;
+        pthread_mutex_unlock(&st->ioMutex);
+
+        if (b->op == RM_SORT_WRITE) {
+            if ((err = PF_AppendPages(st->fd, b->pages, b->numPages, &firstPage)) != PFE_OK)
+                PF_PrintError("RM_Sort: PF_AppendPages");
+            else if (firstPage != b->firstPage)
+                err = RME_ERROR;
+        } else {
+            if ((err = PF_ReadPages(st->fd, b->firstPage, b->numPages, b->pages)) != PFE_OK)
+                PF_PrintError("RM_Sort: PF_ReadPages");
+        }
+
+        pthread_mutex_lock(&st->ioMutex);
+        b->err = err;
+        b->pending = FALSE;
+        pthread_cond_broadcast(&st->ioDone);
+    }
+    pthread_mutex_unlock(&st->ioMutex);
+    return NULL;
+}
+
+static void RM_SortSubmit(struct RM_SortState *st, RM_SortBlock *b, int op) {
+    pthread_mutex_lock(&st->ioMutex);
+    b->op = op;
+    b->pending = TRUE;
+    b->err = RME_OK;
+    b->next = NULL;
+    if (st->ioTail == NULL)
+        st->ioHead = b;
+    else
+        st->ioTail->next = b;
+    st->ioTail = b;
+    pthread_cond_signal(&st->ioWork);
+    pthread_mutex_unlock(&st->ioMutex);
+}
+
+/* Waits until the block is served; returns the outcome of its request */
+static int RM_SortWait(struct RM_SortState *st, RM_SortBlock *b) {
+    int err;
+
+    pthread_mutex_lock(&st->ioMutex);
+    while (b->pending)
+        pthread_cond_wait(&st->ioDone, &st->ioMutex);
+    err = b->err;
+    pthread_mutex_unlock(&st->ioMutex);
+    return err;
+}
+
+/*
+ * RM_SortStartIO
+ * Desc: On the first spill: creates the temporary file, the writer's
+ *       blocks and the helper thread.
+ */
+static int RM_SortStartIO(struct RM_SortState *st) {
+    RM_SortWriter *w = &st->writer;
+    long blockBytes = (long)st->blockPages * PF_PAGE_SIZE;
+    int pf_err;
+
+    if ((st->writerFrames = malloc(2 * blockBytes)) == NULL)
+        return RME_NOMEM;
+    snprintf(st->fileName, sizeof(st->fileName), "rmsort.%d.%d", (int)getpid(),
+             __sync_fetch_and_add(&RM_SortFileCounter, 1));
+    PF_DestroyFile(st->fileName);
+    if ((pf_err = PF_CreateFile(st->fileName)) != PFE_OK) {
+        PF_PrintError("RM_SortAdd: PF_CreateFile");
+        return pf_err;
+    }
+    if ((st->fd = PF_OpenFile(st->fileName, PF_LRU)) < 0) {
+        PF_PrintError("RM_SortAdd: PF_OpenFile");
+        PF_DestroyFile(st->fileName);
+        pf_err = st->fd;
+        st->fd = -1;
+        return pf_err;
+    }
+    st->nextFilePage = PF_GetNumPages(st->fd);
+
+    memset(w, 0, sizeof(*w));
+    w->blocks[0].pages = st->writerFrames;
+    w->blocks[1].pages = st->writerFrames + blockBytes;
+
+    if (pthread_create(&st->ioThread, NULL, RM_SortIOMain, st) != 0)
+        return RME_ERROR;
+    st->ioRunning = TRUE;
+    return RME_OK;
+}
+
+
+/* --- Writing Runs --- */
+
+/* Sends the block being filled to the file and switches to the other one */
+static int RM_SortFlushBlock(struct RM_SortState *st) {
+    RM_SortWriter *w = &st->writer;
+    RM_SortBlock *b = &w->blocks[w->cur];
+    int numPages = (w->used + PF_PAGE_SIZE - 1) / PF_PAGE_SIZE;
+
+    if (numPages == 0)
+        return RME_OK;
+    memset(b->pages + w->used, 0, (long)numPages * PF_PAGE_SIZE - w->used);
+    b->firstPage = st->nextFilePage;
+    b->numPages = numPages;
+    st->nextFilePage += numPages;
+    w->run.numPages += numPages;
+    RM_SortSubmit(st, b, RM_SORT_WRITE);
+
+    w->cur ^= 1;
+    w->used = 0;
+    return RM_SortWait(st, &w->blocks[w->cur]);
+}
+
+static int RM_SortWriteBytes(struct RM_SortState *st, char *src, int n) {
+    RM_SortWriter *w = &st->writer;
+    int blockBytes = st->blockPages * PF_PAGE_SIZE, k, err;
+
+    while (n > 0) {
+        if (w->used == blockBytes && (err = RM_SortFlushBlock(st)) != RME_OK)
+            return err;
+        k = (n < blockBytes - w->used) ? n : blockBytes - w->used;
+        memcpy(w->blocks[w->cur].pages + w->used, src, k);
+        w->used += k;
+        src += k;
+        n -= k;
+    }
+    return RME_OK;
+}
+
+/* Appends an item to the run being written, starting one if need be */
+static int RM_SortWriteItem(struct RM_SortState *st, char *data, int len) {
+    RM_SortWriter *w = &st->writer;
+    int err;
+
+    if (w->run.numItems == 0) {
+        w->run.firstPage = st->nextFilePage;
+        w->run.numPages = 0;
+    }
+    if ((err = RM_SortWriteBytes(st, (char *)&len, sizeof(int))) != RME_OK ||
+        (err = RM_SortWriteBytes(st, data, len)) != RME_OK)
+        return err;
+    w->run.numItems++;
+    return RME_OK;
+}
+
+/* Writes out the rest of the run and records it */
+static int RM_SortEndRun(struct RM_SortState *st, int pass) {
+    RM_SortWriter *w = &st->writer;
+    RM_SortRun *bigger;
+    int err;
+
+    if (w->run.numItems == 0)
+        return RME_OK;
+    if ((err = RM_SortFlushBlock(st)) != RME_OK ||
+        (err = RM_SortWait(st, &w->blocks[w->cur ^ 1])) != RME_OK)
+        return err;
+
+    if (st->numRuns == st->runCap) {
+        st->runCap = (st->runCap == 0) ? 16 : 2 * st->runCap;
+        if ((bigger = realloc(st->runs, sizeof(RM_SortRun) * st->runCap)) == NULL)
+            return RME_NOMEM;
+        st->runs = bigger;
+    }
+    w->run.pass = pass;
+    st->runs[st->numRuns++] = w->run;
+    w->run.numItems = 0;
+    return RME_OK;
+}
+
+
+/* --- Run Generation --- */
+
+/* TRUE if a sorts before b: earlier run first, then the comparator */
+static int RM_SortLess(struct RM_SortState *st, RM_SortItem *a, RM_SortItem *b) {
+    if (a->run != b->run)
+        return a->run < b->run;
+    return (*st->cmp)(st->arg, a->data, a->len, b->data, b->len) < 0;
+}
+
+static void RM_SortPush(struct RM_SortState *st, RM_SortItem *item) {
+    RM_SortItem *h = st->heap;
+    int i = st->heapSize++, parent;
+
+    while (i > 0) {
+        parent = (i - 1) / 2;
+        if (!RM_SortLess(st, item, &h[parent]))
+            break;
+        h[i] = h[parent];
+        i = parent;
+    }
+    h[i] = *item;
+}
+
+static void RM_SortPop(struct RM_SortState *st, RM_SortItem *top) {
+    RM_SortItem *h = st->heap;
+    RM_SortItem last;
+    int i = 0, child;
+
+    *top = h[0];
+    last = h[--st->heapSize];
+    while ((child = 2 * i + 1) < st->heapSize) {
+        if (child + 1 < st->heapSize && RM_SortLess(st, &h[child + 1], &h[child]))
+            child++;
+        if (!RM_SortLess(st, &h[child], &last))
+            break;
+        h[i] = h[child];
+        i = child;
+    }
+    h[i] = last;
+}
+
+/*
+ * RM_SortSpill
+ * Desc: Writes the smallest item in memory to its run, ending the
+ *       current run first if the item belongs to the next one.
+ */
+static int RM_SortSpill(struct RM_SortState *st) {
+    RM_SortItem top;
+    int err;
+
+    RM_SortPop(st, &top);
+    st->memUsed -= RM_SORT_COST(top.len);
+    if (top.run != st->curRun) {
+        if ((err = RM_SortEndRun(st, 0)) != RME_OK) {
+            free(top.data);
+            return err;
+        }
+        st->curRun = top.run;
+    }
+    err = RM_SortWriteItem(st, top.data, top.len);
+    free(st->lastOut);
+    st->lastOut = top.data;
+    st->lastLen = top.len;
+    return err;
+}
+
+int RM_BeginSort(RM_Sort *sort, RM_SortCompareFcn cmp, void *arg, int numFrames) {
+    struct RM_SortState *st;
+
+    sort->state = NULL;
+    sort->numItems = 0;
+    sort->numRuns = 0;
+    sort->numPasses = 0;
+    if (cmp == NULL || numFrames < RM_SORT_MINFRAMES)
+        return RME_INVALIDARG;
+    if ((st = calloc(1, sizeof(struct RM_SortState))) == NULL)
+        return RME_NOMEM;
+
+    st->cmp = cmp;
+    st->arg = arg;
+    st->numFrames = numFrames;
+    // Blocks shrink with memory so a merge can still take 7 runs or more
+    st->blockPages = numFrames / 16;
+    if (st->blockPages > RM_SORT_BLOCK)
+        st->blockPages = RM_SORT_BLOCK;
+    if (st->blockPages < 1)
+        st->blockPages = 1;
+    st->fanIn = (numFrames - 2 * st->blockPages) / (2 * st->blockPages);
+    st->budget = (long)(numFrames - 2 * st->blockPages) * PF_PAGE_SIZE;
+    st->fd = -1;
+    pthread_mutex_init(&st->ioMutex, NULL);
+    pthread_cond_init(&st->ioWork, NULL);
+    pthread_cond_init(&st->ioDone, NULL);
+    sort->state = st;
+    return RME_OK;
+}
+
+int RM_SortAdd(RM_Sort *sort, char *data, int dataLength) {
+    struct RM_SortState *st = sort->state;
+    RM_SortItem item, *bigger;
+    int err;
+
+    if (st == NULL || st->done || dataLength < 0)
+        return RME_INVALIDARG;
+    if (st->heapSize == st->heapCap) {
+        st->heapCap = (st->heapCap == 0) ? 1024 : 2 * st->heapCap;
+        if ((bigger = realloc(st->heap, sizeof(RM_SortItem) * st->heapCap)) == NULL)
+            return RME_NOMEM;
+        st->heap = bigger;
+    }
+    if ((item.data = malloc(dataLength > 0 ? dataLength : 1)) == NULL)
+        return RME_NOMEM;
+    memcpy(item.data, data, dataLength);
+    item.len = dataLength;
+
+    // An item smaller than the last one written waits for the next run
+    item.run = st->curRun;
+    if (st->lastOut != NULL &&
+        (*st->cmp)(st->arg, data, dataLength, st->lastOut, st->lastLen) < 0)
+        item.run = st->curRun + 1;
+    RM_SortPush(st, &item);
+    st->memUsed += RM_SORT_COST(dataLength);
+    sort->numItems++;
+
+    // Memory full: items go out smallest first until it is not
+    while (st->memUsed > st->budget && st->heapSize > 0) {
+        if (st->fd < 0 && (err = RM_SortStartIO(st)) != RME_OK)
+            return err;
+        if ((err = RM_SortSpill(st)) != RME_OK)
+            return err;
+    }
+    return RME_OK;
+}
+
+
+/* --- Merging --- */
+
+/* Asks for the run's next pages in block b */
+static void RM_SortFetch(struct RM_SortState *st, RM_SortReader *r, RM_SortBlock *b) {
+    b->firstPage = r->nextPage;
+    b->numPages = (r->pagesLeft < st->blockPages) ? r->pagesLeft : st->blockPages;
+    r->nextPage += b->numPages;
+    r->pagesLeft -= b->numPages;
+    RM_SortSubmit(st, b, RM_SORT_READ);
+}
+
+/* Moves on to the other block, which is then refilled behind the reader */
+static int RM_SortNextBlock(struct RM_SortState *st, RM_SortReader *r) {
+    int old = r->cur, err;
+
+    r->cur ^= 1;
+    if (r->blocks[r->cur].numPages == 0)
+        return RME_ERROR; // The run ended early
+    if ((err = RM_SortWait(st, &r->blocks[r->cur])) != RME_OK)
+        return err;
+    r->pos = 0;
+    r->avail = r->blocks[r->cur].numPages * PF_PAGE_SIZE;
+
+    if (r->pagesLeft > 0)
+        RM_SortFetch(st, r, &r->blocks[old]);
+    else
+        r->blocks[old].numPages = 0;
+    return RME_OK;
+}
+
+static int RM_SortReadBytes(struct RM_SortState *st, RM_SortReader *r, char *dst, int n) {
+    int k, err;
+
+    while (n > 0) {
+        if (r->pos == r->avail && (err = RM_SortNextBlock(st, r)) != RME_OK)
+            return err;
+        k = (n < r->avail - r->pos) ? n : r->avail - r->pos;
+        memcpy(dst, r->blocks[r->cur].pages + r->pos, k);
+        r->pos += k;
+        dst += k;
+        n -= k;
+    }
+    return RME_OK;
+}
+
+/*
+ * RM_SortReadItem
+ * Desc: Makes the run's next item current. It is used where it lies in
+ *       the block, unless it continues in the next one.
+ */
+static int RM_SortReadItem(struct RM_SortState *st, RM_SortReader *r) {
+    char *bigger;
+    int len, err;
+
+    if (r->itemsLeft == 0) {
+        r->item = NULL;
+        return RME_OK;
+    }
+    if ((err = RM_SortReadBytes(st, r, (char *)&len, sizeof(int))) != RME_OK)
+        return err;
+    if (r->pos == r->avail && len > 0 && (err = RM_SortNextBlock(st, r)) != RME_OK)
+        return err;
+
+    if (r->pos + len <= r->avail) {
+        r->item = r->blocks[r->cur].pages + r->pos;
+        r->pos += len;
+    } else {
+        if (len > r->stageSize) {
+            if ((bigger = realloc(r->stage, len)) == NULL)
+                return RME_NOMEM;
+            r->stage = bigger;
+            r->stageSize = len;
+        }
+        if ((err = RM_SortReadBytes(st, r, r->stage, len)) != RME_OK)
+            return err;
+        r->item = r->stage;
+    }
+    r->itemLen = len;
+    r->itemsLeft--;
+    return RME_OK;
+}
+
+/* TRUE if reader a's item comes first; an exhausted run never does */
+static int RM_SortBeats(struct RM_SortState *st, int a, int b) {
+    RM_SortReader *ra = &st->readers[a], *rb = &st->readers[b];
+    int cmp;
+
+    if (ra->item == NULL || rb->item == NULL)
+        return rb->item == NULL && (ra->item != NULL || a < b);
+    cmp = (*st->cmp)(st->arg, ra->item, ra->itemLen, rb->item, rb->itemLen);
+    return cmp < 0 || (cmp == 0 && a < b);
+}
+
+/*
+ * RM_SortStartMerge
+ * Desc: Opens a reader on each of runs[first .. first+k-1], reads their
+ *       first items and plays the loser tree out. Reader i is leaf k+i
+ *       of a tree whose node n has children 2n and 2n+1.
+ */
+static int RM_SortStartMerge(struct RM_SortState *st, int first, int k) {
+    RM_SortReader *r;
+    int *winners, i, left, right, err;
+
+    if ((winners = malloc(sizeof(int) * 2 * k)) == NULL)
+        return RME_NOMEM;
+    st->numReaders = k;
+    for (i = 0; i < k; i++) {
+        r = &st->readers[i];
+        r->nextPage = st->runs[first + i].firstPage;
+        r->pagesLeft = st->runs[first + i].numPages;
+        r->itemsLeft = st->runs[first + i].numItems;
+        r->cur = 1;
+        r->pos = r->avail = 0;
+        r->blocks[1].numPages = 0;
+        RM_SortFetch(st, r, &r->blocks[0]); // Block 1 follows once block 0 is in use
+    }
+    for (i = 0; i < k; i++)
+        if ((err = RM_SortReadItem(st, &st->readers[i])) != RME_OK) {
+            free(winners);
+            return err;
+        }
+
+    for (i = 0; i < k; i++)
+        winners[k + i] = i;
+    for (i = k - 1; i >= 1; i--) {
+        left = winners[2 * i];
+        right = winners[2 * i + 1];
+        if (RM_SortBeats(st, left, right)) {
+            winners[i] = left;
+            st->tree[i] = right;
+        } else {
+            winners[i] = right;
+            st->tree[i] = left;
+        }
+    }
+    st->tree[0] = (k == 1) ? 0 : winners[1];
+    st->advance = FALSE;
+    free(winners);
+    return RME_OK;
+}
+
+/* The next item of the merge, or NULL at its end */
+static int RM_SortMergeNext(struct RM_SortState *st, char **data, int *dataLength) {
+    RM_SortReader *r;
+    int winner, i, t, err;
+
+    if (st->advance) {
+        // Only the path from the winner's leaf to the root is replayed
+        winner = st->tree[0];
+        if ((err = RM_SortReadItem(st, &st->readers[winner])) != RME_OK)
+            return err;
+        for (i = (st->numReaders + winner) / 2; i >= 1; i /= 2) {
+            if (RM_SortBeats(st, st->tree[i], winner)) {
+                t = st->tree[i];
+                st->tree[i] = winner;
+                winner = t;
+            }
+        }
+        st->tree[0] = winner;
+        st->advance = FALSE;
+    }
+
+    r = &st->readers[st->tree[0]];
+    *data = r->item;
+    *dataLength = r->itemLen;
+    st->advance = (r->item != NULL);
+    return RME_OK;
+}
+
+/* Waits for any reads still out on the readers' blocks */
+static void RM_SortDrainReaders(struct RM_SortState *st) {
+    int i;
+
+    for (i = 0; i < st->numReaders; i++) {
+        RM_SortWait(st, &st->readers[i].blocks[0]);
+        RM_SortWait(st, &st->readers[i].blocks[1]);
+    }
+}
+
+/*
+ * RM_SortMergeRuns
+ * Desc: Merges the oldest runs into a new one until the live runs fit
+ *       in a single merge. The last of these merges takes only as many
+ *       runs as it must.
+ */
+static int RM_SortMergeRuns(struct RM_SortState *st) {
+    char *data;
+    int live, k, pass, i, len, err;
+
+    while ((live = st->numRuns - st->firstLive) > st->fanIn) {
+        k = (live - st->fanIn + 1 < st->fanIn) ? live - st->fanIn + 1 : st->fanIn;
+        if ((err = RM_SortStartMerge(st, st->firstLive, k)) != RME_OK)
+            return err;
+        pass = 0;
+        for (i = st->firstLive; i < st->firstLive + k; i++)
+            if (st->runs[i].pass > pass)
+                pass = st->runs[i].pass;
+
+        while ((err = RM_SortMergeNext(st, &data, &len)) == RME_OK && data != NULL)
+            if ((err = RM_SortWriteItem(st, data, len)) != RME_OK)
+                break;
+        RM_SortDrainReaders(st);
+        if (err != RME_OK || (err = RM_SortEndRun(st, pass + 1)) != RME_OK)
+            return err;
+        st->firstLive += k;
+    }
+    return RME_OK;
+}
+
+int RM_SortDone(RM_Sort *sort) {
+    struct RM_SortState *st = sort->state;
+    long blockBytes;
+    int i, err;
+
+    if (st == NULL || st->done)
+        return RME_INVALIDARG;
+    st->done = TRUE;
+    if (st->fd < 0)
+        return RME_OK; // All in memory
+
+    // 1. The rest of memory goes out to the runs
+    while (st->heapSize > 0)
+        if ((err = RM_SortSpill(st)) != RME_OK)
+            return err;
+    if ((err = RM_SortEndRun(st, 0)) != RME_OK)
+        return err;
+    free(st->heap);
+    free(st->lastOut);
+    st->heap = NULL;
+    st->lastOut = NULL;
+    sort->numRuns = st->numRuns;
+
+    // 2. Readers take the frames the heap had; the writer keeps its own
+    blockBytes = (long)st->blockPages * PF_PAGE_SIZE;
+    st->readerFrames = malloc(2 * st->fanIn * blockBytes);
+    st->readers = calloc(st->fanIn, sizeof(RM_SortReader));
+    st->tree = malloc(sizeof(int) * st->fanIn);
+    if (st->readerFrames == NULL || st->readers == NULL || st->tree == NULL)
+        return RME_NOMEM;
+    for (i = 0; i < st->fanIn; i++) {
+        st->readers[i].blocks[0].pages = st->readerFrames + 2 * i * blockBytes;
+        st->readers[i].blocks[1].pages = st->readerFrames + (2 * i + 1) * blockBytes;
+    }
+
+    // 3. Merge down to one final merge, and start it
+    if ((err = RM_SortMergeRuns(st)) != RME_OK)
+        return err;
+    for (i = st->firstLive; i < st->numRuns; i++)
+        if (st->runs[i].pass + 1 > sort->numPasses)
+            sort->numPasses = st->runs[i].pass + 1;
+    return RM_SortStartMerge(st, st->firstLive, st->numRuns - st->firstLive);
+}
+
+int RM_SortNext(RM_Sort *sort, char **data, int *dataLength) {
+    struct RM_SortState *st = sort->state;
+    int err;
+
+    if (st == NULL || !st->done)
+        return RME_INVALIDARG;
+
+    if (st->fd < 0) {
+        // In memory: the heap hands items out in order
+        free(st->outItem.data);
+        st->outItem.data = NULL;
+        if (st->heapSize == 0)
+            return RME_EOF;
+        RM_SortPop(st, &st->outItem);
+        *data = st->outItem.data;
+        *dataLength = st->outItem.len;
+        return RME_OK;
+    }
+
+    if ((err = RM_SortMergeNext(st, data, dataLength)) != RME_OK)
+        return err;
+    return (*data == NULL) ? RME_EOF : RME_OK;
+}
+
+int RM_EndSort(RM_Sort *sort) {
+    struct RM_SortState *st = sort->state;
+    int err = RME_OK, i;
+
+    if (st == NULL)
+        return RME_OK;
+
+    // 1. Let the helper thread finish what is queued, then stop it
+    if (st->ioRunning) {
+        pthread_mutex_lock(&st->ioMutex);
+        st->ioStop = TRUE;
+        pthread_cond_signal(&st->ioWork);
+        pthread_mutex_unlock(&st->ioMutex);
+        pthread_join(st->ioThread, NULL);
+    }
+
+    // 2. Drop the temporary file
+    if (st->fd >= 0) {
+        if (PF_CloseFile(st->fd) != PFE_OK)
+            err = RME_ERROR;
+        PF_DestroyFile(st->fileName);
+    }
+
+    // 3. Free the memory
+    for (i = 0; i < st->heapSize; i++)
+        free(st->heap[i].data);
+    free(st->heap);
+    free(st->lastOut);
+    free(st->outItem.data);
+    if (st->readers != NULL)
+        for (i = 0; i < st->fanIn; i++)
+            free(st->readers[i].stage);
+    free(st->readers);
+    free(st->tree);
+    free(st->runs);
+    free(st->writerFrames);
+    free(st->readerFrames);
+    pthread_mutex_destroy(&st->ioMutex);
+    pthread_cond_destroy(&st->ioWork);
+    pthread_cond_destroy(&st->ioDone);
+    free(st);
+    sort->state = NULL;
+    return err;
+}
+
+
+/* --- ORDER BY --- */
+
+int RM_SortFile(RM_FileHandle *fh, RM_Filter *filter, RM_OrderBy *order,
+                int numFrames, RM_Sort *sort) {
+    RM_ScanHandle sh;
+    RID rid;
+    char *buf;
+    int bufSize = PF_PAGE_SIZE, recLen, err;
+
+    if ((err = RM_BeginSort(sort, RM_CompareRecords, order, numFrames)) != RME_OK)
+        return err;
+    if ((buf = malloc(bufSize)) == NULL) {
+        RM_EndSort(sort);
+        return RME_NOMEM;
+    }
+
+    if ((err = RM_OpenScan(fh, &sh, filter, NULL)) == RME_OK) {
+        while ((err = RM_GetNextRecordAlloc(&sh, &rid, &buf, &bufSize, &recLen)) == RME_OK) {
+            if ((err = RM_SortAdd(sort, buf, recLen)) != RME_OK)
+                break;
+        }
+        RM_CloseScan(&sh);
+    }
+    free(buf);
+
+    if (err == RME_EOF)
+        err = RM_SortDone(sort);
+    if (err != RME_OK)
+        RM_EndSort(sort);
+    return err;
+}
@@ -0,0 +1,68 @@
+/* rmtypes.h: internal declarations shared by the RM layer source files */
+
+#ifndef RM_TYPES_H
+#define RM_TYPES_H
+
+#include "rm.h"
+
+/* Files of slotted pages (either width of slot entry) */
+#define RM_IS_SLOTTED(fh) ((fh)->format == RM_FMT_SLOTTED || (fh)->format == RM_FMT_COMPACT)
+
+/*
+ * Free-space map of an open file (rm.c). RM_NoteRoom records the room
+ * left on a page: bytes for slotted pages, free slots for fixed and PAX
+ * pages (0 = full). RM_FindRoom sets *pageNum to the first page that may
+ * have at least 'room' left, without reading any page; pages not noted
+ * yet may have any room, so the caller must still check the page.
+ * Returns RME_OK, RME_EOF (no such page: allocate one) or RME_NOMEM.
+ */
+extern void RM_NoteRoom(RM_FileHandle *fh, int pageNum, int room);
+extern int RM_FindRoom(RM_FileHandle *fh, int room, int *pageNum);
+
+/*
+ * RM_GetNextRecord into a malloc'ed buffer of *bufSize bytes, which is
+ * grown with realloc until the record fits (rm.c). The caller frees
+ * *buf, also on an error.
+ */
+extern int RM_GetNextRecordAlloc(RM_ScanHandle *sh, RID *rid, char **buf, int *bufSize,
+                                 int *dataLength);
+
+/* Moves a scan to its next used page (rm.c) */
+extern int RM_ScanNextPage(RM_ScanHandle *sh, char *caller);
+
+/*
+ * Slotted pages built in memory by the bulk loader (rmload.c).
+ * RM_InitPage formats a zeroed page for the file's layout and
+ * RM_PageAppend adds a record in a new slot (-1 = no room) and
+ * RM_PageRoom returns the longest record that still fits (rm.c).
+ */
+extern void RM_InitPage(RM_FileHandle *fh, char *pageData);
+extern int RM_PageAppend(char *pageData, char *data, int dataLength);
+extern int RM_PageRoom(char *pageData);
+
+/*
+ * PAX pages (rmpax.c). RM_PaxInitLayout fills in the layout for a
+ * schema and returns the records per page (0 = a record cannot fit).
+ * The rest implement the record API of rm.c for RM_FMT_PAX files.
+ */
+extern int RM_PaxInitLayout(RM_Schema *schema, RM_PaxLayout *layout);
+extern int RM_PaxInsertRecord(RM_FileHandle *fh, char *data, int dataLength, RID *rid);
+extern int RM_PaxDeleteRecord(RM_FileHandle *fh, RID rid);
+extern int RM_PaxUpdateRecord(RM_FileHandle *fh, RID rid, char *data, int dataLength);
+extern int RM_PaxGetRecord(RM_FileHandle *fh, RID rid, char *dataBuf, int bufSize, int *dataLength);
+extern int RM_PaxGetNextRecord(RM_ScanHandle *sh, RID *rid, char *dataBuf, int bufSize, int *dataLength);
+
+/*
+ * Fixed-length pages (rmfixed.c). RM_FixedInitLayout fills in the layout
+ * for a record length and returns the records per page (0 = none fit).
+ * The rest implement the record API of rm.c for RM_FMT_FIXED files.
+ */
+extern int RM_FixedInitLayout(int recordLength, RM_FixedLayout *layout);
+extern int RM_FixedInsertRecord(RM_FileHandle *fh, char *data, int dataLength, RID *rid);
+extern int RM_FixedDeleteRecord(RM_FileHandle *fh, RID rid);
+extern int RM_FixedUpdateRecord(RM_FileHandle *fh, RID rid, char *data, int dataLength);
+extern int RM_FixedGetRecord(RM_FileHandle *fh, RID rid, char *dataBuf, int bufSize, int *dataLength);
+extern int RM_FixedGetNextRecord(RM_ScanHandle *sh, RID *rid, char *dataBuf, int bufSize, int *dataLength);
+extern int RM_FixedGetNextBatch(RM_ScanHandle *sh, RM_Batch *batch);
+
+#endif /* RM_TYPES_H */
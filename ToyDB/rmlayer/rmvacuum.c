@@ -0,0 +1,142 @@
+/* rmvacuum.c: Repacking RM files */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "rm.h"
+#include "rmtypes.h"
+#include "pf.h"
+
+/*
+ * Deleting a record gives its bytes back to its page but never the page
+ * back to the file: half-empty pages stay half empty, disposed overflow
+ * pages only go on the PF free list, and scans read all of them. A
+ * vacuum copies the live records into a fresh file of the same layout,
+ * packed tight by the bulk loader, and renames it over the old one.
+ * Records that were moved by an update come back at their home RID, so
+ * the copy has no forwarding stubs either. Every record gets a new RID;
+ * the map says which.
+ */
+#define VACUUM_SUFFIX ".vacuum"
+#define MAX_NAME_LEN 512
+
+static int RM_CompareRidMap(const void *a, const void *b) {
+    RID ra = ((const RM_RidMap *)a)->oldRid;
+    RID rb = ((const RM_RidMap *)b)->oldRid;
+    return (ra > rb) - (ra < rb);
+}
+
+/*
+ * RM_CopyRecords
+ * Desc: Bulk loads every record of 'from' into 'to' and notes where
+ *       each one went.
+ */
+static int RM_CopyRecords(RM_FileHandle *from, RM_FileHandle *to,
+                          RM_RidMap **map, int *numMapped) {
+    RM_ScanHandle sh;
+    RM_BulkLoader bl;
+    RID rid, newRid;
+    RM_RidMap *grown;
+    char *buf;
+    int bufSize = PF_PAGE_SIZE, capacity = 1024, recLen, err;
+
+    if ((buf = malloc(bufSize)) == NULL ||
+        (*map = malloc(sizeof(RM_RidMap) * capacity)) == NULL) {
+        free(buf);
+        return RME_NOMEM;
+    }
+    if ((err = RM_BeginBulkLoad(to, &bl)) != RME_OK) {
+        free(buf);
+        return err;
+    }
+
+    if ((err = RM_OpenScan(from, &sh, NULL, NULL)) != RME_OK) {
+        free(buf);
+        RM_EndBulkLoad(&bl);
+        return err;
+    }
+    while ((err = RM_GetNextRecordAlloc(&sh, &rid, &buf, &bufSize, &recLen)) == RME_OK) {
+        if ((err = RM_BulkInsert(&bl, buf, recLen, &newRid)) != RME_OK)
+            break;
+
+        // On failure *map is kept, for RM_VacuumFile to free
+        if (*numMapped == capacity) {
+            if ((grown = realloc(*map, sizeof(RM_RidMap) * capacity * 2)) == NULL) {
+                err = RME_NOMEM;
+                break;
+            }
+            *map = grown;
+            capacity *= 2;
+        }
+        (*map)[*numMapped].oldRid = rid;
+        (*map)[(*numMapped)++].newRid = newRid;
+    }
+    RM_CloseScan(&sh);
+    free(buf);
+
+    if (err == RME_EOF)
+        return RM_EndBulkLoad(&bl);
+    RM_EndBulkLoad(&bl);
+    return err;
+}
+
+int RM_VacuumFile(char *fileName, RM_RidMap **map, int *numMapped) {
+    RM_FileHandle oldFh, newFh;
+    RM_Schema *schema;
+    char tmpName[MAX_NAME_LEN];
+    int err;
+
+    *map = NULL;
+    *numMapped = 0;
+    if (snprintf(tmpName, sizeof(tmpName), "%s%s", fileName, VACUUM_SUFFIX) >= (int)sizeof(tmpName))
+        return RME_INVALIDARG;
+
+    // 1. An empty file of the same layout next to the old one
+    if ((err = RM_OpenFile(fileName, PF_LRU, &oldFh)) != RME_OK)
+        return err;
+    schema = (oldFh.schema.numAttrs > 0) ? &oldFh.schema : NULL;
+    RM_DestroyFile(tmpName);
+    if (oldFh.format == RM_FMT_FIXED)
+        err = RM_CreateFixedFile(tmpName, oldFh.fixed.recordLength, schema);
+    else
+        err = RM_CreateFileFormat(tmpName, oldFh.format, schema);
+    if (err != RME_OK || (err = RM_OpenFile(tmpName, PF_LRU, &newFh)) != RME_OK) {
+        RM_CloseFile(&oldFh);
+        return err;
+    }
+
+    // 2. Copy the live records over
+    err = RM_CopyRecords(&oldFh, &newFh, map, numMapped);
+    RM_CloseFile(&oldFh);
+    if (RM_CloseFile(&newFh) != RME_OK && err == RME_OK)
+        err = RME_ERROR;
+
+    // 3. The copy replaces the file
+    if (err == RME_OK && rename(tmpName, fileName) != 0)
+        err = RME_ERROR;
+    if (err != RME_OK) {
+        RM_DestroyFile(tmpName);
+        free(*map);
+        *map = NULL;
+        *numMapped = 0;
+        return err;
+    }
+
+    // A moved record turns up where it lives, not at its home RID
+    qsort(*map, *numMapped, sizeof(RM_RidMap), RM_CompareRidMap);
+    return RME_OK;
+}
+
+RID RM_MapRID(RM_RidMap *map, int numMapped, RID oldRid) {
+    int lo = 0, hi = numMapped - 1, mid;
+
+    while (lo <= hi) {
+        mid = (lo + hi) / 2;
+        if (map[mid].oldRid == oldRid)
+            return map[mid].newRid;
+        if (map[mid].oldRid < oldRid)
+            lo = mid + 1;
+        else
+            hi = mid - 1;
+    }
+    return RME_INVALIDRID;
+}
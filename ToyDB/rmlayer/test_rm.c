@@ -4,19 +4,25 @@
  * This program reads the fixed-length student.txt file and simulates
  * variable-length data to test the slotted-page implementation.
  * It then generates the space utilization report required by the assignment.
+ * The same records are also loaded into a compact slotted file
+ * (RM_FMT_COMPACT, 2-byte slot entries), and both files are scanned
+ * from a cold buffer pool to show what the extra records per page buy.
  */
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h> // For ceil()
+#include <time.h>
 #include "pf.h"
 #include "rm.h"
 #include "pftypes.h" // To access PFftab for stats
 
 #define STUDENT_DB_NAME "student_slotted.db"
+#define COMPACT_DB_NAME "student_compact.db"
 #define STUDENT_DATA_FILE "../../data/student.txt"
 #define MAX_LINE_LEN 256
 #define MAX_TEST_NAME_LEN 100 // Max length for our simulated variable names
+#define SCAN_ROUNDS 20        // Full scans timed per file
 
 //
 // This is the key function to simulate variable-length data.
@@ -53,38 +59,28 @@ char* create_variable_record(char* line, int* recordLen) {
 }
 
 
-int main() {
-    RM_FileHandle fh;
-    RID rid;
-    FILE* dataFile;
+//
+// Loads every line of the data file into an RM file of the given format.
+// The random generator is reseeded, so every format gets the same records.
+//
+long load_file(char* fileName, int format, FILE* dataFile, RM_FileHandle* fh, long* usefulData) {
     char line[MAX_LINE_LEN];
     char* varRecord;
     int recordLen;
-    long totalUsefulData = 0;
-    long totalNumRecords = 0;
+    long numRecords = 0;
+    RID rid;
 
-    // --- Part 1: Initialize and Populate the RM File ---
-    
-    // Init the PF layer (with a 20-page buffer pool)
-    PF_Init(20);
     srand(0); // Use fixed seed for reproducible tests
+    rewind(dataFile);
+    *usefulData = 0;
 
     // Create the RM file
-    RM_CreateFile(STUDENT_DB_NAME);
-    if (RM_OpenFile(STUDENT_DB_NAME, PF_LRU, &fh) != RME_OK) {
+    RM_DestroyFile(fileName);
+    RM_CreateFileFormat(fileName, format, NULL);
+    if (RM_OpenFile(fileName, PF_LRU, fh) != RME_OK) {
         printf("Error opening RM file.\n");
-        return 1;
-    }
-
-    // Open the raw student data file
-    if ((dataFile = fopen(STUDENT_DATA_FILE, "r")) == NULL) {
-        printf("Error: Could not open data file: %s\n", STUDENT_DATA_FILE);
-        printf("Please check the path.\n");
-        RM_CloseFile(&fh);
-        return 1;
+        return -1;
     }
-    
-    printf("Loading and simulating variable-length data...\n");
 
     // Read data file line by line
     while (fgets(line, MAX_LINE_LEN, dataFile)) {
@@ -99,17 +95,119 @@ int main() {
         }
 
         // Insert into our slotted-page file
-        if (RM_InsertRecord(&fh, varRecord, recordLen, &rid) != RME_OK) {
+        if (RM_InsertRecord(fh, varRecord, recordLen, &rid) != RME_OK) {
             printf("Error inserting record.\n");
         } else {
-            totalUsefulData += recordLen;
-            totalNumRecords++;
+            *usefulData += recordLen;
+            numRecords++;
         }
         
         free(varRecord); // Free the simulated record buffer
     }
+    return numRecords;
+}
+
+//
+// Scans the whole file SCAN_ROUNDS times, each time from a freshly opened
+// (cold) file; returns the seconds per scan and the page reads of one scan.
+//
+double time_scans(char* fileName, long* pageReads, long* numScanned) {
+    RM_FileHandle fh;
+    RM_ScanHandle sh;
+    RID rid;
+    char scanBuf[PF_PAGE_SIZE];
+    int recordLen;
+    double seconds = 0;
+    clock_t start;
+
+    for (int round = 0; round < SCAN_ROUNDS; round++) {
+        RM_OpenFile(fileName, PF_LRU, &fh);
+        PF_ResetStats();
+        *numScanned = 0;
+        start = clock();
+        RM_OpenScan(&fh, &sh, NULL, NULL);
+        while (RM_GetNextRecord(&sh, &rid, scanBuf, sizeof(scanBuf), &recordLen) == RME_OK)
+            (*numScanned)++;
+        RM_CloseScan(&sh);
+        seconds += (double)(clock() - start) / CLOCKS_PER_SEC;
+        *pageReads = PF_GetDiskReads();
+        RM_CloseFile(&fh);
+    }
+    return seconds / SCAN_ROUNDS;
+}
+
+//
+// Deletes a random half of the records of a file and inserts as many again.
+// Deleted slots are reused through each page's chain of empty slots and
+// empty tails of the slot directory are cut off, so the file must not grow.
+//
+void churn(char* label, char* fileName, FILE* dataFile, long numRecords, int pagesBefore) {
+    RM_FileHandle fh;
+    RM_ScanHandle sh;
+    RID rid;
+    char line[MAX_LINE_LEN];
+    char scanBuf[PF_PAGE_SIZE];
+    char* varRecord;
+    int recordLen;
+    RID *rids = malloc(sizeof(RID) * numRecords);
+    long numRids = 0, numDeleted = 0, numReinserted = 0;
+    clock_t churnStart = clock();
+
+    RM_OpenFile(fileName, PF_LRU, &fh);
+    RM_OpenScan(&fh, &sh, NULL, NULL);
+    while (numRids < numRecords &&
+           RM_GetNextRecord(&sh, &rids[numRids], scanBuf, sizeof(scanBuf), &recordLen) == RME_OK)
+        numRids++;
+    RM_CloseScan(&sh);
+    for (long i = 0; i < numRids; i++) {
+        if (rand() % 2 == 0 && RM_DeleteRecord(&fh, rids[i]) == RME_OK)
+            numDeleted++;
+    }
+    rewind(dataFile);
+    while (numReinserted < numDeleted && fgets(line, MAX_LINE_LEN, dataFile)) {
+        line[strcspn(line, "\n")] = 0;
+        if ((varRecord = create_variable_record(line, &recordLen)) == NULL)
+            continue;
+        if (RM_InsertRecord(&fh, varRecord, recordLen, &rid) == RME_OK)
+            numReinserted++;
+        free(varRecord);
+    }
+    free(rids);
+    printf("Churn (%s): deleted %ld, inserted %ld; %d pages before, %d after (%f sec)\n",
+           label, numDeleted, numReinserted, pagesBefore,
+           PFftab[fh.pfFileDesc].hdr.numpages, (double)(clock() - churnStart) / CLOCKS_PER_SEC);
+
+    // Close the file (flushes all pages)
+    RM_CloseFile(&fh);
+}
+
+
+int main() {
+    RM_FileHandle fh, fhCompact;
+    FILE* dataFile;
+    long totalUsefulData = 0;
+    long totalNumRecords = 0;
+
+    // --- Part 1: Initialize and Populate the RM Files ---
+    
+    // Init the PF layer (with a 20-page buffer pool)
+    PF_Init(20);
+
+    // Open the raw student data file
+    if ((dataFile = fopen(STUDENT_DATA_FILE, "r")) == NULL) {
+        printf("Error: Could not open data file: %s\n", STUDENT_DATA_FILE);
+        printf("Please check the path.\n");
+        return 1;
+    }
+    
+    printf("Loading and simulating variable-length data...\n");
+    if ((totalNumRecords = load_file(STUDENT_DB_NAME, RM_FMT_SLOTTED, dataFile,
+                                     &fh, &totalUsefulData)) < 0 ||
+        load_file(COMPACT_DB_NAME, RM_FMT_COMPACT, dataFile, &fhCompact, &totalUsefulData) < 0) {
+        fclose(dataFile);
+        return 1;
+    }
 
-    fclose(dataFile);
     printf("...Loaded %ld records.\n", totalNumRecords);
     
     // --- Part 2: Calculate Statistics and Print Table ---
@@ -121,9 +219,9 @@ int main() {
     int totalPagesUsed_Slotted = PFftab[fh.pfFileDesc].hdr.numpages;
     long totalSpaceUsed_Slotted = (long)totalPagesUsed_Slotted * PF_PAGE_SIZE;
     double utilization_Slotted = (double)totalUsefulData / totalSpaceUsed_Slotted;
-
-    // Close the file (flushes all pages)
-    RM_CloseFile(&fh);
+    int totalPagesUsed_Compact = PFftab[fhCompact.pfFileDesc].hdr.numpages;
+    long totalSpaceUsed_Compact = (long)totalPagesUsed_Compact * PF_PAGE_SIZE;
+    double utilization_Compact = (double)totalUsefulData / totalSpaceUsed_Compact;
 
     // Print the header
     printf("| %-20s | %-20s | %-20s | %-20s | %-20s |\n",
@@ -133,6 +231,8 @@ int main() {
     // Print Slotted Page results
     printf("| %-20s | %-20s | %-20ld | %-20ld | %-20.2f |\n",
            "Slotted Page", "N/A", totalSpaceUsed_Slotted, totalUsefulData, utilization_Slotted * 100);
+    printf("| %-20s | %-20s | %-20ld | %-20ld | %-20.2f |\n",
+           "Compact Slotted", "N/A", totalSpaceUsed_Compact, totalUsefulData, utilization_Compact * 100);
 
 
     // Calculate and Print Static Management results
@@ -161,5 +261,29 @@ int main() {
     }
     
     printf("\n");
+
+    // --- Part 3: Full scans of both layouts from a cold buffer pool ---
+    long readsSlotted, readsCompact, scannedSlotted, scannedCompact;
+    RM_CloseFile(&fh);
+    RM_CloseFile(&fhCompact);
+    double secSlotted = time_scans(STUDENT_DB_NAME, &readsSlotted, &scannedSlotted);
+    double secCompact = time_scans(COMPACT_DB_NAME, &readsCompact, &scannedCompact);
+
+    printf("Compact slots: %d pages instead of %d (%.2f%% more utilization, %.1f vs %.1f records per page)\n",
+           totalPagesUsed_Compact, totalPagesUsed_Slotted,
+           (utilization_Compact - utilization_Slotted) * 100,
+           (double)totalNumRecords / (totalPagesUsed_Compact - 1),
+           (double)totalNumRecords / (totalPagesUsed_Slotted - 1));
+    printf("Full scan (avg of %d): slotted %ld records, %ld page reads, %f sec; "
+           "compact %ld records, %ld page reads, %f sec (speedup %.2fx in reads, %.2fx in time)\n\n",
+           SCAN_ROUNDS, scannedSlotted, readsSlotted, secSlotted,
+           scannedCompact, readsCompact, secCompact,
+           readsCompact > 0 ? (double)readsSlotted / readsCompact : 0.0,
+           secCompact > 0 ? secSlotted / secCompact : 0.0);
+
+    // --- Part 4: Churn (delete half of the records, insert as many again) ---
+    churn("Slotted", STUDENT_DB_NAME, dataFile, totalNumRecords, totalPagesUsed_Slotted);
+    churn("Compact", COMPACT_DB_NAME, dataFile, totalNumRecords, totalPagesUsed_Compact);
+    fclose(dataFile);
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,229 @@
+/*
+ * test_rmcol.c: Column file benchmark for the Record Manager (RM) layer.
+ *
+ * Loads gradsum.txt and studregn.txt twice, as typed slotted RM files
+ * and as column files, then runs the same selective queries on both
+ * starting from a cold buffer pool:
+ *   Q1  SELECT roll, cpi FROM gradsum WHERE year = 2001 AND cpi >= 8.0
+ *   Q2  SELECT roll FROM gradsum WHERE cpi >= 9.5
+ *   Q3  SELECT roll, course FROM studregn WHERE year = 1996 AND grade = 'AA'
+ * Both tables are roughly clustered on year, so zone maps on the year
+ * column let the column scan skip most pages; cpi is not clustered,
+ * so Q2 only gains from reading two columns instead of whole rows.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "pf.h"
+#include "rm.h"
+
+#define GRADSUM_DATA_FILE  "../../data/gradsum.txt"
+#define STUDREGN_DATA_FILE "../../data/studregn.txt"
+#define ROW_DB_NAME "rmcol_rows.db"
+#define COL_DB_NAME "rmcol_cols.db"
+#define MAX_LINE_LEN 256
+
+/* gradsum fields: roll;year;sem;...;cpi;... */
+#define GS_ROLL 0
+#define GS_YEAR 1
+#define GS_CPI  6
+
+/* studregn fields: year;sem;course;grade;...;roll;credits */
+#define SR_YEAR   0
+#define SR_COURSE 2
+#define SR_GRADE  3
+#define SR_ROLL   6
+
+static void GradsumSchema(RM_Schema *schema) {
+    RM_InitSchema(schema);
+    RM_AddAttr(schema, "roll", RM_INT, 0);
+    RM_AddAttr(schema, "year", RM_INT, 0);
+    RM_AddAttr(schema, "sem", RM_INT, 0);
+    RM_AddAttr(schema, "spi", RM_FLOAT, 0);
+    RM_AddAttr(schema, "spi2", RM_FLOAT, 0);
+    RM_AddAttr(schema, "spi3", RM_FLOAT, 0);
+    RM_AddAttr(schema, "cpi", RM_FLOAT, 0);
+    RM_AddAttr(schema, "credits", RM_FLOAT, 0);
+    RM_AddAttr(schema, "points", RM_FLOAT, 0);
+}
+
+static void StudregnSchema(RM_Schema *schema) {
+    RM_InitSchema(schema);
+    RM_AddAttr(schema, "year", RM_INT, 0);
+    RM_AddAttr(schema, "sem", RM_INT, 0);
+    RM_AddAttr(schema, "course", RM_VARCHAR, 8);
+    RM_AddAttr(schema, "grade", RM_VARCHAR, 2);
+    RM_AddAttr(schema, "type", RM_CHAR, 1);
+    RM_AddAttr(schema, "status", RM_CHAR, 1);
+    RM_AddAttr(schema, "roll", RM_INT, 0);
+    RM_AddAttr(schema, "credits", RM_FLOAT, 0);
+}
+
+/*
+ * LoadTable
+ * Desc: Loads one data file into a new slotted RM file and a new column
+ *       file with the same schema. Returns the number of rows loaded.
+ */
+static long LoadTable(char *dataPath, RM_Schema *schema) {
+    RM_FileHandle fh;
+    RM_ColFileHandle cfh;
+    FILE *dataFile;
+    char line[MAX_LINE_LEN];
+    char recBuf[PF_PAGE_SIZE];
+    int recLen, rowNum;
+    RID rid;
+    long numLoaded = 0;
+
+    RM_DestroyFile(ROW_DB_NAME);
+    RM_DestroyFile(COL_DB_NAME);
+    if (RM_CreateTypedFile(ROW_DB_NAME, schema) != RME_OK ||
+        RM_CreateColumnFile(COL_DB_NAME, schema) != RME_OK ||
+        RM_OpenFile(ROW_DB_NAME, PF_LRU, &fh) != RME_OK)
+        return -1;
+    if (RM_OpenColumnFile(COL_DB_NAME, PF_LRU, &cfh) != RME_OK) {
+        RM_CloseFile(&fh);
+        return -1;
+    }
+    if ((dataFile = fopen(dataPath, "r")) == NULL) {
+        printf("Error: Could not open data file: %s\n", dataPath);
+        RM_CloseColumnFile(&cfh);
+        RM_CloseFile(&fh);
+        return -1;
+    }
+
+    fgets(line, MAX_LINE_LEN, dataFile); // Skip the title line
+    while (fgets(line, MAX_LINE_LEN, dataFile)) {
+        line[strcspn(line, "\n")] = 0;
+        if (RM_EncodeDelimited(schema, line, ';', recBuf, sizeof(recBuf), &recLen) != RME_OK)
+            continue;
+        if (RM_InsertRecord(&fh, recBuf, recLen, &rid) == RME_OK &&
+            RM_InsertRow(&cfh, recBuf, recLen, &rowNum) == RME_OK)
+            numLoaded++;
+    }
+    fclose(dataFile);
+
+    printf("%s: %ld rows, %d slotted pages, %d column-file pages\n", dataPath, numLoaded,
+           PF_GetNumPages(fh.pfFileDesc), PF_GetNumPages(cfh.pfFileDesc));
+    RM_CloseColumnFile(&cfh);
+    RM_CloseFile(&fh);
+    return numLoaded;
+}
+
+/*
+ * RunRowQuery
+ * Desc: Runs the query over the slotted file with a typed filter and
+ *       reads the projected fields of every match.
+ */
+static void RunRowQuery(RM_Filter *filter, int numCols, int *cols) {
+    RM_FileHandle fh;
+    RM_ScanHandle sh;
+    char recBuf[PF_PAGE_SIZE];
+    char *fieldPtr;
+    int recLen, fieldLen, i;
+    long numMatched = 0, numFields = 0;
+    RID rid;
+    clock_t start;
+
+    RM_OpenFile(ROW_DB_NAME, PF_LRU, &fh);
+    filter->schema = RM_GetSchema(&fh);
+    PF_ResetStats();
+    start = clock();
+    RM_OpenScan(&fh, &sh, filter, NULL);
+    while (RM_GetNextRecord(&sh, &rid, recBuf, sizeof(recBuf), &recLen) == RME_OK) {
+        for (i = 0; i < numCols; i++)
+            if (RM_GetField(filter->schema, recBuf, cols[i], &fieldPtr, &fieldLen) == RME_OK)
+                numFields++;
+        numMatched++;
+    }
+    RM_CloseScan(&sh);
+    printf("  slotted rows:  %6ld matches, %6ld fields, %5ld page reads, %f sec\n",
+           numMatched, numFields, PF_GetPhysicalIOs(), (double)(clock() - start) / CLOCKS_PER_SEC);
+    RM_CloseFile(&fh);
+}
+
+/*
+ * RunColumnQuery
+ * Desc: Runs the query over the column file.
+ */
+static void RunColumnQuery(RM_Filter *filter, int numCols, int *cols) {
+    RM_ColFileHandle cfh;
+    RM_ColScanHandle sh;
+    char *fields[RM_MAXPROJ];
+    int lens[RM_MAXPROJ];
+    int rowNum, i;
+    long numMatched = 0, numFields = 0;
+    clock_t start;
+
+    RM_OpenColumnFile(COL_DB_NAME, PF_LRU, &cfh);
+    filter->schema = &cfh.schema;
+    PF_ResetStats();
+    start = clock();
+    if (RM_OpenColumnScan(&cfh, &sh, filter, numCols, cols) != RME_OK) {
+        printf("Error opening column scan.\n");
+        RM_CloseColumnFile(&cfh);
+        return;
+    }
+    while (RM_GetNextRow(&sh, &rowNum, fields, lens) == RME_OK) {
+        for (i = 0; i < numCols; i++)
+            if (fields[i] != NULL)
+                numFields++;
+        numMatched++;
+    }
+    RM_CloseColumnScan(&sh);
+    printf("  column file:   %6ld matches, %6ld fields, %5ld page reads, %f sec"
+           " (%ld data pages read, %ld skipped by zone maps)\n",
+           numMatched, numFields, PF_GetPhysicalIOs(), (double)(clock() - start) / CLOCKS_PER_SEC,
+           sh.pagesRead, sh.pagesSkipped);
+    RM_CloseColumnFile(&cfh);
+}
+
+int main() {
+    RM_Schema schema;
+    RM_Filter filter;
+    int q1Cols[] = { GS_ROLL, GS_CPI };
+    int q2Cols[] = { GS_ROLL };
+    int q3Cols[] = { SR_ROLL, SR_COURSE };
+
+    PF_Init(50);
+
+    // --- gradsum ---
+    GradsumSchema(&schema);
+    if (LoadTable(GRADSUM_DATA_FILE, &schema) < 0) {
+        printf("Error loading %s\n", GRADSUM_DATA_FILE);
+        return 1;
+    }
+
+    printf("\nQ1: SELECT roll, cpi FROM gradsum WHERE year = 2001 AND cpi >= 8.0\n");
+    RM_InitTypedFilter(&filter, &schema);
+    RM_AddPredicate(&filter, GS_YEAR, 'i', RM_EQ, "2001");
+    RM_AddPredicate(&filter, GS_CPI, 'f', RM_GE, "8.0");
+    RunRowQuery(&filter, 2, q1Cols);
+    RunColumnQuery(&filter, 2, q1Cols);
+
+    printf("\nQ2: SELECT roll FROM gradsum WHERE cpi >= 9.5\n");
+    RM_InitTypedFilter(&filter, &schema);
+    RM_AddPredicate(&filter, GS_CPI, 'f', RM_GE, "9.5");
+    RunRowQuery(&filter, 1, q2Cols);
+    RunColumnQuery(&filter, 1, q2Cols);
+
+    // --- studregn ---
+    printf("\n");
+    StudregnSchema(&schema);
+    if (LoadTable(STUDREGN_DATA_FILE, &schema) < 0) {
+        printf("Error loading %s\n", STUDREGN_DATA_FILE);
+        return 1;
+    }
+
+    printf("\nQ3: SELECT roll, course FROM studregn WHERE year = 1996 AND grade = 'AA'\n");
+    RM_InitTypedFilter(&filter, &schema);
+    RM_AddPredicate(&filter, SR_YEAR, 'i', RM_EQ, "1996");
+    RM_AddPredicate(&filter, SR_GRADE, 'c', RM_EQ, "AA");
+    RunRowQuery(&filter, 2, q3Cols);
+    RunColumnQuery(&filter, 2, q3Cols);
+
+    RM_DestroyFile(ROW_DB_NAME);
+    RM_DestroyFile(COL_DB_NAME);
+    printf("\n");
+    return 0;
+}
@@ -0,0 +1,186 @@
+/*
+ * test_rmcomp.c: Page compression benchmark for the PF layer.
+ *
+ * Usage: test_rmcomp [dataDir]      (default ../../data)
+ *
+ * Loads every table of data/ into an RM file, one line per record,
+ * once with raw pages and once with PF page compression on, then scans
+ * each file back from a cold buffer pool. For both it reports the bytes
+ * written by the load, the bytes read by the scan, the space the file
+ * takes on disk and the time of each phase; the difference in time is
+ * the CPU cost of compressing and decompressing. The scans must return
+ * the same records (compared by count and checksum).
+ *
+ * The buffer pool holds a whole table, so the load writes every page
+ * exactly once (when the file is closed) and the scan reads it once.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "pf.h"
+#include "rm.h"
+
+#define COMP_DB_NAME "rmcomp.db"
+#define MAX_PATH_LEN 512
+#define MAX_LINE_LEN PF_PAGE_SIZE
+#define BATCH_SIZE 512
+#define NUM_BUFS 1024 /* More than the pages of the largest table */
+
+/* What one load + scan of a table measured */
+typedef struct {
+    long rows;
+    int pages;
+    long bytesWritten;
+    long bytesRead;
+    long diskBytes;         // Blocks allocated to the file
+    double loadSec;
+    double scanSec;
+    unsigned long checksum; // Of the records the scan returned
+} RunStats;
+
+static double Elapsed(struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/*
+ * RunTable
+ * Desc: Loads the lines of dataPath into a fresh RM file with page
+ *       compression on or off, then scans it back.
+ */
+static int RunTable(char *dataPath, int compress, RunStats *st) {
+    RM_FileHandle fh;
+    RM_ScanHandle sh;
+    RM_Batch batch;
+    struct timespec start;
+    struct stat sb;
+    FILE *dataFile;
+    char line[MAX_LINE_LEN];
+    RID rid;
+    int i, j;
+
+    memset(st, 0, sizeof(RunStats));
+    if ((dataFile = fopen(dataPath, "r")) == NULL)
+        return RME_ERROR;
+
+    // 1. Load: every line (title included) is one record
+    RM_DestroyFile(COMP_DB_NAME);
+    if (RM_CreateFile(COMP_DB_NAME) != RME_OK || RM_OpenFile(COMP_DB_NAME, PF_LRU, &fh) != RME_OK) {
+        fclose(dataFile);
+        return RME_ERROR;
+    }
+    PF_SetCompression(fh.pfFileDesc, compress);
+    PF_ResetStats();
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (fgets(line, MAX_LINE_LEN, dataFile)) {
+        line[strcspn(line, "\n")] = 0;
+        if (RM_InsertRecord(&fh, line, strlen(line) + 1, &rid) == RME_OK)
+            st->rows++;
+    }
+    st->pages = PF_GetNumPages(fh.pfFileDesc);
+    RM_CloseFile(&fh); // Flushes the dirty pages
+    st->loadSec = Elapsed(&start);
+    st->bytesWritten = PF_GetBytesWritten();
+    fclose(dataFile);
+
+    if (stat(COMP_DB_NAME, &sb) == 0)
+        st->diskBytes = (long)sb.st_blocks * 512;
+
+    // 2. Scan it back from a cold buffer pool
+    if (RM_OpenFile(COMP_DB_NAME, PF_LRU, &fh) != RME_OK || RM_InitBatch(&batch, BATCH_SIZE) != RME_OK)
+        return RME_ERROR;
+    PF_SetCompression(fh.pfFileDesc, compress);
+    PF_ResetStats();
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    RM_OpenScan(&fh, &sh, NULL, NULL);
+    while (RM_GetNextBatch(&sh, &batch) == RME_OK) {
+        for (i = 0; i < batch.numRecords; i++)
+            for (j = 0; j < batch.lengths[i]; j++)
+                st->checksum = st->checksum * 31 + (unsigned char)batch.recPtrs[i][j];
+    }
+    RM_CloseScan(&sh);
+    st->scanSec = Elapsed(&start);
+    st->bytesRead = PF_GetBytesRead();
+    RM_FreeBatch(&batch);
+    RM_CloseFile(&fh);
+    RM_DestroyFile(COMP_DB_NAME);
+    return RME_OK;
+}
+
+static void PrintHeader() {
+    printf("%-12s %6s %5s | %9s %9s %5s | %9s %9s | %8s %8s | %7s %7s %7s %7s | %s\n",
+           "table", "rows", "pages", "raw KB", "comp KB", "ratio", "disk KB", "comp KB",
+           "read KB", "comp KB", "load ms", "comp", "scan ms", "comp", "same");
+}
+
+static void PrintRow(char *name, RunStats *raw, RunStats *comp) {
+    printf("%-12s %6ld %5d | %9.1f %9.1f %5.2f | %9.1f %9.1f | %8.1f %8.1f | %7.2f %7.2f %7.2f %7.2f | %s\n",
+           name, raw->rows, raw->pages,
+           raw->bytesWritten / 1024.0, comp->bytesWritten / 1024.0,
+           comp->bytesWritten ? (double)raw->bytesWritten / comp->bytesWritten : 0.0,
+           raw->diskBytes / 1024.0, comp->diskBytes / 1024.0,
+           raw->bytesRead / 1024.0, comp->bytesRead / 1024.0,
+           raw->loadSec * 1000, comp->loadSec * 1000,
+           raw->scanSec * 1000, comp->scanSec * 1000,
+           (raw->rows == comp->rows && raw->checksum == comp->checksum) ? "yes" : "NO");
+}
+
+int main(int argc, char *argv[]) {
+    char *dataDir = "../../data";
+    char path[MAX_PATH_LEN], name[MAX_PATH_LEN];
+    struct dirent **entries;
+    RunStats raw, comp, rawTotal, compTotal;
+    int n, i, len;
+
+    if (argc >= 2)
+        dataDir = argv[1];
+    PF_Init(NUM_BUFS);
+
+    if ((n = scandir(dataDir, &entries, NULL, alphasort)) < 0) {
+        printf("Error: Could not read directory %s\n", dataDir);
+        return 1;
+    }
+
+    memset(&rawTotal, 0, sizeof(RunStats));
+    memset(&compTotal, 0, sizeof(RunStats));
+    PrintHeader();
+    for (i = 0; i < n; i++) {
+        len = strlen(entries[i]->d_name);
+        if (len > 4 && strcmp(entries[i]->d_name + len - 4, ".txt") == 0) {
+            snprintf(path, sizeof(path), "%s/%s", dataDir, entries[i]->d_name);
+            snprintf(name, sizeof(name), "%.*s", len - 4, entries[i]->d_name);
+            if (RunTable(path, FALSE, &raw) != RME_OK || RunTable(path, TRUE, &comp) != RME_OK) {
+                printf("Error: Could not load %s\n", path);
+                free(entries[i]);
+                continue;
+            }
+            PrintRow(name, &raw, &comp);
+
+            rawTotal.rows += raw.rows;
+            rawTotal.pages += raw.pages;
+            rawTotal.bytesWritten += raw.bytesWritten;
+            rawTotal.bytesRead += raw.bytesRead;
+            rawTotal.diskBytes += raw.diskBytes;
+            rawTotal.loadSec += raw.loadSec;
+            rawTotal.scanSec += raw.scanSec;
+            compTotal.rows += comp.rows;
+            compTotal.bytesWritten += comp.bytesWritten;
+            compTotal.bytesRead += comp.bytesRead;
+            compTotal.diskBytes += comp.diskBytes;
+            compTotal.loadSec += comp.loadSec;
+            compTotal.scanSec += comp.scanSec;
+        }
+        free(entries[i]);
+    }
+    free(entries);
+
+    PrintRow("TOTAL", &rawTotal, &compTotal);
+    printf("\nCPU cost of compression: %+.2f ms on load, %+.2f ms on scan\n",
+           (compTotal.loadSec - rawTotal.loadSec) * 1000,
+           (compTotal.scanSec - rawTotal.scanSec) * 1000);
+    return 0;
+}
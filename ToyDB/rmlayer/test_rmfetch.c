@@ -0,0 +1,169 @@
+/*
+ * test_rmfetch.c: RID fetch benchmark for the Record Manager (RM) layer.
+ *
+ * Loads gradsum.txt as raw ';'-delimited records and builds what a
+ * secondary index on cpi would return for
+ *   SELECT * FROM gradsum WHERE cpi >= 7.0
+ * namely the RIDs of the matching rows in cpi order, which is random
+ * with respect to the file. The rows are then fetched from a small,
+ * cold buffer pool three ways:
+ *   1. RM_GetRecord once per RID, in index order
+ *   2. RM_GetRecords, records emitted in RID order
+ *   3. RM_GetRecords with keepOrder, records emitted in index order
+ * and the page reads, time and a checksum of what was returned are
+ * compared (1 and 3 must agree on the order, so on the checksum too).
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "pf.h"
+#include "rm.h"
+
+#define FETCH_DB_NAME "gradsum_fetch.db"
+#define GRADSUM_DATA_FILE "../../data/gradsum.txt"
+#define MAX_LINE_LEN 256
+#define MAX_ROWS 100000
+#define NUM_BUFS 20       /* Much less than the pages of the table */
+#define FIELD_CPI 6
+#define MIN_CPI 7.0f
+
+/* One index entry: key and RID */
+typedef struct {
+    float cpi;
+    RID rid;
+} IndexEntry;
+
+/* What a fetch returned: count, bytes and an order-sensitive checksum */
+typedef struct {
+    long numRecords;
+    long numBytes;
+    unsigned long checksum;
+} FetchStats;
+
+static int CompareEntries(const void *a, const void *b) {
+    const IndexEntry *ea = a, *eb = b;
+    if (ea->cpi != eb->cpi)
+        return (ea->cpi < eb->cpi) ? -1 : 1;
+    return 0;
+}
+
+static void AddRecord(FetchStats *st, char *rec, int recLength) {
+    int i;
+    st->numRecords++;
+    st->numBytes += recLength;
+    for (i = 0; i < recLength; i++)
+        st->checksum = st->checksum * 31 + (unsigned char)rec[i];
+}
+
+static int FetchCallback(void *arg, RID rid, char *rec, int recLength) {
+    AddRecord((FetchStats *)arg, rec, recLength);
+    return RME_OK;
+}
+
+/* Parses the cpi field of a raw gradsum record */
+static int GetCpi(char *rec, float *cpi) {
+    char *p = rec;
+    int field;
+
+    for (field = 0; field < FIELD_CPI; field++)
+        if ((p = strchr(p, ';')) == NULL)
+            return FALSE;
+        else
+            p++;
+    return sscanf(p, "%f", cpi) == 1;
+}
+
+static void PrintResult(char *name, FetchStats *st, clock_t start) {
+    printf("  %-34s %6ld records, %8ld bytes, checksum %016lx, %6ld page reads, %f sec\n",
+           name, st->numRecords, st->numBytes, st->checksum, PF_GetPhysicalIOs(),
+           (double)(clock() - start) / CLOCKS_PER_SEC);
+}
+
+int main() {
+    RM_FileHandle fh;
+    RM_ScanHandle sh;
+    FILE *dataFile;
+    IndexEntry *index;
+    RID *rids;
+    FetchStats st;
+    char line[MAX_LINE_LEN];
+    char recBuf[PF_PAGE_SIZE];
+    int recLen, numRows = 0, numRids = 0, i, err;
+    float cpi;
+    RID rid;
+    clock_t start;
+
+    printf("--- RM RID Fetch Test ---\n");
+    PF_Init(NUM_BUFS);
+
+    // 1. Load the table
+    RM_DestroyFile(FETCH_DB_NAME);
+    if (RM_CreateFile(FETCH_DB_NAME) != RME_OK || RM_OpenFile(FETCH_DB_NAME, PF_LRU, &fh) != RME_OK) {
+        printf("Error: Could not create %s\n", FETCH_DB_NAME);
+        return 1;
+    }
+    if ((dataFile = fopen(GRADSUM_DATA_FILE, "r")) == NULL) {
+        printf("Error: Could not open data file: %s\n", GRADSUM_DATA_FILE);
+        return 1;
+    }
+    fgets(line, MAX_LINE_LEN, dataFile); // Skip the title line
+    while (fgets(line, MAX_LINE_LEN, dataFile) && numRows < MAX_ROWS) {
+        line[strcspn(line, "\n")] = 0;
+        if (RM_InsertRecord(&fh, line, strlen(line) + 1, &rid) == RME_OK)
+            numRows++;
+    }
+    fclose(dataFile);
+
+    // 2. "Index" the table on cpi: scan it and sort (cpi, RID) pairs
+    index = malloc(sizeof(IndexEntry) * numRows);
+    rids = malloc(sizeof(RID) * numRows);
+    if (index == NULL || rids == NULL) {
+        printf("Error: Out of memory\n");
+        return 1;
+    }
+    RM_OpenScan(&fh, &sh, NULL, NULL);
+    while (RM_GetNextRecord(&sh, &rid, recBuf, sizeof(recBuf), &recLen) == RME_OK) {
+        if (GetCpi(recBuf, &cpi) && cpi >= MIN_CPI) {
+            index[numRids].cpi = cpi;
+            index[numRids].rid = rid;
+            numRids++;
+        }
+    }
+    RM_CloseScan(&sh);
+    qsort(index, numRids, sizeof(IndexEntry), CompareEntries);
+    for (i = 0; i < numRids; i++)
+        rids[i] = index[i].rid;
+    printf("%d rows in %d pages; %d RIDs with cpi >= %.1f, in cpi order; %d buffers\n\n",
+           numRows, PF_GetNumPages(fh.pfFileDesc), numRids, MIN_CPI, NUM_BUFS);
+    RM_CloseFile(&fh);
+
+    // 3. One RM_GetRecord per RID
+    RM_OpenFile(FETCH_DB_NAME, PF_LRU, &fh);
+    memset(&st, 0, sizeof(st));
+    PF_ResetStats();
+    start = clock();
+    for (i = 0; i < numRids; i++)
+        if (RM_GetRecord(&fh, rids[i], recBuf, sizeof(recBuf), &recLen) == RME_OK)
+            AddRecord(&st, recBuf, recLen);
+    PrintResult("RM_GetRecord per RID:", &st, start);
+    RM_CloseFile(&fh);
+
+    // 4. RM_GetRecords in RID order, then in index order
+    for (i = 0; i < 2; i++) {
+        RM_OpenFile(FETCH_DB_NAME, PF_LRU, &fh);
+        memset(&st, 0, sizeof(st));
+        PF_ResetStats();
+        start = clock();
+        if ((err = RM_GetRecords(&fh, rids, numRids, i, FetchCallback, &st)) != RME_OK)
+            printf("Error: RM_GetRecords returned %d\n", err);
+        PrintResult(i ? "RM_GetRecords (keepOrder):" : "RM_GetRecords (RID order):", &st, start);
+        RM_CloseFile(&fh);
+    }
+
+    RM_DestroyFile(FETCH_DB_NAME);
+    free(index);
+    free(rids);
+    printf("--- Test Complete ---\n");
+    return 0;
+}
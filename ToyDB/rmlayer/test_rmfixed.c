@@ -0,0 +1,170 @@
+/*
+ * test_rmfixed.c: Fixed-length page benchmark for the Record Manager (RM) layer.
+ *
+ * Loads studregn.txt with every line padded to the longest one, as a
+ * CHAR(n) table would store it, into a slotted file and into a
+ * fixed-length file (RM_CreateFixedFile: presence bitmap, no slot
+ * directory). For both it reports pages and load time, then times full
+ * scans one record per call and in batches, and a filtered scan. Last,
+ * a random half of the rows is deleted and inserted again; the file
+ * must not grow and every row must still be readable under its RID.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "pf.h"
+#include "rm.h"
+
+#define SLOTTED_DB_NAME "studregn_slotted.db"
+#define FIXED_DB_NAME "studregn_fixed.db"
+#define STUDREGN_DATA_FILE "../../data/studregn.txt"
+#define MAX_LINE_LEN 256
+#define MAX_ROWS 100000
+#define BATCH_SIZE 512
+#define SCAN_ROUNDS 10
+#define FILTER_YEAR "1996" /* field 0 = year */
+
+static char *rows[MAX_ROWS]; // Padded rows, recordLength bytes each
+static RID rids[MAX_ROWS];
+static int numRows = 0, recordLength = 0;
+
+static double Seconds(clock_t start) {
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+/* One full scan, record at a time or in batches; returns the records seen */
+static long Scan(RM_FileHandle *fh, RM_Filter *filter, int batched) {
+    RM_ScanHandle sh;
+    RM_Batch batch;
+    char recBuf[PF_PAGE_SIZE];
+    int recLen;
+    long n = 0;
+    RID rid;
+
+    RM_OpenScan(fh, &sh, filter, NULL);
+    if (batched) {
+        RM_InitBatch(&batch, BATCH_SIZE);
+        while (RM_GetNextBatch(&sh, &batch) == RME_OK)
+            n += batch.numRecords;
+        RM_FreeBatch(&batch);
+    } else {
+        while (RM_GetNextRecord(&sh, &rid, recBuf, sizeof(recBuf), &recLen) == RME_OK)
+            n++;
+    }
+    RM_CloseScan(&sh);
+    return n;
+}
+
+/*
+ * RunFormat
+ * Desc: Loads, scans and churns one file; 'fixed' picks the layout.
+ */
+static void RunFormat(char *fileName, int fixed, RM_Filter *filter) {
+    RM_FileHandle fh;
+    char recBuf[PF_PAGE_SIZE];
+    clock_t start;
+    long n = 0, numDeleted = 0, bad = 0;
+    int recLen, numPages, i, round, batched;
+    double sec;
+    RID rid;
+
+    // 1. Load
+    RM_DestroyFile(fileName);
+    if ((fixed ? RM_CreateFixedFile(fileName, recordLength, NULL) : RM_CreateFile(fileName)) != RME_OK ||
+        RM_OpenFile(fileName, PF_LRU, &fh) != RME_OK) {
+        printf("Error: Could not create %s\n", fileName);
+        return;
+    }
+    start = clock();
+    for (i = 0; i < numRows; i++)
+        if (RM_InsertRecord(&fh, rows[i], recordLength, &rids[i]) != RME_OK)
+            bad++;
+    sec = Seconds(start);
+    numPages = PF_GetNumPages(fh.pfFileDesc);
+    printf("%s: %d rows in %d pages (%.1f rows per page), load %f sec, %ld failed\n",
+           fixed ? "Fixed-length" : "Slotted", numRows, numPages,
+           (double)numRows / (numPages - 1), sec, bad);
+
+    // 2. Scans: whole file one by one and in batches, then filtered
+    for (batched = 0; batched <= 1; batched++) {
+        start = clock();
+        for (round = 0; round < SCAN_ROUNDS; round++)
+            n = Scan(&fh, NULL, batched);
+        printf("  %-22s %6ld records, %f sec\n", batched ? "RM_GetNextBatch:" : "RM_GetNextRecord:",
+               n, Seconds(start) / SCAN_ROUNDS);
+    }
+    start = clock();
+    for (round = 0; round < SCAN_ROUNDS; round++)
+        n = Scan(&fh, filter, TRUE);
+    printf("  %-22s %6ld records, %f sec\n", "Batch, year = " FILTER_YEAR ":",
+           n, Seconds(start) / SCAN_ROUNDS);
+
+    // 3. Delete a random half and insert those rows again
+    srand(0);
+    if (fixed && RM_InsertRecord(&fh, rows[0], recordLength - 1, &rid) != RME_INVALIDARG)
+        printf("  Error: A record of the wrong length was not refused\n");
+    for (i = 0; i < numRows; i++) {
+        if (rand() % 2 == 0) {
+            if (RM_DeleteRecord(&fh, rids[i]) != RME_OK ||
+                RM_InsertRecord(&fh, rows[i], recordLength, &rids[i]) != RME_OK)
+                bad++;
+            numDeleted++;
+        }
+    }
+    bad = 0;
+    for (i = 0; i < numRows; i++) {
+        if (RM_GetRecord(&fh, rids[i], recBuf, sizeof(recBuf), &recLen) != RME_OK ||
+            recLen != recordLength || memcmp(recBuf, rows[i], recLen) != 0)
+            bad++;
+    }
+    printf("  Churn: %ld rows deleted and reinserted, %d pages before, %d after, "
+           "%ld mismatches, %ld records scanned\n\n",
+           numDeleted, numPages, PF_GetNumPages(fh.pfFileDesc), bad, Scan(&fh, NULL, TRUE));
+
+    RM_CloseFile(&fh);
+    RM_DestroyFile(fileName);
+}
+
+int main() {
+    RM_Filter filter;
+    FILE *dataFile;
+    char line[MAX_LINE_LEN];
+    int len, i;
+
+    printf("--- RM Fixed-Length Page Test ---\n");
+    PF_Init(50);
+
+    // 1. Read the rows and find the longest
+    if ((dataFile = fopen(STUDREGN_DATA_FILE, "r")) == NULL) {
+        printf("Error: Could not open data file: %s\n", STUDREGN_DATA_FILE);
+        return 1;
+    }
+    fgets(line, MAX_LINE_LEN, dataFile); // Skip the title line
+    while (fgets(line, MAX_LINE_LEN, dataFile) && numRows < MAX_ROWS) {
+        line[strcspn(line, "\n")] = 0;
+        rows[numRows++] = strdup(line);
+        if ((len = strlen(line) + 1) > recordLength)
+            recordLength = len;
+    }
+    fclose(dataFile);
+
+    // 2. Pad every row to that length
+    for (i = 0; i < numRows; i++) {
+        char *padded = calloc(1, recordLength);
+        strcpy(padded, rows[i]);
+        free(rows[i]);
+        rows[i] = padded;
+    }
+    printf("%d rows of %d bytes\n\n", numRows, recordLength);
+
+    RM_InitFilter(&filter, ';');
+    RM_AddPredicate(&filter, 0, 'c', RM_EQ, FILTER_YEAR);
+    RunFormat(SLOTTED_DB_NAME, FALSE, &filter);
+    RunFormat(FIXED_DB_NAME, TRUE, &filter);
+
+    for (i = 0; i < numRows; i++)
+        free(rows[i]);
+    printf("--- Test Complete ---\n");
+    return 0;
+}
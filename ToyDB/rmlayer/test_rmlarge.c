@@ -0,0 +1,378 @@
+/*
+ * test_rmlarge.c: Large record test for the Record Manager (RM) layer.
+ *
+ * Loads crsedetails.txt (one record per course, terminated by ";;")
+ * together with one record per department holding the text of all its
+ * courses ("AE;<course>;;<course>;;..."). The department records are
+ * many pages long and are stored in overflow page chains. Every record
+ * is then read back with RM_GetRecord and with a record stream using a
+ * small buffer, scanned one at a time and in batches (with and without
+ * a filter), and finally the large records are deleted and inserted
+ * again, which must reuse their disposed pages rather than grow the file.
+ * A second file interleaves small and large records, so overflow chains
+ * cross the page ranges of RM_ParallelScan's workers; it is scanned many
+ * times over at 1 to 8 threads and every scan must return every record.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pf.h"
+#include "rm.h"
+
+#define LARGE_DB_NAME "rmlarge.db"
+#define CRSE_DATA_FILE "../../data/crsedetails.txt"
+#define MAX_RECORDS 4096
+#define MAX_DEPTS 512
+#define STREAM_BUF_SIZE 256
+#define BATCH_SIZE 512
+#define FILTER_VALUE "M" /* field 0 >= "M" */
+#define PAR_DB_NAME "rmlarge_par.db"
+#define PAR_RECORDS 400
+#define PAR_LARGE_LEN 9000 /* Every third record; the rest are small */
+#define PAR_SMALL_LEN 100
+#define PAR_ROUNDS 300
+#define PAR_THREADS 8
+
+typedef struct {
+    char *data;
+    int length;
+    RID rid;
+} TestRecord;
+
+static TestRecord records[MAX_RECORDS];
+static int numRecords = 0, numLarge = 0;
+
+/* Appends len bytes of src to a malloc'd string */
+static char *Append(char *str, int *strLen, char *src, int len) {
+    char *newStr = realloc(str, *strLen + len + 1);
+    if (newStr == NULL) {
+        free(str);
+        return NULL;
+    }
+    memcpy(newStr + *strLen, src, len);
+    *strLen += len;
+    newStr[*strLen] = '\0';
+    return newStr;
+}
+
+/*
+ * BuildRecords
+ * Desc: Splits the data file into course records, then appends one
+ *       record per department (the text before the space of the code).
+ */
+static int BuildRecords(char *text) {
+    char *depts[MAX_DEPTS], *p, *end, *space;
+    int deptLens[MAX_DEPTS], numDepts = 0, numCourses, i, d, len;
+
+    p = strchr(text, '\n'); // Skip the title line
+    p = (p == NULL) ? text + strlen(text) : p + 1;
+    while ((end = strstr(p, ";;")) != NULL && numRecords < MAX_RECORDS) {
+        len = end - p;
+        if ((records[numRecords].data = malloc(len + 1)) == NULL)
+            return -1;
+        memcpy(records[numRecords].data, p, len);
+        records[numRecords].data[len] = '\0';
+        records[numRecords].length = len + 1;
+        numRecords++;
+        p = end + 2;
+        while (*p == '\n' || *p == '\r')
+            p++;
+    }
+    numCourses = numRecords;
+
+    for (i = 0; i < numCourses; i++) {
+        char *code = records[i].data;
+        if ((space = strchr(code, ' ')) == NULL)
+            continue;
+        len = space - code;
+        for (d = 0; d < numDepts; d++)
+            if (deptLens[d] >= len && strncmp(depts[d], code, len) == 0 && depts[d][len] == ';')
+                break;
+        if (d == numDepts) {
+            if (numDepts == MAX_DEPTS)
+                continue;
+            deptLens[d] = 0;
+            if ((depts[d] = Append(NULL, &deptLens[d], code, len)) == NULL)
+                return -1;
+            numDepts++;
+        }
+        if ((depts[d] = Append(depts[d], &deptLens[d], ";", 1)) == NULL ||
+            (depts[d] = Append(depts[d], &deptLens[d], code, records[i].length - 1)) == NULL ||
+            (depts[d] = Append(depts[d], &deptLens[d], ";;", 2)) == NULL)
+            return -1;
+    }
+
+    for (d = 0; d < numDepts && numRecords < MAX_RECORDS; d++) {
+        records[numRecords].data = depts[d];
+        records[numRecords].length = deptLens[d] + 1;
+        if (records[numRecords].length > PF_PAGE_SIZE)
+            numLarge++;
+        numRecords++;
+    }
+    return numCourses;
+}
+
+static TestRecord *FindRecord(RID rid) {
+    int i;
+    for (i = 0; i < numRecords; i++)
+        if (records[i].rid == rid)
+            return &records[i];
+    return NULL;
+}
+
+/* Checks one scanned record against what was inserted */
+static int Matches(RID rid, char *data, int length) {
+    TestRecord *rec = FindRecord(rid);
+    return rec != NULL && rec->length == length && memcmp(rec->data, data, length) == 0;
+}
+
+/* The contents of record i of the parallel scan file */
+static int ParRecord(int i, char *buf) {
+    int len = (i % 3 == 2) ? PAR_LARGE_LEN : PAR_SMALL_LEN, j;
+
+    sprintf(buf, "%05d;", i);
+    for (j = 6; j < len; j++)
+        buf[j] = 'a' + (i + j) % 26;
+    return len;
+}
+
+/* Per-worker result of a parallel scan, padded to its own cache line */
+typedef struct {
+    int found;
+    int bad;
+    char pad[64 - 2 * sizeof(int)];
+} ParCount;
+
+/* RM_ParallelScan callback: checks a record against ParRecord() */
+static int CheckParRecord(void *arg, RID rid, char *rec, int recLength) {
+    ParCount *count = (ParCount *)arg;
+    char expect[PAR_LARGE_LEN];
+    int i = atoi(rec);
+
+    count->found++;
+    if (i < 0 || i >= PAR_RECORDS || ParRecord(i, expect) != recLength ||
+        memcmp(expect, rec, recLength) != 0)
+        count->bad++;
+    return RME_OK;
+}
+
+/*
+ * TestParallelScan
+ * Desc: Loads PAR_RECORDS records, every third one in an overflow chain,
+ *       and runs PAR_ROUNDS parallel scans at each thread count.
+ * Returns: 0 if every scan returned every record intact, 1 otherwise
+ */
+static int TestParallelScan() {
+    RM_FileHandle fh;
+    ParCount counts[PAR_THREADS];
+    void *args[PAR_THREADS];
+    char rec[PAR_LARGE_LEN];
+    RID rid;
+    int i, t, round, numThreads, err, found, bad, failed = 0;
+
+    RM_DestroyFile(PAR_DB_NAME);
+    if (RM_CreateFile(PAR_DB_NAME) != RME_OK || RM_OpenFile(PAR_DB_NAME, PF_LRU, &fh) != RME_OK) {
+        printf("Error: Could not create %s\n", PAR_DB_NAME);
+        return 1;
+    }
+    for (i = 0; i < PAR_RECORDS; i++) {
+        if (RM_InsertRecord(&fh, rec, ParRecord(i, rec), &rid) != RME_OK) {
+            printf("Error: Insert of record %d failed\n", i);
+            return 1;
+        }
+    }
+    for (t = 0; t < PAR_THREADS; t++)
+        args[t] = &counts[t];
+
+    for (numThreads = 1; numThreads <= PAR_THREADS; numThreads *= 2) {
+        found = bad = 0;
+        for (round = 0; round < PAR_ROUNDS; round++) {
+            memset(counts, 0, sizeof(counts));
+            if ((err = RM_ParallelScan(&fh, numThreads, NULL, CheckParRecord, args)) != RME_OK) {
+                printf("Error: RM_ParallelScan failed (%d) in round %d\n", err, round);
+                failed = 1;
+                break;
+            }
+            for (t = 0; t < numThreads; t++) {
+                found += counts[t].found;
+                bad += counts[t].bad;
+            }
+        }
+        printf("RM_ParallelScan:     %d threads, %d rounds, %d records (expected %d), %d mismatches\n",
+               numThreads, round, found, round * PAR_RECORDS, bad);
+        if (found != round * PAR_RECORDS || bad != 0)
+            failed = 1;
+    }
+
+    RM_CloseFile(&fh);
+    RM_DestroyFile(PAR_DB_NAME);
+    return failed;
+}
+
+int main() {
+    RM_FileHandle fh;
+    RM_ScanHandle sh;
+    RM_RecordStream rs;
+    RM_Filter filter;
+    RM_Batch batch;
+    FILE *dataFile;
+    char *text, *buf, chunk[STREAM_BUF_SIZE];
+    long textLen;
+    int numCourses, maxLen = 0, i, n, len, pos, bad, numPages, pagesAfter;
+    int expectFiltered = 0, found, foundLarge;
+    RID rid;
+
+    printf("--- RM Large Record Test ---\n");
+    PF_Init(50);
+
+    // 1. Read and split the data file
+    if ((dataFile = fopen(CRSE_DATA_FILE, "rb")) == NULL) {
+        printf("Error: Could not open data file: %s\n", CRSE_DATA_FILE);
+        return 1;
+    }
+    fseek(dataFile, 0, SEEK_END);
+    textLen = ftell(dataFile);
+    rewind(dataFile);
+    text = malloc(textLen + 1);
+    if (text == NULL || fread(text, 1, textLen, dataFile) != (size_t)textLen) {
+        printf("Error: Could not read %s\n", CRSE_DATA_FILE);
+        return 1;
+    }
+    text[textLen] = '\0';
+    fclose(dataFile);
+
+    if ((numCourses = BuildRecords(text)) < 0) {
+        printf("Error: Out of memory\n");
+        return 1;
+    }
+    for (i = 0; i < numRecords; i++) {
+        if (records[i].length > maxLen)
+            maxLen = records[i].length;
+        if (strcmp(records[i].data, FILTER_VALUE) >= 0)
+            expectFiltered++;
+    }
+    printf("%d course records, %d department records (%d larger than a page, longest %d bytes)\n",
+           numCourses, numRecords - numCourses, numLarge, maxLen);
+
+    // 2. Load them
+    RM_DestroyFile(LARGE_DB_NAME);
+    if (RM_CreateFile(LARGE_DB_NAME) != RME_OK || RM_OpenFile(LARGE_DB_NAME, PF_LRU, &fh) != RME_OK) {
+        printf("Error: Could not create %s\n", LARGE_DB_NAME);
+        return 1;
+    }
+    for (i = 0; i < numRecords; i++) {
+        if (RM_InsertRecord(&fh, records[i].data, records[i].length, &records[i].rid) != RME_OK) {
+            printf("Error: Insert of record %d (%d bytes) failed\n", i, records[i].length);
+            return 1;
+        }
+    }
+    numPages = PF_GetNumPages(fh.pfFileDesc);
+    printf("Loaded into %d pages\n", numPages);
+
+    // 3. Read every record back whole, and through a stream
+    buf = malloc(maxLen);
+    bad = 0;
+    for (i = 0; i < numRecords; i++) {
+        if (RM_GetRecord(&fh, records[i].rid, buf, maxLen, &len) != RME_OK ||
+            len != records[i].length || memcmp(buf, records[i].data, len) != 0)
+            bad++;
+    }
+    printf("RM_GetRecord:        %d records, %d mismatches\n", numRecords, bad);
+    if (RM_GetRecord(&fh, records[numRecords - 1].rid, buf, records[numRecords - 1].length - 1, &len)
+        != RME_BUFTOOSMALL)
+        printf("Error: A short buffer was not refused\n");
+
+    bad = 0;
+    for (i = 0; i < numRecords; i++) {
+        if (RM_OpenRecordStream(&fh, records[i].rid, &rs) != RME_OK) {
+            bad++;
+            continue;
+        }
+        pos = 0;
+        while (RM_ReadRecordStream(&rs, chunk, sizeof(chunk), &n) == RME_OK) {
+            if (pos + n > records[i].length || memcmp(chunk, records[i].data + pos, n) != 0)
+                break;
+            pos += n;
+        }
+        if (pos != records[i].length || rs.totalLength != records[i].length)
+            bad++;
+        RM_CloseRecordStream(&rs);
+    }
+    printf("RM_ReadRecordStream: %d records, %d mismatches (%d byte buffer)\n",
+           numRecords, bad, STREAM_BUF_SIZE);
+
+    // 4. Scan them, one at a time and in batches, with and without a filter
+    RM_InitFilter(&filter, ';');
+    RM_AddPredicate(&filter, 0, 'c', RM_GE, FILTER_VALUE);
+    for (i = 0; i < 2; i++) {
+        found = foundLarge = bad = 0;
+        RM_OpenScan(&fh, &sh, i ? &filter : NULL, NULL);
+        while (RM_GetNextRecord(&sh, &rid, buf, maxLen, &len) == RME_OK) {
+            if (!Matches(rid, buf, len))
+                bad++;
+            found++;
+            if (len > PF_PAGE_SIZE)
+                foundLarge++;
+        }
+        RM_CloseScan(&sh);
+        printf("RM_GetNextRecord%-11s %d records (%d large, expected %d), %d mismatches\n",
+               i ? " (filtered):" : ":", found, foundLarge,
+               i ? expectFiltered : numRecords, bad);
+    }
+
+    RM_InitBatch(&batch, BATCH_SIZE);
+    for (i = 0; i < 2; i++) {
+        found = foundLarge = bad = 0;
+        RM_OpenScan(&fh, &sh, i ? &filter : NULL, NULL);
+        while (RM_GetNextBatch(&sh, &batch) == RME_OK) {
+            for (n = 0; n < batch.numRecords; n++) {
+                if (!Matches(batch.rids[n], batch.recPtrs[n], batch.lengths[n]))
+                    bad++;
+                found++;
+                if (batch.lengths[n] > PF_PAGE_SIZE)
+                    foundLarge++;
+            }
+        }
+        RM_CloseScan(&sh);
+        printf("RM_GetNextBatch%-12s %d records (%d large, expected %d), %d mismatches\n",
+               i ? " (filtered):" : ":", found, foundLarge,
+               i ? expectFiltered : numRecords, bad);
+    }
+    RM_FreeBatch(&batch);
+
+    // 5. Delete the large records and insert them again: the overflow
+    //    pages they gave back are reused
+    for (i = numCourses; i < numRecords; i++)
+        if (RM_DeleteRecord(&fh, records[i].rid) != RME_OK)
+            printf("Error: Delete of record %d failed\n", i);
+    if (RM_GetRecord(&fh, records[numRecords - 1].rid, buf, maxLen, &len) != RME_INVALIDRID)
+        printf("Error: A deleted record can still be read\n");
+    for (i = numCourses; i < numRecords; i++)
+        if (RM_InsertRecord(&fh, records[i].data, records[i].length, &records[i].rid) != RME_OK)
+            printf("Error: Reinsert of record %d failed\n", i);
+    pagesAfter = PF_GetNumPages(fh.pfFileDesc);
+
+    bad = 0;
+    for (i = 0; i < numRecords; i++) {
+        if (RM_GetRecord(&fh, records[i].rid, buf, maxLen, &len) != RME_OK ||
+            len != records[i].length || memcmp(buf, records[i].data, len) != 0)
+            bad++;
+    }
+    printf("Delete + reinsert:   %d mismatches, %d pages before, %d after (%s)\n",
+           bad, numPages, pagesAfter, pagesAfter <= numPages ? "pages reused" : "FILE GREW");
+
+    RM_CloseFile(&fh);
+    RM_DestroyFile(LARGE_DB_NAME);
+    for (i = 0; i < numRecords; i++)
+        free(records[i].data);
+    free(buf);
+    free(text);
+
+    // 6. Parallel scans with overflow chains crossing the workers' ranges
+    if (TestParallelScan() != 0) {
+        printf("Error: Parallel scans lost or damaged records\n");
+        return 1;
+    }
+    printf("--- Test Complete ---\n");
+    return 0;
+}
@@ -0,0 +1,186 @@
+/*
+ * test_rmpar.c: Parallel scan benchmark for the Record Manager (RM) layer.
+ *
+ * Loads the two largest tables (gradsum.txt and studregn.txt), then runs
+ * a COUNT(*) and a filtered COUNT over each with RM_ParallelScan at 1, 2,
+ * 4 and 8 threads. Every worker counts into its own slot, so the only
+ * shared state is the PF buffer pool. The buffer pool is sized to hold
+ * both files, so after the first pass the scans are CPU bound and the
+ * speedup is limited by the number of cores on the machine. Every scan
+ * must count the same rows, whatever the thread count; the test exits
+ * with 1 if one does not, or if a scan fails.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "pf.h"
+#include "rm.h"
+
+#define MAX_LINE_LEN 256
+#define NUM_BUFS 2000  /* Enough frames for both tables */
+#define NUM_PASSES 10  /* Scans per measurement, to get above timer noise */
+#define MAX_THREADS 8
+
+typedef struct {
+    char *name;
+    char *dataFile;
+    char *dbName;
+    int field;       // Filtered column
+    char attrType;
+    int op;
+    char *value;
+    char *desc;
+} ParTable;
+
+static ParTable tables[] = {
+    { "gradsum",  "../../data/gradsum.txt",  "gradsum_par.db",  6, 'f', RM_GE, "8.0", "cpi >= 8.0" },
+    { "studregn", "../../data/studregn.txt", "studregn_par.db", 3, 'c', RM_EQ, "AA",  "grade = 'AA'" },
+};
+
+/* One counter per worker, padded so workers do not share a cache line */
+typedef struct {
+    long count;
+    char pad[64 - sizeof(long)];
+} ParCounter;
+
+static int CountRecord(void *arg, RID rid, char *rec, int recLength) {
+    ((ParCounter *)arg)->count++;
+    return RME_OK;
+}
+
+static double WallSeconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static long LoadTable(ParTable *tbl, RM_FileHandle *fh) {
+    FILE *dataFile;
+    char line[MAX_LINE_LEN];
+    RID rid;
+    long numLoaded = 0;
+
+    RM_DestroyFile(tbl->dbName);
+    RM_CreateFile(tbl->dbName);
+    if (RM_OpenFile(tbl->dbName, PF_LRU, fh) != RME_OK) {
+        printf("Error opening RM file %s.\n", tbl->dbName);
+        return -1;
+    }
+    if ((dataFile = fopen(tbl->dataFile, "r")) == NULL) {
+        printf("Error: Could not open data file: %s\n", tbl->dataFile);
+        RM_CloseFile(fh);
+        return -1;
+    }
+
+    fgets(line, MAX_LINE_LEN, dataFile); // Skip the "Database dummy" title line
+    while (fgets(line, MAX_LINE_LEN, dataFile)) {
+        line[strcspn(line, "\n")] = 0;
+        if (RM_InsertRecord(fh, line, strlen(line) + 1, &rid) == RME_OK)
+            numLoaded++;
+    }
+    fclose(dataFile);
+    return numLoaded;
+}
+
+/*
+ * Runs NUM_PASSES parallel scans, returns seconds per scan and the count,
+ * or -1.0 if a scan failed or the passes did not all count the same
+ */
+static double TimeScan(RM_FileHandle *fh, int numThreads, RM_Filter *filter, long *count) {
+    ParCounter counters[MAX_THREADS];
+    void *args[MAX_THREADS];
+    double start;
+    long passCount;
+    int pass, t, err;
+
+    for (t = 0; t < numThreads; t++)
+        args[t] = &counters[t];
+
+    start = WallSeconds();
+    for (pass = 0; pass < NUM_PASSES; pass++) {
+        for (t = 0; t < numThreads; t++)
+            counters[t].count = 0;
+        if ((err = RM_ParallelScan(fh, numThreads, filter, CountRecord, args)) != RME_OK) {
+            printf("RM_ParallelScan failed (%d) with %d threads.\n", err, numThreads);
+            return -1.0;
+        }
+
+        passCount = 0;
+        for (t = 0; t < numThreads; t++)
+            passCount += counters[t].count;
+        if (pass > 0 && passCount != *count) {
+            printf("Error: pass %d counted %ld rows, pass 0 %ld (%d threads)\n",
+                   pass, passCount, *count, numThreads);
+            return -1.0;
+        }
+        *count = passCount;
+    }
+    return (WallSeconds() - start) / NUM_PASSES;
+}
+
+int main() {
+    RM_FileHandle fh;
+    RM_Filter filter;
+    long numLoaded, count, count1;
+    double t1, t;
+    int i, numThreads;
+
+    PF_Init(NUM_BUFS);
+    printf("Online CPUs: %ld\n\n", sysconf(_SC_NPROCESSORS_ONLN));
+
+    for (i = 0; i < (int)(sizeof(tables) / sizeof(tables[0])); i++) {
+        ParTable *tbl = &tables[i];
+
+        printf("Loading %s...\n", tbl->dataFile);
+        if ((numLoaded = LoadTable(tbl, &fh)) < 0)
+            return 1;
+        printf("...Loaded %ld records into %d pages.\n\n",
+               numLoaded, PF_GetNumPages(fh.pfFileDesc));
+
+        RM_InitFilter(&filter, ';');
+        RM_AddPredicate(&filter, tbl->field, tbl->attrType, tbl->op, tbl->value);
+
+        printf("%-8s %-24s %8s %8s %12s %8s\n",
+               "threads", "query", "rows", "count", "sec/scan", "speedup");
+
+        // COUNT(*): every row, at every thread count
+        t1 = 0.0;
+        for (numThreads = 1; numThreads <= MAX_THREADS; numThreads *= 2) {
+            if ((t = TimeScan(&fh, numThreads, NULL, &count)) < 0.0)
+                return 1;
+            if (numThreads == 1) t1 = t;
+            printf("%-8d %-24s %8ld %8ld %12f %7.2fx\n", numThreads, "COUNT(*)",
+                   numLoaded, count, t, (t > 0.0) ? t1 / t : 0.0);
+            if (count != numLoaded) {
+                printf("Error: counted %ld of %ld rows\n", count, numLoaded);
+                return 1;
+            }
+        }
+
+        // COUNT(*) WHERE <filter>: the same count at every thread count
+        t1 = 0.0;
+        count1 = 0;
+        for (numThreads = 1; numThreads <= MAX_THREADS; numThreads *= 2) {
+            if ((t = TimeScan(&fh, numThreads, &filter, &count)) < 0.0)
+                return 1;
+            if (numThreads == 1) {
+                t1 = t;
+                count1 = count;
+            }
+            printf("%-8d %-24s %8ld %8ld %12f %7.2fx\n", numThreads, tbl->desc,
+                   numLoaded, count, t, (t > 0.0) ? t1 / t : 0.0);
+            if (count != count1) {
+                printf("Error: %d threads counted %ld rows, 1 thread %ld\n",
+                       numThreads, count, count1);
+                return 1;
+            }
+        }
+        printf("\n");
+
+        RM_CloseFile(&fh);
+        RM_DestroyFile(tbl->dbName);
+    }
+    return 0;
+}
@@ -0,0 +1,336 @@
+/*
+ * test_rmscan.c: Selective scan benchmark for the Record Manager (RM) layer.
+ *
+ * Loads gradsum.txt as raw ';'-delimited records and answers
+ *   SELECT roll, year, cpi FROM gradsum WHERE year = 2001 AND cpi >= 8.0
+ * twice: once the old way (copy every record out, then sscanf it in the
+ * caller), and once with the filter and projection pushed into the scan.
+ * It then compares a full-table scan one record per call against
+ * RM_GetNextBatch, which returns a page's worth of records per call.
+ * Finally it loads the same rows as typed records and runs the query
+ * with a typed filter, reading fields through the offset table, and
+ * compares SUM(cpi) over slotted typed pages with a column scan of the
+ * same rows stored in PAX pages.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "pf.h"
+#include "rm.h"
+
+#define GRADSUM_DB_NAME "gradsum_scan.db"
+#define GRADSUM_TYPED_DB_NAME "gradsum_typed.db"
+#define GRADSUM_PAX_DB_NAME "gradsum_pax.db"
+#define GRADSUM_DATA_FILE "../../data/gradsum.txt"
+#define MAX_LINE_LEN 256
+#define BATCH_SIZE 512 /* More than the records of one 4 KB page */
+
+/* gradsum fields: roll;year;sem;...;cpi;... */
+#define FIELD_ROLL 0
+#define FIELD_YEAR 1
+#define FIELD_CPI  6
+
+int main() {
+    RM_FileHandle fh, paxFh;
+    RM_ScanHandle sh;
+    RM_Column col;
+    RM_Filter filter;
+    RM_Projection proj;
+    RM_Batch batch;
+    RM_Schema schema;
+    RID rid;
+    FILE *dataFile;
+    char line[MAX_LINE_LEN];
+    char recBuf[PF_PAGE_SIZE];
+    int recLen;
+    long numLoaded = 0, numMatched, bytesCopied;
+    clock_t start;
+    double t_caller, t_pushdown, t_single, t_batch, t_typed, t_rowsum, t_colsum;
+    double sum;
+    long numCalls;
+
+    PF_Init(50);
+
+    RM_DestroyFile(GRADSUM_DB_NAME);
+    RM_CreateFile(GRADSUM_DB_NAME);
+    if (RM_OpenFile(GRADSUM_DB_NAME, PF_LRU, &fh) != RME_OK) {
+        printf("Error opening RM file.\n");
+        return 1;
+    }
+    if ((dataFile = fopen(GRADSUM_DATA_FILE, "r")) == NULL) {
+        printf("Error: Could not open data file: %s\n", GRADSUM_DATA_FILE);
+        RM_CloseFile(&fh);
+        return 1;
+    }
+
+    printf("Loading %s...\n", GRADSUM_DATA_FILE);
+    fgets(line, MAX_LINE_LEN, dataFile); // Skip the "Database dummy" title line
+    while (fgets(line, MAX_LINE_LEN, dataFile)) {
+        line[strcspn(line, "\n")] = 0;
+        if (RM_InsertRecord(&fh, line, strlen(line) + 1, &rid) == RME_OK)
+            numLoaded++;
+    }
+    fclose(dataFile);
+    printf("...Loaded %ld records.\n\n", numLoaded);
+
+    // --- Scan 1: copy everything out, filter and project in the caller ---
+    numMatched = 0;
+    bytesCopied = 0;
+    start = clock();
+    RM_OpenScan(&fh, &sh, NULL, NULL);
+    while (RM_GetNextRecord(&sh, &rid, recBuf, sizeof(recBuf), &recLen) == RME_OK) {
+        char roll[32], out[64];
+        int year;
+        float cpi;
+
+        bytesCopied += recLen;
+        if (sscanf(recBuf, "%31[^;];%d;%*[^;];%*[^;];%*[^;];%*[^;];%f",
+                   roll, &year, &cpi) != 3)
+            continue;
+        if (year == 2001 && cpi >= 8.0f) {
+            sprintf(out, "%s;%d;%.2f", roll, year, cpi);
+            numMatched++;
+        }
+    }
+    RM_CloseScan(&sh);
+    t_caller = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    printf("Caller-side filter:   %6ld matches, %8ld bytes copied, %f sec\n",
+           numMatched, bytesCopied, t_caller);
+
+    // --- Scan 2: filter and projection evaluated inside the page loop ---
+    RM_InitFilter(&filter, ';');
+    RM_AddPredicate(&filter, FIELD_YEAR, 'i', RM_EQ, "2001");
+    RM_AddPredicate(&filter, FIELD_CPI, 'f', RM_GE, "8.0");
+
+    RM_InitProjection(&proj, ';');
+    RM_AddProjField(&proj, FIELD_ROLL);
+    RM_AddProjField(&proj, FIELD_YEAR);
+    RM_AddProjField(&proj, FIELD_CPI);
+
+    numMatched = 0;
+    bytesCopied = 0;
+    start = clock();
+    RM_OpenScan(&fh, &sh, &filter, &proj);
+    while (RM_GetNextRecord(&sh, &rid, recBuf, sizeof(recBuf), &recLen) == RME_OK) {
+        bytesCopied += recLen;
+        numMatched++;
+    }
+    RM_CloseScan(&sh);
+    t_pushdown = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    printf("Pushed-down filter:   %6ld matches, %8ld bytes copied, %f sec\n",
+           numMatched, bytesCopied, t_pushdown);
+
+    // The same scan into a buffer that starts too small: a refused record
+    // is returned again once the buffer is grown to *dataLength
+    {
+        long numGrown = 0, bytesGrown = 0;
+        int smallSize = 4, err;
+
+        RM_OpenScan(&fh, &sh, &filter, &proj);
+        while ((err = RM_GetNextRecord(&sh, &rid, recBuf, smallSize, &recLen)) != RME_EOF) {
+            if (err == RME_BUFTOOSMALL && recLen > smallSize && recLen <= (int)sizeof(recBuf)) {
+                smallSize = recLen;
+                continue;
+            }
+            if (err != RME_OK)
+                break;
+            bytesGrown += recLen;
+            numGrown++;
+        }
+        RM_CloseScan(&sh);
+        printf("Growing buffer:       %6ld matches, %8ld bytes copied (ends at %d bytes)\n",
+               numGrown, bytesGrown, smallSize);
+        if (err != RME_EOF || numGrown != numMatched || bytesGrown != bytesCopied) {
+            printf("Error: a record was lost while the buffer grew\n");
+            return 1;
+        }
+    }
+
+    // --- Scan 3: full scan, one record per call ---
+    numMatched = 0;
+    bytesCopied = 0;
+    numCalls = 0;
+    start = clock();
+    RM_OpenScan(&fh, &sh, NULL, NULL);
+    while (RM_GetNextRecord(&sh, &rid, recBuf, sizeof(recBuf), &recLen) == RME_OK) {
+        bytesCopied += recLen;
+        numMatched++;
+        numCalls++;
+    }
+    RM_CloseScan(&sh);
+    t_single = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    printf("\nRecord-at-a-time:     %6ld records, %8ld calls, %f sec\n",
+           numMatched, numCalls, t_single);
+
+    // --- Scan 4: full scan, one page of records per call ---
+    if (RM_InitBatch(&batch, BATCH_SIZE) != RME_OK) {
+        printf("Error allocating batch.\n");
+        return 1;
+    }
+    numMatched = 0;
+    bytesCopied = 0;
+    numCalls = 0;
+    start = clock();
+    RM_OpenScan(&fh, &sh, NULL, NULL);
+    while (RM_GetNextBatch(&sh, &batch) == RME_OK) {
+        for (int i = 0; i < batch.numRecords; i++)
+            bytesCopied += batch.lengths[i];
+        numMatched += batch.numRecords;
+        numCalls++;
+    }
+    RM_CloseScan(&sh);
+    t_batch = (double)(clock() - start) / CLOCKS_PER_SEC;
+    RM_FreeBatch(&batch);
+
+    printf("Batch (%d/call):     %6ld records, %8ld calls, %f sec\n",
+           BATCH_SIZE, numMatched, numCalls, t_batch);
+
+    RM_CloseFile(&fh);
+    RM_DestroyFile(GRADSUM_DB_NAME);
+
+    // --- Scan 5: typed records, fields found through the offset table ---
+    RM_InitSchema(&schema);
+    RM_AddAttr(&schema, "roll", RM_INT, 0);
+    RM_AddAttr(&schema, "year", RM_INT, 0);
+    RM_AddAttr(&schema, "sem", RM_INT, 0);
+    RM_AddAttr(&schema, "spi", RM_FLOAT, 0);
+    RM_AddAttr(&schema, "spi2", RM_FLOAT, 0);
+    RM_AddAttr(&schema, "spi3", RM_FLOAT, 0);
+    RM_AddAttr(&schema, "cpi", RM_FLOAT, 0);
+    RM_AddAttr(&schema, "credits", RM_FLOAT, 0);
+    RM_AddAttr(&schema, "points", RM_FLOAT, 0);
+
+    RM_DestroyFile(GRADSUM_TYPED_DB_NAME);
+    RM_CreateTypedFile(GRADSUM_TYPED_DB_NAME, &schema);
+    if (RM_OpenFile(GRADSUM_TYPED_DB_NAME, PF_LRU, &fh) != RME_OK || RM_GetSchema(&fh) == NULL) {
+        printf("Error opening typed RM file.\n");
+        return 1;
+    }
+    if ((dataFile = fopen(GRADSUM_DATA_FILE, "r")) == NULL) {
+        printf("Error: Could not open data file: %s\n", GRADSUM_DATA_FILE);
+        return 1;
+    }
+    numLoaded = 0;
+    fgets(line, MAX_LINE_LEN, dataFile); // Skip the title line
+    while (fgets(line, MAX_LINE_LEN, dataFile)) {
+        line[strcspn(line, "\n")] = 0;
+        if (RM_EncodeDelimited(RM_GetSchema(&fh), line, ';', recBuf, sizeof(recBuf), &recLen) == RME_OK &&
+            RM_InsertRecord(&fh, recBuf, recLen, &rid) == RME_OK)
+            numLoaded++;
+    }
+    fclose(dataFile);
+
+    RM_InitTypedFilter(&filter, RM_GetSchema(&fh));
+    RM_AddPredicate(&filter, FIELD_YEAR, 'i', RM_EQ, "2001");
+    RM_AddPredicate(&filter, FIELD_CPI, 'f', RM_GE, "8.0");
+
+    numMatched = 0;
+    bytesCopied = 0;
+    start = clock();
+    RM_OpenScan(&fh, &sh, &filter, NULL);
+    while (RM_GetNextRecord(&sh, &rid, recBuf, sizeof(recBuf), &recLen) == RME_OK) {
+        int roll;
+        float cpi;
+
+        // O(1) field reads, no text parsing
+        if (RM_GetIntField(RM_GetSchema(&fh), recBuf, FIELD_ROLL, &roll) == RME_OK &&
+            RM_GetFloatField(RM_GetSchema(&fh), recBuf, FIELD_CPI, &cpi) == RME_OK)
+            numMatched++;
+        bytesCopied += recLen;
+    }
+    RM_CloseScan(&sh);
+    t_typed = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    printf("\nTyped records (%ld loaded):\n", numLoaded);
+    printf("Typed filter:         %6ld matches, %8ld bytes copied, %f sec\n",
+           numMatched, bytesCopied, t_typed);
+
+    // --- Scan 6: SUM(cpi), whole typed rows vs. one PAX column ---
+    if (RM_InitBatch(&batch, BATCH_SIZE) != RME_OK) {
+        printf("Error allocating batch.\n");
+        return 1;
+    }
+    sum = 0.0;
+    numMatched = 0;
+    start = clock();
+    RM_OpenScan(&fh, &sh, NULL, NULL);
+    while (RM_GetNextBatch(&sh, &batch) == RME_OK) {
+        for (int i = 0; i < batch.numRecords; i++) {
+            float cpi;
+            if (RM_GetFloatField(RM_GetSchema(&fh), batch.recPtrs[i], FIELD_CPI, &cpi) == RME_OK) {
+                sum += cpi;
+                numMatched++;
+            }
+        }
+    }
+    RM_CloseScan(&sh);
+    t_rowsum = (double)(clock() - start) / CLOCKS_PER_SEC;
+    RM_FreeBatch(&batch);
+
+    // Copy the typed rows into a PAX file; RIDs are kept per file
+    RM_DestroyFile(GRADSUM_PAX_DB_NAME);
+    if (RM_CreateFileFormat(GRADSUM_PAX_DB_NAME, RM_FMT_PAX, RM_GetSchema(&fh)) != RME_OK ||
+        RM_OpenFile(GRADSUM_PAX_DB_NAME, PF_LRU, &paxFh) != RME_OK) {
+        printf("Error creating PAX file.\n");
+        return 1;
+    }
+    RM_OpenScan(&fh, &sh, NULL, NULL);
+    while (RM_GetNextRecord(&sh, &rid, recBuf, sizeof(recBuf), &recLen) == RME_OK)
+        RM_InsertRecord(&paxFh, recBuf, recLen, &rid);
+    RM_CloseScan(&sh);
+
+    printf("\nSUM(cpi) over %d slotted pages / %d PAX pages (%d rows per PAX page):\n",
+           PF_GetNumPages(fh.pfFileDesc) - RM_FIRST_DATA_PAGE,
+           PF_GetNumPages(paxFh.pfFileDesc) - RM_FIRST_DATA_PAGE, paxFh.pax.capacity);
+    printf("Typed rows (batch):   %6ld values, sum %.2f, %f sec\n", numMatched, sum, t_rowsum);
+
+    sum = 0.0;
+    numMatched = 0;
+    start = clock();
+    RM_OpenScan(&paxFh, &sh, NULL, NULL);
+    while (RM_GetNextColumn(&sh, FIELD_CPI, &col) == RME_OK) {
+        float *cpis = (float *)col.values; // 4-byte aligned minipage
+        for (int i = 0; i < col.numSlots; i++) {
+            if (RM_BITSET(col.present, i) && !RM_BITSET(col.nulls, i)) {
+                sum += cpis[i];
+                numMatched++;
+            }
+        }
+    }
+    RM_CloseScan(&sh);
+    t_colsum = (double)(clock() - start) / CLOCKS_PER_SEC;
+    printf("PAX column scan:      %6ld values, sum %.2f, %f sec\n", numMatched, sum, t_colsum);
+
+    // A PAX RID fetches the whole row back (after the scan has let go of
+    // the page: PF does not let a page be fixed twice)
+    RID *rids = malloc(sizeof(RID) * numLoaded);
+    long numRids = 0;
+    RM_OpenScan(&paxFh, &sh, &filter, NULL);
+    while (RM_GetNextRecord(&sh, &rid, recBuf, sizeof(recBuf), &recLen) == RME_OK)
+        rids[numRids++] = rid;
+    RM_CloseScan(&sh);
+
+    numMatched = 0;
+    for (long i = 0; i < numRids; i++) {
+        int year;
+        float cpi;
+        if (RM_GetRecord(&paxFh, rids[i], recBuf, sizeof(recBuf), &recLen) == RME_OK &&
+            RM_GetIntField(RM_GetSchema(&paxFh), recBuf, FIELD_YEAR, &year) == RME_OK &&
+            RM_GetFloatField(RM_GetSchema(&paxFh), recBuf, FIELD_CPI, &cpi) == RME_OK &&
+            year == 2001 && cpi >= 8.0f)
+            numMatched++;
+    }
+    free(rids);
+    printf("PAX typed filter:     %6ld matches, %6ld fetched back by RID\n", numRids, numMatched);
+
+    RM_CloseFile(&paxFh);
+    RM_DestroyFile(GRADSUM_PAX_DB_NAME);
+    RM_CloseFile(&fh);
+    RM_DestroyFile(GRADSUM_TYPED_DB_NAME);
+    printf("\n");
+    return 0;
+}
@@ -0,0 +1,185 @@
+/*
+ * test_rmsort.c: External sort test for the Record Manager (RM) layer.
+ *
+ * Part 1 sorts a shuffled permutation of keys carried in items of
+ * varying length, a few of them longer than a page, with memory from
+ * plenty down to RM_SORT_MINFRAMES frames, and checks every item that
+ * comes back. Part 2 runs ORDER BY roll number, course descending over
+ * studregn.txt loaded into an RM file. Each run reports the runs and
+ * merge passes it took, its time and the bytes it moved.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "pf.h"
+#include "rm.h"
+
+#define DB_NAME "studregn_sort.db"
+#define STUDREGN_DATA_FILE "../../data/studregn.txt"
+#define NUM_KEYS 200000
+#define LONG_EVERY 2000    /* Every 2000th key gets a LONG_LEN item */
+#define LONG_LEN 6000
+#define MAX_ITEM LONG_LEN
+
+static int frameCounts[] = { 100000, 512, 64, 16, RM_SORT_MINFRAMES };
+#define NUM_FRAME_COUNTS ((int)(sizeof(frameCounts) / sizeof(frameCounts[0])))
+
+static double Seconds(clock_t start) {
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+/* Item of a key: the key, then filler that depends on it */
+static int MakeItem(int key, char *item) {
+    int len = (key % LONG_EVERY == 0) ? LONG_LEN : (int)sizeof(int) + key % 60;
+    int i;
+
+    memcpy(item, &key, sizeof(int));
+    for (i = sizeof(int); i < len; i++)
+        item[i] = (char)('a' + (key + i) % 26);
+    return len;
+}
+
+static int CompareKeys(void *arg, char *a, int aLen, char *b, int bLen) {
+    int ka, kb;
+
+    memcpy(&ka, a, sizeof(int));
+    memcpy(&kb, b, sizeof(int));
+    return (ka > kb) - (ka < kb);
+}
+
+static void PrintStats(RM_Sort *sort, double sec) {
+    printf("%4d runs, %d passes, %f sec, %8ld KB written, %8ld KB read\n",
+           sort->numRuns, sort->numPasses, sec,
+           PF_GetBytesWritten() / 1024, PF_GetBytesRead() / 1024);
+}
+
+static void SortKeys(void) {
+    static int keys[NUM_KEYS];
+    char item[MAX_ITEM], expected[MAX_ITEM], *data;
+    RM_Sort sort;
+    int i, j, t, f, len, expLen, err;
+    long n, bad;
+    clock_t start;
+
+    printf("Part 1: %d items, one in %d of %d bytes\n", NUM_KEYS, LONG_EVERY, LONG_LEN);
+    for (i = 0; i < NUM_KEYS; i++)
+        keys[i] = i;
+    srand(42);
+    for (i = NUM_KEYS - 1; i > 0; i--) {
+        j = rand() % (i + 1);
+        t = keys[i];
+        keys[i] = keys[j];
+        keys[j] = t;
+    }
+
+    for (f = 0; f < NUM_FRAME_COUNTS; f++) {
+        PF_ResetStats();
+        start = clock();
+        if ((err = RM_BeginSort(&sort, CompareKeys, NULL, frameCounts[f])) != RME_OK) {
+            printf("Error: RM_BeginSort returned %d\n", err);
+            return;
+        }
+        for (i = 0; i < NUM_KEYS && err == RME_OK; i++) {
+            len = MakeItem(keys[i], item);
+            err = RM_SortAdd(&sort, item, len);
+        }
+        if (err == RME_OK)
+            err = RM_SortDone(&sort);
+
+        // The keys must come back as 0, 1, 2, ... with their items intact
+        n = bad = 0;
+        while (err == RME_OK && (err = RM_SortNext(&sort, &data, &len)) == RME_OK) {
+            expLen = MakeItem((int)n, expected);
+            if (len != expLen || memcmp(data, expected, len) != 0)
+                bad++;
+            n++;
+        }
+        printf("  %6d frames: ", frameCounts[f]);
+        PrintStats(&sort, Seconds(start));
+        printf("                 %ld items, %ld wrong%s\n", n, bad,
+               (err == RME_EOF) ? "" : " (sort failed)");
+        RM_EndSort(&sort);
+    }
+}
+
+static void SortFile(void) {
+    RM_FileHandle fh;
+    RM_BulkLoader bl;
+    RM_OrderBy order;
+    RM_Sort sort;
+    FILE *dataFile;
+    char line[PF_PAGE_SIZE], prev[PF_PAGE_SIZE], *data;
+    long numRows = 0, sumIn = 0, n, sumOut, bad;
+    int f, i, len, prevLen = 0, err;
+    RID rid;
+    clock_t start;
+
+    // 1. Load the table
+    RM_DestroyFile(DB_NAME);
+    if (RM_CreateFile(DB_NAME) != RME_OK || RM_OpenFile(DB_NAME, PF_LRU, &fh) != RME_OK) {
+        printf("Error: Could not create %s\n", DB_NAME);
+        return;
+    }
+    if ((dataFile = fopen(STUDREGN_DATA_FILE, "r")) == NULL) {
+        printf("Error: Could not open data file: %s\n", STUDREGN_DATA_FILE);
+        RM_CloseFile(&fh);
+        return;
+    }
+    RM_BeginBulkLoad(&fh, &bl);
+    fgets(line, sizeof(line), dataFile); // Skip the title line
+    while (fgets(line, sizeof(line), dataFile)) {
+        line[strcspn(line, "\n")] = 0;
+        len = strlen(line) + 1;
+        if (RM_BulkInsert(&bl, line, len, &rid) != RME_OK)
+            break;
+        for (i = 0; i < len; i++)
+            sumIn += (unsigned char)line[i] * (i + 1);
+        numRows++;
+    }
+    RM_EndBulkLoad(&bl);
+    fclose(dataFile);
+    printf("\nPart 2: ORDER BY rollno, course DESC over %ld rows of studregn\n", numRows);
+
+    // 2. Sort with less and less memory
+    RM_InitOrderBy(&order, ';');
+    RM_AddOrderKey(&order, 6, 'i', FALSE);
+    RM_AddOrderKey(&order, 2, 'c', TRUE);
+    for (f = 0; f < NUM_FRAME_COUNTS; f++) {
+        PF_ResetStats();
+        start = clock();
+        if ((err = RM_SortFile(&fh, NULL, &order, frameCounts[f], &sort)) != RME_OK) {
+            printf("Error: RM_SortFile returned %d\n", err);
+            break;
+        }
+
+        // Every row once (same checksum), each not before the one ahead
+        n = sumOut = bad = 0;
+        while ((err = RM_SortNext(&sort, &data, &len)) == RME_OK) {
+            if (n > 0 && RM_CompareRecords(&order, prev, prevLen, data, len) > 0)
+                bad++;
+            for (i = 0; i < len; i++)
+                sumOut += (unsigned char)data[i] * (i + 1);
+            memcpy(prev, data, len);
+            prevLen = len;
+            n++;
+        }
+        printf("  %6d frames: ", frameCounts[f]);
+        PrintStats(&sort, Seconds(start));
+        printf("                 %ld rows, %ld out of order, checksum %s%s\n", n, bad,
+               (sumOut == sumIn) ? "ok" : "WRONG", (err == RME_EOF) ? "" : " (sort failed)");
+        RM_EndSort(&sort);
+    }
+
+    RM_CloseFile(&fh);
+    RM_DestroyFile(DB_NAME);
+}
+
+int main() {
+    printf("--- RM External Sort Test ---\n");
+    PF_Init(50);
+    SortKeys();
+    SortFile();
+    printf("--- Test Complete ---\n");
+    return 0;
+}
@@ -0,0 +1,189 @@
+/*
+ * test_rmupdate.c: Record update benchmark for the Record Manager (RM) layer.
+ *
+ * Loads student.txt (one record per line) and rewrites every record
+ * three times:
+ *   1. same length (a field is changed in place)
+ *   2. 40 bytes longer (the pages are full, so most records move and
+ *      leave a forwarding stub)
+ *   3. back to the original text (moved records return home)
+ * once with RM_UpdateRecord and once with RM_DeleteRecord followed by
+ * RM_InsertRecord, the only way to change a record before. For both it
+ * reports the time, page reads/writes and how many RIDs changed (each
+ * one an index entry to fix). After every round the file is checked:
+ * each record must be readable under its RID and a scan must return
+ * each record exactly once.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "pf.h"
+#include "rm.h"
+
+#define UPDATE_DB_NAME "student_update.db"
+#define STUDENT_DATA_FILE "../../data/student.txt"
+#define MAX_LINE_LEN 256
+#define MAX_ROWS 20000
+#define GROW_BYTES 40
+
+static char *original[MAX_ROWS];  // Text of each row as loaded
+static char *current[MAX_ROWS];   // What each row holds now
+static RID rids[MAX_ROWS];
+static int numRows = 0;
+
+/* Builds the new text of row i for a round */
+static void NewVersion(int round, int i, char *buf) {
+    char *p;
+
+    strcpy(buf, original[i]);
+    if (round == 1) {
+        if ((p = strchr(buf, 'X')) != NULL)
+            *p = 'Y'; // Same length
+    } else if (round == 2) {
+        snprintf(buf + strlen(buf), MAX_LINE_LEN - strlen(buf),
+                 "note %-*d", GROW_BYTES - 5, i); // GROW_BYTES longer
+    }
+}
+
+static int CompareRids(const void *a, const void *b) {
+    RID ra = *(const RID *)a, rb = *(const RID *)b;
+    return (ra > rb) - (ra < rb);
+}
+
+/*
+ * Check
+ * Desc: Reads every row by RID and scans the file; returns the number
+ *       of problems found.
+ */
+static int Check(RM_FileHandle *fh) {
+    RM_ScanHandle sh;
+    RID *seen, rid;
+    char buf[PF_PAGE_SIZE];
+    int len, bad = 0, n = 0, i;
+
+    for (i = 0; i < numRows; i++) {
+        if (RM_GetRecord(fh, rids[i], buf, sizeof(buf), &len) != RME_OK ||
+            len != (int)strlen(current[i]) + 1 || memcmp(buf, current[i], len) != 0)
+            bad++;
+    }
+
+    // The scan must return each RID once (moved records under their
+    // home RID, forwarding stubs not at all)
+    seen = malloc(sizeof(RID) * (numRows + 1));
+    RM_OpenScan(fh, &sh, NULL, NULL);
+    while (RM_GetNextRecord(&sh, &rid, buf, sizeof(buf), &len) == RME_OK) {
+        if (n <= numRows)
+            seen[n] = rid;
+        n++;
+    }
+    RM_CloseScan(&sh);
+    if (n != numRows) {
+        bad++;
+    } else {
+        qsort(seen, n, sizeof(RID), CompareRids);
+        for (i = 1; i < n; i++)
+            if (seen[i] == seen[i - 1])
+                bad++;
+    }
+    free(seen);
+    return bad;
+}
+
+/*
+ * RunRound
+ * Desc: Rewrites every row to its version for 'round', with
+ *       RM_UpdateRecord or with delete + insert.
+ */
+static void RunRound(RM_FileHandle *fh, int round, int useUpdate) {
+    char buf[MAX_LINE_LEN];
+    long changed = 0, failed = 0;
+    clock_t start;
+    RID newRid;
+    int i;
+
+    PF_ResetStats();
+    start = clock();
+    for (i = 0; i < numRows; i++) {
+        NewVersion(round, i, buf);
+        if (useUpdate) {
+            if (RM_UpdateRecord(fh, rids[i], buf, strlen(buf) + 1) != RME_OK) {
+                failed++;
+                continue;
+            }
+        } else {
+            if (RM_DeleteRecord(fh, rids[i]) != RME_OK ||
+                RM_InsertRecord(fh, buf, strlen(buf) + 1, &newRid) != RME_OK) {
+                failed++;
+                continue;
+            }
+            if (newRid != rids[i])
+                changed++;
+            rids[i] = newRid;
+        }
+        free(current[i]);
+        current[i] = strdup(buf);
+    }
+    printf("  %-16s %8.1f updates/sec, %7ld page reads, %7ld page writes, "
+           "%6ld RIDs changed, %ld failed, %d pages",
+           useUpdate ? "RM_UpdateRecord:" : "delete + insert:",
+           numRows / ((double)(clock() - start) / CLOCKS_PER_SEC),
+           PF_GetDiskReads(), PF_GetDiskWrites(), changed, failed,
+           PF_GetNumPages(fh->pfFileDesc));
+    printf(", %d check errors\n", Check(fh));
+}
+
+int main() {
+    static char *names[] = { "", "same length", "40 bytes longer", "back to original" };
+    RM_FileHandle fh;
+    FILE *dataFile;
+    char line[MAX_LINE_LEN];
+    int useUpdate, round, i;
+
+    printf("--- RM Update Test ---\n");
+    PF_Init(50);
+
+    if ((dataFile = fopen(STUDENT_DATA_FILE, "r")) == NULL) {
+        printf("Error: Could not open data file: %s\n", STUDENT_DATA_FILE);
+        return 1;
+    }
+    fgets(line, MAX_LINE_LEN, dataFile); // Skip the title line
+    while (fgets(line, MAX_LINE_LEN - GROW_BYTES, dataFile) && numRows < MAX_ROWS) {
+        line[strcspn(line, "\n")] = 0;
+        original[numRows++] = strdup(line);
+    }
+    fclose(dataFile);
+
+    for (useUpdate = 1; useUpdate >= 0; useUpdate--) {
+        // 1. Load the table
+        RM_DestroyFile(UPDATE_DB_NAME);
+        if (RM_CreateFile(UPDATE_DB_NAME) != RME_OK ||
+            RM_OpenFile(UPDATE_DB_NAME, PF_LRU, &fh) != RME_OK) {
+            printf("Error: Could not create %s\n", UPDATE_DB_NAME);
+            return 1;
+        }
+        for (i = 0; i < numRows; i++) {
+            current[i] = strdup(original[i]);
+            RM_InsertRecord(&fh, current[i], strlen(current[i]) + 1, &rids[i]);
+        }
+        printf("\n%s: %d rows in %d pages\n",
+               useUpdate ? "RM_UpdateRecord" : "Delete + insert",
+               numRows, PF_GetNumPages(fh.pfFileDesc));
+
+        // 2. Rewrite every row, round by round
+        for (round = 1; round <= 3; round++) {
+            printf(" Round %d (%s)\n", round, names[round]);
+            RunRound(&fh, round, useUpdate);
+        }
+
+        RM_CloseFile(&fh);
+        RM_DestroyFile(UPDATE_DB_NAME);
+        for (i = 0; i < numRows; i++)
+            free(current[i]);
+    }
+
+    for (i = 0; i < numRows; i++)
+        free(original[i]);
+    printf("\n--- Test Complete ---\n");
+    return 0;
+}
@@ -0,0 +1,228 @@
+/*
+ * test_rmvacuum.c: Vacuum test for the Record Manager (RM) layer.
+ *
+ * Loads studregn.txt into a slotted, a compact and a fixed-length file
+ * (rows padded to the longest one). In the slotted files some rows then
+ * grow by update until they are forwarded to another page, and a few
+ * records too large for a page come and go, leaving freed overflow
+ * pages. Three rows in four are deleted. For each file the pages, the
+ * file size and a cold full scan are reported before and after
+ * RM_VacuumFile, and every surviving row must be found under the RID
+ * the vacuum's map gives for it.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+#include "pf.h"
+#include "rm.h"
+
+#define SLOTTED_DB_NAME "studregn_vac_slotted.db"
+#define COMPACT_DB_NAME "studregn_vac_compact.db"
+#define FIXED_DB_NAME "studregn_vac_fixed.db"
+#define STUDREGN_DATA_FILE "../../data/studregn.txt"
+#define MAX_LINE_LEN 256
+#define MAX_ROWS 100000
+#define SCAN_ROUNDS 10
+#define GROW_EVERY 40      /* Every 40th row grows by GROW_BYTES */
+#define GROW_BYTES 120
+#define NUM_LARGE 30       /* Records longer than a page */
+#define LARGE_LEN 9000
+
+static char *rows[MAX_ROWS]; // Row as loaded; grown rows are replaced
+static int lens[MAX_ROWS];
+static RID rids[MAX_ROWS];
+static int alive[MAX_ROWS];
+static int numRows = 0, recordLength = 0;
+
+static double Seconds(clock_t start) {
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+static long FileBytes(char *fileName) {
+    struct stat st;
+    return (stat(fileName, &st) == 0) ? (long)st.st_size : -1;
+}
+
+/* Cold full scans (the file is reopened each round); returns the records seen */
+static long TimeScan(char *fileName, double *sec, long *pageReads, int *numPages) {
+    RM_FileHandle fh;
+    RM_ScanHandle sh;
+    char recBuf[LARGE_LEN];
+    int recLen, round;
+    long n = 0;
+    clock_t start;
+    RID rid;
+
+    *sec = 0;
+    for (round = 0; round < SCAN_ROUNDS; round++) {
+        RM_OpenFile(fileName, PF_LRU, &fh);
+        PF_ResetStats();
+        n = 0;
+        start = clock();
+        RM_OpenScan(&fh, &sh, NULL, NULL);
+        while (RM_GetNextRecord(&sh, &rid, recBuf, sizeof(recBuf), &recLen) == RME_OK)
+            n++;
+        RM_CloseScan(&sh);
+        *sec += Seconds(start);
+        *pageReads = PF_GetDiskReads();
+        *numPages = PF_GetNumPages(fh.pfFileDesc);
+        RM_CloseFile(&fh);
+    }
+    *sec /= SCAN_ROUNDS;
+    return n;
+}
+
+/*
+ * RunFormat
+ * Desc: Loads, thins out and vacuums one file of the given format.
+ */
+static void RunFormat(char *label, char *fileName, int format) {
+    RM_FileHandle fh;
+    RM_RidMap *map;
+    RID largeRids[NUM_LARGE], newRid;
+    char large[LARGE_LEN];
+    char recBuf[LARGE_LEN];
+    int i, recLen, numPages, numMapped, numLive = 0, err;
+    long n, pageReads, bytes, bad = 0, lost = 0;
+    double sec;
+    clock_t start;
+
+    // 1. Load
+    RM_DestroyFile(fileName);
+    err = (format == RM_FMT_FIXED) ? RM_CreateFixedFile(fileName, recordLength, NULL)
+                                   : RM_CreateFileFormat(fileName, format, NULL);
+    if (err != RME_OK || RM_OpenFile(fileName, PF_LRU, &fh) != RME_OK) {
+        printf("Error: Could not create %s\n", fileName);
+        return;
+    }
+    for (i = 0; i < numRows; i++) {
+        lens[i] = (format == RM_FMT_FIXED) ? recordLength : (int)strlen(rows[i]) + 1;
+        alive[i] = (RM_InsertRecord(&fh, rows[i], lens[i], &rids[i]) == RME_OK);
+        if (!alive[i])
+            bad++;
+    }
+
+    // 2. Slotted files: forward grown rows, free some overflow chains
+    if (format != RM_FMT_FIXED) {
+        for (i = 0; i < numRows; i += GROW_EVERY) {
+            char *grown = calloc(1, lens[i] + GROW_BYTES);
+            memcpy(grown, rows[i], lens[i]);
+            memset(grown + lens[i], '+', GROW_BYTES - 1);
+            if (RM_UpdateRecord(&fh, rids[i], grown, lens[i] + GROW_BYTES) != RME_OK)
+                bad++;
+            free(rows[i]);
+            rows[i] = grown;
+            lens[i] += GROW_BYTES;
+        }
+        memset(large, 'L', sizeof(large));
+        for (i = 0; i < NUM_LARGE; i++)
+            if (RM_InsertRecord(&fh, large, LARGE_LEN, &largeRids[i]) != RME_OK)
+                bad++;
+        for (i = 0; i < NUM_LARGE; i += 2)
+            if (RM_DeleteRecord(&fh, largeRids[i]) != RME_OK)
+                bad++;
+    }
+
+    // 3. Delete three rows in four
+    srand(0);
+    for (i = 0; i < numRows; i++) {
+        if (alive[i] && rand() % 4 != 0) {
+            if (RM_DeleteRecord(&fh, rids[i]) != RME_OK)
+                bad++;
+            alive[i] = FALSE;
+        }
+        numLive += alive[i];
+    }
+    RM_CloseFile(&fh);
+
+    printf("%s: %d of %d rows left%s, %ld errors\n", label, numLive, numRows,
+           (format != RM_FMT_FIXED) ? " (plus large records)" : "", bad);
+    n = TimeScan(fileName, &sec, &pageReads, &numPages);
+    bytes = FileBytes(fileName);
+    printf("  Before vacuum: %5d pages, %9ld bytes, scan %6ld records, %5ld page reads, %f sec\n",
+           numPages, bytes, n, pageReads, sec);
+
+    // 4. Vacuum
+    start = clock();
+    if ((err = RM_VacuumFile(fileName, &map, &numMapped)) != RME_OK) {
+        printf("  Error: RM_VacuumFile returned %d\n", err);
+        return;
+    }
+    printf("  Vacuum:        %f sec, %d RIDs in the map\n", Seconds(start), numMapped);
+
+    n = TimeScan(fileName, &sec, &pageReads, &numPages);
+    printf("  After vacuum:  %5d pages, %9ld bytes, scan %6ld records, %5ld page reads, %f sec\n",
+           numPages, FileBytes(fileName), n, pageReads, sec);
+
+    // 5. Every surviving row under its new RID, no deleted one in the map
+    bad = 0;
+    RM_OpenFile(fileName, PF_LRU, &fh);
+    for (i = 0; i < numRows; i++) {
+        newRid = RM_MapRID(map, numMapped, rids[i]);
+        if (!alive[i]) {
+            if (newRid != RME_INVALIDRID)
+                bad++;
+            continue;
+        }
+        if (newRid == RME_INVALIDRID) {
+            lost++;
+            continue;
+        }
+        if (RM_GetRecord(&fh, newRid, recBuf, sizeof(recBuf), &recLen) != RME_OK ||
+            recLen != lens[i] || memcmp(recBuf, rows[i], recLen) != 0)
+            bad++;
+    }
+    for (i = 1; format != RM_FMT_FIXED && i < NUM_LARGE; i += 2) {
+        newRid = RM_MapRID(map, numMapped, largeRids[i]);
+        if (RM_GetRecord(&fh, newRid, recBuf, sizeof(recBuf), &recLen) != RME_OK ||
+            recLen != LARGE_LEN || memcmp(recBuf, large, recLen) != 0)
+            bad++;
+    }
+    printf("  Check: %ld rows lost, %ld mismatches\n\n", lost, bad);
+    RM_CloseFile(&fh);
+    free(map);
+    RM_DestroyFile(fileName);
+}
+
+int main() {
+    FILE *dataFile;
+    char line[MAX_LINE_LEN];
+    int len, i;
+
+    printf("--- RM Vacuum Test ---\n");
+    PF_Init(50);
+
+    // 1. Read the rows and find the longest
+    if ((dataFile = fopen(STUDREGN_DATA_FILE, "r")) == NULL) {
+        printf("Error: Could not open data file: %s\n", STUDREGN_DATA_FILE);
+        return 1;
+    }
+    fgets(line, MAX_LINE_LEN, dataFile); // Skip the title line
+    while (fgets(line, MAX_LINE_LEN, dataFile) && numRows < MAX_ROWS) {
+        line[strcspn(line, "\n")] = 0;
+        if ((len = strlen(line) + 1) > recordLength)
+            recordLength = len;
+        rows[numRows++] = strdup(line);
+    }
+    fclose(dataFile);
+    printf("%d rows\n\n", numRows);
+
+    RunFormat("Slotted", SLOTTED_DB_NAME, RM_FMT_SLOTTED);
+    RunFormat("Compact", COMPACT_DB_NAME, RM_FMT_COMPACT);
+
+    // 2. The fixed-length file takes every row padded to the longest
+    for (i = 0; i < numRows; i++) {
+        char *padded = calloc(1, recordLength);
+        strcpy(padded, rows[i]); // Grown rows keep the original string
+        free(rows[i]);
+        rows[i] = padded;
+    }
+    RunFormat("Fixed-length", FIXED_DB_NAME, RM_FMT_FIXED);
+
+    for (i = 0; i < numRows; i++)
+        free(rows[i]);
+    printf("--- Test Complete ---\n");
+    return 0;
+}